@@ -0,0 +1,108 @@
+package vips
+
+/*
+#include <stdlib.h>
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"errors"
+	"runtime"
+	"unsafe"
+)
+
+// BatchItem is one input of ProcessBatch: a file path, or encoded bytes when Path is empty.
+type BatchItem struct {
+	Path string
+	Data []byte
+}
+
+// BatchSpec is the work ProcessBatch runs on every item.
+type BatchSpec struct {
+	Load   ImageLoadOptions // Loader options and limits for every item
+	Ops    []PipelineOp     // Operations to apply, in order
+	Output EncodeSpec       // Output encoding; Format must not be FormatNone
+}
+
+// BatchResult is the outcome of one ProcessBatch item.
+type BatchResult struct {
+	Data []byte // Encoded output, nil if Err is set
+	Err  error  // Failure of this item, as an *Error
+}
+
+// ProcessBatch loads, processes and encodes many images in a single call into the C
+// library. Whole images are spread over parallelism native threads (0 = one per CPU
+// core), which keeps every core busy on small images where libvips' per-image
+// threading cannot. Results are in item order; a failing item does not stop the
+// others. The returned error is only set when the batch could not be run at all.
+//
+// Data slices are copied before decoding, so they are only read during the call and may
+// be reused as soon as ProcessBatch returns. With many small images, combine with
+// SetConcurrency(1) so each image uses a single libvips thread.
+func ProcessBatch(items []BatchItem, spec *BatchSpec, parallelism int) ([]BatchResult, error) {
+	if spec == nil {
+		return nil, errors.New("batch spec is nil")
+	}
+	cOps, err := pipelineOps(spec.Ops)
+	if err != nil {
+		return nil, err
+	}
+
+	// The item array lives in Go memory, so the slices it points to are pinned for the call
+	var pinner runtime.Pinner
+	defer pinner.Unpin()
+	cItems := make([]C.ImageBatchItem, len(items))
+	for i := range items {
+		if items[i].Path != "" {
+			cPath := C.CString(items[i].Path)
+			defer C.free(unsafe.Pointer(cPath))
+			cItems[i].path = cPath
+		} else if len(items[i].Data) > 0 {
+			pinner.Pin(&items[i].Data[0])
+			cItems[i].data = (*C.uchar)(unsafe.Pointer(&items[i].Data[0]))
+			cItems[i].size = C.size_t(len(items[i].Data))
+		}
+	}
+
+	cSpec := C.ImageBatchSpec{
+		load:     spec.Load.toC(),
+		ops:      firstOp(cOps),
+		op_count: C.size_t(len(cOps)),
+		output:   spec.Output.toC(),
+	}
+	cResults := make([]C.ImageBatchResult, len(items))
+	err = checkStatus(func() C.ImageStatus {
+		return C.process_batch(firstItem(cItems), C.size_t(len(cItems)), cSpec, firstResult(cResults), C.int(parallelism))
+	})
+	runtime.KeepAlive(spec)
+	if err != nil {
+		return nil, err
+	}
+
+	results := make([]BatchResult, len(cResults))
+	for i := range cResults {
+		if cResults[i].status != C.SUCCESS {
+			results[i].Err = errorFromC(&cResults[i].error)
+			continue
+		}
+		results[i].Data = C.GoBytes(unsafe.Pointer(cResults[i].output.data), C.int(cResults[i].output.size))
+		C.free_image_buffer(cResults[i].output)
+	}
+	return results, nil
+}
+
+// firstItem returns a pointer to the first item, or nil for an empty batch.
+func firstItem(cItems []C.ImageBatchItem) *C.ImageBatchItem {
+	if len(cItems) == 0 {
+		return nil
+	}
+	return &cItems[0]
+}
+
+// firstResult returns a pointer to the first result, or nil for an empty batch.
+func firstResult(cResults []C.ImageBatchResult) *C.ImageBatchResult {
+	if len(cResults) == 0 {
+		return nil
+	}
+	return &cResults[0]
+}
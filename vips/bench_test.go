@@ -0,0 +1,636 @@
+package vips
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"slices"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+)
+
+// Benchmarks for the Go bindings. Together with vips/c/test/bench_wrapper.cpp
+// they show how much of each call is cgo overhead versus libvips work.
+//
+//	go test -run '^$' -bench . -benchmem -json ./vips > bench_go.json
+//
+// Wrapper operations are lazy, so the transform benchmarks load, transform
+// and encode each iteration; compare them with BenchmarkDecodeEncode, which
+// performs the same load and encode without a transform.
+
+const benchSource = "c/test/test.jpg"
+
+// benchSizes is the matrix of source sizes, from 0.3MP to the full test image.
+var benchSizes = []struct{ width, height int }{
+	{640, 480},
+	{1920, 1080},
+	{4000, 3000},
+}
+
+// benchJPEG holds the encoded source for each size, created on first use.
+var benchJPEG = map[[2]int][]byte{}
+
+func TestMain(m *testing.M) {
+	if err := Init(); err != nil {
+		fmt.Fprintln(os.Stderr, err)
+		os.Exit(1)
+	}
+	code := m.Run()
+	Cleanup()
+	os.Exit(code)
+}
+
+// sourceJPEG returns a JPEG of the test image scaled to width x height.
+func sourceJPEG(b *testing.B, width, height int) []byte {
+	b.Helper()
+	key := [2]int{width, height}
+	if data, ok := benchJPEG[key]; ok {
+		return data
+	}
+	img, err := Thumbnail(benchSource, &ImageResizeOptions{Width: width, Height: height})
+	if err != nil {
+		b.Skipf("cannot prepare %dx%d source: %v", width, height, err)
+	}
+	defer img.Free()
+	data, err := img.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 90})
+	if err != nil {
+		b.Fatal(err)
+	}
+	benchJPEG[key] = data
+	return data
+}
+
+// reportMPs adds a megapixels per second metric for an image of width x height.
+func reportMPs(b *testing.B, width, height int) {
+	if seconds := b.Elapsed().Seconds(); seconds > 0 {
+		b.ReportMetric(float64(width*height)/1e6*float64(b.N)/seconds, "MP/s")
+	}
+}
+
+// forEachSize runs fn as a sub-benchmark for every source size.
+func forEachSize(b *testing.B, fn func(b *testing.B, data []byte, width, height int)) {
+	for _, size := range benchSizes {
+		b.Run(fmt.Sprintf("%dx%d", size.width, size.height), func(b *testing.B) {
+			data := sourceJPEG(b, size.width, size.height)
+			b.ResetTimer()
+			fn(b, data, size.width, size.height)
+			reportMPs(b, size.width, size.height)
+		})
+	}
+}
+
+// transform loads data, applies op and encodes the result once per iteration.
+func transform(b *testing.B, data []byte, op func(img *Image) error) {
+	for i := 0; i < b.N; i++ {
+		img, err := LoadImageFromBytes(data)
+		if err != nil {
+			b.Fatal(err)
+		}
+		if err := op(img); err != nil {
+			b.Fatal(err)
+		}
+		if _, err := img.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 80}); err != nil {
+			b.Fatal(err)
+		}
+		img.Free()
+	}
+}
+
+// BenchmarkCgoCall measures a near-empty round trip into the C library.
+func BenchmarkCgoCall(b *testing.B) {
+	for i := 0; i < b.N; i++ {
+		_ = CurrentRuntimeConfig()
+	}
+}
+
+// BenchmarkExtractMetadata measures a header-only call on a loaded image.
+func BenchmarkExtractMetadata(b *testing.B) {
+	img, err := LoadImage(benchSource)
+	if err != nil {
+		b.Skip(err)
+	}
+	defer img.Free()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := img.ExtractMetadata(); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func BenchmarkLoadImage(b *testing.B) {
+	for i := 0; i < b.N; i++ {
+		img, err := LoadImage(benchSource)
+		if err != nil {
+			b.Skip(err)
+		}
+		img.Free()
+	}
+}
+
+func BenchmarkDecodeEncode(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(*Image) error { return nil })
+	})
+}
+
+func BenchmarkResize(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.Resize(&ImageResizeOptions{Width: width / 4, Height: height / 4, MaintainAspect: true})
+		})
+	})
+}
+
+// BenchmarkRawCacheResize is BenchmarkResize with the source mapped from a raw cache
+// entry instead of decoded from JPEG.
+func BenchmarkRawCacheResize(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		cache, err := NewRawCache(&RawCacheOptions{Directory: b.TempDir()})
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer cache.Close()
+		img, err := LoadImageFromBytes(data)
+		if err != nil {
+			b.Fatal(err)
+		}
+		err = cache.Store("source", img)
+		img.Free()
+		if err != nil {
+			b.Fatal(err)
+		}
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			master, err := cache.Load("source")
+			if err != nil {
+				b.Fatal(err)
+			}
+			if err := master.Resize(&ImageResizeOptions{Width: width / 4, Height: height / 4, MaintainAspect: true}); err != nil {
+				b.Fatal(err)
+			}
+			if _, err := master.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 80}); err != nil {
+				b.Fatal(err)
+			}
+			master.Free()
+		}
+	})
+}
+
+// BenchmarkResultCacheHit measures a thumbnail request answered from a warm ResultCache,
+// to compare with the full render of BenchmarkResize above.
+func BenchmarkResultCacheHit(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		cache, err := NewResultCache(nil)
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer cache.Close()
+		out := &EncodeSpec{Format: FormatJPEG, JPEG: ImageEncodeJPEGOptions{Quality: 80}}
+		op := ResizeOp(&ImageResizeOptions{Width: width / 4, Height: height / 4, MaintainAspect: true})
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			if _, err := cache.Process(data, nil, out, op); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
+
+// BenchmarkFetchRegion reads 256x256 regions at scattered positions of a decoded image,
+// reusing one buffer. The rate is reported for the region, not the whole image.
+func BenchmarkFetchRegion(b *testing.B) {
+	for _, size := range benchSizes {
+		b.Run(fmt.Sprintf("%dx%d", size.width, size.height), func(b *testing.B) {
+			img, err := LoadImageFromBytes(sourceJPEG(b, size.width, size.height))
+			if err != nil {
+				b.Fatal(err)
+			}
+			defer img.Free()
+			// Decode once up front so the iterations measure region reads only
+			if _, err := img.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 10}); err != nil {
+				b.Fatal(err)
+			}
+			var buf []byte
+			b.ResetTimer()
+			for i := 0; i < b.N; i++ {
+				x := (i * 7919) % (size.width - 256)
+				y := (i * 104729) % (size.height - 256)
+				if buf, _, err = img.FetchRegion(x, y, 256, 256, buf); err != nil {
+					b.Fatal(err)
+				}
+			}
+			reportMPs(b, 256, 256)
+		})
+	}
+}
+
+// BenchmarkWriteTensor decodes a JPEG straight into a normalised CHW float tensor,
+// the replacement for an EncodeToPNG round trip in front of a model.
+func BenchmarkWriteTensor(b *testing.B) {
+	spec := &TensorSpec{
+		Order: TensorCHW,
+		Scale: 1.0 / 255,
+		Mean:  [4]float32{0.485, 0.456, 0.406},
+		Std:   [4]float32{0.229, 0.224, 0.225},
+	}
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		var tensor []float32
+		for i := 0; i < b.N; i++ {
+			img, err := LoadImageFromBytes(data)
+			if err != nil {
+				b.Fatal(err)
+			}
+			if tensor, err = img.WriteTensor(spec, tensor); err != nil {
+				b.Fatal(err)
+			}
+			img.Free()
+		}
+	})
+}
+
+func BenchmarkCrop(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.Crop(&ImageCropOptions{X: width / 4, Y: height / 4, Width: width / 2, Height: height / 2})
+		})
+	})
+}
+
+func BenchmarkRotate(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.Rotate(&ImageRotateOptions{Angle: 90})
+		})
+	})
+}
+
+// BenchmarkRotateArbitrary resamples, for comparison with the exact remap in BenchmarkRotate.
+func BenchmarkRotateArbitrary(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.Rotate(&ImageRotateOptions{Angle: 30})
+		})
+	})
+}
+
+func BenchmarkFlip(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.Flip(&ImageFlipOptions{Direction: FlipHorizontal})
+		})
+	})
+}
+
+func BenchmarkChangeOpacity(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.ChangeOpacity(&ImageOpacityOptions{Opacity: 0.5})
+		})
+	})
+}
+
+func BenchmarkWatermark(b *testing.B) {
+	mark, err := LoadImageFromBytes(sourceJPEG(b, 640, 480))
+	if err != nil {
+		b.Fatal(err)
+	}
+	defer mark.Free()
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.Watermark(mark, &ImageWatermarkOptions{X: 10, Y: 10, Opacity: 0.5})
+		})
+	})
+}
+
+// BenchmarkPreparedWatermark prepares the overlay once, for comparison with BenchmarkWatermark.
+func BenchmarkPreparedWatermark(b *testing.B) {
+	logo, err := LoadImageFromBytes(sourceJPEG(b, 640, 480))
+	if err != nil {
+		b.Fatal(err)
+	}
+	mark, err := PrepareWatermark(logo, 0.5, BlendOver)
+	logo.Free()
+	if err != nil {
+		b.Fatal(err)
+	}
+	defer mark.Free()
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.ApplyWatermark(mark, &WatermarkPlacement{X: 10, Y: 10})
+		})
+	})
+}
+
+func BenchmarkEncodeToJPEG(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		img, err := LoadImageFromBytes(data)
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer img.Free()
+		for i := 0; i < b.N; i++ {
+			if _, err := img.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 80}); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
+
+// BenchmarkSaveJPEG streams the encode to a file, for comparison with
+// BenchmarkEncodeToJPEG followed by os.WriteFile in BenchmarkWriteFileJPEG.
+func BenchmarkSaveJPEG(b *testing.B) {
+	spec := &EncodeSpec{Format: FormatJPEG, JPEG: ImageEncodeJPEGOptions{Quality: 80}}
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		img, err := LoadImageFromBytes(data)
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer img.Free()
+		path := filepath.Join(b.TempDir(), "out.jpg")
+		for i := 0; i < b.N; i++ {
+			if err := img.Save(path, spec); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
+
+func BenchmarkWriteFileJPEG(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		img, err := LoadImageFromBytes(data)
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer img.Free()
+		path := filepath.Join(b.TempDir(), "out.jpg")
+		for i := 0; i < b.N; i++ {
+			out, err := img.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 80})
+			if err != nil {
+				b.Fatal(err)
+			}
+			if err := os.WriteFile(path, out, 0o644); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
+
+// BenchmarkAppendJPEG reuses one output buffer, for comparison with BenchmarkEncodeToJPEG.
+func BenchmarkAppendJPEG(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		img, err := LoadImageFromBytes(data)
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer img.Free()
+		var buf []byte
+		for i := 0; i < b.N; i++ {
+			if buf, err = img.AppendJPEG(buf[:0], &ImageEncodeJPEGOptions{Quality: 80}); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
+
+func BenchmarkEncodeToPNG(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		img, err := LoadImageFromBytes(data)
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer img.Free()
+		for i := 0; i < b.N; i++ {
+			if _, err := img.EncodeToPNG(&ImageEncodePNGOptions{Compression: 6}); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
+
+// batchSize is the number of images per ProcessBatch call.
+const batchSize = 64
+
+// BenchmarkProcessBatch resizes and re-encodes batchSize copies of the source in one
+// call with one image per core, for comparison with BenchmarkProcessBatchSerial.
+func BenchmarkProcessBatch(b *testing.B) {
+	benchmarkBatch(b, 0)
+}
+
+// BenchmarkProcessBatchSerial runs the same batch one image at a time.
+func BenchmarkProcessBatchSerial(b *testing.B) {
+	benchmarkBatch(b, 1)
+}
+
+func benchmarkBatch(b *testing.B, parallelism int) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		items := make([]BatchItem, batchSize)
+		for i := range items {
+			items[i].Data = data
+		}
+		spec := &BatchSpec{
+			Load:   ImageLoadOptions{Access: AccessSequential},
+			Ops:    []PipelineOp{ResizeOp(&ImageResizeOptions{Width: width / 4, MaintainAspect: true})},
+			Output: EncodeSpec{Format: FormatJPEG, JPEG: ImageEncodeJPEGOptions{Quality: 80}},
+		}
+		for i := 0; i < b.N; i++ {
+			results, err := ProcessBatch(items, spec, parallelism)
+			if err != nil {
+				b.Fatal(err)
+			}
+			for _, result := range results {
+				if result.Err != nil {
+					b.Fatal(result.Err)
+				}
+			}
+		}
+		b.ReportMetric(float64(batchSize), "images/op")
+	})
+}
+
+// renditionWidths is a typical responsive-image width set.
+var renditionWidths = []int{1600, 1200, 800, 480, 320, 160}
+
+// BenchmarkRenditions encodes every rendition width from one decode, for comparison
+// with one thumbnail per width in BenchmarkRenditionsSeparate.
+func BenchmarkRenditions(b *testing.B) {
+	specs := make([]RenditionSpec, len(renditionWidths))
+	for i, width := range renditionWidths {
+		specs[i] = RenditionSpec{
+			Resize: ImageResizeOptions{Width: width, MaintainAspect: true},
+			Output: EncodeSpec{Format: FormatJPEG, JPEG: ImageEncodeJPEGOptions{Quality: 80}},
+		}
+	}
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		for i := 0; i < b.N; i++ {
+			if _, err := RenditionsFromBytes(data, specs); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
+
+func BenchmarkRenditionsSeparate(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		for i := 0; i < b.N; i++ {
+			for _, w := range renditionWidths {
+				img, err := ThumbnailFromBytes(data, &ImageResizeOptions{Width: w, MaintainAspect: true})
+				if err != nil {
+					b.Fatal(err)
+				}
+				if _, err := img.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 80}); err != nil {
+					b.Fatal(err)
+				}
+				img.Free()
+			}
+		}
+	})
+}
+
+// BenchmarkResizeToParallel decodes once and derives the rendition sizes from the
+// shared image on parallel goroutines, for comparison with BenchmarkRenditions.
+func BenchmarkResizeToParallel(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		for i := 0; i < b.N; i++ {
+			img, err := LoadImageFromBytes(data)
+			if err != nil {
+				b.Fatal(err)
+			}
+			var wg sync.WaitGroup
+			errs := make([]error, len(renditionWidths))
+			for j, w := range renditionWidths {
+				wg.Add(1)
+				go func(j, w int) {
+					defer wg.Done()
+					small, err := img.ResizeTo(&ImageResizeOptions{Width: w, MaintainAspect: true})
+					if err == nil {
+						_, err = small.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 80})
+						small.Free()
+					}
+					errs[j] = err
+				}(j, w)
+			}
+			wg.Wait()
+			img.Free()
+			for _, err := range errs {
+				if err != nil {
+					b.Fatal(err)
+				}
+			}
+		}
+	})
+}
+
+// BenchmarkMixedSizes runs mostly small requests with an occasional full-size one
+// in parallel, with the global concurrency and with the adaptive scheduler, and
+// reports the p99 latency of the small requests.
+func BenchmarkMixedSizes(b *testing.B) {
+	small := sourceJPEG(b, 640, 480)
+	large := sourceJPEG(b, 4000, 3000)
+	out := &EncodeSpec{Format: FormatJPEG, JPEG: ImageEncodeJPEGOptions{Quality: 80}}
+	modes := []struct {
+		name      string
+		scheduler *SchedulerOptions
+	}{
+		{"global", nil},
+		{"scheduler", &SchedulerOptions{PixelsPerThread: 2000000}},
+	}
+	for _, mode := range modes {
+		b.Run(mode.name, func(b *testing.B) {
+			SetScheduler(mode.scheduler)
+			defer SetScheduler(nil)
+
+			var mu sync.Mutex
+			var latencies []time.Duration
+			var n atomic.Int64
+			b.ResetTimer()
+			b.RunParallel(func(pb *testing.PB) {
+				for pb.Next() {
+					isSmall := n.Add(1)%8 != 0
+					data := small
+					if !isSmall {
+						data = large
+					}
+					start := time.Now()
+					img, err := LoadImageFromBytes(data)
+					if err != nil {
+						b.Fatal(err)
+					}
+					if _, err := img.Pipeline(out, ResizeOp(&ImageResizeOptions{Width: 320})); err != nil {
+						b.Fatal(err)
+					}
+					img.Free()
+					if isSmall {
+						mu.Lock()
+						latencies = append(latencies, time.Since(start))
+						mu.Unlock()
+					}
+				}
+			})
+			b.StopTimer()
+			if len(latencies) > 0 {
+				slices.Sort(latencies)
+				b.ReportMetric(float64(latencies[len(latencies)*99/100].Microseconds())/1000, "p99-small-ms")
+			}
+		})
+	}
+}
+
+// BenchmarkThumbnailCover crops squares after shrink-on-load, for comparison with
+// a full decode followed by Image.Cover in BenchmarkCover.
+func BenchmarkThumbnailCover(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		for i := 0; i < b.N; i++ {
+			img, err := ThumbnailCoverFromBytes(data, &ImageCoverOptions{Width: 400, Height: 400, Mode: CropAttention}, nil)
+			if err != nil {
+				b.Fatal(err)
+			}
+			if _, err := img.EncodeToJPEG(&ImageEncodeJPEGOptions{Quality: 80}); err != nil {
+				b.Fatal(err)
+			}
+			img.Free()
+		}
+	})
+}
+
+func BenchmarkCover(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			return img.Cover(&ImageCoverOptions{Width: 400, Height: 400, Mode: CropAttention})
+		})
+	})
+}
+
+// BenchmarkPipeline runs resize + crop + encode in one call, for comparison with
+// the same steps as separate method calls in BenchmarkChained.
+func BenchmarkPipeline(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		out := &EncodeSpec{Format: FormatJPEG, JPEG: ImageEncodeJPEGOptions{Quality: 80}}
+		for i := 0; i < b.N; i++ {
+			img, err := LoadImageFromBytes(data)
+			if err != nil {
+				b.Fatal(err)
+			}
+			_, err = img.Pipeline(out,
+				ResizeOp(&ImageResizeOptions{Width: width / 2, Height: height / 2}),
+				CropOp(&ImageCropOptions{Width: width / 4, Height: height / 4}))
+			if err != nil {
+				b.Fatal(err)
+			}
+			img.Free()
+		}
+	})
+}
+
+func BenchmarkChained(b *testing.B) {
+	forEachSize(b, func(b *testing.B, data []byte, width, height int) {
+		transform(b, data, func(img *Image) error {
+			if err := img.Resize(&ImageResizeOptions{Width: width / 2, Height: height / 2}); err != nil {
+				return err
+			}
+			return img.Crop(&ImageCropOptions{Width: width / 4, Height: height / 4})
+		})
+	})
+}
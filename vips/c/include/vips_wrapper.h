@@ -38,6 +38,7 @@
 #define IMAGE_SDK_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -69,9 +70,83 @@ typedef struct {
     char colorspace[32];    ///< Color space (e.g., "srgb", "cmyk")
     double density_x;       ///< Horizontal resolution in pixels per mm
     double density_y;       ///< Vertical resolution in pixels per mm
-    long file_size;         ///< File size in bytes (0 if not from file)
+    long file_size;         ///< Encoded size in bytes (set by the probe functions, 0 otherwise)
+    int orientation;        ///< EXIF orientation 1-8 (1 if absent or already applied by `autorotate`)
+    int has_alpha;          ///< Non-zero if the image has an alpha channel
+    int pages;              ///< Number of pages or animation frames (1 for single images)
+    int has_icc;            ///< Non-zero if an ICC profile is embedded
+    int frames;             ///< Frames stacked in this image (see ImageLoadOptions `n`); each is height / frames tall
 } ImageMeta;
 
+/**
+ * @brief Pixel access pattern requested from the loader
+ * 
+ * Sequential access lets libvips stream the file top to bottom and keep only
+ * a strip of decoded pixels in memory, instead of caching the whole image.
+ */
+typedef enum {
+    IMAGE_ACCESS_RANDOM = 0,        ///< Pixels may be read in any order (default)
+    IMAGE_ACCESS_SEQUENTIAL = 1     ///< Pixels are read once, top to bottom
+} ImageAccess;
+
+/**
+ * @brief How strictly the loader treats damaged files
+ */
+typedef enum {
+    IMAGE_FAIL_ON_NONE = 0,         ///< Decode whatever can be decoded (default)
+    IMAGE_FAIL_ON_TRUNCATED,        ///< Reject truncated files
+    IMAGE_FAIL_ON_ERROR,            ///< Reject files with decode errors
+    IMAGE_FAIL_ON_WARNING           ///< Reject files with anything unusual
+} ImageFailOn;
+
+/**
+ * @brief Options for image loading
+ * 
+ * The limits guard against decompression bombs: they are checked against the
+ * encoded size and the image header before any pixel memory is allocated, and
+ * a load exceeding one fails with IMAGE_TOO_LARGE. A zero limit is unlimited.
+ * 
+ * @example Stream a large TIFF through resize and encode:
+ * @code
+ * ImageLoadOptions opts = {IMAGE_ACCESS_SEQUENTIAL};
+ * VImageHandle img = load_image_with_options("master.tif", opts, NULL);
+ * @endcode
+ * 
+ * @example Accept untrusted uploads of up to 20MB and 50 megapixels:
+ * @code
+ * ImageLoadOptions opts = {IMAGE_ACCESS_SEQUENTIAL, 16384, 16384, 50000000, 20 << 20, IMAGE_FAIL_ON_ERROR};
+ * @endcode
+ * 
+ * @example Load every frame of an animated GIF or WebP:
+ * @code
+ * ImageLoadOptions opts = {IMAGE_ACCESS_SEQUENTIAL};
+ * opts.n = -1;
+ * @endcode
+ * 
+ * @note Multi-page loads stack the pages top to bottom in one tall image (the
+ *       frame height is in ImageMeta `frames`). resize, crop, rotate, flip, cover
+ *       and the watermark operations work frame by frame, and encode_to_webp()
+ *       and encode_to_gif() write the frames as an animation. Encoders without
+ *       animation support write the whole stack as one tall image
+ * @note `page` and `n` are ignored by single-page formats, except that a `page`
+ *       beyond the first fails with IMAGE_INVALID_BOUNDS
+ * @note `autorotate` turns and mirrors the pixels to the EXIF orientation and resets
+ *       the tag to 1. Mirrored-only images (orientation 2) stay sequential; the other
+ *       orientations read pixels out of order, so a sequential load of such an image
+ *       is decoded into memory during the load
+ */
+typedef struct {
+    ImageAccess access;     ///< Access pattern (IMAGE_ACCESS_RANDOM if zero-initialized)
+    int max_width;          ///< Reject wider images; 0 = no limit
+    int max_height;         ///< Reject taller images; 0 = no limit
+    uint64_t max_pixels;    ///< Reject images with more pixels (width * height); 0 = no limit
+    uint64_t max_bytes;     ///< Reject larger encoded inputs; 0 = no limit
+    ImageFailOn fail_on;    ///< Strictness towards damaged files
+    int autorotate;         ///< Non-zero to apply the EXIF orientation to the pixels
+    int page;               ///< First page or frame to load (0-based)
+    int n;                  ///< Pages to load from `page` on: 0 or 1 = one, -1 = all
+} ImageLoadOptions;
+
 /**
  * @brief Options for image resizing operations
  * 
@@ -132,6 +207,91 @@ typedef struct {
     double opacity;         ///< Opacity level (0.0=transparent, 1.0=opaque)
 } ImageWatermarkOptions;
 
+/**
+ * @brief Blend modes for prepared watermarks
+ * 
+ * The separable modes of the PDF specification; all of them keep an opaque
+ * base image opaque.
+ */
+typedef enum {
+    IMAGE_BLEND_OVER = 0,           ///< Plain alpha compositing (default)
+    IMAGE_BLEND_MULTIPLY,           ///< Darkens: base * mark
+    IMAGE_BLEND_SCREEN,             ///< Lightens: inverse of multiply
+    IMAGE_BLEND_OVERLAY,            ///< Multiply or screen depending on the base
+    IMAGE_BLEND_DARKEN,             ///< Darker of base and mark
+    IMAGE_BLEND_LIGHTEN,            ///< Lighter of base and mark
+    IMAGE_BLEND_HARD_LIGHT,         ///< Multiply or screen depending on the mark
+    IMAGE_BLEND_SOFT_LIGHT,         ///< Gentle darken or lighten depending on the mark
+    IMAGE_BLEND_DIFFERENCE,         ///< Absolute difference
+    IMAGE_BLEND_EXCLUSION           ///< Lower-contrast difference
+} ImageBlendMode;
+
+/**
+ * @brief Where a prepared watermark is placed on the base image
+ */
+typedef enum {
+    IMAGE_GRAVITY_NONE = 0,         ///< x/y are absolute coordinates, as in watermark_image()
+    IMAGE_GRAVITY_NORTH_WEST,       ///< Top-left corner
+    IMAGE_GRAVITY_NORTH,            ///< Top edge, centred horizontally
+    IMAGE_GRAVITY_NORTH_EAST,       ///< Top-right corner
+    IMAGE_GRAVITY_WEST,             ///< Left edge, centred vertically
+    IMAGE_GRAVITY_CENTRE,           ///< Centre of the image
+    IMAGE_GRAVITY_EAST,             ///< Right edge, centred vertically
+    IMAGE_GRAVITY_SOUTH_WEST,       ///< Bottom-left corner
+    IMAGE_GRAVITY_SOUTH,            ///< Bottom edge, centred horizontally
+    IMAGE_GRAVITY_SOUTH_EAST,       ///< Bottom-right corner
+    IMAGE_GRAVITY_TILE              ///< Repeated across the whole image
+} ImageGravity;
+
+/**
+ * @brief Placement of a prepared watermark
+ * 
+ * @example Bottom-right logo, 20px from the edges, a quarter of the image wide:
+ * @code
+ * ImageWatermarkPlacement place = {IMAGE_GRAVITY_SOUTH_EAST, 20, 20, 0.25};
+ * @endcode
+ */
+typedef struct {
+    ImageGravity gravity;   ///< Anchor (IMAGE_GRAVITY_NONE if zero-initialized)
+    int x;                  ///< Absolute x (NONE), margin from the anchored edge (shift when centred), or grid offset (TILE)
+    int y;                  ///< Absolute y (NONE), margin from the anchored edge (shift when centred), or grid offset (TILE)
+    double width_fraction;  ///< Watermark width relative to the base width; 0 = natural size
+} ImageWatermarkPlacement;
+
+/**
+ * @brief How cover_image() and the cover thumbnails choose the crop window
+ */
+typedef enum {
+    IMAGE_CROP_CENTRE = 0,          ///< Keep the centre (default)
+    IMAGE_CROP_ATTENTION,           ///< Keep the region most likely to draw the eye (skin, saturation, edges)
+    IMAGE_CROP_ENTROPY,             ///< Keep the region with the most detail
+    IMAGE_CROP_GRAVITY              ///< Keep the edge or corner named by `gravity`
+} ImageCropMode;
+
+/**
+ * @brief Options for cover-fit resizing
+ * 
+ * The image is scaled to cover width x height and the overflow along one axis
+ * is cropped, so the result is always exactly width x height.
+ * 
+ * @example Square avatar that keeps faces in frame:
+ * @code
+ * ImageCoverOptions opts = {256, 256, IMAGE_CROP_ATTENTION};
+ * ImageStatus result = cover_image(handle, opts);
+ * @endcode
+ * 
+ * @example Banner that keeps the top of the image:
+ * @code
+ * ImageCoverOptions opts = {1200, 400, IMAGE_CROP_GRAVITY, IMAGE_GRAVITY_NORTH};
+ * @endcode
+ */
+typedef struct {
+    int width;              ///< Output width in pixels (required)
+    int height;             ///< Output height in pixels (required)
+    ImageCropMode mode;     ///< How the crop window is chosen
+    ImageGravity gravity;   ///< Kept edge or corner for IMAGE_CROP_GRAVITY; NONE and TILE mean centre
+} ImageCoverOptions;
+
 /**
  * @brief Options for opacity adjustment
  * 
@@ -145,6 +305,30 @@ typedef struct {
     double opacity;         ///< Overall opacity (0.0=transparent, 1.0=opaque)
 } ImageOpacityOptions;
 
+/**
+ * @brief Rendering intent for ICC conversions
+ */
+typedef enum {
+    IMAGE_INTENT_RELATIVE = 0,      ///< Relative colorimetric (default)
+    IMAGE_INTENT_PERCEPTUAL,        ///< Perceptual: compress out-of-gamut colours smoothly
+    IMAGE_INTENT_SATURATION,        ///< Saturation: keep colours vivid
+    IMAGE_INTENT_ABSOLUTE           ///< Absolute colorimetric: keep the white point
+} ImageIntent;
+
+/**
+ * @brief Options for conversion to 8-bit sRGB
+ * 
+ * @example Convert with the perceptual intent, keeping the sRGB profile:
+ * @code
+ * ImageSRGBOptions opts = {1, IMAGE_INTENT_PERCEPTUAL};
+ * ImageStatus result = ensure_srgb8(handle, opts);
+ * @endcode
+ */
+typedef struct {
+    int keep_profile;       ///< Non-zero to keep the sRGB ICC profile after an ICC conversion; 0 strips it
+    ImageIntent intent;     ///< Intent for ICC conversions
+} ImageSRGBOptions;
+
 /**
  * @brief Options for image rotation
  * 
@@ -164,9 +348,47 @@ typedef struct {
     double angle;           ///< Rotation angle in degrees (positive=clockwise)
 } ImageRotateOptions;
 
+/**
+ * @brief Mirror axis for flip_image()
+ */
+typedef enum {
+    IMAGE_FLIP_HORIZONTAL = 0,      ///< Mirror left to right
+    IMAGE_FLIP_VERTICAL             ///< Mirror top to bottom
+} ImageFlipDirection;
+
+/**
+ * @brief Options for image flipping
+ * 
+ * @example Mirror a selfie:
+ * @code
+ * ImageFlipOptions opts = {IMAGE_FLIP_HORIZONTAL};
+ * ImageStatus result = flip_image(handle, opts);
+ * @endcode
+ */
+typedef struct {
+    ImageFlipDirection direction;   ///< Mirror axis
+} ImageFlipOptions;
+
+/**
+ * @brief Chroma subsampling choice for encoders that support it
+ */
+typedef enum {
+    IMAGE_SUBSAMPLE_AUTO = 0,       ///< Let the encoder decide (subsample below high quality)
+    IMAGE_SUBSAMPLE_ON,             ///< Always subsample chroma (4:2:0), smaller files
+    IMAGE_SUBSAMPLE_OFF             ///< Never subsample chroma (4:4:4), sharper colour edges
+} ImageSubsample;
+
 /**
  * @brief JPEG encoding options
  * 
+ * Only `quality` and `interlace` are read unless `version` is set to
+ * IMAGE_ENCODE_JPEG_OPTIONS_VERSION; this keeps `{quality, interlace}`
+ * initialisers written against the original struct working unchanged, and
+ * lets later fields be added without reinterpreting older callers.
+ * 
+ * The trellis/deringing/scan/quant-table controls need libvips built against
+ * mozjpeg and are ignored by plain libjpeg.
+ * 
  * @example High quality JPEG:
  * @code
  * ImageEncodeJPEGOptions opts = {95, 1}; // 95% quality, interlaced
@@ -178,12 +400,40 @@ typedef struct {
  * ImageEncodeJPEGOptions opts = {75, 0}; // 75% quality, progressive
  * ImageBuffer result = encode_to_jpeg(handle, opts);
  * @endcode
+ * 
+ * @example Smallest output, tuned from a preset:
+ * @code
+ * ImageEncodeJPEGOptions opts = jpeg_options_preset(IMAGE_JPEG_PRESET_SMALLEST, 80);
+ * opts.subsample = IMAGE_SUBSAMPLE_OFF; // keep chroma for text-heavy images
+ * ImageBuffer result = encode_to_jpeg(handle, opts);
+ * @endcode
  */
 typedef struct {
-    int quality;            ///< JPEG quality (1-100, higher=better quality)
-    int interlace;          ///< 1 for progressive JPEG, 0 for baseline
+    int quality;                ///< JPEG quality (1-100, higher=better quality)
+    int interlace;              ///< 1 for progressive JPEG, 0 for baseline
+    int version;                ///< 0 (quality/interlace only) or IMAGE_ENCODE_JPEG_OPTIONS_VERSION
+    int optimize_coding;        ///< 1 to compute optimal Huffman tables (smaller, slightly slower)
+    int trellis_quant;          ///< 1 for trellis quantisation (mozjpeg)
+    int overshoot_deringing;    ///< 1 to reduce ringing on black-on-white edges (mozjpeg)
+    int optimize_scans;         ///< 1 to pick progressive scans by size, needs interlace (mozjpeg)
+    int quant_table;            ///< Quantisation table 0-8, 3 suits photos (mozjpeg; 0 is standard)
+    ImageSubsample subsample;   ///< Chroma subsampling
+    int strip;                  ///< 1 to drop EXIF/XMP/ICC metadata
 } ImageEncodeJPEGOptions;
 
+/// Current layout version of ImageEncodeJPEGOptions
+#define IMAGE_ENCODE_JPEG_OPTIONS_VERSION 2
+
+/**
+ * @brief Ready-made JPEG encoder trade-offs
+ */
+typedef enum {
+    IMAGE_JPEG_PRESET_DEFAULT = 0,  ///< libjpeg defaults, metadata kept
+    IMAGE_JPEG_PRESET_FAST,         ///< Lowest encode CPU: baseline, no extra passes, metadata stripped
+    IMAGE_JPEG_PRESET_BALANCED,     ///< Optimised Huffman tables and stripped metadata, little CPU cost
+    IMAGE_JPEG_PRESET_SMALLEST      ///< All mozjpeg size tools, progressive, 4:2:0, metadata stripped
+} ImageJPEGPreset;
+
 /**
  * @brief PNG encoding options
  * 
@@ -204,6 +454,131 @@ typedef struct {
     int interlace;          ///< 1 for interlaced PNG, 0 for standard
 } ImageEncodePNGOptions;
 
+/**
+ * @brief WebP encoding options
+ * 
+ * @example Fast lossy WebP for thumbnails:
+ * @code
+ * ImageEncodeWebPOptions opts = {80, 0, 1, 0, 1}; // Q80, lossy, effort 1, strip metadata
+ * ImageBuffer result = encode_to_webp(handle, opts);
+ * @endcode
+ */
+typedef struct {
+    int quality;            ///< Quality (1-100, other values select 75)
+    int lossless;           ///< 1 for lossless compression
+    int effort;             ///< CPU effort (0=fastest ... 6=smallest, other values select 4)
+    int smart_subsample;    ///< 1 for sharper chroma at some CPU cost
+    int strip;              ///< 1 to drop EXIF/XMP/ICC metadata
+} ImageEncodeWebPOptions;
+
+/**
+ * @brief HEIF (HEVC) encoding options
+ * 
+ * @example
+ * @code
+ * ImageEncodeHEIFOptions opts = {50, 0, 4, IMAGE_SUBSAMPLE_AUTO, 1};
+ * ImageBuffer result = encode_to_heif(handle, opts);
+ * @endcode
+ */
+typedef struct {
+    int quality;                ///< Quality (1-100, other values select 50)
+    int lossless;               ///< 1 for lossless compression
+    int effort;                 ///< CPU effort (0=fastest ... 9=smallest, other values select 4)
+    ImageSubsample subsample;   ///< Chroma subsampling
+    int strip;                  ///< 1 to drop EXIF/XMP/ICC metadata
+} ImageEncodeHEIFOptions;
+
+/**
+ * @brief AVIF encoding options
+ * 
+ * Same fields as ImageEncodeHEIFOptions; AVIF is HEIF with AV1 compression.
+ * 
+ * @example Balanced AVIF for the CDN:
+ * @code
+ * ImageEncodeAVIFOptions opts = {55, 0, 2, IMAGE_SUBSAMPLE_ON, 1};
+ * ImageBuffer result = encode_to_avif(handle, opts);
+ * @endcode
+ */
+typedef ImageEncodeHEIFOptions ImageEncodeAVIFOptions;
+
+/**
+ * @brief JPEG XL encoding options
+ * 
+ * @example
+ * @code
+ * ImageEncodeJXLOptions opts = {75, 0, 3, 1}; // Q75, lossy, effort 3, strip metadata
+ * ImageBuffer result = encode_to_jxl(handle, opts);
+ * @endcode
+ */
+typedef struct {
+    int quality;            ///< Quality (1-100, other values select 75)
+    int lossless;           ///< 1 for lossless compression
+    int effort;             ///< CPU effort (1=fastest ... 9=smallest, other values select 7)
+    int strip;              ///< 1 to drop EXIF/XMP/ICC metadata
+} ImageEncodeJXLOptions;
+
+/**
+ * @brief GIF encoding options
+ * 
+ * Multi-frame images are written as animations, keeping the loaded frame
+ * delays and loop count.
+ * 
+ * @example Small animated thumbnail:
+ * @code
+ * ImageEncodeGIFOptions opts = {4, 6}; // effort 4, 64 colours
+ * ImageBuffer result = encode_to_gif(handle, opts);
+ * @endcode
+ */
+typedef struct {
+    int effort;             ///< CPU effort for palette search (1=fastest ... 10=best, other values select 7)
+    int bitdepth;           ///< Bits per palette index (1-8, other values select 8 = 256 colours)
+} ImageEncodeGIFOptions;
+
+/**
+ * @brief Callback that returns a zero-copy input buffer to its owner
+ * 
+ * @param data The buffer that was passed to load_image_from_owned_bytes()
+ * @param user_data The opaque pointer that was passed alongside it
+ */
+typedef void (*ImageBufferReleaseFn)(void* data, void* user_data);
+
+/**
+ * @brief Output formats understood by the encode-spec based APIs
+ */
+typedef enum {
+    IMAGE_FORMAT_NONE = 0,          ///< Do not encode
+    IMAGE_FORMAT_JPEG,              ///< JPEG, options in ImageEncodeSpec.jpeg
+    IMAGE_FORMAT_PNG,               ///< PNG, options in ImageEncodeSpec.png
+    IMAGE_FORMAT_WEBP,              ///< WebP, options in ImageEncodeSpec.webp
+    IMAGE_FORMAT_AVIF,              ///< AVIF, options in ImageEncodeSpec.avif
+    IMAGE_FORMAT_JXL,               ///< JPEG XL, options in ImageEncodeSpec.jxl
+    IMAGE_FORMAT_HEIF,              ///< HEIF (HEVC), options in ImageEncodeSpec.heif
+    IMAGE_FORMAT_GIF                ///< GIF, options in ImageEncodeSpec.gif
+} ImageFormat;
+
+/**
+ * @brief Output format plus the options of its encoder
+ * 
+ * Only the options field matching `format` is read.
+ * 
+ * @example
+ * @code
+ * ImageEncodeSpec out = {0};
+ * out.format = IMAGE_FORMAT_JPEG;
+ * out.jpeg = (ImageEncodeJPEGOptions){85, 1};
+ * @endcode
+ */
+typedef struct {
+    ImageFormat format;             ///< Output format
+    ImageEncodeJPEGOptions jpeg;    ///< Used when format is IMAGE_FORMAT_JPEG
+    ImageEncodePNGOptions png;      ///< Used when format is IMAGE_FORMAT_PNG
+    ImageEncodeWebPOptions webp;    ///< Used when format is IMAGE_FORMAT_WEBP
+    ImageEncodeAVIFOptions avif;    ///< Used when format is IMAGE_FORMAT_AVIF
+    ImageEncodeJXLOptions jxl;      ///< Used when format is IMAGE_FORMAT_JXL
+    ImageEncodeHEIFOptions heif;    ///< Used when format is IMAGE_FORMAT_HEIF
+    ImageEncodeGIFOptions gif;      ///< Used when format is IMAGE_FORMAT_GIF
+} ImageEncodeSpec;
+
 /**
  * @brief Encoded image data buffer
  * 
@@ -226,6 +601,69 @@ typedef struct {
     size_t size;            ///< Size of data in bytes
 } ImageBuffer;
 
+/**
+ * @brief Callback receiving encoded image bytes as they are produced
+ * 
+ * @param data Pointer to the next chunk of encoded bytes (valid only during the call)
+ * @param size Size of the chunk in bytes
+ * @param user_data The opaque pointer from ImageWriter
+ * @return Number of bytes consumed (normally `size`), or -1 to abort the encode
+ */
+typedef long long (*ImageWriteFn)(const void* data, size_t size, void* user_data);
+
+/**
+ * @brief Streaming destination for encoded image data
+ * 
+ * @example Stream a JPEG to a socket:
+ * @code
+ * static long long write_socket(const void* data, size_t size, void* user_data) {
+ *     return send(*(int*)user_data, data, size, 0);
+ * }
+ * 
+ * ImageWriter writer = {write_socket, &client_fd};
+ * ImageStatus status = encode_to_jpeg_writer(handle, (ImageEncodeJPEGOptions){85, 1}, writer);
+ * @endcode
+ */
+typedef struct {
+    ImageWriteFn write;     ///< Called for each encoded chunk, in order
+    void* user_data;        ///< Passed through to `write`
+} ImageWriter;
+
+/**
+ * @brief Three-state switch for runtime features
+ */
+typedef enum {
+    RUNTIME_SWITCH_DEFAULT = 0,     ///< Leave libvips' own setting unchanged
+    RUNTIME_SWITCH_ON,              ///< Force the feature on
+    RUNTIME_SWITCH_OFF              ///< Force the feature off
+} RuntimeSwitch;
+
+/**
+ * @brief Process-wide libvips runtime settings
+ * 
+ * Zero-initialised fields leave the corresponding libvips default in place,
+ * so only the settings of interest need to be filled in. These settings are
+ * global to the process and shared by all callers.
+ * 
+ * @example One libvips thread per pipeline, bounded operation cache:
+ * @code
+ * RuntimeConfig config = {};
+ * config.concurrency = 1;               // Go workers provide the parallelism
+ * config.cache_max = 100;               // at most 100 cached operations
+ * config.cache_max_mem = 64 << 20;      // ... holding at most 64 MB
+ * vips_wrapper_init_ex(&config);
+ * @endcode
+ */
+typedef struct {
+    int concurrency;            ///< Worker threads per pipeline (0 = libvips default / VIPS_CONCURRENCY)
+    int cache_max;              ///< Max cached operations (0 = libvips default)
+    size_t cache_max_mem;       ///< Max memory held by cached operations in bytes (0 = libvips default)
+    int cache_max_files;        ///< Max files held open by cached operations (0 = libvips default)
+    int cache_disable;          ///< 1 to disable the operation cache, overriding the limits above
+    RuntimeSwitch vector;       ///< SIMD (Highway/orc) code paths
+    RuntimeSwitch leak_check;   ///< Reference leak reporting at shutdown (debug builds)
+} RuntimeConfig;
+
 //=============================================================================
 // STATUS CODES AND ERROR HANDLING
 //=============================================================================
@@ -267,7 +705,12 @@ typedef enum {
     IMAGE_INVALID_DIMENSIONS,       ///< Invalid width/height parameters
     IMAGE_INVALID_POSITION,         ///< Invalid x/y coordinates
     IMAGE_INVALID_BOUNDS,           ///< Operation exceeds image boundaries
-    IMAGE_SAVE_FAILURE              ///< Failed to save image to file
+    IMAGE_SAVE_FAILURE,             ///< Failed to save image to file
+    IMAGE_BUFFER_TOO_SMALL,         ///< Caller-provided output buffer is too small
+    IMAGE_QUEUE_FULL,               ///< Worker pool queue is full, job rejected
+    IMAGE_TOO_LARGE,                ///< Input exceeds a configured size or pixel limit
+    IMAGE_CACHE_MISS,               ///< Key not present in the raw pixel cache
+    IMAGE_CANCELLED                 ///< Cancelled through its cancel token, or past its deadline
 } ImageStatus;
 
 //=============================================================================
@@ -297,6 +740,82 @@ typedef enum {
  */
 int vips_wrapper_init();
 
+/**
+ * @brief Initialize the Image SDK with runtime settings
+ * 
+ * Same as vips_wrapper_init(), then applies `config`. Use this to stop
+ * N application workers x libvips' default thread count from
+ * oversubscribing the CPU, and to bound the operation cache.
+ * 
+ * @param config Runtime settings, or NULL for libvips defaults
+ * @return SUCCESS on successful initialization, VIPS_INIT_FAILURE otherwise
+ * 
+ * @example
+ * @code
+ * RuntimeConfig config = {};
+ * config.concurrency = 2;
+ * config.cache_disable = 1;
+ * if (vips_wrapper_init_ex(&config) != SUCCESS) {
+ *     return -1;
+ * }
+ * @endcode
+ * 
+ * @note Settings can be changed later with the vips_wrapper_set_* functions
+ */
+int vips_wrapper_init_ex(const RuntimeConfig* config);
+
+/**
+ * @brief Set the number of worker threads each pipeline may use
+ * 
+ * Takes effect for pipelines started after the call.
+ * 
+ * @param concurrency Threads per pipeline, or 0 for the libvips default
+ */
+void vips_wrapper_set_concurrency(int concurrency);
+
+/**
+ * @brief Set the maximum number of operations in the libvips operation cache
+ * @param max Maximum cached operations; 0 disables caching
+ */
+void vips_wrapper_set_cache_max(int max);
+
+/**
+ * @brief Set the maximum memory held by the libvips operation cache
+ * @param max_mem Maximum cache memory in bytes; 0 disables caching
+ */
+void vips_wrapper_set_cache_max_mem(size_t max_mem);
+
+/**
+ * @brief Set the maximum number of files held open by the libvips operation cache
+ * @param max_files Maximum open files; 0 disables caching of file operations
+ */
+void vips_wrapper_set_cache_max_files(int max_files);
+
+/**
+ * @brief Enable or disable libvips' SIMD (Highway/orc) code paths
+ * @param enabled Non-zero to enable
+ */
+void vips_wrapper_set_vector_enabled(int enabled);
+
+/**
+ * @brief Enable or disable libvips reference leak reporting
+ * @param enabled Non-zero to report leaked objects at shutdown
+ * @note Adds bookkeeping to every operation; intended for test builds
+ */
+void vips_wrapper_set_leak_check(int enabled);
+
+/**
+ * @brief Read the runtime settings currently in effect
+ * 
+ * Fills every field with the live libvips value, so the result can be logged
+ * or passed back to vips_wrapper_init_ex().
+ * 
+ * @param config Output settings
+ * @note `leak_check` cannot be queried from libvips and is reported as RUNTIME_SWITCH_DEFAULT
+ *       unless it was set through this SDK
+ */
+void vips_wrapper_get_runtime_config(RuntimeConfig* config);
+
 /**
  * @brief Clean up SDK resources
  * 
@@ -324,6 +843,17 @@ void vips_wrapper_cleanup();
  * 
  * Represents a loaded image in memory that can be efficiently processed
  * through multiple operations without reloading from disk.
+ * 
+ * Thread safety:
+ * - Functions that only read a handle (extract_metadata(), the encoders,
+ *   clone_vimage_handle(), the `*_to` transforms, process_pipeline() with an
+ *   output format, submit_job()) may run on the same handle from any number of
+ *   threads at once, provided it was loaded with IMAGE_ACCESS_RANDOM.
+ * - In-place transforms (resize_image(), crop_image(), ...) and
+ *   free_vimage_handle() replace or release the image and need exclusive use
+ *   of that handle; other handles sharing the same pixels are unaffected.
+ * - A handle loaded with IMAGE_ACCESS_SEQUENTIAL can be read only once and
+ *   must not be shared.
  */
 typedef void* VImageHandle;
 
@@ -360,6 +890,7 @@ typedef void* VImageHandle;
  * @endcode
  * 
  * @note Supported formats: JPEG, PNG, TIFF, WebP, GIF, and many others
+ * @note No size limits are applied; use load_image_with_options() for untrusted input
  * @warning Always check return value for NULL before using the handle
  */
 VImageHandle load_image(const char* input_path);
@@ -400,50 +931,304 @@ VImageHandle load_image(const char* input_path);
  * @endcode
  * 
  * @note Supports the same formats as load_image: JPEG, PNG, TIFF, WebP, GIF, etc.
- * @note The byte buffer is copied internally, so the original data can be freed after this call
+ * @note The byte buffer is NOT copied: it must stay valid and unmodified until the handle
+ *       and every image derived from it have been freed. Use load_image_from_owned_bytes()
+ *       to have the library tell you when the buffer may be released.
  * @warning Always check return value for NULL before using the handle
  */
 VImageHandle load_image_from_bytes(const unsigned char* data, size_t size);
 
 /**
- * @brief Free a VImage handle
+ * @brief Load an image from file with explicit loader options
  * 
- * Releases the memory associated with a VImage handle. The handle becomes
- * invalid after this call and should not be used.
+ * Same as load_image(), but lets the caller pick the pixel access pattern.
+ * Use IMAGE_ACCESS_SEQUENTIAL for pipelines that read the image once from top
+ * to bottom (resize, crop, opacity and watermark chains followed by an encode):
+ * peak memory then grows with the width of the image rather than its area.
  * 
- * @param handle The VImageHandle to free (can be NULL)
+ * @param input_path Path to the image file to load
+ * @param options Loader options (access pattern, limits, strictness)
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle on success, NULL on failure; the status is IMAGE_TOO_LARGE
+ *         if the file or its header exceeds one of the limits
  * 
- * @example
+ * @example Streaming resize:
  * @code
- * VImageHandle img = load_image("photo.jpg");
+ * ImageLoadOptions load_opts = {IMAGE_ACCESS_SEQUENTIAL};
+ * VImageHandle img = load_image_with_options("large.png", load_opts, NULL);
  * if (img) {
- *     // ... process image ...
- *     free_vimage_handle(img); // Always free when done
- *     img = NULL; // Good practice to avoid accidental reuse
+ *     ImageResizeOptions resize_opts = {1, 1024, 0};
+ *     resize_image(img, resize_opts);
+ *     ImageBuffer result = encode_to_jpeg(img, (ImageEncodeJPEGOptions){85, 0});
+ *     free_image_buffer(result);
+ *     free_vimage_handle(img);
  * }
  * @endcode
  * 
- * @note It's safe to pass NULL to this function
- * @warning Do not use the handle after calling this function
+ * @note rotate_image() and vertical flip_image() need random access; a sequentially
+ *       loaded image is rendered into memory once before it is rotated or flipped
+ * @note `.v` files (see save_image()) are mapped rather than decoded: pixels are paged
+ *       in as they are read, in any order, and the access pattern is ignored
+ * @warning A sequentially loaded image can be encoded only once
  */
-void free_vimage_handle(VImageHandle handle);
+VImageHandle load_image_with_options(const char* input_path, ImageLoadOptions options, ImageStatus* status);
 
 /**
- * @brief Free an ImageBuffer
- *
- * Releases the memory associated with an ImageBuffer. The buffer's data
- * becomes invalid after this call.
- *
- * @param buffer The ImageBuffer to free.
- *
- * @example
+ * @brief Load an image from byte buffer with explicit loader options
+ * 
+ * Buffer counterpart of load_image_with_options().
+ * 
+ * @param data Pointer to the image data bytes
+ * @param size Size of the image data in bytes
+ * @param options Loader options (access pattern, limits, strictness)
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle on success, NULL on failure (IMAGE_TOO_LARGE over a limit)
+ * 
+ * @note The same buffer lifetime rules as load_image_from_bytes() apply
+ */
+VImageHandle load_image_from_bytes_with_options(const unsigned char* data, size_t size,
+                                                ImageLoadOptions options, ImageStatus* status);
+
+/**
+ * @brief Load an image from byte buffer without copying, transferring buffer ownership
+ * 
+ * Decodes directly from the caller's memory. Ownership of the buffer passes to
+ * the library on entry: the caller must not modify or free it until `release`
+ * is called. `release` is invoked exactly once, either when libvips closes the
+ * last image that reads from the buffer or, if loading fails, before this
+ * function returns.
+ * 
+ * @param data Pointer to the image data bytes
+ * @param size Size of the image data in bytes
+ * @param options Loader options (access pattern, limits, strictness)
+ * @param release Callback that hands the buffer back to its owner (required)
+ * @param user_data Opaque pointer passed through to `release`
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle on success, NULL on failure
+ * 
+ * @example Decode an upload without copying it:
  * @code
- * ImageBuffer img_buffer = load_image_to_buffer("photo.png");
- * if (img_buffer.data) {
- *     // ... process image buffer ...
- *     free_image_buffer(img_buffer); // Always free when done
- *     img_buffer.data = nullptr; // Good practice to avoid accidental reuse
- *     img_buffer.size = 0;
+ * static void release_upload(void* data, void* user_data) {
+ *     free(data);
+ * }
+ * 
+ * VImageHandle img = load_image_from_owned_bytes(upload, upload_size,
+ *                                                (ImageLoadOptions){IMAGE_ACCESS_SEQUENTIAL},
+ *                                                release_upload, NULL, NULL);
+ * // upload now belongs to the library; do not touch it again
+ * @endcode
+ * 
+ * @note The buffer may outlive free_vimage_handle() while other handles (e.g. a
+ *       watermarked base image) or the libvips operation cache still reference it
+ * @note `release` may be called from any thread
+ * @warning Passing a NULL `release` fails and leaves ownership with the caller
+ */
+VImageHandle load_image_from_owned_bytes(const unsigned char* data, size_t size,
+                                         ImageLoadOptions options,
+                                         ImageBufferReleaseFn release, void* user_data,
+                                         ImageStatus* status);
+
+/**
+ * @brief Load an image from file, shrinking it to the target size during decode
+ * 
+ * Combines load_image() and resize_image() into a single operation. The target
+ * size is pushed down into the loader (JPEG DCT shrink, WebP/HEIF scale-on-load,
+ * PDF/SVG render scale), so a large source is never fully decoded. The returned
+ * handle can be chained like any other handle.
+ * 
+ * @param input_path Path to the image file to load
+ * @param options Resize parameters (dimensions and aspect ratio settings)
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle on success, NULL on failure
+ * 
+ * @example Fit a 24MP photo into 400x400:
+ * @code
+ * ImageResizeOptions opts = {1, 400, 400};
+ * VImageHandle thumb = thumbnail_from_path("large_photo.jpg", opts, NULL);
+ * if (thumb) {
+ *     ImageBuffer result = encode_to_jpeg(thumb, (ImageEncodeJPEGOptions){80, 0});
+ *     free_image_buffer(result);
+ *     free_vimage_handle(thumb);
+ * }
+ * @endcode
+ * 
+ * @note Produces the same dimensions as load_image() followed by resize_image()
+ * @note EXIF orientation is not applied, matching load_image(); use
+ *       thumbnail_from_path_with_options() with `autorotate` to apply it
+ * @note The source is always read sequentially
+ * @warning At least one of width/height must be positive
+ */
+VImageHandle thumbnail_from_path(const char* input_path, ImageResizeOptions options, ImageStatus* status);
+
+/**
+ * @brief Load a thumbnail from file with explicit loader options
+ * 
+ * thumbnail_from_path() with the limits, strictness and `autorotate` of
+ * load_image_with_options(). The limits are checked against the source file and
+ * its header, not the thumbnail. With `autorotate`, the orientation is applied
+ * inside the shrink-on-load step, so the target box applies to the upright image.
+ * 
+ * @param input_path Path to the image file to load
+ * @param options Resize parameters (dimensions and aspect ratio settings)
+ * @param load Loader options; `access`, `page` and `n` are ignored, the first page is read sequentially
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle on success, NULL on failure (IMAGE_TOO_LARGE over a limit)
+ * 
+ * @example Upright 400x400 thumbnail of a phone photo:
+ * @code
+ * ImageLoadOptions load = {0};
+ * load.autorotate = 1;
+ * VImageHandle thumb = thumbnail_from_path_with_options("IMG_0042.jpg", (ImageResizeOptions){1, 400, 400},
+ *                                                       load, NULL);
+ * @endcode
+ * 
+ * @note Dimension limits cost one extra header read of the source
+ */
+VImageHandle thumbnail_from_path_with_options(const char* input_path, ImageResizeOptions options,
+                                              ImageLoadOptions load, ImageStatus* status);
+
+/**
+ * @brief Load an image from byte buffer, shrinking it to the target size during decode
+ * 
+ * Buffer counterpart of thumbnail_from_path().
+ * 
+ * @param data Pointer to the image data bytes
+ * @param size Size of the image data in bytes
+ * @param options Resize parameters (dimensions and aspect ratio settings)
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle on success, NULL on failure
+ * 
+ * @example Thumbnail an upload:
+ * @code
+ * ImageResizeOptions opts = {1, 320, 0}; // 320px wide, height follows
+ * VImageHandle thumb = thumbnail_from_buffer(upload_data, upload_size, opts, NULL);
+ * @endcode
+ * 
+ * @note The bytes are copied, so the caller's buffer can be freed after this call
+ * @warning At least one of width/height must be positive
+ */
+VImageHandle thumbnail_from_buffer(const unsigned char* data, size_t size, ImageResizeOptions options,
+                                   ImageStatus* status);
+
+/**
+ * @brief Load a thumbnail from byte buffer with explicit loader options
+ * 
+ * Buffer counterpart of thumbnail_from_path_with_options().
+ * 
+ * @param data Pointer to the image data bytes
+ * @param size Size of the image data in bytes
+ * @param options Resize parameters (dimensions and aspect ratio settings)
+ * @param load Loader options; `access`, `page` and `n` are ignored, the first page is read sequentially
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle on success, NULL on failure (IMAGE_TOO_LARGE over a limit)
+ * 
+ * @note The bytes are copied, so the caller's buffer can be freed after this call
+ */
+VImageHandle thumbnail_from_buffer_with_options(const unsigned char* data, size_t size, ImageResizeOptions options,
+                                                ImageLoadOptions load, ImageStatus* status);
+
+/**
+ * @brief Load a cover-fit thumbnail from file: shrink on load, then crop to the exact box
+ * 
+ * The thumbnail counterpart of cover_image(). libvips picks the shrink-on-load
+ * factor for the covering size and chooses the crop window on the shrunk image,
+ * so no more pixels are decoded than the output needs.
+ * 
+ * @param input_path Path to the image file to load
+ * @param options Output size and crop mode
+ * @param load Loader options as for thumbnail_from_path_with_options()
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle of exactly options.width x options.height on success, NULL on failure
+ * 
+ * @example 400x400 square from a photo:
+ * @code
+ * ImageCoverOptions cover = {400, 400, IMAGE_CROP_ATTENTION};
+ * VImageHandle square = thumbnail_cover_from_path("photo.jpg", cover, (ImageLoadOptions){0}, NULL);
+ * @endcode
+ * 
+ * @note IMAGE_CROP_GRAVITY and dimension limits cost one extra header read of the source
+ * @note ATTENTION and ENTROPY analyse the shrunk image, not the source
+ * @warning Both width and height must be positive
+ */
+VImageHandle thumbnail_cover_from_path(const char* input_path, ImageCoverOptions options, ImageLoadOptions load,
+                                       ImageStatus* status);
+
+/**
+ * @brief Load a cover-fit thumbnail from byte buffer
+ * 
+ * Buffer counterpart of thumbnail_cover_from_path().
+ * 
+ * @param data Pointer to the image data bytes
+ * @param size Size of the image data in bytes
+ * @param options Output size and crop mode
+ * @param load Loader options as for thumbnail_from_path_with_options()
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle of exactly options.width x options.height on success, NULL on failure
+ * 
+ * @note The bytes are copied, so the caller's buffer can be freed after this call
+ */
+VImageHandle thumbnail_cover_from_buffer(const unsigned char* data, size_t size, ImageCoverOptions options,
+                                         ImageLoadOptions load, ImageStatus* status);
+
+/**
+ * @brief Free a VImage handle
+ * 
+ * Releases the memory associated with a VImage handle. The handle becomes
+ * invalid after this call and should not be used.
+ * 
+ * @param handle The VImageHandle to free (can be NULL)
+ * 
+ * @example
+ * @code
+ * VImageHandle img = load_image("photo.jpg");
+ * if (img) {
+ *     // ... process image ...
+ *     free_vimage_handle(img); // Always free when done
+ *     img = NULL; // Good practice to avoid accidental reuse
+ * }
+ * @endcode
+ * 
+ * @note It's safe to pass NULL to this function
+ * @warning Do not use the handle after calling this function
+ */
+void free_vimage_handle(VImageHandle handle);
+
+/**
+ * @brief Create a second handle to the same image
+ * 
+ * The new handle shares the lazy operation graph and any decoded pixels with
+ * `handle`; nothing is copied. Both handles are independent from then on: an
+ * in-place transform or free_vimage_handle() on one never affects the other.
+ * 
+ * @param handle VImageHandle to clone
+ * @return New VImageHandle, or NULL if `handle` is NULL; free it with free_vimage_handle()
+ * 
+ * @example Give each worker thread its own handle to transform in place:
+ * @code
+ * VImageHandle mine = clone_vimage_handle(shared);
+ * resize_image(mine, (ImageResizeOptions){1, 320, 0});
+ * @endcode
+ * 
+ * @note Clones of a sequentially loaded image still share its single pass
+ */
+VImageHandle clone_vimage_handle(VImageHandle handle);
+
+/**
+ * @brief Free an ImageBuffer
+ *
+ * Releases the memory associated with an ImageBuffer. The buffer's data
+ * becomes invalid after this call.
+ *
+ * @param buffer The ImageBuffer to free.
+ *
+ * @example
+ * @code
+ * ImageBuffer img_buffer = load_image_to_buffer("photo.png");
+ * if (img_buffer.data) {
+ *     // ... process image buffer ...
+ *     free_image_buffer(img_buffer); // Always free when done
+ *     img_buffer.data = nullptr; // Good practice to avoid accidental reuse
+ *     img_buffer.size = 0;
  * }
  * @endcode
  *
@@ -520,6 +1305,28 @@ ImageStatus resize_image(VImageHandle handle, ImageResizeOptions options);
  */
 ImageStatus crop_image(VImageHandle handle, ImageCropOptions options);
 
+/**
+ * @brief Resize an image to cover a box and crop it to exactly that box
+ * 
+ * Scales the image (up or down) so it covers width x height, then crops the
+ * overflowing axis as chosen by `mode`. For an undecoded source prefer
+ * thumbnail_cover_from_path()/buffer(), which also shrink on load.
+ * 
+ * @param handle VImageHandle of the image to resize
+ * @param options Output size and crop mode
+ * @return SUCCESS on success, IMAGE_INVALID_DIMENSIONS if width or height is not positive
+ * 
+ * @example Centre-cropped 16:9 preview:
+ * @code
+ * ImageCoverOptions opts = {640, 360, IMAGE_CROP_CENTRE};
+ * ImageStatus result = cover_image(img, opts);
+ * @endcode
+ * 
+ * @note ATTENTION and ENTROPY scan the resized image once before cropping it, so
+ *       for a sequentially loaded image the resized pixels are rendered into memory
+ */
+ImageStatus cover_image(VImageHandle handle, ImageCoverOptions options);
+
 /**
  * @brief Rotate an image by a specified angle
  * 
@@ -542,11 +1349,76 @@ ImageStatus crop_image(VImageHandle handle, ImageCropOptions options);
  * ImageStatus result = rotate_image(img, opts);
  * @endcode
  * 
- * @note Background is filled with appropriate color (transparent for images with alpha)
- * @note Canvas size may increase to accommodate rotated image
+ * @note Multiples of 90 degrees are exact pixel remaps (no interpolation, no
+ *       background, width and height swap for odd multiples); other angles are
+ *       resampled, fill the background with an appropriate color (transparent for
+ *       images with alpha) and may enlarge the canvas
  */
 ImageStatus rotate_image(VImageHandle handle, ImageRotateOptions options);
 
+/**
+ * @brief Resize into a new handle, leaving the source unchanged
+ * 
+ * Functional form of resize_image(): `*dst` receives a new handle that shares
+ * the lazy graph and pixels of `src`. Several threads can derive from one
+ * decoded source at once without locking.
+ * 
+ * @param src VImageHandle of the source image (not modified)
+ * @param dst Receives the resized image on success, NULL on failure
+ * @param options Resize parameters, as for resize_image()
+ * @return SUCCESS on success, error code on failure
+ * 
+ * @example Fan one decode out to parallel workers:
+ * @code
+ * // on each worker thread
+ * VImageHandle small = NULL;
+ * if (resize_image_to(shared, &small, (ImageResizeOptions){1, width, 0}) == SUCCESS) {
+ *     ImageBuffer webp = encode_to_webp(small, (ImageEncodeWebPOptions){80, 0, 4, 0, 1});
+ *     free_image_buffer(webp);
+ *     free_vimage_handle(small);
+ * }
+ * @endcode
+ */
+ImageStatus resize_image_to(VImageHandle src, VImageHandle* dst, ImageResizeOptions options);
+
+/**
+ * @brief Crop into a new handle, leaving the source unchanged
+ * 
+ * Functional form of crop_image(); see resize_image_to().
+ * 
+ * @param src VImageHandle of the source image (not modified)
+ * @param dst Receives the cropped image on success, NULL on failure
+ * @param options Crop rectangle, as for crop_image()
+ * @return SUCCESS on success, error code on failure
+ */
+ImageStatus crop_image_to(VImageHandle src, VImageHandle* dst, ImageCropOptions options);
+
+/**
+ * @brief Rotate into a new handle, leaving the source unchanged
+ * 
+ * Functional form of rotate_image(); see resize_image_to().
+ * 
+ * @param src VImageHandle of the source image (not modified)
+ * @param dst Receives the rotated image on success, NULL on failure
+ * @param options Rotation parameters, as for rotate_image()
+ * @return SUCCESS on success, error code on failure
+ */
+ImageStatus rotate_image_to(VImageHandle src, VImageHandle* dst, ImageRotateOptions options);
+
+/**
+ * @brief Mirror an image horizontally or vertically
+ * 
+ * An exact pixel remap with the same dimensions as the input.
+ * 
+ * @param handle VImageHandle of the image to flip
+ * @param options Flip parameters (mirror axis)
+ * @return SUCCESS on success, error code on failure
+ * 
+ * @note A horizontal flip keeps sequential access; a vertical flip reads rows
+ *       bottom to top, so a sequentially loaded image is rendered into memory first
+ */
+ImageStatus flip_image(VImageHandle handle, ImageFlipOptions options);
+
 /**
  * @brief Apply a watermark to an image
  * 
@@ -580,10 +1452,84 @@ ImageStatus rotate_image(VImageHandle handle, ImageRotateOptions options);
  * 
  * @note Watermark is blended using alpha compositing
  * @note Watermark position can be negative (partial overlay)
+ * @note An 8-bit RGB base with an 8-bit sRGB watermark is composited in 8-bit
+ *       integer arithmetic in one vectorised pass; other formats use libvips' composite
  */
 ImageStatus watermark_image(VImageHandle base_handle, VImageHandle watermark_handle, 
                            ImageWatermarkOptions options);
 
+/**
+ * @brief Opaque handle to a prepared watermark
+ */
+typedef void* ImageWatermarkHandle;
+
+/**
+ * @brief Prepare a watermark for repeated use
+ * 
+ * watermark_image() rebuilds the overlay on every call: it adds an alpha
+ * channel if needed and scales it by the opacity. A prepared watermark does
+ * that once: the overlay is converted to sRGB, its alpha is scaled by
+ * `opacity`, the colour is premultiplied, and the result is rendered into
+ * memory. Applying it is then a single composite.
+ * 
+ * The prepared watermark is immutable and thread-safe. It can be applied
+ * from any number of threads at once, and `watermark` may be freed as soon
+ * as this call returns. Scaled variants (see ImageWatermarkPlacement.width_fraction)
+ * are rendered on first use and kept inside the handle.
+ * 
+ * @param watermark VImageHandle of the overlay, usually a logo PNG
+ * @param opacity Opacity applied to the overlay (clamped to [0.0, 1.0])
+ * @param blend_mode How the overlay is blended onto base images
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return Watermark handle on success, NULL on failure; release with free_watermark()
+ * 
+ * @example Prepare once at startup, stamp every request:
+ * @code
+ * VImageHandle logo = load_image("logo.png");
+ * ImageWatermarkHandle mark = prepare_watermark(logo, 0.6, IMAGE_BLEND_OVER, NULL);
+ * free_vimage_handle(logo);
+ * 
+ * // on any thread:
+ * ImageWatermarkPlacement place = {IMAGE_GRAVITY_SOUTH_EAST, 16, 16, 0.2};
+ * watermark_image_prepared(photo, mark, place);
+ * @endcode
+ * 
+ * @note The overlay pixels stay in memory until free_watermark(), plus one
+ *       copy per size class used
+ */
+ImageWatermarkHandle prepare_watermark(VImageHandle watermark, double opacity, ImageBlendMode blend_mode,
+                                       ImageStatus* status);
+
+/**
+ * @brief Apply a prepared watermark to an image
+ * 
+ * With a `width_fraction`, the watermark is scaled to a size class: the
+ * largest of a set of widths, 8 per octave, that does not exceed
+ * `width_fraction` times the base width. All base images of similar width
+ * therefore share one scaled copy, and the width error is under 9%.
+ * 
+ * @param base_handle VImageHandle of the image to modify
+ * @param watermark Prepared watermark
+ * @param placement Anchor, offsets and scale
+ * @return SUCCESS on success, error code on failure
+ * 
+ * @note A watermark placed partly outside the image is clipped, as with watermark_image()
+ * @note The image keeps its band format; the result has an alpha channel
+ * @note IMAGE_BLEND_OVER on an 8-bit RGB base takes the same 8-bit fast path as watermark_image()
+ */
+ImageStatus watermark_image_prepared(VImageHandle base_handle, ImageWatermarkHandle watermark,
+                                     ImageWatermarkPlacement placement);
+
+/**
+ * @brief Release a prepared watermark
+ * 
+ * Pipelines and pool jobs that use the watermark hold their own reference,
+ * so it can be freed while they are still queued or running.
+ * 
+ * @param watermark Handle to release (NULL is ignored)
+ */
+void free_watermark(ImageWatermarkHandle watermark);
+
 /**
  * @brief Change the overall opacity of an image
  * 
@@ -608,13 +1554,232 @@ ImageStatus watermark_image(VImageHandle base_handle, VImageHandle watermark_han
  * 
  * @note Opacity values are clamped to [0.0, 1.0] range
  * @note Automatically adds alpha channel if needed
+ * @note 8-bit images stay 8-bit and are scaled in one vectorised pass, with the
+ *       opacity rounded to 1/255; other formats keep the generic float path
  */
 ImageStatus change_image_opacity(VImageHandle handle, ImageOpacityOptions options);
 
+/**
+ * @brief Convert an image to 8 bits per channel sRGB (or 8-bit greyscale)
+ * 
+ * Resize, watermark and the encoders otherwise run on whatever the source
+ * holds. CMYK, 16-bit and wide-gamut images are then processed in high
+ * precision and only cast on encode, which is slower and can clip colours.
+ * Converting first lets later steps run on 8-bit data:
+ * - an embedded ICC profile is honoured: pixels go through the profile to sRGB;
+ * - CMYK without a profile is converted with a generic CMYK profile;
+ * - other colourspaces (Lab, scRGB, RGB16, ...) are converted to sRGB, and
+ *   16-bit greyscale to 8-bit greyscale;
+ * - the result is cast to 8 bits per band, keeping an alpha channel.
+ * 
+ * An image that is already 8-bit sRGB or greyscale without a profile is left
+ * untouched, so calling this on every input is cheap.
+ * 
+ * @param handle VImageHandle of the image to modify
+ * @param options Profile handling and rendering intent
+ * @return SUCCESS on success, error code on failure
+ * 
+ * @example Normalise before resizing:
+ * @code
+ * VImageHandle img = load_image("print.tif"); // CMYK, 16-bit
+ * ensure_srgb8(img, (ImageSRGBOptions){0});
+ * resize_image(img, (ImageResizeOptions){1, 1024, 0});
+ * @endcode
+ * 
+ * @note Without lcms support in libvips, ICC conversion falls back to the
+ *       built-in colourspace conversion, with a warning through the log handler
+ */
+ImageStatus ensure_srgb8(VImageHandle handle, ImageSRGBOptions options);
+
+/**
+ * @brief Operation kinds for process_pipeline()
+ */
+typedef enum {
+    PIPELINE_OP_RESIZE = 0,         ///< resize_image(), options in `resize`
+    PIPELINE_OP_CROP,               ///< crop_image(), options in `crop`
+    PIPELINE_OP_ROTATE,             ///< rotate_image(), options in `rotate`
+    PIPELINE_OP_WATERMARK,          ///< watermark_image(), `watermark_image` + `watermark`
+    PIPELINE_OP_OPACITY,            ///< change_image_opacity(), options in `opacity`
+    PIPELINE_OP_PREPARED_WATERMARK, ///< watermark_image_prepared(), `prepared_watermark` + `placement`
+    PIPELINE_OP_ENSURE_SRGB8,       ///< ensure_srgb8(), options in `srgb`
+    PIPELINE_OP_FLIP,               ///< flip_image(), options in `flip`
+    PIPELINE_OP_COVER               ///< cover_image(), options in `cover`
+} ImagePipelineOpType;
+
+/**
+ * @brief One step of an operation pipeline
+ * 
+ * Only the fields matching `type` are read, so a zero-initialized op with the
+ * relevant options filled in is valid.
+ * 
+ * @example
+ * @code
+ * ImagePipelineOp ops[2] = {{0}, {0}};
+ * ops[0].type = PIPELINE_OP_RESIZE;
+ * ops[0].resize = (ImageResizeOptions){1, 800, 600};
+ * ops[1].type = PIPELINE_OP_WATERMARK;
+ * ops[1].watermark_image = logo;
+ * ops[1].watermark = (ImageWatermarkOptions){10, 10, 0.7};
+ * @endcode
+ */
+typedef struct {
+    ImagePipelineOpType type;           ///< Operation to run
+    ImageResizeOptions resize;          ///< PIPELINE_OP_RESIZE options
+    ImageCropOptions crop;              ///< PIPELINE_OP_CROP options
+    ImageRotateOptions rotate;          ///< PIPELINE_OP_ROTATE options
+    VImageHandle watermark_image;       ///< PIPELINE_OP_WATERMARK overlay image
+    ImageWatermarkOptions watermark;    ///< PIPELINE_OP_WATERMARK options
+    ImageOpacityOptions opacity;        ///< PIPELINE_OP_OPACITY options
+    ImageWatermarkHandle prepared_watermark;    ///< PIPELINE_OP_PREPARED_WATERMARK watermark
+    ImageWatermarkPlacement placement;          ///< PIPELINE_OP_PREPARED_WATERMARK placement
+    ImageSRGBOptions srgb;                      ///< PIPELINE_OP_ENSURE_SRGB8 options
+    ImageFlipOptions flip;                      ///< PIPELINE_OP_FLIP options
+    ImageCoverOptions cover;                    ///< PIPELINE_OP_COVER options
+} ImagePipelineOp;
+
+/**
+ * @brief Run a chain of operations and the final encode in one call
+ * 
+ * Applies `ops` in order to a working copy of the image and encodes the
+ * result, crossing the library boundary once instead of once per step.
+ * Steps are fused where that cannot change the output: consecutive crops
+ * become one crop, consecutive opacity changes multiply into one, and
+ * rotations by multiples of 360 degrees are skipped.
+ * 
+ * @param handle VImageHandle of the source image
+ * @param ops Operations to apply, in order
+ * @param n Number of operations
+ * @param out Output format and encoder options; IMAGE_FORMAT_NONE applies the
+ *            operations to `handle` in place and encodes nothing
+ * @param result Receives the encoded data (may be NULL for IMAGE_FORMAT_NONE)
+ * @return SUCCESS on success, error code of the first failing step otherwise
+ * 
+ * @example Resize, watermark and encode:
+ * @code
+ * ImageEncodeSpec out = {0};
+ * out.format = IMAGE_FORMAT_JPEG;
+ * out.jpeg = (ImageEncodeJPEGOptions){85, 0};
+ * 
+ * ImageBuffer result = {0};
+ * if (process_pipeline(img, ops, 2, out, &result) == SUCCESS) {
+ *     // ... use result.data ...
+ *     free_image_buffer(result);
+ * }
+ * @endcode
+ * 
+ * @note The source handle is not modified unless out.format is IMAGE_FORMAT_NONE,
+ *       so it can be reused for further pipelines
+ */
+ImageStatus process_pipeline(VImageHandle handle, const ImagePipelineOp* ops, size_t n,
+                             ImageEncodeSpec out, ImageBuffer* result);
+
+/**
+ * @brief One output size of generate_renditions()
+ */
+typedef struct {
+    ImageResizeOptions resize;      ///< Target size, interpreted as by resize_image()
+    ImageEncodeSpec output;         ///< Output format and encoder options
+} ImageRenditionSpec;
+
+/**
+ * @brief Encode several sizes of one image from a single decode
+ * 
+ * The source is decoded once and resized to the largest rendition, which is
+ * kept in memory. Each smaller rendition is resized from the smallest larger
+ * one that covers it on both axes rather than from the source, and the
+ * renditions are then encoded in parallel. Every rendition has the dimensions resize_image() would give it
+ * on the source.
+ * 
+ * @param source VImageHandle of the source image (not modified)
+ * @param specs Sizes and encodings, in any order
+ * @param n Number of renditions
+ * @param out Array of `n` buffers receiving the encoded renditions, in the order
+ *            of `specs`; release each with free_image_buffer()
+ * @return SUCCESS, or the error of the first failing rendition; on failure every
+ *         `out` entry is {NULL, 0}
+ * 
+ * @example Responsive widths of an upload:
+ * @code
+ * ImageRenditionSpec specs[3] = {{{1, 1600, 0}}, {{1, 800, 0}}, {{1, 320, 0}}};
+ * for (int i = 0; i < 3; i++) {
+ *     specs[i].output.format = IMAGE_FORMAT_WEBP;
+ *     specs[i].output.webp = (ImageEncodeWebPOptions){80, 0, 4, 0, 0};
+ * }
+ * ImageBuffer out[3];
+ * if (generate_renditions(img, specs, 3, out) == SUCCESS) {
+ *     // ... store out[0..2], then free_image_buffer() each ...
+ * }
+ * @endcode
+ * 
+ * @note Peak memory is about 1.3x the uncompressed largest rendition
+ * @note Multi-frame images are resized as one tall image; run process_pipeline()
+ *       once per size to keep animations
+ */
+ImageStatus generate_renditions(VImageHandle source, const ImageRenditionSpec* specs, size_t n, ImageBuffer* out);
+
+/**
+ * @brief Encode several sizes of an encoded image from a single decode
+ * 
+ * Like generate_renditions(), but decodes the data itself. JPEG input is
+ * decoded with the largest DCT shrink that still covers every rendition, so
+ * a large source is never decoded at full resolution. Each rendition is then
+ * resized once, from the decode or from the smallest larger rendition.
+ * 
+ * @param data Pointer to the encoded image bytes; only read during the call
+ * @param size Size of the data in bytes
+ * @param specs Sizes and encodings, in any order
+ * @param n Number of renditions
+ * @param out Array of `n` buffers receiving the encoded renditions
+ * @return See generate_renditions(); IMAGE_LOAD_FAILURE if the data cannot be decoded
+ * 
+ * @note EXIF orientation is not applied, matching load_image()
+ */
+ImageStatus generate_renditions_from_buffer(const unsigned char* data, size_t size,
+                                            const ImageRenditionSpec* specs, size_t n, ImageBuffer* out);
+
+/**
+ * @brief Encode several sizes of an encoded image with custom loader options
+ * 
+ * Like generate_renditions_from_buffer(), but applies the load limits,
+ * strictness and autorotation of `load`. Sizes refer to the upright image
+ * when autorotation is on. The access mode and page selection are ignored.
+ * 
+ * @param data Pointer to the encoded image bytes; only read during the call
+ * @param size Size of the data in bytes
+ * @param load Loader options
+ * @param specs Sizes and encodings, in any order
+ * @param n Number of renditions
+ * @param out Array of `n` buffers receiving the encoded renditions
+ * @return See generate_renditions_from_buffer(); IMAGE_TOO_LARGE if the input is over a load limit
+ */
+ImageStatus generate_renditions_from_buffer_with_options(const unsigned char* data, size_t size,
+                                                         ImageLoadOptions load, const ImageRenditionSpec* specs,
+                                                         size_t n, ImageBuffer* out);
+
 //=============================================================================
 // ENCODING AND METADATA FUNCTIONS
 //=============================================================================
 
+/**
+ * @brief Fill JPEG encoding options from a preset
+ * 
+ * Returns a fully versioned ImageEncodeJPEGOptions that callers may tweak
+ * further before encoding.
+ * 
+ * @param preset Trade-off between encode CPU and output size
+ * @param quality JPEG quality (1-100), or 0 for the encoder default
+ * @return Options with `version` set to IMAGE_ENCODE_JPEG_OPTIONS_VERSION
+ * 
+ * @example
+ * @code
+ * ImageEncodeJPEGOptions thumbs = jpeg_options_preset(IMAGE_JPEG_PRESET_FAST, 80);
+ * ImageEncodeJPEGOptions hero = jpeg_options_preset(IMAGE_JPEG_PRESET_SMALLEST, 82);
+ * @endcode
+ * 
+ * @note SMALLEST typically saves 10-25% over DEFAULT with mozjpeg, at several times the CPU
+ */
+ImageEncodeJPEGOptions jpeg_options_preset(ImageJPEGPreset preset, int quality);
+
 /**
  * @brief Encode image to JPEG format
  * 
@@ -622,7 +1787,7 @@ ImageStatus change_image_opacity(VImageHandle handle, ImageOpacityOptions option
  * The caller is responsible for freeing the returned buffer.
  * 
  * @param handle VImageHandle of the image to encode
- * @param options JPEG encoding parameters (quality, interlacing)
+ * @param options JPEG encoding parameters (quality, interlacing, coding and metadata controls)
  * @return ImageBuffer containing encoded data, or {NULL, 0} on failure
  * 
  * @example High quality JPEG:
@@ -681,19 +1846,240 @@ ImageBuffer encode_to_jpeg(const VImageHandle handle, ImageEncodeJPEGOptions opt
 ImageBuffer encode_to_png(const VImageHandle handle, ImageEncodePNGOptions options);
 
 /**
- * @brief Extract metadata from an image
+ * @brief Encode image to WebP format
  * 
- * Retrieves comprehensive metadata information from the image including
- * dimensions, color properties, and format details.
- * 
- * @param handle VImageHandle of the image
- * @return ImageMeta structure containing metadata information
+ * @param handle VImageHandle of the image to encode
+ * @param options WebP encoding parameters (quality, lossless, effort, subsampling, strip)
+ * @return ImageBuffer containing encoded data, or {NULL, 0} on failure
  * 
- * @example Display image information:
+ * @example
  * @code
- * VImageHandle img = load_image("photo.jpg");
- * ImageMeta meta = extract_metadata(img);
- * printf("Image: %dx%d pixels\n", meta.width, meta.height);
+ * ImageEncodeWebPOptions opts = {80, 0, 4, 0, 1};
+ * ImageBuffer result = encode_to_webp(img, opts);
+ * if (result.data) {
+ *     // ... use result ...
+ *     free_image_buffer(result);
+ * }
+ * @endcode
+ * 
+ * @note Effort trades encode CPU for size: 0 is several times faster than 6
+ * @note Multi-frame images (loaded with `n`) are written as animations
+ * @warning Always check result.data for NULL and free when done
+ */
+ImageBuffer encode_to_webp(const VImageHandle handle, ImageEncodeWebPOptions options);
+
+/**
+ * @brief Encode image to AVIF format
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param options AVIF encoding parameters (quality, lossless, effort, subsampling, strip)
+ * @return ImageBuffer containing encoded data, or {NULL, 0} on failure
+ * 
+ * @note Requires libvips built with libheif and an AV1 encoder
+ * @note AV1 encoding is CPU heavy; effort 0-2 is usually enough for on-the-fly use
+ * @warning Always check result.data for NULL and free when done
+ */
+ImageBuffer encode_to_avif(const VImageHandle handle, ImageEncodeAVIFOptions options);
+
+/**
+ * @brief Encode image to JPEG XL format
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param options JPEG XL encoding parameters (quality, lossless, effort, strip)
+ * @return ImageBuffer containing encoded data, or {NULL, 0} on failure
+ * 
+ * @note Requires libvips built with libjxl
+ * @warning Always check result.data for NULL and free when done
+ */
+ImageBuffer encode_to_jxl(const VImageHandle handle, ImageEncodeJXLOptions options);
+
+/**
+ * @brief Encode image to HEIF (HEVC) format
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param options HEIF encoding parameters (quality, lossless, effort, subsampling, strip)
+ * @return ImageBuffer containing encoded data, or {NULL, 0} on failure
+ * 
+ * @note Requires libvips built with libheif and an HEVC encoder
+ * @warning Always check result.data for NULL and free when done
+ */
+ImageBuffer encode_to_heif(const VImageHandle handle, ImageEncodeHEIFOptions options);
+
+/**
+ * @brief Encode image to GIF format
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param options GIF encoding parameters (effort, bitdepth)
+ * @return ImageBuffer containing encoded data, or {NULL, 0} on failure
+ * 
+ * @note Multi-frame images (loaded with `n`) are written as animations
+ * @note Requires libvips 8.12 or newer built with cgif
+ * @warning Always check result.data for NULL and free when done
+ */
+ImageBuffer encode_to_gif(const VImageHandle handle, ImageEncodeGIFOptions options);
+
+/**
+ * @brief Encode image to any format libvips can write to memory
+ * 
+ * Generic entry point for formats without a dedicated function (TIFF, GIF,
+ * JPEG 2000, ...). The saver is chosen from `suffix` and configured with
+ * libvips' own option names.
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param suffix Format suffix, e.g. ".tif", ".gif", ".webp"
+ * @param options Saver options as comma-separated name=value pairs, or NULL
+ * @return ImageBuffer containing encoded data, or {NULL, 0} on failure
+ * 
+ * @example Deflate-compressed TIFF:
+ * @code
+ * ImageBuffer tiff = encode_to_format(img, ".tif", "compression=deflate,tile=true");
+ * @endcode
+ * 
+ * @example GIF with reduced effort:
+ * @code
+ * ImageBuffer gif = encode_to_format(img, ".gif", "effort=1,bitdepth=6");
+ * @endcode
+ * 
+ * @warning Always check result.data for NULL and free when done
+ */
+ImageBuffer encode_to_format(const VImageHandle handle, const char* suffix, const char* options);
+
+/**
+ * @brief Encode image to JPEG format, streaming to a writer callback
+ * 
+ * Encoded chunks are handed to `writer.write` as libvips produces them, so no
+ * buffer holding the whole encoded image is ever allocated.
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param options JPEG encoding parameters (quality, interlacing)
+ * @param writer Destination callback for the encoded bytes
+ * @return SUCCESS on success, IMAGE_SAVE_FAILURE if the encoder or the writer failed
+ * 
+ * @example Write straight to a file:
+ * @code
+ * static long long write_file(const void* data, size_t size, void* user_data) {
+ *     return fwrite(data, 1, size, (FILE*)user_data) == size ? (long long)size : -1;
+ * }
+ * 
+ * FILE* file = fopen("output.jpg", "wb");
+ * ImageWriter writer = {write_file, file};
+ * ImageStatus status = encode_to_jpeg_writer(img, (ImageEncodeJPEGOptions){85, 0}, writer);
+ * fclose(file);
+ * @endcode
+ * 
+ * @note The callback may run on a libvips worker thread
+ * @warning The chunk pointer is only valid for the duration of the callback
+ */
+ImageStatus encode_to_jpeg_writer(const VImageHandle handle, ImageEncodeJPEGOptions options,
+                                  ImageWriter writer);
+
+/**
+ * @brief Encode image to PNG format, streaming to a writer callback
+ * 
+ * PNG counterpart of encode_to_jpeg_writer().
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param options PNG encoding parameters (compression, interlacing)
+ * @param writer Destination callback for the encoded bytes
+ * @return SUCCESS on success, IMAGE_SAVE_FAILURE if the encoder or the writer failed
+ */
+ImageStatus encode_to_png_writer(const VImageHandle handle, ImageEncodePNGOptions options,
+                                 ImageWriter writer);
+
+/**
+ * @brief Encode image to JPEG format into a caller-provided buffer
+ * 
+ * Writes the encoded bytes into `out` without any intermediate allocation,
+ * so a buffer can be reused across requests. If `capacity` is too small the
+ * encode still runs to completion, `*out_size` receives the size that would
+ * have been needed, and IMAGE_BUFFER_TOO_SMALL is returned.
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param options JPEG encoding parameters (quality, interlacing)
+ * @param out Destination buffer (may be NULL when capacity is 0)
+ * @param capacity Size of `out` in bytes
+ * @param out_size Receives the encoded size in bytes
+ * @return SUCCESS, IMAGE_BUFFER_TOO_SMALL, or an error code on failure
+ * 
+ * @example Reuse one buffer, growing it when needed:
+ * @code
+ * size_t needed = 0;
+ * ImageStatus status = encode_to_jpeg_into(img, opts, buf, buf_cap, &needed);
+ * if (status == IMAGE_BUFFER_TOO_SMALL) {
+ *     buf = realloc(buf, buf_cap = needed);
+ *     status = encode_to_jpeg_into(img, opts, buf, buf_cap, &needed);
+ * }
+ * @endcode
+ * 
+ * @warning Retrying re-runs the encode; sequentially loaded images can only be
+ *          encoded once, so size the buffer generously for those
+ */
+ImageStatus encode_to_jpeg_into(const VImageHandle handle, ImageEncodeJPEGOptions options,
+                                unsigned char* out, size_t capacity, size_t* out_size);
+
+/**
+ * @brief Encode image to PNG format into a caller-provided buffer
+ * 
+ * PNG counterpart of encode_to_jpeg_into().
+ * 
+ * @param handle VImageHandle of the image to encode
+ * @param options PNG encoding parameters (compression, interlacing)
+ * @param out Destination buffer (may be NULL when capacity is 0)
+ * @param capacity Size of `out` in bytes
+ * @param out_size Receives the encoded size in bytes
+ * @return SUCCESS, IMAGE_BUFFER_TOO_SMALL, or an error code on failure
+ */
+ImageStatus encode_to_png_into(const VImageHandle handle, ImageEncodePNGOptions options,
+                               unsigned char* out, size_t capacity, size_t* out_size);
+
+/**
+ * @brief Encode an image straight to a file
+ * 
+ * The encoder writes to a temporary file next to `path` as it goes, so the
+ * encoded image is never held in memory, and renames it over `path` once
+ * complete. On failure the temporary file is removed and an existing file at
+ * `path` is left as it was.
+ * 
+ * With IMAGE_FORMAT_NONE the saver is chosen from the file extension,
+ * which also covers formats without an ImageFormat: save to `.v` for
+ * uncompressed intermediates that later loads map into memory instead of
+ * decoding (see load_image_with_options()), or to `.tif`.
+ * 
+ * @param handle VImageHandle of the image to save
+ * @param path Destination file, replaced if it exists
+ * @param spec Output format and encoder options
+ * @return SUCCESS, IMAGE_INVALID_PATH for a NULL path, IMAGE_INVALID_FORMAT,
+ *         or IMAGE_SAVE_FAILURE if encoding or writing failed
+ * 
+ * @example
+ * @code
+ * ImageEncodeSpec jpeg = {IMAGE_FORMAT_JPEG};
+ * jpeg.jpeg.quality = 85;
+ * save_image(img, "/srv/cache/photo.jpg", jpeg);
+ * 
+ * ImageEncodeSpec by_extension = {IMAGE_FORMAT_NONE};
+ * save_image(img, "/srv/cache/master.v", by_extension);
+ * @endcode
+ * 
+ * @warning Do not save over the file `handle` was loaded from: pixels may
+ *          still be read from it while the new file is written
+ */
+ImageStatus save_image(const VImageHandle handle, const char* path, ImageEncodeSpec spec);
+
+/**
+ * @brief Extract metadata from an image
+ * 
+ * Retrieves comprehensive metadata information from the image including
+ * dimensions, color properties, and format details.
+ * 
+ * @param handle VImageHandle of the image
+ * @return ImageMeta structure containing metadata information
+ * 
+ * @example Display image information:
+ * @code
+ * VImageHandle img = load_image("photo.jpg");
+ * ImageMeta meta = extract_metadata(img);
+ * printf("Image: %dx%d pixels\n", meta.width, meta.height);
  * printf("Channels: %d\n", meta.channels);
  * printf("Format: %s\n", meta.format);
  * printf("Colorspace: %s\n", meta.colorspace);
@@ -709,10 +2095,1138 @@ ImageBuffer encode_to_png(const VImageHandle handle, ImageEncodePNGOptions optio
  * @endcode
  * 
  * @note Returns zero-initialized structure if handle is invalid
- * @note file_size is typically 0 for images created in memory
+ * @note file_size is always 0; use the probe functions to learn the encoded size
  */
 ImageMeta extract_metadata(const VImageHandle handle);
 
+/**
+ * @brief Options for header-only probing
+ */
+typedef struct {
+    uint64_t max_pixels;    ///< Reject images with more pixels (width * height * pages); 0 = no limit
+    int fail_on_error;      ///< Non-zero to reject files libvips can only read with errors (truncated, corrupt)
+} ImageProbeOptions;
+
+/**
+ * @brief Read image metadata from a file header without decoding pixels
+ * 
+ * Opens the file, parses its header and fills `meta`; no pixel data is decoded
+ * and no handle is created. Use it for admission control: reject oversized or
+ * unsupported uploads, or pick a shrink factor, before paying for a decode.
+ * 
+ * @param input_path Path to the image file
+ * @param options Pixel limit and error strictness
+ * @param meta Receives the metadata, including file_size; also filled when the
+ *             pixel limit is exceeded so the caller can report the dimensions
+ * @return SUCCESS, IMAGE_INVALID_PATH, IMAGE_INVALID_FORMAT for unsupported files,
+ *         IMAGE_LOAD_FAILURE for unreadable headers, or IMAGE_TOO_LARGE if
+ *         `max_pixels` is exceeded
+ * 
+ * @example Reject uploads over 50 megapixels:
+ * @code
+ * ImageProbeOptions probe = {50000000, 1};
+ * ImageMeta meta;
+ * if (probe_image_from_path("upload.jpg", probe, &meta) != SUCCESS) {
+ *     return reject(vips_wrapper_last_error()->message);
+ * }
+ * ImageResizeOptions fit = {1, meta.width > 4096 ? 4096 : meta.width, 0};
+ * VImageHandle img = thumbnail_from_path("upload.jpg", fit, NULL);
+ * @endcode
+ * 
+ * @note Width and height are those stored in the file; check `orientation`
+ *       (5-8 swap the axes) before comparing them with a target box
+ */
+ImageStatus probe_image_from_path(const char* input_path, ImageProbeOptions options, ImageMeta* meta);
+
+/**
+ * @brief Read image metadata from an encoded buffer without decoding pixels
+ * 
+ * Buffer counterpart of probe_image_from_path(). The buffer is only read
+ * during the call and may be freed afterwards.
+ * 
+ * @param data Pointer to the encoded image bytes
+ * @param size Size of the data in bytes (reported as file_size)
+ * @param options Pixel limit and error strictness
+ * @param meta Receives the metadata
+ * @return See probe_image_from_path()
+ */
+ImageStatus probe_image_from_bytes(const unsigned char* data, size_t size, ImageProbeOptions options,
+                                   ImageMeta* meta);
+
+//=============================================================================
+// WORKER POOL
+//=============================================================================
+
+/**
+ * @brief Opaque handle to a native worker pool
+ */
+typedef void* ImageWorkerPoolHandle;
+
+/**
+ * @brief Worker pool sizing
+ */
+typedef struct {
+    int workers;            ///< Worker threads (0 = one per CPU core)
+    int queue_depth;        ///< Jobs that may wait for a worker (0 = 2 x workers)
+} ImageWorkerPoolOptions;
+
+/**
+ * @brief A pipeline job: operations on a source image plus an output encoding
+ * 
+ * Same meaning as the arguments of process_pipeline(). The output format must
+ * not be IMAGE_FORMAT_NONE, since a job never modifies its source image.
+ */
+typedef struct {
+    VImageHandle image;             ///< Source image
+    const ImagePipelineOp* ops;     ///< Operations to apply, in order
+    size_t op_count;                ///< Number of entries in `ops`
+    ImageEncodeSpec output;         ///< Output format and encoder options
+} ImagePipelineSpec;
+
+/**
+ * @brief Called on a worker thread when a job finishes
+ * 
+ * @param status SUCCESS, or the error the pipeline failed with
+ * @param result Encoded output on success, else {NULL, 0}; owned by the callee,
+ *        which must release it with free_image_buffer()
+ * @param user_data Value passed to submit_job()
+ */
+typedef void (*ImageJobCompletionFn)(ImageStatus status, ImageBuffer result, void* user_data);
+
+/**
+ * @brief Create a fixed-size pool of worker threads running pipeline jobs
+ * 
+ * Callers hand work to the pool with submit_job() and return immediately, so
+ * the number of threads inside libvips stays fixed however many callers there
+ * are. When the queue is full new jobs are rejected with IMAGE_QUEUE_FULL
+ * rather than piling up, keeping latency flat under overload.
+ * 
+ * @param options Pool sizing
+ * @return Pool handle, or NULL if the threads could not be started
+ * 
+ * @example
+ * @code
+ * ImageWorkerPoolOptions opts = {4, 16};
+ * ImageWorkerPoolHandle pool = create_worker_pool(opts);
+ * // ... submit_job(pool, spec, on_done, ctx) ...
+ * destroy_worker_pool(pool);
+ * @endcode
+ * 
+ * @note Combine with vips_wrapper_set_concurrency() to bound the threads each job uses
+ */
+ImageWorkerPoolHandle create_worker_pool(ImageWorkerPoolOptions options);
+
+/**
+ * @brief Queue a pipeline job on a worker pool
+ * 
+ * The spec is copied, and the source and watermark images are referenced, so
+ * the caller may free its handles and the ops array as soon as this returns.
+ * `done` is called exactly once for every accepted job, on a worker thread.
+ * 
+ * @param pool Pool handle
+ * @param spec Job description
+ * @param done Completion callback
+ * @param user_data Passed through to `done`
+ * @return SUCCESS if queued, IMAGE_QUEUE_FULL if rejected, or a validation error
+ * 
+ * @example
+ * @code
+ * static void on_done(ImageStatus status, ImageBuffer result, void* ctx) {
+ *     if (status == SUCCESS) send_response(ctx, result.data, result.size);
+ *     free_image_buffer(result);
+ * }
+ * 
+ * ImagePipelineSpec spec = {img, ops, 2, out};
+ * if (submit_job(pool, spec, on_done, ctx) == IMAGE_QUEUE_FULL) {
+ *     reply_busy(ctx); // shed load instead of queueing
+ * }
+ * @endcode
+ */
+ImageStatus submit_job(ImageWorkerPoolHandle pool, ImagePipelineSpec spec, ImageJobCompletionFn done,
+                       void* user_data);
+
+/**
+ * @brief Number of jobs waiting for a worker
+ * @param pool Pool handle
+ * @return Queued (not yet running) jobs, or 0 for a NULL pool
+ */
+size_t worker_pool_queued(ImageWorkerPoolHandle pool);
+
+/**
+ * @brief Stop a worker pool
+ * 
+ * Stops accepting jobs, runs the jobs already queued, then joins the worker
+ * threads and frees the pool.
+ * 
+ * @param pool Pool handle (NULL is ignored)
+ * @warning Must not be called from a completion callback of the same pool
+ */
+void destroy_worker_pool(ImageWorkerPoolHandle pool);
+
+//=============================================================================
+// INSTRUMENTATION AND LOGGING
+//=============================================================================
+
+/**
+ * @brief Operation groups tracked by vips_wrapper_get_stats()
+ * 
+ * libvips evaluates lazily: transforms only build the pipeline, and the pixel
+ * work (including decode) runs inside whichever encode or pipeline call
+ * first needs the pixels. Latencies are the wall time of each wrapper call.
+ */
+typedef enum {
+    IMAGE_OP_LOAD = 0,              ///< load_image*, load_image_from_*, clone_vimage_handle (errors only)
+    IMAGE_OP_THUMBNAIL,             ///< thumbnail_* (decode happens here)
+    IMAGE_OP_RESIZE,                ///< resize_image, resize_image_to, cover_image
+    IMAGE_OP_CROP,                  ///< crop_image, crop_image_to
+    IMAGE_OP_ROTATE,                ///< rotate_image, rotate_image_to, flip_image
+    IMAGE_OP_WATERMARK,             ///< watermark_image, prepare_watermark, watermark_image_prepared
+    IMAGE_OP_OPACITY,               ///< change_image_opacity
+    IMAGE_OP_ENCODE,                ///< encode_to_* (buffer, writer and fixed-buffer variants), save_image
+    IMAGE_OP_PIPELINE,              ///< process_pipeline, process_pipeline_cancellable/_ex and worker pool jobs
+    IMAGE_OP_PROBE,                 ///< probe_image_from_path/bytes
+    IMAGE_OP_RENDITIONS,            ///< generate_renditions* (decode, resizes and encodes)
+    IMAGE_OP_COLOUR,                ///< ensure_srgb8
+    IMAGE_OP_RAW_CACHE,             ///< export_to_raw_cache, load_from_raw_cache (hits only)
+    IMAGE_OP_RESULT_CACHE,          ///< process_cached hits, including calls that waited for a coalesced render
+    IMAGE_OP_TILES,                 ///< fetch_region, generate_tile_pyramid
+    IMAGE_OP_TENSOR,                ///< write_to_memory (pending operations run here)
+    IMAGE_OP_COUNT                  ///< Number of operation groups
+} ImageOperation;
+
+/// Number of latency histogram buckets; see vips_wrapper_latency_bucket_bound_ns()
+#define IMAGE_LATENCY_BUCKETS 16
+
+/**
+ * @brief Counters for one operation group
+ */
+typedef struct {
+    uint64_t calls;                 ///< Completed calls
+    uint64_t errors;                ///< Calls that failed
+    uint64_t bytes_in;              ///< Encoded bytes passed to loaders
+    uint64_t bytes_out;             ///< Encoded bytes produced by encoders
+    uint64_t latency_ns_sum;        ///< Total wall time of all calls, in nanoseconds
+    uint64_t latency_buckets[IMAGE_LATENCY_BUCKETS]; ///< Calls per latency bucket (not cumulative)
+} ImageOperationStats;
+
+/**
+ * @brief Snapshot of wrapper and libvips statistics
+ */
+typedef struct {
+    ImageOperationStats ops[IMAGE_OP_COUNT];    ///< Indexed by ImageOperation
+    uint64_t vips_mem;              ///< Bytes currently allocated by libvips for pixel buffers
+    uint64_t vips_mem_highwater;    ///< Peak of vips_mem since startup
+    int vips_allocs;                ///< Active libvips pixel buffer allocations
+    int vips_files;                 ///< Files currently open in libvips
+    int cache_size;                 ///< Operations currently in the libvips operation cache
+    int cache_max;                  ///< Operation cache size limit
+    uint64_t result_cache_hits;     ///< process_cached() calls answered from a result cache, all caches
+    uint64_t result_cache_misses;   ///< process_cached() calls that rendered their result
+    uint64_t result_cache_coalesced;    ///< process_cached() calls that waited for another call's render
+    uint64_t result_cache_evictions;    ///< Results evicted to stay within the byte budgets
+    uint64_t result_cache_entries;  ///< Results currently held by all result caches
+    uint64_t result_cache_bytes;    ///< Encoded bytes currently held by all result caches
+} ImageStats;
+
+/**
+ * @brief Take a snapshot of the wrapper's counters and libvips' memory and cache state
+ * 
+ * Counters are updated with relaxed atomics and no locks, so the snapshot is
+ * cheap enough to poll from a metrics scraper.
+ * 
+ * @param stats Output snapshot
+ * 
+ * @example
+ * @code
+ * ImageStats stats;
+ * vips_wrapper_get_stats(&stats);
+ * const ImageOperationStats* enc = &stats.ops[IMAGE_OP_ENCODE];
+ * printf("encode: %llu calls, %llu errors, %.1f ms avg\n",
+ *        (unsigned long long)enc->calls, (unsigned long long)enc->errors,
+ *        enc->calls ? enc->latency_ns_sum / 1e6 / enc->calls : 0.0);
+ * @endcode
+ * 
+ * @note libvips does not count operation cache hits, so only cache occupancy is reported
+ */
+void vips_wrapper_get_stats(ImageStats* stats);
+
+/**
+ * @brief Reset all operation counters to zero (libvips values are unaffected)
+ * 
+ * The result cache hit, miss, coalesced and eviction totals are reset too;
+ * result cache occupancy is not.
+ */
+void vips_wrapper_reset_stats();
+
+/**
+ * @brief Upper bound of a latency histogram bucket
+ * 
+ * Bucket `i` counts calls taking at most 100us * 2^i; the last bucket is unbounded.
+ * 
+ * @param bucket Bucket index (0 .. IMAGE_LATENCY_BUCKETS-1)
+ * @return Upper bound in nanoseconds, or UINT64_MAX for the last bucket
+ */
+uint64_t vips_wrapper_latency_bucket_bound_ns(int bucket);
+
+/**
+ * @brief Stable lower-case name of an operation group, e.g. "resize"
+ * @param op Operation group
+ * @return Static string, or "unknown" for an invalid value
+ */
+const char* vips_wrapper_operation_name(ImageOperation op);
+
+/**
+ * @brief Severity of a log message
+ */
+typedef enum {
+    IMAGE_LOG_ERROR = 0,            ///< A call failed
+    IMAGE_LOG_WARNING               ///< A call succeeded with a caveat
+} ImageLogLevel;
+
+/**
+ * @brief Receives the wrapper's diagnostic messages
+ * 
+ * May be called concurrently from any thread, including worker pool threads.
+ * 
+ * @param level Message severity
+ * @param message NUL-terminated message, valid only during the call
+ * @param user_data Value passed to vips_wrapper_set_log_handler()
+ */
+typedef void (*ImageLogFn)(ImageLogLevel level, const char* message, void* user_data);
+
+/**
+ * @brief Route diagnostic messages to a handler
+ * 
+ * By default messages go to vips_wrapper_log_to_stderr(). Passing NULL
+ * discards them, which keeps error storms from serialising threads on
+ * stderr; failures are still counted in vips_wrapper_get_stats() and
+ * described by vips_wrapper_last_error().
+ * 
+ * @param handler Message handler, or NULL to discard messages
+ * @param user_data Passed through to `handler`
+ * 
+ * @example
+ * @code
+ * vips_wrapper_set_log_handler(NULL, NULL);                       // silence
+ * vips_wrapper_set_log_handler(vips_wrapper_log_to_stderr, NULL); // restore default
+ * @endcode
+ * 
+ * @warning `user_data` must stay valid until another handler is installed
+ */
+void vips_wrapper_set_log_handler(ImageLogFn handler, void* user_data);
+
+/**
+ * @brief Default log handler: writes each message to stderr with a single write
+ */
+void vips_wrapper_log_to_stderr(ImageLogLevel level, const char* message, void* user_data);
+
+//=============================================================================
+// ERROR DETAIL
+//=============================================================================
+
+/// Capacity of ImageError::message, including the terminating NUL
+#define IMAGE_ERROR_MESSAGE_SIZE 1024
+
+/**
+ * @brief Detail of the most recent failed call on the calling thread
+ * 
+ * Recorded into thread-local storage on every failure, whether or not a log
+ * handler is installed. Recording never allocates or locks; long messages are
+ * truncated to fit.
+ */
+typedef struct {
+    ImageStatus code;               ///< Status of the failed call (also for calls returning a handle or buffer)
+    ImageOperation operation;       ///< Operation group of the failed call
+    char message[IMAGE_ERROR_MESSAGE_SIZE]; ///< Wrapper message followed by the libvips error text
+} ImageError;
+
+/**
+ * @brief Detail of the most recent failure on the calling thread
+ * 
+ * Successful calls do not reset the record, so read it only right after a
+ * call reported failure (a SUCCESS-less status, a NULL handle or an empty
+ * buffer), on the same thread. Worker pool failures can be read from inside
+ * the completion callback, which runs on the worker thread.
+ * 
+ * @return Pointer to the calling thread's record, valid until the thread's next
+ *         failing call; code is SUCCESS if nothing failed on this thread yet
+ * 
+ * @example
+ * @code
+ * ImageStatus status;
+ * VImageHandle img = load_image_from_bytes_with_options(data, size, opts, &status);
+ * if (!img) {
+ *     const ImageError* err = vips_wrapper_last_error();
+ *     fprintf(stderr, "%s failed (%d): %s\n",
+ *             vips_wrapper_operation_name(err->operation), err->code, err->message);
+ * }
+ * @endcode
+ */
+const ImageError* vips_wrapper_last_error();
+
+/**
+ * @brief Reset the calling thread's error record to SUCCESS with an empty message
+ */
+void vips_wrapper_clear_error();
+
+//=============================================================================
+// BATCH PROCESSING
+//=============================================================================
+
+/**
+ * @brief One input of process_batch(): a file path or an encoded buffer
+ */
+typedef struct {
+    const char* path;               ///< File to load, or NULL to decode `data`
+    const unsigned char* data;      ///< Encoded image bytes, used when `path` is NULL; copied, not retained
+    size_t size;                    ///< Size of `data` in bytes
+} ImageBatchItem;
+
+/**
+ * @brief The work process_batch() runs on every item
+ * 
+ * Same meaning as the arguments of process_pipeline(); the output format must
+ * not be IMAGE_FORMAT_NONE. Watermark images referenced by `ops` are shared
+ * by all items and must stay valid for the duration of the call.
+ */
+typedef struct {
+    ImageLoadOptions load;          ///< Loader options and limits for every item
+    const ImagePipelineOp* ops;     ///< Operations to apply, in order
+    size_t op_count;                ///< Number of entries in `ops`
+    ImageEncodeSpec output;         ///< Output format and encoder options
+} ImageBatchSpec;
+
+/**
+ * @brief Outcome of one process_batch() item
+ */
+typedef struct {
+    ImageStatus status;             ///< SUCCESS, or the error the item failed with
+    ImageBuffer output;             ///< Encoded output on success, else {NULL, 0}; free with free_image_buffer()
+    ImageError error;               ///< Failure detail when status is not SUCCESS
+} ImageBatchResult;
+
+/**
+ * @brief Load, process and encode many images in one call
+ * 
+ * Whole images are spread over `parallelism` threads (the calling thread is
+ * one of them), each running load, pipeline and encode for one item at a
+ * time. For small images this keeps every core busy where libvips' own
+ * per-image threading cannot, and the whole batch costs a single call.
+ * A failing item does not stop the others.
+ * 
+ * @param items Inputs to process
+ * @param n Number of items
+ * @param spec Loader options, operations and output encoding shared by all items
+ * @param results Receives one result per item, in item order
+ * @param parallelism Images processed at once (0 = one per CPU core)
+ * @return SUCCESS once every item has run (check each result's status), or a
+ *         validation error if nothing was run
+ * 
+ * @example Re-encode stored originals as 1024px JPEGs:
+ * @code
+ * ImagePipelineOp resize = {PIPELINE_OP_RESIZE};
+ * resize.resize = (ImageResizeOptions){1, 1024, 0};
+ * ImageBatchSpec spec = {{IMAGE_ACCESS_SEQUENTIAL}, &resize, 1};
+ * spec.output.format = IMAGE_FORMAT_JPEG;
+ * spec.output.jpeg.quality = 82;
+ * 
+ * vips_wrapper_set_concurrency(1); // one libvips thread per image
+ * process_batch(items, n, spec, results, 0);
+ * for (size_t i = 0; i < n; ++i) {
+ *     if (results[i].status == SUCCESS) store(i, results[i].output);
+ *     else fprintf(stderr, "%zu: %s\n", i, results[i].error.message);
+ *     free_image_buffer(results[i].output);
+ * }
+ * @endcode
+ * 
+ * @note Each image still uses vips_wrapper_set_concurrency() threads inside
+ *       libvips; with many small images a concurrency of 1 avoids oversubscribing the cores
+ */
+ImageStatus process_batch(const ImageBatchItem* items, size_t n, ImageBatchSpec spec, ImageBatchResult* results,
+                          int parallelism);
+
+//=============================================================================
+// RAW PIXEL CACHE
+//=============================================================================
+
+/**
+ * @brief Opaque handle to a raw pixel cache
+ */
+typedef void* ImageRawCacheHandle;
+
+/**
+ * @brief Raw pixel cache location and size bound
+ */
+typedef struct {
+    const char* directory;          ///< Directory holding the cache files; created if missing
+    uint64_t max_bytes;             ///< Total size of the cache files before the least recently used are evicted (0 = unbounded)
+} ImageRawCacheOptions;
+
+/**
+ * @brief Raw pixel cache counters, as seen by this process
+ */
+typedef struct {
+    uint64_t entries;               ///< Files currently indexed
+    uint64_t bytes;                 ///< Total size of the indexed files
+    uint64_t hits;                  ///< load_from_raw_cache() calls that returned an image
+    uint64_t misses;                ///< load_from_raw_cache() calls that returned IMAGE_CACHE_MISS
+    uint64_t evictions;             ///< Files removed to stay within max_bytes
+} ImageRawCacheStats;
+
+/**
+ * @brief Open a directory of decoded images kept for repeated derivative generation
+ * 
+ * Entries are stored uncompressed in the libvips `.v` format, which is mapped
+ * rather than decoded on load: re-rendering a cached master costs page-ins
+ * instead of a JPEG/PNG decode. Files already in the directory are indexed,
+ * oldest first, so a cache survives restarts and can be shared by several
+ * processes on one disk; each process enforces `max_bytes` on what it sees.
+ * Temporary files left by writers that crashed (untouched for 10 minutes)
+ * are deleted.
+ * 
+ * @param options Directory and size bound
+ * @param status Receives SUCCESS or the failure code (may be NULL)
+ * @return Cache handle, or NULL if the directory cannot be created or read
+ * 
+ * @example Decode each master once, at the largest size ever served:
+ * @code
+ * ImageRawCacheOptions opts = {"/ssd/vips-cache", 50ull << 30}; // 50GB
+ * ImageRawCacheHandle cache = create_raw_cache(opts, NULL);
+ * 
+ * ImageStatus status;
+ * VImageHandle master = load_from_raw_cache(cache, key, &status);
+ * if (status == IMAGE_CACHE_MISS) {
+ *     master = thumbnail_from_path(path, (ImageResizeOptions){1, 4096, 4096}, &status);
+ *     if (master) export_to_raw_cache(cache, key, master);
+ * }
+ * // ... renditions / pipelines from master ...
+ * @endcode
+ */
+ImageRawCacheHandle create_raw_cache(ImageRawCacheOptions options, ImageStatus* status);
+
+/**
+ * @brief Store the decoded pixels of an image under `key`
+ * 
+ * The image is rendered (any pending operations run now) and written to a
+ * temporary file that is renamed into place, so concurrent readers see the
+ * old entry or the new one, never a partial file. An existing entry for the
+ * key is replaced. Least recently used entries are then evicted until the
+ * cache fits `max_bytes`.
+ * 
+ * @param cache Cache handle
+ * @param key Caller-chosen identifier, e.g. master path plus pre-shrink size
+ * @param handle Image to store; resize it first to cache a pre-shrunk copy
+ * @return SUCCESS, IMAGE_TOO_LARGE if the entry alone exceeds max_bytes, or
+ *         IMAGE_SAVE_FAILURE if the file could not be written
+ */
+ImageStatus export_to_raw_cache(ImageRawCacheHandle cache, const char* key, VImageHandle handle);
+
+/**
+ * @brief Load the image stored under `key`
+ * 
+ * The file is mapped, not decoded, and allows random access. A hit marks the
+ * entry as most recently used. Entries written by other processes are
+ * picked up on first use.
+ * 
+ * @param cache Cache handle
+ * @param key Identifier passed to export_to_raw_cache()
+ * @param status Receives SUCCESS, IMAGE_CACHE_MISS, or another failure code (may be NULL)
+ * @return VImageHandle on a hit, NULL otherwise
+ * 
+ * @note An entry evicted while images loaded from it are alive stays readable
+ *       through them until they are freed
+ */
+VImageHandle load_from_raw_cache(ImageRawCacheHandle cache, const char* key, ImageStatus* status);
+
+/**
+ * @brief Read the counters of a raw pixel cache
+ * @param cache Cache handle
+ * @return Counters, all zero for a NULL cache
+ */
+ImageRawCacheStats raw_cache_stats(ImageRawCacheHandle cache);
+
+/**
+ * @brief Close a raw pixel cache
+ * 
+ * The files stay on disk for the next create_raw_cache() on the directory.
+ * 
+ * @param cache Cache handle (NULL is ignored)
+ */
+void destroy_raw_cache(ImageRawCacheHandle cache);
+
+//=============================================================================
+// RESULT CACHE
+//=============================================================================
+
+/**
+ * @brief Opaque handle to an in-memory cache of encoded pipeline outputs
+ */
+typedef void* ImageResultCacheHandle;
+
+/**
+ * @brief Result cache size and sharding
+ * 
+ * The byte budget is split evenly between the shards, and each shard evicts on
+ * its own; an output larger than one shard's budget is returned but not kept.
+ */
+typedef struct {
+    uint64_t max_bytes;             ///< Encoded bytes kept before least recently used results are evicted (0 = 64 MiB)
+    int shards;                     ///< Independently locked partitions (0 = 16)
+} ImageResultCacheOptions;
+
+/**
+ * @brief Result cache counters
+ */
+typedef struct {
+    uint64_t entries;               ///< Results currently held
+    uint64_t bytes;                 ///< Encoded bytes currently held
+    uint64_t hits;                  ///< process_cached() calls answered from the cache
+    uint64_t misses;                ///< process_cached() calls that rendered their result
+    uint64_t coalesced;             ///< process_cached() calls that waited for an identical call's render
+    uint64_t evictions;             ///< Results evicted to stay within max_bytes
+} ImageResultCacheStats;
+
+/**
+ * @brief Shared, read-only reference to a cached encoded output
+ * 
+ * The bytes stay valid until the reference is released, even if the result is
+ * evicted or the cache destroyed in the meantime.
+ */
+typedef struct {
+    const unsigned char* data;      ///< Encoded bytes (do not modify or free)
+    size_t size;                    ///< Size of data in bytes
+    void* ref;                      ///< Reference to release with release_cached_buffer()
+} ImageCachedBuffer;
+
+/**
+ * @brief Create a cache of encoded outputs for repeated identical requests
+ * 
+ * @param options Byte budget and shard count
+ * @param status Receives SUCCESS or the failure code (may be NULL)
+ * @return Cache handle, or NULL on allocation failure
+ */
+ImageResultCacheHandle create_result_cache(ImageResultCacheOptions options, ImageStatus* status);
+
+/**
+ * @brief Decode, process and encode an image, or return the stored result of an identical call
+ * 
+ * Results are keyed on a 128-bit hash of the input bytes and the size, plus
+ * every option that can change the output: the load options other than
+ * `access`, the operations and the encoder options of the output format.
+ * Concurrent calls with the same key are coalesced: one of them renders, the
+ * others wait and share its result (or its error). Failures are not cached.
+ * 
+ * Pipelines with a PIPELINE_OP_WATERMARK step are rendered every time, because
+ * the overlay's pixels are not part of the key. Prepared watermarks are keyed
+ * by identity, so results made with a freed watermark are never reused.
+ * 
+ * @param cache Cache handle
+ * @param data Encoded input image; only read during the call (a miss decodes a
+ *             copy, so the buffer is not retained)
+ * @param size Size of data in bytes
+ * @param load Loader options and limits, as for load_image_from_bytes_with_options()
+ * @param ops Operations to apply, in order (may be NULL when n is 0)
+ * @param n Number of operations
+ * @param out Output format and encoder options; the format must not be IMAGE_FORMAT_NONE
+ * @param result Receives the shared encoded output on success, {NULL, 0, NULL} otherwise
+ * @return SUCCESS or the failure code of the load, pipeline or encode
+ * 
+ * @example Serve hot thumbnails without re-encoding them:
+ * @code
+ * ImageResultCacheHandle cache = create_result_cache((ImageResultCacheOptions){256ull << 20}, NULL);
+ * 
+ * ImagePipelineOp resize = {PIPELINE_OP_RESIZE};
+ * resize.resize = (ImageResizeOptions){1, 320, 320};
+ * ImageEncodeSpec out = {IMAGE_FORMAT_WEBP};
+ * out.webp.quality = 75;
+ * 
+ * ImageCachedBuffer thumb;
+ * if (process_cached(cache, data, size, (ImageLoadOptions){0}, &resize, 1, out, &thumb) == SUCCESS) {
+ *     send_response(thumb.data, thumb.size);
+ *     release_cached_buffer(thumb);
+ * }
+ * @endcode
+ * 
+ * @note Only the input bytes identify the source: a different image with the
+ *       same 128-bit hash and size would be served the other's result
+ */
+ImageStatus process_cached(ImageResultCacheHandle cache, const unsigned char* data, size_t size,
+                           ImageLoadOptions load, const ImagePipelineOp* ops, size_t n, ImageEncodeSpec out,
+                           ImageCachedBuffer* result);
+
+/**
+ * @brief Release a reference returned by process_cached()
+ * @param buffer Buffer to release (a NULL ref is ignored)
+ */
+void release_cached_buffer(ImageCachedBuffer buffer);
+
+/**
+ * @brief Read the counters of a result cache
+ * 
+ * The totals over all result caches are also in ImageStats.
+ * 
+ * @param cache Cache handle
+ * @return Counters, all zero for a NULL cache
+ */
+ImageResultCacheStats result_cache_stats(ImageResultCacheHandle cache);
+
+/**
+ * @brief Free a result cache and its results
+ * 
+ * No process_cached() call may be running on the cache. Buffers still
+ * referenced by callers stay valid until released.
+ * 
+ * @param cache Cache handle (NULL is ignored)
+ */
+void destroy_result_cache(ImageResultCacheHandle cache);
+
+//=============================================================================
+// REGIONS AND TILE PYRAMIDS
+//=============================================================================
+
+/**
+ * @brief Sample type of raw pixels, in libvips band format order
+ */
+typedef enum {
+    IMAGE_SAMPLE_UCHAR = 0,         ///< unsigned 8-bit (JPEG, 8-bit PNG, ...)
+    IMAGE_SAMPLE_CHAR,              ///< signed 8-bit
+    IMAGE_SAMPLE_USHORT,            ///< unsigned 16-bit (16-bit PNG and TIFF)
+    IMAGE_SAMPLE_SHORT,             ///< signed 16-bit
+    IMAGE_SAMPLE_UINT,              ///< unsigned 32-bit
+    IMAGE_SAMPLE_INT,               ///< signed 32-bit
+    IMAGE_SAMPLE_FLOAT,             ///< 32-bit float
+    IMAGE_SAMPLE_COMPLEX,           ///< two 32-bit floats
+    IMAGE_SAMPLE_DOUBLE,            ///< 64-bit float
+    IMAGE_SAMPLE_DPCOMPLEX          ///< two 64-bit floats
+} ImageSampleFormat;
+
+/**
+ * @brief Layout of the pixels written by fetch_region()
+ *
+ * Rows are packed top to bottom with no padding; each pixel holds `bands`
+ * interleaved samples in native byte order.
+ */
+typedef struct {
+    int width;                      ///< Region width in pixels
+    int height;                     ///< Region height in pixels
+    int bands;                      ///< Samples per pixel (3 = RGB, 4 = RGBA, ...)
+    ImageSampleFormat format;       ///< Sample type
+    size_t bytes_per_pixel;         ///< bands * sample size
+    size_t stride;                  ///< Bytes per row: width * bytes_per_pixel
+} ImagePixelLayout;
+
+/**
+ * @brief Read the raw pixels of a rectangle of an image
+ *
+ * Only the rectangle is computed: for tiled or mapped sources (tiled TIFF,
+ * `.v` files, raw cache entries) and the transforms on top of them, the cost
+ * grows with the region, not with the image. Pending operations run for the
+ * requested pixels only.
+ *
+ * `*layout` is filled in before anything is computed, so a call with a NULL
+ * or short buffer returns IMAGE_BUFFER_TOO_SMALL cheaply and tells the
+ * caller how much to allocate.
+ *
+ * @param handle Image to read; not modified
+ * @param x Left edge of the region (0-based)
+ * @param y Top edge of the region (0-based)
+ * @param width Region width in pixels
+ * @param height Region height in pixels
+ * @param out Destination buffer (may be NULL when capacity is 0)
+ * @param capacity Size of `out` in bytes
+ * @param layout Receives the pixel layout; the needed size is stride * height (may be NULL)
+ * @return SUCCESS, IMAGE_INVALID_DIMENSIONS, IMAGE_INVALID_BOUNDS if the region
+ *         leaves the image, IMAGE_BUFFER_TOO_SMALL, or VIPS_ERROR
+ *
+ * @example Serve 256x256 tiles of a gigapixel TIFF:
+ * @code
+ * VImageHandle map = load_image("/data/map.tif"); // random access: tiles are read on demand
+ * unsigned char tile[256 * 256 * 4];
+ * ImagePixelLayout layout;
+ * if (fetch_region(map, col * 256, row * 256, 256, 256, tile, sizeof(tile), &layout) == SUCCESS) {
+ *     send_pixels(tile, layout.stride * layout.height);
+ * }
+ * @endcode
+ *
+ * @note A handle loaded with IMAGE_ACCESS_SEQUENTIAL is decoded in full on
+ *       every call; load with IMAGE_ACCESS_RANDOM to read regions
+ */
+ImageStatus fetch_region(const VImageHandle handle, int x, int y, int width, int height,
+                         unsigned char* out, size_t capacity, ImagePixelLayout* layout);
+
+/**
+ * @brief Directory layouts of generate_tile_pyramid()
+ */
+typedef enum {
+    IMAGE_TILE_LAYOUT_DZ = 0,       ///< Deep Zoom: `name.dzi` plus `name_files/<level>/<col>_<row>` (default)
+    IMAGE_TILE_LAYOUT_ZOOMIFY,      ///< Zoomify: `name/ImageProperties.xml` plus `TileGroup<n>/`
+    IMAGE_TILE_LAYOUT_GOOGLE,       ///< Google Maps: `name/<z>/<y>/<x>`, square tiles padded with the background
+    IMAGE_TILE_LAYOUT_IIIF          ///< IIIF Image API 2: `name/info.json` plus region/size paths
+} ImageTileLayout;
+
+/**
+ * @brief How far down generate_tile_pyramid() shrinks
+ */
+typedef enum {
+    IMAGE_TILE_DEPTH_ONEPIXEL = 0,  ///< Until the image is one pixel (Deep Zoom default)
+    IMAGE_TILE_DEPTH_ONETILE,       ///< Until the image fits in one tile
+    IMAGE_TILE_DEPTH_ONE            ///< Full resolution only
+} ImageTileDepth;
+
+/**
+ * @brief Options for generate_tile_pyramid()
+ *
+ * Tiles are encoded with `tiles`: JPEG (the default for IMAGE_FORMAT_NONE),
+ * PNG or WebP. Of the encoder options, quality, lossless, compression and
+ * effort are used.
+ */
+typedef struct {
+    ImageTileLayout layout;         ///< Directory layout
+    int tile_size;                  ///< Tile edge in pixels (0 = 254 for Deep Zoom, 256 otherwise)
+    int overlap;                    ///< Pixels shared by neighbouring tiles (Deep Zoom only; 0 = none)
+    ImageTileDepth depth;           ///< Pyramid depth
+    ImageEncodeSpec tiles;          ///< Tile format and encoder options
+} ImageTilePyramidOptions;
+
+/**
+ * @brief Write a zoomable tile pyramid of an image
+ *
+ * The image is read once, top to bottom, and every level is shrunk from the
+ * one above in the same pass, so even sequentially loaded gigapixel images
+ * need memory for a few rows of tiles only. Tiles are encoded and written by
+ * libvips' worker threads in parallel (see vips_wrapper_set_concurrency()).
+ *
+ * @param handle Image to tile
+ * @param path Output name without extension: `/srv/tiles/map` writes
+ *        `/srv/tiles/map.dzi` and `/srv/tiles/map_files/` for Deep Zoom
+ * @param options Layout, tile size and tile encoding
+ * @return SUCCESS, IMAGE_INVALID_PATH, IMAGE_INVALID_DIMENSIONS,
+ *         IMAGE_INVALID_FORMAT, or IMAGE_SAVE_FAILURE
+ *
+ * @example
+ * @code
+ * ImageLoadOptions load = {IMAGE_ACCESS_SEQUENTIAL};
+ * VImageHandle scan = load_image_with_options("/data/slide.tif", load, NULL);
+ * ImageTilePyramidOptions opts = {IMAGE_TILE_LAYOUT_DZ, 256, 1};
+ * opts.tiles.format = IMAGE_FORMAT_WEBP;
+ * opts.tiles.webp.quality = 80;
+ * generate_tile_pyramid(scan, "/srv/tiles/slide", opts);
+ * @endcode
+ */
+ImageStatus generate_tile_pyramid(const VImageHandle handle, const char* path, ImageTilePyramidOptions options);
+
+//=============================================================================
+// RAW PIXEL INTERCHANGE
+//=============================================================================
+
+/**
+ * @brief Wrap raw interleaved pixels as an image
+ * 
+ * The counterpart of write_to_memory() for pixels that come from elsewhere: a
+ * camera, a GPU readback or a model output. Rows are packed top to bottom,
+ * each pixel holding `bands` interleaved samples of `format` in native byte
+ * order. The interpretation is set from the band count: 1-2 bands are
+ * greyscale (with alpha), 3-4 are sRGB (with alpha) and anything else is
+ * multiband; 16-bit samples map to GREY16/RGB16.
+ * 
+ * With a NULL `release` the pixels are copied and stay with the caller. With
+ * a `release` callback they are used in place, as in load_image_from_owned_bytes():
+ * ownership passes to the library on entry and `release` is called exactly
+ * once, when libvips closes the last image that reads from the pixels or,
+ * on failure, before this function returns.
+ * 
+ * @param pixels Interleaved pixel data
+ * @param size Size of `pixels` in bytes; at least width * height * bands * sample size
+ * @param width Image width in pixels
+ * @param height Image height in pixels
+ * @param bands Samples per pixel
+ * @param format Sample type
+ * @param release Callback that hands the pixels back to their owner, or NULL to copy them
+ * @param user_data Opaque pointer passed through to `release`
+ * @param status Receives SUCCESS or the failure code (may be NULL); see vips_wrapper_last_error()
+ * @return VImageHandle on success, NULL on failure; the status is IMAGE_INVALID_DIMENSIONS
+ *         for a non-positive size, IMAGE_INVALID_FORMAT for an unknown sample type and
+ *         IMAGE_BUFFER_TOO_SMALL if `size` is short of the pixel data
+ * 
+ * @example Encode a model output without an intermediate file:
+ * @code
+ * VImageHandle mask = load_image_from_memory(output, 512 * 512, 512, 512, 1,
+ *                                            IMAGE_SAMPLE_UCHAR, NULL, NULL, NULL);
+ * ImageBuffer png = encode_to_png(mask, (ImageEncodePNGOptions){0});
+ * @endcode
+ * 
+ * @note Both variants count as loads in vips_wrapper_get_stats()
+ */
+VImageHandle load_image_from_memory(const void* pixels, size_t size, int width, int height, int bands,
+                                    ImageSampleFormat format, ImageBufferReleaseFn release, void* user_data,
+                                    ImageStatus* status);
+
+/**
+ * @brief Axis order of the samples written by write_to_memory()
+ */
+typedef enum {
+    IMAGE_TENSOR_HWC = 0,           ///< Interleaved: row, column, band (as libvips stores pixels)
+    IMAGE_TENSOR_CHW                ///< Planar: one plane per band, each row by row (PyTorch, ONNX)
+} ImageTensorOrder;
+
+/**
+ * @brief Output layout and normalisation of write_to_memory()
+ * 
+ * Each sample is written as `(v * scale - mean[b]) / std[b]`, where `b` is its
+ * band. The zero defaults write the samples unchanged; `{.scale = 1.0f / 255}`
+ * maps 8-bit pixels to [0, 1]. Values outside the range of IMAGE_SAMPLE_UCHAR
+ * are clipped.
+ */
+typedef struct {
+    ImageTensorOrder order;         ///< Interleaved or planar
+    ImageSampleFormat format;       ///< IMAGE_SAMPLE_UCHAR (default) or IMAGE_SAMPLE_FLOAT
+    size_t row_stride;              ///< Bytes from one row to the next, e.g. rounded up for aligned rows (0 = packed)
+    float scale;                    ///< Applied before mean and std (0 = 1)
+    float mean[4];                  ///< Subtracted per band after scaling
+    float std[4];                   ///< Divisor per band after the mean (0 = 1)
+} ImageTensorSpec;
+
+/**
+ * @brief Write the pixels of an image into a caller-allocated tensor
+ * 
+ * Pending operations, the conversion to the output sample type, the
+ * normalisation and the interleaved-to-planar reordering all run in one
+ * streaming pass over the image: strips are computed by libvips' worker
+ * threads and written straight into `out`, with no encoded or decoded
+ * intermediate. Sequentially loaded images work.
+ * 
+ * The output is `height` rows of `row_stride` bytes for IMAGE_TENSOR_HWC and
+ * `bands` such planes back to back for IMAGE_TENSOR_CHW. `*out_size` is set
+ * before anything is computed, so a call with a NULL or short buffer returns
+ * IMAGE_BUFFER_TOO_SMALL cheaply and tells the caller how much to allocate.
+ * 
+ * @param handle Image to write; not modified
+ * @param spec Layout, sample type and normalisation
+ * @param out Destination, aligned to the sample size (may be NULL when capacity is 0)
+ * @param capacity Size of `out` in bytes
+ * @param out_size Receives the number of bytes the tensor needs (may be NULL)
+ * @return SUCCESS, IMAGE_INVALID_FORMAT for an unsupported sample type or order,
+ *         IMAGE_INVALID_DIMENSIONS for a short row_stride, a misaligned `out` or
+ *         mean/std on an image with more than 4 bands, IMAGE_BUFFER_TOO_SMALL, or VIPS_ERROR
+ * 
+ * @example ImageNet input for a 224x224 model:
+ * @code
+ * ensure_srgb8(img, (ImageSRGBOptions){0});
+ * cover_image(img, (ImageCoverOptions){224, 224});
+ * 
+ * ImageTensorSpec spec = {IMAGE_TENSOR_CHW, IMAGE_SAMPLE_FLOAT, 0, 1.0f / 255,
+ *                         {0.485f, 0.456f, 0.406f}, {0.229f, 0.224f, 0.225f}};
+ * float input[3 * 224 * 224];
+ * size_t needed;
+ * write_to_memory(img, spec, input, sizeof(input), &needed);
+ * @endcode
+ * 
+ * @note Apply ensure_srgb8() first for 16-bit or CMYK sources: samples are
+ *       converted by value, not rescaled
+ */
+ImageStatus write_to_memory(const VImageHandle handle, ImageTensorSpec spec, void* out, size_t capacity,
+                            size_t* out_size);
+
+//=============================================================================
+// CANCELLATION AND DEADLINES
+//=============================================================================
+
+/**
+ * @brief Opaque cancel token
+ * 
+ * Created by create_cancel_token(), passed to the *_cancellable calls, released
+ * by free_cancel_token().
+ */
+typedef void* ImageCancelHandle;
+
+/**
+ * @brief Create a cancel token, optionally with a deadline
+ * 
+ * A token is cancelled when cancel_token_cancel() is called or its deadline
+ * passes, whichever comes first. Cancellation is permanent: use a new token
+ * for each request.
+ * 
+ * @param timeout_ms Deadline in milliseconds from now (0 = no deadline,
+ *        negative = already expired)
+ * @return Token handle, or NULL if out of memory
+ */
+ImageCancelHandle create_cancel_token(int64_t timeout_ms);
+
+/**
+ * @brief Cancel a token
+ * 
+ * Safe to call from any thread, any number of times, while calls using the
+ * token are running. Running calls stop at the next strip of pixels they
+ * compute and return IMAGE_CANCELLED.
+ * 
+ * @param token Token to cancel (NULL is ignored)
+ */
+void cancel_token_cancel(ImageCancelHandle token);
+
+/**
+ * @brief Check whether a token has been cancelled or is past its deadline
+ * 
+ * @param token Token to check
+ * @return 1 if cancelled, 0 otherwise (also for NULL)
+ */
+int cancel_token_is_cancelled(ImageCancelHandle token);
+
+/**
+ * @brief Release a cancel token
+ * 
+ * Calls still running with the token keep their own reference, so it may be
+ * freed at any time.
+ * 
+ * @param token Token to release (NULL is ignored)
+ */
+void free_cancel_token(ImageCancelHandle token);
+
+/**
+ * @brief process_pipeline() that can be cancelled while it runs
+ * 
+ * The token is checked before the pipeline starts and then on every strip of
+ * pixels the encoder asks for. Once it is cancelled, libvips' worker threads
+ * are stopped through the image's kill flag, the partial output is freed and
+ * the call returns IMAGE_CANCELLED, normally within the time it takes to
+ * compute one strip. The source handle is not affected and can be reused.
+ * 
+ * With zero operations this is a cancellable encode.
+ * 
+ * @param handle VImageHandle of the source image
+ * @param ops Operations to apply, in order (may be NULL when n is 0)
+ * @param n Number of operations
+ * @param out Output format and encoder options; for IMAGE_FORMAT_NONE the
+ *            token is checked only before the operations are applied
+ * @param result Receives the encoded data (may be NULL for IMAGE_FORMAT_NONE)
+ * @param cancel Cancel token (NULL = process_pipeline())
+ * @return SUCCESS, IMAGE_CANCELLED, or the error codes of process_pipeline()
+ * 
+ * @example Give up on an encode after 2 seconds:
+ * @code
+ * ImageCancelHandle deadline = create_cancel_token(2000);
+ * ImageEncodeSpec out = {IMAGE_FORMAT_JPEG};
+ * out.jpeg.quality = 85;
+ * ImageBuffer jpeg = {0};
+ * ImageStatus status = process_pipeline_cancellable(img, NULL, 0, out, &jpeg, deadline);
+ * free_cancel_token(deadline);
+ * if (status == IMAGE_CANCELLED) {
+ *     // nothing to free; jpeg.data is NULL
+ * }
+ * @endcode
+ * 
+ * @note Work libvips does before the first strip (e.g. rendering a rotated
+ *       sequential image into memory) runs to completion before the token is seen
+ */
+ImageStatus process_pipeline_cancellable(VImageHandle handle, const ImagePipelineOp* ops, size_t n,
+                                         ImageEncodeSpec out, ImageBuffer* result, ImageCancelHandle cancel);
+
+//=============================================================================
+// SCHEDULING AND PROGRESS
+//=============================================================================
+
+/**
+ * @brief Adaptive thread allocation for pipelines
+ * 
+ * With a global concurrency setting every pipeline asks libvips for the same
+ * number of threads, so one very large image can occupy the whole machine
+ * while small requests queue up behind it. The scheduler instead sizes each
+ * render from its pixel count (the larger of the source and the output, both
+ * known from the header before any pixel is decoded): one thread per
+ * `pixels_per_thread` pixels, at least 1 and at most `max_threads`.
+ * 
+ * All threads handed out come from a shared `thread_budget`. A render never
+ * waits for the budget: when it is used up it gets a single thread, so
+ * small images keep flowing while a large one runs.
+ */
+typedef struct {
+    int64_t pixels_per_thread;  ///< Pixels per worker thread (0 = scheduler off, use the global concurrency)
+    int max_threads;            ///< Most threads one render may use (0 = the libvips concurrency setting)
+    int thread_budget;          ///< Threads shared by all running renders (0 = one per CPU core)
+} ImageSchedulerOptions;
+
+/**
+ * @brief Enable, change or disable the adaptive scheduler
+ * 
+ * Applies to every pipeline render started after the call, including worker
+ * pool jobs, batches and result cache misses.
+ * 
+ * @param options Scheduler settings, or NULL to disable it
+ * 
+ * @example Small images single-threaded, up to 8 threads from 24 MP:
+ * @code
+ * ImageSchedulerOptions sched = {3000000, 8, 0}; // 3 MP per thread
+ * vips_wrapper_set_scheduler(&sched);
+ * @endcode
+ */
+void vips_wrapper_set_scheduler(const ImageSchedulerOptions* options);
+
+/**
+ * @brief Get the scheduler settings and the threads currently handed out
+ * 
+ * @param options Receives the settings in effect (all zero when disabled)
+ * @return Threads currently held by running renders
+ */
+int vips_wrapper_get_scheduler(ImageSchedulerOptions* options);
+
+/**
+ * @brief Called as a render advances
+ * 
+ * @param percent Share of the output computed so far, 0-100. Each value is
+ *        reported at most once, in increasing order, and 100 only once the
+ *        render has succeeded.
+ * @param user_data Value given in ImageRunOptions
+ * 
+ * @warning Runs on libvips worker threads (calls never overlap); keep it short
+ *          and do not call back into the SDK for the same image
+ */
+typedef void (*ImageProgressFn)(int percent, void* user_data);
+
+/**
+ * @brief Per-call controls of process_pipeline_ex()
+ * 
+ * Zero-initialised fields keep the behavior of process_pipeline().
+ */
+typedef struct {
+    ImageCancelHandle cancel;   ///< Cancel token (NULL = not cancellable)
+    int concurrency;            ///< Threads for this render (0 = chosen by the scheduler or global setting)
+    ImageProgressFn progress;   ///< Progress callback (NULL = none)
+    void* user_data;            ///< Passed to `progress`
+} ImageRunOptions;
+
+/**
+ * @brief process_pipeline() with cancellation, a thread count and progress reports
+ * 
+ * Progress is measured on the pixels the encoder pulls through the pipeline,
+ * so it covers decode and all operations. An explicit `concurrency` bypasses
+ * the scheduler and is not counted against its budget.
+ * 
+ * @param handle VImageHandle of the source image
+ * @param ops Operations to apply, in order (may be NULL when n is 0)
+ * @param n Number of operations
+ * @param out Output format and encoder options; with IMAGE_FORMAT_NONE
+ *            nothing is rendered, so only `cancel` is used
+ * @param result Receives the encoded data (may be NULL for IMAGE_FORMAT_NONE)
+ * @param run Per-call controls (NULL = process_pipeline())
+ * @return SUCCESS, IMAGE_CANCELLED, or the error codes of process_pipeline()
+ * 
+ * @example Report progress of a large encode:
+ * @code
+ * static void on_progress(int percent, void* job) {
+ *     update_job_status(job, percent);
+ * }
+ * 
+ * ImageRunOptions run = {};
+ * run.progress = on_progress;
+ * run.user_data = job;
+ * ImageStatus status = process_pipeline_ex(img, ops, 2, out, &result, &run);
+ * @endcode
+ * 
+ * @note libvips only honours per-render thread counts from 8.13 on; with
+ *       older versions `concurrency` and the scheduler have no effect
+ */
+ImageStatus process_pipeline_ex(VImageHandle handle, const ImagePipelineOp* ops, size_t n, ImageEncodeSpec out,
+                                ImageBuffer* result, const ImageRunOptions* run);
+
 //=============================================================================
 // USAGE EXAMPLES AND BEST PRACTICES
 //=============================================================================
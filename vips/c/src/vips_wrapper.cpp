@@ -1,10 +1,30 @@
 #include "vips_wrapper.h"
 #include <vips/vips8>
+#include <cstdio>
 #include <cstring>
-#include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <cmath>
 #include <memory>
+#include <mutex>
+#include <new>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 using namespace vips;
 
@@ -18,560 +38,6078 @@ struct VImageCleanup {
 // Type alias for a smart pointer to VImage
 using VImagePtr = std::unique_ptr<VImage, VImageCleanup>;
 
+// Custom deleter releasing our reference to a VipsBlob
+struct VipsBlobCleanup {
+    void operator()(VipsBlob* blob) const {
+        vips_area_unref(VIPS_AREA(blob));
+    }
+};
+
+// Type alias for a smart pointer to VipsBlob
+using VipsBlobPtr = std::unique_ptr<VipsBlob, VipsBlobCleanup>;
+
+//=============================================================================
+// Logging and operation counters. Both are lock-free on the hot path so that
+// error storms and metric updates do not serialise worker threads.
+//=============================================================================
+
+// Installed log handler; replaced sinks are leaked since a logging thread may still read them
+struct LogSink {
+    ImageLogFn handler;
+    void* user_data;
+};
+
+static const LogSink default_log_sink{vips_wrapper_log_to_stderr, nullptr};
+static std::atomic<const LogSink*> log_sink{&default_log_sink};
+
+// Detail of the last failed call on this thread, returned by vips_wrapper_last_error()
+static thread_local ImageError last_error{SUCCESS, IMAGE_OP_LOAD, {0}};
+
+/**
+ * @brief Streams message fragments into a fixed NUL-terminated buffer, truncating silently.
+ *
+ * Used instead of std::ostringstream so that failing calls neither allocate nor lock.
+ */
+class MessageBuffer {
+public:
+    MessageBuffer(char* data, size_t size) : data_(data), size_(size) {
+        data_[0] = '\0';
+    }
+
+    MessageBuffer& operator<<(const char* text) {
+        append(text ? text : "(null)", text ? std::strlen(text) : 6);
+        return *this;
+    }
+
+    MessageBuffer& operator<<(const std::string& text) {
+        append(text.data(), text.size());
+        return *this;
+    }
+
+    MessageBuffer& operator<<(double value) {
+        char digits[32];
+        int n = std::snprintf(digits, sizeof(digits), "%g", value);
+        append(digits, n > 0 ? static_cast<size_t>(n) : 0);
+        return *this;
+    }
+
+    /// Integers and enums are written in decimal
+    template <typename T, typename = typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+    MessageBuffer& operator<<(T value) {
+        char digits[24];
+        int n = std::is_signed<T>::value || std::is_enum<T>::value
+            ? std::snprintf(digits, sizeof(digits), "%lld", static_cast<long long>(value))
+            : std::snprintf(digits, sizeof(digits), "%llu", static_cast<unsigned long long>(value));
+        append(digits, n > 0 ? static_cast<size_t>(n) : 0);
+        return *this;
+    }
+
+private:
+    void append(const char* text, size_t length) {
+        size_t room = size_ - 1 - used_;
+        length = std::min(length, room);
+        std::memcpy(data_ + used_, text, length);
+        used_ += length;
+        data_[used_] = '\0';
+    }
+
+    char* data_;
+    size_t size_;
+    size_t used_ = 0;
+};
+
+/**
+ * @brief Formats its arguments into a message and passes it to the installed log handler.
+ *
+ * Nothing is formatted when logging is disabled.
+ */
+template <typename... Args>
+static void log_message(ImageLogLevel level, const Args&... args) {
+    const LogSink* sink = log_sink.load(std::memory_order_acquire);
+    if (!sink->handler) {
+        return;
+    }
+    thread_local char text[IMAGE_ERROR_MESSAGE_SIZE];
+    MessageBuffer message(text, sizeof(text));
+    (message << ... << args);
+    sink->handler(level, text, sink->user_data);
+}
+
+/**
+ * @brief Stores the error message of the current call in the thread's ImageError without logging it.
+ */
+template <typename... Args>
+static void set_error_message(const Args&... args) {
+    MessageBuffer message(last_error.message, sizeof(last_error.message));
+    (message << ... << args);
+}
+
+/**
+ * @brief Records an error message in the thread's ImageError and logs it.
+ *
+ * The message is always recorded, even with logging disabled, so that callers can
+ * read it back through vips_wrapper_last_error().
+ */
+template <typename... Args>
+static void log_error(const Args&... args) {
+    set_error_message(args...);
+    const LogSink* sink = log_sink.load(std::memory_order_acquire);
+    if (sink->handler) {
+        sink->handler(IMAGE_LOG_ERROR, last_error.message, sink->user_data);
+    }
+}
+
+/**
+ * @brief Records the status of a failed call in the thread's ImageError and returns it.
+ */
+static ImageStatus fail(ImageOperation op, ImageStatus status) {
+    last_error.code = status;
+    last_error.operation = op;
+    return status;
+}
+
+// Live counters behind ImageOperationStats
+struct OperationCounters {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> errors;
+    std::atomic<uint64_t> bytes_in;
+    std::atomic<uint64_t> bytes_out;
+    std::atomic<uint64_t> latency_ns_sum;
+    std::atomic<uint64_t> latency_buckets[IMAGE_LATENCY_BUCKETS];
+};
+
+static OperationCounters operation_counters[IMAGE_OP_COUNT];
+
+// Upper bound of latency bucket 0; each following bucket doubles it
+static const uint64_t LATENCY_BUCKET_BASE_NS = 100000;
+
+/**
+ * @brief Returns the histogram bucket for a call that took `ns` nanoseconds.
+ */
+static int latency_bucket(uint64_t ns) {
+    int bucket = 0;
+    uint64_t bound = LATENCY_BUCKET_BASE_NS;
+    while (bucket < IMAGE_LATENCY_BUCKETS - 1 && ns > bound) {
+        bound <<= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Times one wrapper call and records it in operation_counters when it goes out of scope.
+ *
+ * A call counts as failed unless succeed() (or finish() with SUCCESS) is reached;
+ * failures are also recorded in the thread's ImageError with the status given to
+ * fail()/finish(), UNKNOWN_ERROR if none was, and reported through `status_out`.
+ */
+class OperationTimer {
+public:
+    explicit OperationTimer(ImageOperation op, uint64_t bytes_in = 0, ImageStatus* status_out = nullptr)
+        : op_(op), counters_(operation_counters[op]), bytes_in_(bytes_in), status_out_(status_out),
+          start_(std::chrono::steady_clock::now()) {}
+
+    ~OperationTimer() {
+        uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                std::chrono::steady_clock::now() - start_).count());
+        counters_.calls.fetch_add(1, std::memory_order_relaxed);
+        if (!succeeded_) {
+            counters_.errors.fetch_add(1, std::memory_order_relaxed);
+            ::fail(op_, status_);
+        }
+        if (bytes_in_) counters_.bytes_in.fetch_add(bytes_in_, std::memory_order_relaxed);
+        if (bytes_out_) counters_.bytes_out.fetch_add(bytes_out_, std::memory_order_relaxed);
+        counters_.latency_ns_sum.fetch_add(ns, std::memory_order_relaxed);
+        counters_.latency_buckets[latency_bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        if (status_out_) *status_out_ = succeeded_ ? SUCCESS : status_;
+    }
+
+    OperationTimer(const OperationTimer&) = delete;
+    OperationTimer& operator=(const OperationTimer&) = delete;
+
+    /// Marks the call successful, recording `bytes_out` encoded bytes, and returns `value`.
+    template <typename T>
+    T succeed(T value, uint64_t bytes_out = 0) {
+        succeeded_ = true;
+        bytes_out_ = bytes_out;
+        return value;
+    }
+
+    /// Marks the call successful if `status` is SUCCESS, and returns it.
+    ImageStatus finish(ImageStatus status, uint64_t bytes_out = 0) {
+        succeeded_ = status == SUCCESS;
+        status_ = status;
+        bytes_out_ = succeeded_ ? bytes_out : 0;
+        return status;
+    }
+
+    /// Marks the call failed with `status`.
+    void fail(ImageStatus status) {
+        succeeded_ = false;
+        status_ = status;
+    }
+
+    /// Marks the call failed with `status` and returns `value` (the failure result of the call).
+    template <typename T>
+    T fail(ImageStatus status, T value) {
+        fail(status);
+        return value;
+    }
+
+private:
+    ImageOperation op_;
+    OperationCounters& counters_;
+    uint64_t bytes_in_;
+    uint64_t bytes_out_ = 0;
+    ImageStatus* status_out_;
+    ImageStatus status_ = UNKNOWN_ERROR;
+    bool succeeded_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Translates ImageResizeOptions into vips_thumbnail arguments.
+ *
+ * vips_thumbnail always needs a width; a missing dimension is mapped to VIPS_MAX_COORD so
+ * that only the given one constrains the result, which matches resize_image's behaviour.
+ *
+ * @param options The resize options to translate.
+ * @param option The VOption set that receives "height", "size" and "no_rotate".
+ * @param autorotate Whether the thumbnail applies the EXIF orientation.
+ * @return The width to pass to the thumbnail operation.
+ */
+static int thumbnail_options(const ImageResizeOptions& options, VOption* option, bool autorotate = false) {
+    int width = options.width > 0 ? options.width : VIPS_MAX_COORD;
+    int height = options.height > 0 ? options.height : VIPS_MAX_COORD;
+
+    option->set("height", height);
+    // Exact dimensions only make sense when both are given; otherwise scale proportionally
+    if (!options.maintain_aspect && options.width > 0 && options.height > 0) {
+        option->set("size", VIPS_SIZE_FORCE);
+    }
+    // By default keep pixel orientation identical to load_image + resize_image
+    option->set("no_rotate", !autorotate);
+    return width;
+}
+
+// Private metadata field marking images whose pixels can only be read top to bottom.
+// libvips copies metadata from inputs to outputs, so the mark follows the image
+// through resize/crop/watermark chains.
+static const char* const SEQUENTIAL_ACCESS_FIELD = "vipsgo-sequential";
+
+// libvips 8.12 replaced the boolean "fail" loader option with the "fail_on" level
+#if VIPS_MAJOR_VERSION > 8 || (VIPS_MAJOR_VERSION == 8 && VIPS_MINOR_VERSION >= 12)
+#define VIPS_WRAPPER_HAVE_FAIL_ON 1
+#endif
+
+/**
+ * @brief Asks the loader to reject damaged files at the given strictness.
+ *
+ * Older libvips only has an on/off switch, which is turned on for any level.
+ *
+ * @param option The loader option set to extend.
+ * @param fail_on The strictness level; IMAGE_FAIL_ON_NONE leaves the loader default.
+ */
+static void set_fail_on(VOption* option, ImageFailOn fail_on) {
+    if (fail_on == IMAGE_FAIL_ON_NONE) {
+        return;
+    }
+#ifdef VIPS_WRAPPER_HAVE_FAIL_ON
+    switch (fail_on) {
+    case IMAGE_FAIL_ON_TRUNCATED: option->set("fail_on", VIPS_FAIL_ON_TRUNCATED); break;
+    case IMAGE_FAIL_ON_WARNING:   option->set("fail_on", VIPS_FAIL_ON_WARNING); break;
+    default:                      option->set("fail_on", VIPS_FAIL_ON_ERROR); break;
+    }
+#else
+    option->set("fail", true);
+#endif
+}
+
+/**
+ * @brief Returns whether the load options ask for anything but the first page alone.
+ */
+static bool requests_pages(const ImageLoadOptions& options) {
+    return options.page > 0 || (options.n != 0 && options.n != 1);
+}
+
+/**
+ * @brief Returns whether a loader accepts the "page" and "n" options.
+ *
+ * Only multi-page loaders (GIF, WebP, TIFF, PDF, HEIF, ...) have them, and passing
+ * them to any other loader fails the load.
+ *
+ * @param loader Loader type name from vips_foreign_find_load*, or null.
+ */
+static bool loader_has_pages(const char* loader) {
+    GType type = loader ? g_type_from_name(loader) : 0;
+    if (!type) {
+        return false;
+    }
+    gpointer loader_class = g_type_class_ref(type);
+    bool has_pages = g_object_class_find_property(G_OBJECT_CLASS(loader_class), "n") != nullptr;
+    g_type_class_unref(loader_class);
+    return has_pages;
+}
+
+/**
+ * @brief Builds the loader VOption set for the given load options.
+ * @param options The load options to translate.
+ * @param loader Loader type name; pages are only requested from multi-page loaders.
+ * @return A VOption set to pass to new_from_file/new_from_buffer.
+ */
+static VOption* load_option(const ImageLoadOptions& options, const char* loader = nullptr) {
+    VOption* option = VImage::option();
+    option->set("access", options.access == IMAGE_ACCESS_SEQUENTIAL
+        ? VIPS_ACCESS_SEQUENTIAL : VIPS_ACCESS_RANDOM);
+    set_fail_on(option, options.fail_on);
+    if (requests_pages(options) && loader_has_pages(loader)) {
+        option->set("page", options.page);
+        option->set("n", options.n == 0 ? 1 : options.n);
+    }
+    return option;
+}
+
+/**
+ * @brief Rejects a page beyond the first for formats that only have one.
+ *
+ * @param loader Loader type name, or null if no loader recognised the input.
+ * @param options The load options holding the page.
+ * @return SUCCESS, or IMAGE_INVALID_BOUNDS for page > 0 of a single-page format.
+ */
+static ImageStatus check_single_page(const char* loader, const ImageLoadOptions& options) {
+    if (options.page > 0 && loader && !loader_has_pages(loader)) {
+        log_error("Error: Page ", options.page, " requested from a single-page format (", loader, ").");
+        return IMAGE_INVALID_BOUNDS;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Checks the encoded size of an input against the max_bytes load limit.
+ *
+ * @param size Encoded size in bytes.
+ * @param options The load options holding the limit.
+ * @return SUCCESS, or IMAGE_TOO_LARGE if the input is over the limit.
+ */
+static ImageStatus check_input_size(uint64_t size, const ImageLoadOptions& options) {
+    if (options.max_bytes > 0 && size > options.max_bytes) {
+        // Rejecting oversized input is routine admission control, so it is recorded but not logged
+        set_error_message("Error: Input of ", size, " bytes exceeds the limit of ", options.max_bytes, " bytes.");
+        return IMAGE_TOO_LARGE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Checks the header of a freshly opened image against the load limits.
+ *
+ * Loaders only parse the header until pixels are requested, so this runs before
+ * any pixel memory has been allocated.
+ *
+ * @param img The freshly loaded image.
+ * @param options The load options holding the limits.
+ * @return SUCCESS, or IMAGE_TOO_LARGE if a dimension or the pixel count is over its limit.
+ */
+static ImageStatus check_load_limits(const VImage& img, const ImageLoadOptions& options) {
+    uint64_t pixels = static_cast<uint64_t>(img.width()) * static_cast<uint64_t>(img.height());
+    if ((options.max_width > 0 && img.width() > options.max_width) ||
+        (options.max_height > 0 && img.height() > options.max_height) ||
+        (options.max_pixels > 0 && pixels > options.max_pixels)) {
+        set_error_message("Error: Image of ", img.width(), "x", img.height(), " pixels exceeds the load limits (",
+                          options.max_width, "x", options.max_height, ", ", options.max_pixels, " pixels).");
+        return IMAGE_TOO_LARGE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns whether any header-based load limit is set.
+ */
+static bool has_dimension_limits(const ImageLoadOptions& options) {
+    return options.max_width > 0 || options.max_height > 0 || options.max_pixels > 0;
+}
+
+/**
+ * @brief Passes the loader strictness through vips_thumbnail.
+ *
+ * vips_thumbnail only gained "fail_on" together with the loaders; older libvips
+ * thumbnails always decode leniently.
+ *
+ * @param option The thumbnail option set to extend.
+ * @param fail_on The strictness level.
+ */
+static void set_thumbnail_fail_on(VOption* option, ImageFailOn fail_on) {
+#ifdef VIPS_WRAPPER_HAVE_FAIL_ON
+    set_fail_on(option, fail_on);
+#else
+    (void)option;
+    (void)fail_on;
+#endif
+}
+
+/**
+ * @brief Records the access mode on a freshly loaded image.
+ *
+ * The loader result may be shared through the libvips operation cache, so the
+ * mark is set on a copy rather than on the loader output itself.
+ *
+ * @param img The freshly loaded image.
+ * @param access The access mode the image was loaded with.
+ * @return The image to hand out to the caller.
+ */
+static VImage tag_access(const VImage& img, ImageAccess access) {
+    if (access != IMAGE_ACCESS_SEQUENTIAL) {
+        return img;
+    }
+    VImage tagged = img.copy();
+    tagged.set(SEQUENTIAL_ACCESS_FIELD, 1);
+    return tagged;
+}
+
+/**
+ * @brief Returns an image that supports random access to its pixels.
+ *
+ * Images loaded with IMAGE_ACCESS_SEQUENTIAL are rendered into memory once, which
+ * is the fallback for operations that read pixels out of order (e.g. rotation).
+ *
+ * @param img The image that is about to be read out of order.
+ * @return img itself if it already allows random access, otherwise an in-memory copy.
+ */
+static VImage ensure_random_access(const VImage& img) {
+    if (!img.get_typeof(SEQUENTIAL_ACCESS_FIELD)) {
+        return img;
+    }
+    VImage materialized = img.copy_memory();
+    materialized.remove(SEQUENTIAL_ACCESS_FIELD);
+    return materialized;
+}
+
+/**
+ * @brief Returns `img` without the sequential-access mark.
+ *
+ * `.v` files store every metadata field, so an image saved while marked comes back
+ * marked; mapped files allow random access whatever the mark says.
+ */
+static VImage clear_access_tag(const VImage& img) {
+    if (!img.get_typeof(SEQUENTIAL_ACCESS_FIELD)) {
+        return img;
+    }
+    VImage cleared = img.copy();
+    cleared.remove(SEQUENTIAL_ACCESS_FIELD);
+    return cleared;
+}
+
+/**
+ * @brief Whether `img` was loaded from a `.v` file, whose pixels libvips maps into memory.
+ *
+ * Mapped pixels are paged in on demand in any order, so such images never need the
+ * sequential-access fallback of ensure_random_access().
+ */
+static bool is_mapped_file(const VImage& img) {
+    return img.get_typeof(VIPS_META_LOADER) &&
+           std::strncmp(img.get_string(VIPS_META_LOADER), "vipsload", 8) == 0;
+}
+
+/**
+ * @brief Turns and mirrors `img` upright according to its EXIF orientation.
+ *
+ * The orientation tag is removed afterwards, so applying it twice is harmless.
+ * Mirroring left to right reads rows in order and keeps sequential access; the
+ * other orientations read pixels out of order and materialize sequential images.
+ *
+ * @return SUCCESS on success.
+ */
+static ImageStatus apply_autorotate(VImage& img) {
+    int orientation = img.get_typeof(VIPS_META_ORIENTATION) ? img.get_int(VIPS_META_ORIENTATION) : 1;
+    if (orientation <= 1 || orientation > 8) {
+        return SUCCESS;
+    }
+    if (orientation == 2) {
+        // The flip result may be shared through the operation cache, so untag a copy
+        VImage upright = img.flip(VIPS_DIRECTION_HORIZONTAL).copy();
+        upright.remove(VIPS_META_ORIENTATION);
+        img = upright;
+        return SUCCESS;
+    }
+    img = ensure_random_access(img).autorot();
+    return SUCCESS;
+}
+
+/**
+ * @brief Number of frames stacked in `img` (multi-page loads are one tall "toilet roll").
+ */
+static int frame_count(const VImage& img) {
+    int page_height = vips_image_get_page_height(img.get_image());
+    return page_height > 0 && page_height < img.height() ? img.height() / page_height : 1;
+}
+
+/**
+ * @brief Height of one frame of `img`; the full height for single images.
+ */
+static int frame_height(const VImage& img) {
+    return img.height() / frame_count(img);
+}
+
+/**
+ * @brief Applies a geometric operation to every frame of a multi-frame image.
+ *
+ * Each frame is cut out with extract_area, transformed on its own and the results
+ * are stacked again with the output frame height as the new page height. The graph
+ * stays lazy: an encoder pulling rows top to bottom reads the frames in order, so
+ * sequential sources work and only the frames being encoded are in flight.
+ *
+ * @param img The image to transform in place.
+ * @param frames The frame count of `img` (> 1).
+ * @param apply Transform of a single frame; every frame must come out the same size.
+ * @return SUCCESS, or the first failure of `apply` (img is left unchanged).
+ */
+template <typename Apply>
+static ImageStatus map_frames(VImage& img, int frames, Apply apply) {
+    int page_height = img.height() / frames;
+    std::vector<VImage> out;
+    out.reserve(frames);
+    for (int i = 0; i < frames; ++i) {
+        VImage frame = img.extract_area(0, i * page_height, img.width(), page_height);
+        ImageStatus status = apply(frame);
+        if (status != SUCCESS) {
+            return status;
+        }
+        out.push_back(frame);
+    }
+
+    // The joined image may be shared through the operation cache, so the page height is set on a copy
+    VImage joined = VImage::arrayjoin(out, VImage::option()->set("across", 1)).copy();
+    joined.set(VIPS_META_PAGE_HEIGHT, out[0].height());
+    img = joined;
+    return SUCCESS;
+}
+
+// Caller-supplied release hook for a zero-copy input buffer
+struct OwnedBuffer {
+    const unsigned char* data;
+    ImageBufferReleaseFn release;
+    void* user_data;
+};
+
+/**
+ * @brief "postclose" handler that hands an input buffer back to its owner.
+ *
+ * libvips closes the loader output only once no image in any graph (nor the operation
+ * cache) still references it, which is exactly when the encoded bytes are no longer read.
+ *
+ * @param image The image being closed (unused).
+ * @param user_data The OwnedBuffer registered for the image.
+ */
+static void release_owned_buffer(VipsImage* image, void* user_data) {
+    OwnedBuffer* owned = static_cast<OwnedBuffer*>(user_data);
+    owned->release(const_cast<unsigned char*>(owned->data), owned->user_data);
+    delete owned;
+}
+
+/**
+ * @brief Fills an ImageMeta from the header fields of `img`; no pixels are computed.
+ *
+ * file_size is left at 0 since an image does not know its encoded size.
+ *
+ * @param img The image to describe.
+ * @return The metadata.
+ */
+static ImageMeta describe_image(const VImage& img) {
+    ImageMeta meta = {0}; // Initialize all members to zero/null
+
+    meta.width = img.width();
+    meta.height = img.height();
+    meta.channels = img.bands();
+
+    // Safely retrieve and copy format string
+    try {
+        std::string format_str = img.get_string("vips-loader");
+        std::strncpy(meta.format, format_str.c_str(), sizeof(meta.format) - 1);
+        meta.format[sizeof(meta.format) - 1] = '\0';
+    } catch (const VError &e) {
+        log_message(IMAGE_LOG_WARNING, "VIPS Error getting image format: ", e.what());
+        std::strncpy(meta.format, "unknown", sizeof(meta.format) - 1);
+        meta.format[sizeof(meta.format) - 1] = '\0';
+    }
+
+    // Safely retrieve and copy colorspace string
+    try {
+        VipsInterpretation interp = img.interpretation();
+        const char* colorspace_name = vips_enum_nick(VIPS_TYPE_INTERPRETATION, interp);
+        if (colorspace_name) {
+            std::strncpy(meta.colorspace, colorspace_name, sizeof(meta.colorspace) - 1);
+            meta.colorspace[sizeof(meta.colorspace) - 1] = '\0';
+        } else {
+            std::strncpy(meta.colorspace, "unknown", sizeof(meta.colorspace) - 1);
+            meta.colorspace[sizeof(meta.colorspace) - 1] = '\0';
+        }
+    } catch (const VError &e) {
+        log_message(IMAGE_LOG_WARNING, "VIPS Error getting image colorspace: ", e.what());
+        std::strncpy(meta.colorspace, "unknown", sizeof(meta.colorspace) - 1);
+        meta.colorspace[sizeof(meta.colorspace) - 1] = '\0';
+    }
+
+    // Safely retrieve density (DPI)
+    try {
+        meta.density_x = img.xres();
+        meta.density_y = img.yres();
+    } catch (const VError &e) {
+        log_message(IMAGE_LOG_WARNING, "VIPS Error getting image density: ", e.what());
+        meta.density_x = 72.0; // Default DPI
+        meta.density_y = 72.0;
+    }
+
+    meta.orientation = img.get_typeof(VIPS_META_ORIENTATION) ? img.get_int(VIPS_META_ORIENTATION) : 1;
+    if (meta.orientation < 1 || meta.orientation > 8) meta.orientation = 1;
+    meta.has_alpha = img.has_alpha() ? 1 : 0;
+    meta.pages = img.get_typeof(VIPS_META_N_PAGES) ? std::max(1, img.get_int(VIPS_META_N_PAGES)) : 1;
+    meta.has_icc = img.get_typeof(VIPS_META_ICC_NAME) ? 1 : 0;
+    meta.frames = frame_count(img);
+
+    return meta;
+}
+
+/**
+ * @brief Builds the loader VOption set for probe_image_*.
+ *
+ * Loaders parse only the header until pixels are requested, which a probe never does;
+ * sequential access additionally keeps them from setting up a random-access cache.
+ *
+ * @param options The probe options to translate.
+ * @return A VOption set to pass to new_from_file/new_from_buffer.
+ */
+static VOption* probe_option(const ImageProbeOptions& options) {
+    VOption* option = VImage::option()->set("access", VIPS_ACCESS_SEQUENTIAL);
+    set_fail_on(option, options.fail_on_error ? IMAGE_FAIL_ON_ERROR : IMAGE_FAIL_ON_NONE);
+    return option;
+}
+
+/**
+ * @brief Describes a probed image and applies the probe's pixel limit.
+ *
+ * @param img The header-only image.
+ * @param options The probe options.
+ * @param file_size Encoded size to report.
+ * @param meta Receives the metadata, also when the limit is exceeded.
+ * @return SUCCESS, or IMAGE_TOO_LARGE if the image has more than max_pixels pixels.
+ */
+static ImageStatus finish_probe(const VImage& img, const ImageProbeOptions& options, uint64_t file_size,
+                                ImageMeta* meta) {
+    *meta = describe_image(img);
+    meta->file_size = static_cast<long>(file_size);
+
+    uint64_t pixels = static_cast<uint64_t>(meta->width) * static_cast<uint64_t>(meta->height) *
+                      static_cast<uint64_t>(meta->pages);
+    if (options.max_pixels > 0 && pixels > options.max_pixels) {
+        // Rejecting oversized uploads is routine admission control, so it is recorded but not logged
+        set_error_message("Error: Image of ", meta->width, "x", meta->height, " pixels and ", meta->pages,
+                          " page(s) exceeds the limit of ", options.max_pixels, " pixels.");
+        return IMAGE_TOO_LARGE;
+    }
+    return SUCCESS;
+}
+
+// libvips 8.15 replaced the boolean "strip" saver option with the "keep" flags
+#if VIPS_MAJOR_VERSION > 8 || (VIPS_MAJOR_VERSION == 8 && VIPS_MINOR_VERSION >= 15)
+#define VIPS_WRAPPER_HAVE_KEEP 1
+#endif
+
+/**
+ * @brief Asks the saver to drop EXIF/XMP/IPTC/ICC metadata from its output.
+ * @param option The saver VOption set.
+ * @param strip Non-zero to strip metadata; zero keeps the saver default.
+ */
+static void set_strip(VOption* option, int strip) {
+    if (!strip) {
+        return;
+    }
+#ifdef VIPS_WRAPPER_HAVE_KEEP
+    option->set("keep", VIPS_FOREIGN_KEEP_NONE);
+#else
+    option->set("strip", true);
+#endif
+}
+
+/**
+ * @brief Clamps an encoder setting to its valid range, falling back to a default.
+ * @return `value` if it lies in [min, max], otherwise `fallback`.
+ */
+static int option_in_range(int value, int min, int max, int fallback) {
+    return (value >= min && value <= max) ? value : fallback;
+}
+
+/**
+ * @brief Maps ImageSubsample onto libvips' VipsForeignSubsample.
+ */
+static VipsForeignSubsample subsample_mode(ImageSubsample subsample) {
+    switch (subsample) {
+        case IMAGE_SUBSAMPLE_ON: return VIPS_FOREIGN_SUBSAMPLE_ON;
+        case IMAGE_SUBSAMPLE_OFF: return VIPS_FOREIGN_SUBSAMPLE_OFF;
+        default: return VIPS_FOREIGN_SUBSAMPLE_AUTO;
+    }
+}
+
+/**
+ * @brief Builds the jpegsave VOption set for the given encoding options.
+ * Fields beyond quality/interlace are only read from versioned options.
+ * @param options JPEG encoding options.
+ * @return A VOption set to pass to write_to_buffer/write_to_target.
+ */
+static VOption* jpeg_option(ImageEncodeJPEGOptions options) {
+    VOption* option = VImage::option();
+    if (options.quality > 0 && options.quality <= 100) {
+        option->set("Q", options.quality);
+    } else {
+        option->set("Q", 75); // Default JPEG quality
+    }
+    option->set("interlace", options.interlace != 0);
+    if (options.version < IMAGE_ENCODE_JPEG_OPTIONS_VERSION) {
+        return option; // Legacy layout: the remaining fields are not set by the caller
+    }
+
+    option->set("optimize_coding", options.optimize_coding != 0);
+    option->set("trellis_quant", options.trellis_quant != 0);
+    option->set("overshoot_deringing", options.overshoot_deringing != 0);
+    option->set("optimize_scans", options.optimize_scans != 0);
+    option->set("quant_table", option_in_range(options.quant_table, 0, 8, 0));
+    option->set("subsample_mode", subsample_mode(options.subsample));
+    set_strip(option, options.strip);
+    return option;
+}
+
+/**
+ * @brief Builds the pngsave VOption set for the given encoding options.
+ * @param options PNG encoding options (compression, interlacing).
+ * @return A VOption set to pass to write_to_buffer/write_to_target.
+ */
+static VOption* png_option(ImageEncodePNGOptions options) {
+    VOption* option = VImage::option();
+    // Validate compression level, default to 6 if invalid
+    if (options.compression < 0 || options.compression > 9) {
+        options.compression = 6;
+    }
+    option->set("compression", options.compression);
+    option->set("interlace", options.interlace != 0);
+    return option;
+}
+
+/**
+ * @brief Builds the webpsave VOption set for the given encoding options.
+ * @param options WebP encoding options.
+ * @return A VOption set to pass to write_to_buffer/write_to_target.
+ */
+static VOption* webp_option(ImageEncodeWebPOptions options) {
+    VOption* option = VImage::option();
+    option->set("Q", option_in_range(options.quality, 1, 100, 75));
+    option->set("lossless", options.lossless != 0);
+    option->set("effort", option_in_range(options.effort, 0, 6, 4));
+    option->set("smart_subsample", options.smart_subsample != 0);
+    set_strip(option, options.strip);
+    return option;
+}
+
+/**
+ * @brief Builds the heifsave VOption set shared by AVIF and HEIF output.
+ * @param options AVIF/HEIF encoding options.
+ * @param default_quality Encoder default used when options.quality is out of range.
+ * @return A VOption set to pass to write_to_buffer/write_to_target.
+ */
+static VOption* heif_option(ImageEncodeHEIFOptions options, int default_quality) {
+    VOption* option = VImage::option();
+    option->set("Q", option_in_range(options.quality, 1, 100, default_quality));
+    option->set("lossless", options.lossless != 0);
+    option->set("effort", option_in_range(options.effort, 0, 9, 4));
+    option->set("subsample_mode", subsample_mode(options.subsample));
+    set_strip(option, options.strip);
+    return option;
+}
+
+/**
+ * @brief Builds the jxlsave VOption set for the given encoding options.
+ * @param options JPEG XL encoding options.
+ * @return A VOption set to pass to write_to_buffer/write_to_target.
+ */
+static VOption* jxl_option(ImageEncodeJXLOptions options) {
+    VOption* option = VImage::option();
+    option->set("Q", option_in_range(options.quality, 1, 100, 75));
+    option->set("lossless", options.lossless != 0);
+    option->set("effort", option_in_range(options.effort, 1, 9, 7));
+    set_strip(option, options.strip);
+    return option;
+}
+
+/**
+ * @brief Builds the gifsave VOption set for the given encoding options.
+ * @param options GIF encoding options.
+ * @return A VOption set to pass to write_to_buffer/write_to_target.
+ */
+static VOption* gif_option(ImageEncodeGIFOptions options) {
+    VOption* option = VImage::option();
+    option->set("effort", option_in_range(options.effort, 1, 10, 7));
+    option->set("bitdepth", option_in_range(options.bitdepth, 1, 8, 8));
+    return option;
+}
+
+/**
+ * @brief Encodes an image into a GLib-allocated ImageBuffer.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param suffix Format suffix selecting the saver, optionally with "[...]" options.
+ * @param build_option Callable returning the saver VOption set.
+ * @param operation Name used in error messages.
+ * @return The encoded buffer, or {nullptr, 0} on failure.
+ */
+template <typename BuildOption>
+static ImageBuffer encode_to_image_buffer(const VImageHandle handle, const char* suffix, BuildOption build_option,
+                                          const char* operation) {
+    OperationTimer timer(IMAGE_OP_ENCODE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for ", operation, ".");
+        return timer.fail(VIPS_INVALID_HANDLE, ImageBuffer{nullptr, 0});
+    }
+
+    void* buf = nullptr;
+    size_t buf_size = 0;
+    const VImage* img = static_cast<const VImage*>(handle);
+
+    try {
+        img->write_to_buffer(suffix, &buf, &buf_size, build_option());
+
+        // The buffer returned by write_to_buffer is managed by GLib, so we transfer ownership
+        return timer.succeed(ImageBuffer{static_cast<unsigned char*>(buf), buf_size}, buf_size);
+    } catch (const VError &e) {
+        log_error("VIPS Error during ", operation, ": ", e.what());
+        timer.fail(IMAGE_SAVE_FAILURE);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during ", operation, ": ", e.what());
+        timer.fail(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during ", operation, ": ", e.what());
+        timer.fail(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during ", operation, ".");
+        timer.fail(UNKNOWN_ERROR);
+    }
+    if (buf) g_free(buf); // Ensure buffer is freed on error
+    return ImageBuffer{nullptr, 0};
+}
+
+// Destination of encode_to_*_writer: the caller's writer plus a byte count for the stats
+struct WriterSink {
+    ImageWriter writer;
+    size_t written;
+};
+
+// Destination of encode_to_*_into: a fixed caller-provided buffer
+struct FixedBufferSink {
+    unsigned char* out;
+    size_t capacity;
+    size_t written;     // Total bytes produced, may exceed capacity
+};
+
+/**
+ * @brief VipsTargetCustom "write" handler forwarding encoded chunks to an ImageWriter.
+ * @return The number of bytes consumed, or -1 to abort the encode.
+ */
+static gint64 write_to_image_writer(VipsTargetCustom* target, const void* data, gint64 length, void* user_data) {
+    WriterSink* sink = static_cast<WriterSink*>(user_data);
+    long long consumed = sink->writer.write(data, static_cast<size_t>(length), sink->writer.user_data);
+    if (consumed > 0) {
+        sink->written += static_cast<size_t>(consumed);
+    }
+    return consumed;
+}
+
+/**
+ * @brief VipsTargetCustom "write" handler copying encoded chunks into a FixedBufferSink.
+ *
+ * Once the buffer is full the remaining bytes are only counted, so the caller learns
+ * the size it needs to retry with.
+ *
+ * @return Always the full chunk length; overflow is reported after the encode finishes.
+ */
+static gint64 write_to_fixed_buffer(VipsTargetCustom* target, const void* data, gint64 length, void* user_data) {
+    FixedBufferSink* sink = static_cast<FixedBufferSink*>(user_data);
+    size_t chunk = static_cast<size_t>(length);
+    if (sink->written < sink->capacity) {
+        std::memcpy(sink->out + sink->written, data, std::min(chunk, sink->capacity - sink->written));
+    }
+    sink->written += chunk;
+    return length;
+}
+
+/**
+ * @brief Encodes an image through a VipsTargetCustom whose "write" signal runs the given handler.
+ *
+ * No intermediate buffer is allocated: the encoder's output chunks go straight to `write`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param suffix Format suffix selecting the saver (e.g. ".jpg").
+ * @param build_option Callable returning the saver VOption set.
+ * @param write The "write" signal handler.
+ * @param user_data Data passed to the handler.
+ * @param written Byte count maintained by the handler, read for the encode stats.
+ * @param operation Name used in error messages.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+template <typename BuildOption>
+static ImageStatus encode_to_custom_target(const VImageHandle handle, const char* suffix, BuildOption build_option,
+                                           gint64 (*write)(VipsTargetCustom*, const void*, gint64, void*),
+                                           void* user_data, const size_t* written, const char* operation) {
+    OperationTimer timer(IMAGE_OP_ENCODE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for ", operation, ".");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    const VImage* img = static_cast<const VImage*>(handle);
+
+    try {
+        VTarget target(VIPS_TARGET(vips_target_custom_new()));
+        g_signal_connect(target.get_target(), "write", G_CALLBACK(write), user_data);
+
+        img->write_to_target(suffix, target, build_option());
+        return timer.finish(SUCCESS, *written);
+    } catch (const VError &e) {
+        log_error("VIPS Error during ", operation, ": ", e.what());
+        return timer.finish(IMAGE_SAVE_FAILURE);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during ", operation, ": ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during ", operation, ": ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during ", operation, ".");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Encodes an image into a fixed caller-provided buffer.
+ * @return SUCCESS, IMAGE_BUFFER_TOO_SMALL with the required size in *out_size, or an error code.
+ */
+template <typename BuildOption>
+static ImageStatus encode_to_fixed_buffer(const VImageHandle handle, const char* suffix, BuildOption build_option,
+                                          unsigned char* out, size_t capacity, size_t* out_size,
+                                          const char* operation) {
+    if (!out_size || (!out && capacity > 0)) {
+        log_error("Error: Invalid output buffer for ", operation, ".");
+        return fail(IMAGE_OP_ENCODE, IMAGE_SAVE_FAILURE);
+    }
+
+    FixedBufferSink sink{out, capacity, 0};
+    ImageStatus status = encode_to_custom_target(handle, suffix, build_option, write_to_fixed_buffer,
+                                                 &sink, &sink.written, operation);
+    *out_size = sink.written;
+    if (status == SUCCESS && sink.written > capacity) {
+        // An expected retry signal rather than a fault, so it is recorded but not logged
+        set_error_message("Output buffer of ", capacity, " bytes too small for ", operation, " (",
+                          sink.written, " bytes needed).");
+        return fail(IMAGE_OP_ENCODE, IMAGE_BUFFER_TOO_SMALL);
+    }
+    return status;
+}
+
+//=============================================================================
+// Transform implementations shared by the single-op entry points and process_pipeline.
+// Each validates its options, replaces `img` only on success and lets VError propagate.
+//=============================================================================
+
+/**
+ * @brief Resizes `img` according to the specified options.
+ * @return SUCCESS on success, or a validation error code.
+ */
+static ImageStatus apply_resize(VImage& img, const ImageResizeOptions& options) {
+    if (int frames = frame_count(img); frames > 1) {
+        return map_frames(img, frames, [&](VImage& frame) { return apply_resize(frame, options); });
+    }
+    if (options.width <= 0 && options.height <= 0) {
+        log_error("Error: Invalid dimensions provided for resize (width and/or height must be positive).");
+        return IMAGE_INVALID_DIMENSIONS;
+    }
+
+    VImage resized_img;
+
+    if (options.maintain_aspect) {
+        double scale = 1.0;
+        // Calculate scale factor while maintaining aspect ratio
+        if (options.width > 0 && options.height > 0) {
+            scale = std::min(static_cast<double>(options.width) / img.width(),
+                             static_cast<double>(options.height) / img.height());
+        } else if (options.width > 0) {
+            scale = static_cast<double>(options.width) / img.width();
+        } else { // options.height > 0
+            scale = static_cast<double>(options.height) / img.height();
+        }
+        resized_img = img.resize(scale, VImage::option()->set("kernel", VIPS_KERNEL_LANCZOS3));
+    } else {
+        // Calculate independent scales for width and height
+        double scale_x = (options.width > 0) ? static_cast<double>(options.width) / img.width() : 1.0;
+        double scale_y = (options.height > 0) ? static_cast<double>(options.height) / img.height() : 1.0;
+
+        // If one dimension is not specified, use the scale of the other to maintain proportion if no aspect constraint
+        if (options.width <= 0) {
+            scale_x = scale_y;
+        } else if (options.height <= 0) {
+            scale_y = scale_x;
+        }
+
+        resized_img = img.resize(scale_x, VImage::option()
+            ->set("kernel", VIPS_KERNEL_LANCZOS3)
+            ->set("vscale", scale_y));
+    }
+
+    // Overwrite the original VImage object with the resized one
+    img = resized_img;
+    return SUCCESS;
+}
+
+/**
+ * @brief Resizes `img` to exactly width x height, or returns it if it already has that size.
+ */
+static VImage resize_exact(const VImage& img, int width, int height) {
+    if (img.width() == width && img.height() == height) {
+        return img;
+    }
+    return img.resize(static_cast<double>(width) / img.width(), VImage::option()
+        ->set("kernel", VIPS_KERNEL_LANCZOS3)
+        ->set("vscale", static_cast<double>(height) / img.height()));
+}
+
+/**
+ * @brief Crops `img` to the specified rectangle.
+ * @return SUCCESS on success, or a validation error code.
+ */
+static ImageStatus apply_crop(VImage& img, const ImageCropOptions& options) {
+    if (int frames = frame_count(img); frames > 1) {
+        return map_frames(img, frames, [&](VImage& frame) { return apply_crop(frame, options); });
+    }
+    if (options.width <= 0 || options.height <= 0) {
+        log_error("Error: Invalid dimensions provided for crop (width and height must be positive).");
+        return IMAGE_INVALID_DIMENSIONS;
+    }
+    if (options.x < 0 || options.y < 0) {
+        log_error("Error: Invalid position provided for crop (x and y must be non-negative).");
+        return IMAGE_INVALID_POSITION;
+    }
+
+    // Validate crop bounds against image dimensions
+    if (static_cast<long long>(options.x) + options.width > img.width() ||
+        static_cast<long long>(options.y) + options.height > img.height()) {
+        log_error("Error: Crop area extends beyond image boundaries.");
+        return IMAGE_INVALID_BOUNDS;
+    }
+
+    // Overwrite the original VImage object with the cropped one
+    img = img.crop(options.x, options.y, options.width, options.height);
+    return SUCCESS;
+}
+
+/**
+ * @brief Rotates `img` by the specified angle in degrees.
+ *
+ * Multiples of 90 degrees are exact pixel remaps through vips_rot; other angles
+ * go through the resampling rotate with a background fill.
+ *
+ * @return SUCCESS on success.
+ */
+static ImageStatus apply_rotate(VImage& img, const ImageRotateOptions& options) {
+    if (int frames = frame_count(img); frames > 1) {
+        return map_frames(img, frames, [&](VImage& frame) { return apply_rotate(frame, options); });
+    }
+    // fmod is exact, so right angles are recognised reliably; NaN and infinities fall through
+    double angle = std::fmod(options.angle, 360.0);
+    if (angle < 0.0) {
+        angle += 360.0;
+    }
+    if (std::fmod(angle, 90.0) == 0.0) {
+        static const VipsAngle right_angles[] = {VIPS_ANGLE_D0, VIPS_ANGLE_D90, VIPS_ANGLE_D180, VIPS_ANGLE_D270};
+        int quarter_turns = static_cast<int>(angle / 90.0) % 4;
+        if (quarter_turns != 0) {
+            // Still reads pixels out of order, so sequential images are materialized first
+            img = ensure_random_access(img).rot(right_angles[quarter_turns]);
+        }
+        return SUCCESS;
+    }
+
+    std::vector<double> background_color;
+    // Determine background color based on image properties
+    if (img.has_alpha()) {
+        background_color = {0.0, 0.0, 0.0, 0.0}; // Transparent black
+    } else if (img.bands() >= 3) {
+        background_color = {255.0, 255.0, 255.0}; // White
+    } else {
+        background_color = {0.0}; // Black (grayscale)
+    }
+
+    // Rotation reads source pixels out of order, so sequential images are materialized first
+    VImage rotated_img = ensure_random_access(img).rotate(options.angle, VImage::option()
+        ->set("background", background_color));
+
+    // Overwrite the original VImage object with the rotated one
+    img = rotated_img;
+    return SUCCESS;
+}
+
+/**
+ * @brief Mirrors `img` along the requested axis.
+ * @return SUCCESS on success.
+ */
+static ImageStatus apply_flip(VImage& img, const ImageFlipOptions& options) {
+    if (options.direction == IMAGE_FLIP_VERTICAL) {
+        if (int frames = frame_count(img); frames > 1) {
+            return map_frames(img, frames, [&](VImage& frame) { return apply_flip(frame, options); });
+        }
+        // Rows are produced bottom to top, so sequential images are materialized first
+        img = ensure_random_access(img).flip(VIPS_DIRECTION_VERTICAL);
+    } else {
+        img = img.flip(VIPS_DIRECTION_HORIZONTAL);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Applies `apply` to a copy of `src` and stores the result as a new handle in `*dst`.
+ * VImage copies share the operation graph and pixel cache, so `src` is only read.
+ * @return The status of `apply`; `*dst` is only set on SUCCESS.
+ */
+template <typename Apply>
+static ImageStatus derive_image(VImageHandle src, VImageHandle* dst, Apply apply) {
+    VImage img = *static_cast<const VImage*>(src);
+    ImageStatus status = apply(img);
+    if (status == SUCCESS) {
+        *dst = new VImage(std::move(img));
+    }
+    return status;
+}
+
+//=============================================================================
+// 8-bit alpha kernels. Opacity and OVER compositing on uchar images are a
+// product and a shift per sample; running them as libvips generators keeps the
+// samples in uchar and the work in one pass, where the generic operations
+// promote alpha to double and chain several passes. SSE2 and NEON are part of
+// the x86-64 and AArch64 baselines, so no runtime dispatch is needed.
+//=============================================================================
+
+/// x / 255 rounded to nearest, exact for x in [0, 255 * 255]
+static inline unsigned div255(unsigned x) {
+    return (x + 128 + ((x + 128) >> 8)) >> 8;
+}
+
+/**
+ * @brief out[i] = add[i] + x[i] * y[i] / 255 for n bytes, rounded and saturated.
+ *
+ * @param x First factor of each product.
+ * @param y Second factor of each product.
+ * @param add Bytes added to the products, or null to add nothing.
+ * @param out Result; may alias `x`.
+ * @param n Number of bytes.
+ */
+static void multiply_add_bytes(const uint8_t* x, const uint8_t* y, const uint8_t* add, uint8_t* out, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(128);
+    for (; i + 16 <= n; i += 16) {
+        __m128i xv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        __m128i yv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(xv, zero), _mm_unpacklo_epi8(yv, zero)), half);
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(xv, zero), _mm_unpackhi_epi8(yv, zero)), half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        __m128i result = _mm_packus_epi16(lo, hi);
+        if (add) {
+            result = _mm_adds_epu8(result, _mm_loadu_si128(reinterpret_cast<const __m128i*>(add + i)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t xv = vld1q_u8(x + i);
+        uint8x16_t yv = vld1q_u8(y + i);
+        uint16x8_t lo = vmull_u8(vget_low_u8(xv), vget_low_u8(yv));
+        uint16x8_t hi = vmull_u8(vget_high_u8(xv), vget_high_u8(yv));
+        // div255() as a rounding shift-accumulate followed by a rounding narrow
+        uint8x16_t result = vcombine_u8(vrshrn_n_u16(vrsraq_n_u16(lo, lo, 8), 8),
+                                        vrshrn_n_u16(vrsraq_n_u16(hi, hi, 8), 8));
+        if (add) {
+            result = vqaddq_u8(result, vld1q_u8(add + i));
+        }
+        vst1q_u8(out + i, result);
+    }
+#endif
+    for (; i < n; ++i) {
+        unsigned value = div255(static_cast<unsigned>(x[i]) * y[i]) + (add ? add[i] : 0);
+        out[i] = static_cast<uint8_t>(std::min(value, 255u));
+    }
+}
+
+// Per-thread state of the 8-bit generators: one region per input and scratch rows
+struct ByteKernelSequence {
+    std::vector<VipsRegion*> regions;
+    std::vector<uint8_t> scratch;   // Two output rows
+    bool pattern_ready = false;     // scratch holds the alpha scale factors
+};
+
+/**
+ * @brief vips_stop_many() counterpart for ByteKernelSequence.
+ */
+static int stop_byte_kernel(void* sequence, void* a, void* b) {
+    ByteKernelSequence* seq = static_cast<ByteKernelSequence*>(sequence);
+    for (VipsRegion* region : seq->regions) {
+        g_object_unref(region);
+    }
+    delete seq;
+    return 0;
+}
+
+/**
+ * @brief vips_start_many() counterpart for ByteKernelSequence.
+ *
+ * @param out The generated image; sizes the scratch rows.
+ * @param a Null-terminated array of input images.
+ * @param b Kernel parameters (unused).
+ * @return The sequence, or null on allocation failure.
+ */
+static void* start_byte_kernel(VipsImage* out, void* a, void* b) {
+    ByteKernelSequence* seq = new (std::nothrow) ByteKernelSequence;
+    if (!seq) {
+        return nullptr;
+    }
+    try {
+        seq->scratch.resize(2 * static_cast<size_t>(out->Xsize) * out->Bands);
+        for (VipsImage** in = static_cast<VipsImage**>(a); *in; ++in) {
+            seq->regions.push_back(vips_region_new(*in));
+            if (!seq->regions.back()) {
+                seq->regions.pop_back();
+                stop_byte_kernel(seq, a, b);
+                return nullptr;
+            }
+        }
+    } catch (const std::bad_alloc&) {
+        stop_byte_kernel(seq, a, b);
+        return nullptr;
+    }
+    return seq;
+}
+
+/**
+ * @brief Builds an image computed by `generate` from `base` and `overlay`, threaded and tiled by libvips.
+ *
+ * The output starts as a copy of the header of `base` with `bands` bands; the
+ * generator gets one region per input and a copy of `params` owned by the output.
+ *
+ * @param overlay Second input, or nullptr for a single-input generator.
+ * @throws VError if libvips cannot set up the image.
+ */
+template <typename Params>
+static VImage generate_bytes(const VImage& base, const VImage* overlay, int bands, VipsGenerateFn generate,
+                             const Params& params) {
+    static_assert(std::is_trivially_copyable<Params>::value, "generator parameters are copied bytewise");
+    VipsImage* out = vips_image_new();
+    VipsImage** in = overlay
+        ? vips_allocate_input_array(out, base.get_image(), overlay->get_image(), nullptr)
+        : vips_allocate_input_array(out, base.get_image(), nullptr);
+    void* state = vips_malloc(VIPS_OBJECT(out), sizeof(Params));
+    if (!in || !state || vips_image_pipeline_array(out, VIPS_DEMAND_STYLE_THINSTRIP, in)) {
+        g_object_unref(out);
+        throw VError();
+    }
+    std::memcpy(state, &params, sizeof(Params));
+    out->Bands = bands;
+    if (vips_image_generate(out, start_byte_kernel, generate, stop_byte_kernel, in, state)) {
+        g_object_unref(out);
+        throw VError();
+    }
+    return VImage(out);
+}
+
+// Parameters of generate_alpha_scale()
+struct AlphaScale {
+    int in_bands;       // Bands of the input; one less than the output if alpha is added
+    uint8_t factor;     // Opacity in 1/255ths
+};
+
+/**
+ * @brief Generator scaling the last band by a constant, or appending it as a constant alpha.
+ */
+static int generate_alpha_scale(VipsRegion* out, void* sequence, void* a, void* b, gboolean* stop) {
+    ByteKernelSequence* seq = static_cast<ByteKernelSequence*>(sequence);
+    const AlphaScale* scale = static_cast<const AlphaScale*>(b);
+    const VipsRect* rect = &out->valid;
+    VipsRegion* in = seq->regions[0];
+    if (vips_region_prepare(in, rect)) {
+        return -1;
+    }
+
+    int bands = out->im->Bands;
+    size_t n = static_cast<size_t>(rect->width) * bands;
+    if (scale->in_bands != bands) {
+        for (int y = rect->top; y < VIPS_RECT_BOTTOM(rect); ++y) {
+            const uint8_t* p = VIPS_REGION_ADDR(in, rect->left, y);
+            uint8_t* q = VIPS_REGION_ADDR(out, rect->left, y);
+            for (int x = 0; x < rect->width; ++x, p += scale->in_bands, q += bands) {
+                std::memcpy(q, p, scale->in_bands);
+                q[scale->in_bands] = scale->factor;
+            }
+        }
+        return 0;
+    }
+
+    // Factors as wide as the widest region: 255 (unchanged) for colour, the opacity for alpha
+    uint8_t* factors = seq->scratch.data();
+    if (!seq->pattern_ready) {
+        std::memset(factors, 255, seq->scratch.size());
+        for (size_t i = bands - 1; i < seq->scratch.size(); i += bands) {
+            factors[i] = scale->factor;
+        }
+        seq->pattern_ready = true;
+    }
+    for (int y = rect->top; y < VIPS_RECT_BOTTOM(rect); ++y) {
+        multiply_add_bytes(VIPS_REGION_ADDR(in, rect->left, y), factors, nullptr,
+                           VIPS_REGION_ADDR(out, rect->left, y), n);
+    }
+    return 0;
+}
+
+/**
+ * @brief True if `img` is 8-bit and greyscale or sRGB, with or without alpha.
+ */
+static bool uchar_alpha_layout(const VImage& img) {
+    if (img.format() != VIPS_FORMAT_UCHAR) {
+        return false;
+    }
+    return img.has_alpha() ? img.bands() == 2 || img.bands() == 4 : img.bands() == 1 || img.bands() == 3;
+}
+
+/**
+ * @brief Multiplies the alpha of an 8-bit image by `opacity`, adding an alpha band if it has none.
+ *
+ * @param img An image for which uchar_alpha_layout() holds.
+ * @param opacity Opacity in [0.0, 1.0].
+ * @return The image with scaled alpha, still in uchar.
+ */
+static VImage scale_alpha_uchar(const VImage& img, double opacity) {
+    AlphaScale scale{img.bands(), static_cast<uint8_t>(std::lround(opacity * 255.0))};
+    int bands = img.has_alpha() ? img.bands() : img.bands() + 1;
+    return generate_bytes(img, nullptr, bands, generate_alpha_scale, scale);
+}
+
+// Parameters of generate_over()
+struct OverPlacement {
+    int x;                  // Overlay position in the base
+    int y;
+    bool premultiplied;     // Overlay colour is already multiplied by its alpha
+    uint8_t opacity;        // Applied to straight alpha, in 1/255ths
+};
+
+/**
+ * @brief Generator compositing an RGBA overlay OVER an opaque RGB base into opaque RGBA.
+ *
+ * Each output row is the base with an opaque alpha band; where the overlay covers
+ * it, every sample becomes colour + base * (255 - alpha) / 255, with the overlay
+ * split into premultiplied colour and inverse alpha first.
+ */
+static int generate_over(VipsRegion* out, void* sequence, void* a, void* b, gboolean* stop) {
+    ByteKernelSequence* seq = static_cast<ByteKernelSequence*>(sequence);
+    const OverPlacement* place = static_cast<const OverPlacement*>(b);
+    const VipsRect* rect = &out->valid;
+    VipsRegion* base = seq->regions[0];
+    VipsRegion* mark = seq->regions[1];
+    if (vips_region_prepare(base, rect)) {
+        return -1;
+    }
+
+    VipsRect area = {place->x, place->y, mark->im->Xsize, mark->im->Ysize};
+    VipsRect hit;
+    vips_rect_intersectrect(rect, &area, &hit);
+    if (!vips_rect_isempty(&hit)) {
+        VipsRect mark_rect = {hit.left - place->x, hit.top - place->y, hit.width, hit.height};
+        if (vips_region_prepare(mark, &mark_rect)) {
+            return -1;
+        }
+    }
+
+    uint8_t* colour = seq->scratch.data();
+    uint8_t* inverse = colour + seq->scratch.size() / 2;
+    for (int y = rect->top; y < VIPS_RECT_BOTTOM(rect); ++y) {
+        const uint8_t* p = VIPS_REGION_ADDR(base, rect->left, y);
+        uint8_t* q = VIPS_REGION_ADDR(out, rect->left, y);
+        for (int x = 0; x < rect->width; ++x, p += 3, q += 4) {
+            q[0] = p[0];
+            q[1] = p[1];
+            q[2] = p[2];
+            q[3] = 255;
+        }
+        if (vips_rect_isempty(&hit) || y < hit.top || y >= VIPS_RECT_BOTTOM(&hit)) {
+            continue;
+        }
+
+        const uint8_t* m = VIPS_REGION_ADDR(mark, hit.left - place->x, y - place->y);
+        for (int x = 0; x < hit.width; ++x, m += 4) {
+            unsigned alpha = place->premultiplied ? m[3] : div255(m[3] * place->opacity);
+            for (int c = 0; c < 3; ++c) {
+                colour[4 * x + c] = place->premultiplied ? m[c] : static_cast<uint8_t>(div255(m[c] * alpha));
+            }
+            colour[4 * x + 3] = static_cast<uint8_t>(alpha);
+            std::memset(inverse + 4 * x, static_cast<int>(255 - alpha), 4);
+        }
+        uint8_t* row = VIPS_REGION_ADDR(out, hit.left, y);
+        multiply_add_bytes(row, inverse, colour, row, static_cast<size_t>(hit.width) * 4);
+    }
+    return 0;
+}
+
+/**
+ * @brief True if the OVER fast path applies: an opaque 8-bit sRGB base and an 8-bit sRGB overlay with alpha.
+ */
+static bool uchar_over_layout(const VImage& base, const VImage& overlay) {
+    return base.format() == VIPS_FORMAT_UCHAR && base.bands() == 3 && base.interpretation() == VIPS_INTERPRETATION_sRGB &&
+           overlay.format() == VIPS_FORMAT_UCHAR && overlay.bands() == 4 && overlay.has_alpha() &&
+           overlay.interpretation() == VIPS_INTERPRETATION_sRGB;
+}
+
+/**
+ * @brief Composites `overlay` at (x, y) OVER `base`, both in uchar; see uchar_over_layout().
+ *
+ * Matches composite2() with VIPS_BLEND_MODE_OVER, including its opaque alpha output band.
+ *
+ * @param premultiplied True if the overlay colour is premultiplied (prepared watermarks).
+ * @param opacity Opacity applied to a straight-alpha overlay, in [0.0, 1.0].
+ */
+static VImage composite_over_uchar(const VImage& base, const VImage& overlay, int x, int y,
+                                   bool premultiplied, double opacity) {
+    OverPlacement place{x, y, premultiplied, static_cast<uint8_t>(std::lround(opacity * 255.0))};
+    return generate_bytes(base, &overlay, 4, generate_over, place);
+}
+
+/**
+ * @brief Composites `watermark` onto `img`.
+ * @return SUCCESS on success.
+ */
+static ImageStatus apply_watermark(VImage& img, const VImage& watermark, ImageWatermarkOptions options) {
+    if (int frames = frame_count(img); frames > 1) {
+        return map_frames(img, frames, [&](VImage& frame) { return apply_watermark(frame, watermark, options); });
+    }
+    // Ensure opacity is within valid range [0.0, 1.0]
+    options.opacity = std::max(0.0, std::min(1.0, options.opacity));
+
+    VImage watermark_copy = watermark;
+
+    // Ensure watermark has an alpha channel for blending, add one if missing
+    if (!watermark_copy.has_alpha()) {
+        watermark_copy = watermark_copy.bandjoin(255); // Add opaque alpha channel
+    }
+    if (uchar_over_layout(img, watermark_copy)) {
+        img = composite_over_uchar(img, watermark_copy, options.x, options.y, false, options.opacity);
+        return SUCCESS;
+    }
+
+    // Apply opacity to the watermark's alpha channel if less than 1.0
+    if (options.opacity < 1.0) {
+        VImage alpha_channel = watermark_copy.extract_band(watermark_copy.bands() - 1);
+        VImage scaled_alpha = alpha_channel * options.opacity;
+        watermark_copy = watermark_copy.extract_band(0, VImage::option()->set("n", watermark_copy.bands() - 1))
+                   .bandjoin(scaled_alpha);
+    }
+
+    // Composite the watermark onto the base image, overwriting the original VImage object
+    img = img.composite2(watermark_copy, VIPS_BLEND_MODE_OVER,
+        VImage::option()->set("x", options.x)->set("y", options.y));
+    return SUCCESS;
+}
+
+// State behind an ImageWatermarkHandle: the handle owns one reference, and pipelines
+// and pool jobs take their own, so a watermark can be freed while jobs still use it
+struct PreparedWatermark {
+    VImage image;               // sRGB, opacity applied, premultiplied, in memory
+    VipsBlendMode blend;
+    uint64_t serial;            // Process-unique identity, part of result cache keys
+    std::mutex mutex;           // Guards scaled
+    std::map<int, VImage> scaled;   // Size class width -> rendered variant
+};
+using WatermarkRef = std::shared_ptr<PreparedWatermark>;
+
+// Upper bound on the scaled variants one prepared watermark keeps; further sizes are rendered per call
+static const size_t MAX_WATERMARK_SIZE_CLASSES = 24;
+
+/**
+ * @brief Maps an ImageBlendMode to the libvips blend mode.
+ */
+static VipsBlendMode composite_mode(ImageBlendMode mode) {
+    switch (mode) {
+        case IMAGE_BLEND_MULTIPLY:   return VIPS_BLEND_MODE_MULTIPLY;
+        case IMAGE_BLEND_SCREEN:     return VIPS_BLEND_MODE_SCREEN;
+        case IMAGE_BLEND_OVERLAY:    return VIPS_BLEND_MODE_OVERLAY;
+        case IMAGE_BLEND_DARKEN:     return VIPS_BLEND_MODE_DARKEN;
+        case IMAGE_BLEND_LIGHTEN:    return VIPS_BLEND_MODE_LIGHTEN;
+        case IMAGE_BLEND_HARD_LIGHT: return VIPS_BLEND_MODE_HARD_LIGHT;
+        case IMAGE_BLEND_SOFT_LIGHT: return VIPS_BLEND_MODE_SOFT_LIGHT;
+        case IMAGE_BLEND_DIFFERENCE: return VIPS_BLEND_MODE_DIFFERENCE;
+        case IMAGE_BLEND_EXCLUSION:  return VIPS_BLEND_MODE_EXCLUSION;
+        default:                     return VIPS_BLEND_MODE_OVER;
+    }
+}
+
+/**
+ * @brief Builds the memory-resident overlay of a prepared watermark.
+ *
+ * @param watermark The overlay as loaded.
+ * @param opacity Opacity to bake into the alpha channel, clamped to [0.0, 1.0].
+ * @return The overlay in sRGB with premultiplied alpha, in the overlay's band format.
+ */
+static VImage premultiplied_overlay(const VImage& watermark, double opacity) {
+    opacity = std::max(0.0, std::min(1.0, opacity));
+
+    VImage overlay = watermark.colourspace(VIPS_INTERPRETATION_sRGB);
+    VipsBandFormat format = overlay.format();
+    if (!overlay.has_alpha()) {
+        overlay = overlay.bandjoin(255);
+    }
+    if (opacity < 1.0) {
+        VImage alpha = overlay.extract_band(overlay.bands() - 1) * opacity;
+        overlay = overlay.extract_band(0, VImage::option()->set("n", overlay.bands() - 1)).bandjoin(alpha);
+    }
+    return overlay.premultiply().rint().cast(format).copy_memory();
+}
+
+/**
+ * @brief Returns the size class for a target watermark width.
+ *
+ * Classes are 8 per octave (2^(k/8)), rounded down so the watermark never grows past the target.
+ */
+static int watermark_size_class(double width) {
+    int k = static_cast<int>(std::floor(8.0 * std::log2(std::max(1.0, width))));
+    return std::max(1, static_cast<int>(std::floor(std::exp2(k / 8.0))));
+}
+
+/**
+ * @brief Returns the prepared overlay scaled for a base image of the given width.
+ *
+ * The first request for a size class renders the variant into memory and keeps it;
+ * later requests, from any thread, reuse it.
+ *
+ * @param mark The prepared watermark.
+ * @param base_width Width of the image the watermark is applied to.
+ * @param width_fraction Target watermark width relative to base_width; 0 keeps the natural size.
+ * @return The overlay to composite.
+ */
+static VImage scaled_overlay(PreparedWatermark& mark, int base_width, double width_fraction) {
+    if (width_fraction <= 0.0) {
+        return mark.image;
+    }
+    int width = watermark_size_class(base_width * width_fraction);
+    if (width == mark.image.width()) {
+        return mark.image;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mark.mutex);
+        auto it = mark.scaled.find(width);
+        if (it != mark.scaled.end()) {
+            return it->second;
+        }
+    }
+
+    // Rendered outside the lock; a concurrent first use of the same class renders it twice
+    VImage variant = mark.image.resize(static_cast<double>(width) / mark.image.width()).copy_memory();
+    std::lock_guard<std::mutex> lock(mark.mutex);
+    if (mark.scaled.size() < MAX_WATERMARK_SIZE_CLASSES) {
+        mark.scaled.emplace(width, variant);
+    }
+    return variant;
+}
+
+/**
+ * @brief Offset of a watermark of `size` along an axis of `extent` for an anchor.
+ * @param anchor -1 for the leading edge, 0 for centred, 1 for the trailing edge.
+ * @param margin Distance from the anchored edge, or shift when centred.
+ */
+static int anchor_offset(int anchor, int extent, int size, int margin) {
+    if (anchor < 0) return margin;
+    if (anchor > 0) return extent - size - margin;
+    return (extent - size) / 2 + margin;
+}
+
+/**
+ * @brief Splits a gravity into per-axis anchors for anchor_offset().
+ *
+ * NONE and TILE have no anchor and map to the centre.
+ */
+static void gravity_anchors(ImageGravity gravity, int* anchor_x, int* anchor_y) {
+    if (gravity < IMAGE_GRAVITY_NORTH_WEST || gravity > IMAGE_GRAVITY_SOUTH_EAST) {
+        *anchor_x = 0;
+        *anchor_y = 0;
+        return;
+    }
+    // Gravities are laid out row by row, NORTH_WEST .. SOUTH_EAST
+    int index = static_cast<int>(gravity) - IMAGE_GRAVITY_NORTH_WEST;
+    *anchor_x = index % 3 - 1;
+    *anchor_y = index / 3 - 1;
+}
+
+/**
+ * @brief Composites a prepared watermark onto `img`.
+ * @return SUCCESS on success.
+ */
+static ImageStatus apply_prepared_watermark(VImage& img, PreparedWatermark& mark,
+                                            const ImageWatermarkPlacement& placement) {
+    if (int frames = frame_count(img); frames > 1) {
+        return map_frames(img, frames, [&](VImage& frame) {
+            return apply_prepared_watermark(frame, mark, placement);
+        });
+    }
+    VImage overlay = scaled_overlay(mark, img.width(), placement.width_fraction);
+    int x = placement.x;
+    int y = placement.y;
+
+    if (placement.gravity == IMAGE_GRAVITY_TILE) {
+        // Repeat the overlay over the whole image, shifting the grid by x/y
+        int w = overlay.width();
+        int h = overlay.height();
+        int left = ((-x % w) + w) % w;
+        int top = ((-y % h) + h) % h;
+        int across = (left + img.width() + w - 1) / w;
+        int down = (top + img.height() + h - 1) / h;
+        overlay = overlay.replicate(across, down).crop(left, top, img.width(), img.height());
+        x = 0;
+        y = 0;
+    } else if (placement.gravity != IMAGE_GRAVITY_NONE) {
+        int anchor_x, anchor_y;
+        gravity_anchors(placement.gravity, &anchor_x, &anchor_y);
+        x = anchor_offset(anchor_x, img.width(), overlay.width(), placement.x);
+        y = anchor_offset(anchor_y, img.height(), overlay.height(), placement.y);
+    }
+
+    if (mark.blend == VIPS_BLEND_MODE_OVER && uchar_over_layout(img, overlay)) {
+        img = composite_over_uchar(img, overlay, x, y, true, 1.0);
+        return SUCCESS;
+    }
+
+    // The overlay is premultiplied, so the base must be too; an opaque base is its own premultiplied form
+    VipsBandFormat format = img.format();
+    bool base_alpha = img.has_alpha();
+    VImage base = base_alpha ? img.premultiply() : img;
+    VImage result = base.composite2(overlay, mark.blend,
+        VImage::option()->set("x", x)->set("y", y)->set("premultiplied", true));
+    if (base_alpha) {
+        result = result.unpremultiply();
+    }
+    img = result.format() == format ? result : result.cast(format);
+    return SUCCESS;
+}
+
+/**
+ * @brief Maps cover options to the libvips crop strategy for a source of width x height.
+ *
+ * A gravity only matters along the axis that overflows once the source is scaled
+ * to cover the box, which is where it becomes the low, centre or high end.
+ */
+static VipsInteresting cover_interesting(const ImageCoverOptions& options, int width, int height) {
+    switch (options.mode) {
+        case IMAGE_CROP_ATTENTION: return VIPS_INTERESTING_ATTENTION;
+        case IMAGE_CROP_ENTROPY:   return VIPS_INTERESTING_ENTROPY;
+        case IMAGE_CROP_GRAVITY: {
+            int anchor_x, anchor_y;
+            gravity_anchors(options.gravity, &anchor_x, &anchor_y);
+            bool wider = static_cast<long long>(width) * options.height >
+                         static_cast<long long>(options.width) * height;
+            int anchor = wider ? anchor_x : anchor_y;
+            return anchor < 0 ? VIPS_INTERESTING_LOW : anchor > 0 ? VIPS_INTERESTING_HIGH : VIPS_INTERESTING_CENTRE;
+        }
+        default:                   return VIPS_INTERESTING_CENTRE;
+    }
+}
+
+/**
+ * @brief Scales `img` to cover the box of `options` and crops it to exactly that box.
+ * @return SUCCESS on success, or IMAGE_INVALID_DIMENSIONS for a non-positive box.
+ */
+static ImageStatus apply_cover(VImage& img, const ImageCoverOptions& options) {
+    if (int frames = frame_count(img); frames > 1) {
+        return map_frames(img, frames, [&](VImage& frame) { return apply_cover(frame, options); });
+    }
+    if (options.width <= 0 || options.height <= 0) {
+        log_error("Error: Invalid dimensions provided for cover (width and height must be positive).");
+        return IMAGE_INVALID_DIMENSIONS;
+    }
+
+    double scale = std::max(static_cast<double>(options.width) / img.width(),
+                            static_cast<double>(options.height) / img.height());
+    // Rounding must never leave the covering image short of the box
+    int cover_width = std::max(options.width, static_cast<int>(std::lround(img.width() * scale)));
+    int cover_height = std::max(options.height, static_cast<int>(std::lround(img.height() * scale)));
+    VImage covering = resize_exact(img, cover_width, cover_height);
+
+    if (options.mode == IMAGE_CROP_ATTENTION || options.mode == IMAGE_CROP_ENTROPY) {
+        // The analysis reads the whole image before the crop reads it again
+        img = ensure_random_access(covering).smartcrop(options.width, options.height, VImage::option()
+            ->set("interesting", cover_interesting(options, img.width(), img.height())));
+        return SUCCESS;
+    }
+
+    int anchor_x = 0, anchor_y = 0;
+    if (options.mode == IMAGE_CROP_GRAVITY) {
+        gravity_anchors(options.gravity, &anchor_x, &anchor_y);
+    }
+    img = covering.crop(anchor_offset(anchor_x, cover_width, options.width, 0),
+                        anchor_offset(anchor_y, cover_height, options.height, 0),
+                        options.width, options.height);
+    return SUCCESS;
+}
+
+/**
+ * @brief Translates ImageCoverOptions into vips_thumbnail arguments.
+ *
+ * @param options The cover options to translate.
+ * @param width Upright source width; only read for IMAGE_CROP_GRAVITY.
+ * @param height Upright source height; only read for IMAGE_CROP_GRAVITY.
+ * @param autorotate Whether the thumbnail applies the EXIF orientation.
+ * @param option The VOption set that receives "height", "crop" and "no_rotate".
+ * @return The width to pass to the thumbnail operation.
+ */
+static int cover_thumbnail_options(const ImageCoverOptions& options, int width, int height, bool autorotate,
+                                   VOption* option) {
+    option->set("height", options.height);
+    option->set("crop", cover_interesting(options, width, height));
+    option->set("no_rotate", !autorotate);
+    return options.width;
+}
+
+/**
+ * @brief Size of a source header as it will be after the optional autorotation.
+ */
+static void upright_size(const VImage& header, bool autorotate, int* width, int* height) {
+    int orientation = header.get_typeof(VIPS_META_ORIENTATION) ? header.get_int(VIPS_META_ORIENTATION) : 1;
+    // Orientations 5-8 include a quarter turn
+    bool swap = autorotate && orientation >= 5 && orientation <= 8;
+    *width = swap ? header.height() : header.width();
+    *height = swap ? header.width() : header.height();
+}
+
+/**
+ * @brief Changes the overall opacity of `img`, adding an alpha channel if needed.
+ * @return SUCCESS on success.
+ */
+static ImageStatus apply_opacity(VImage& img, ImageOpacityOptions options) {
+    // Ensure opacity is within valid range [0.0, 1.0]
+    options.opacity = std::max(0.0, std::min(1.0, options.opacity));
+
+    VImage img_copy = img; // Work on a copy to avoid partial modifications on error
+    if (uchar_alpha_layout(img_copy)) {
+        img = scale_alpha_uchar(img_copy, options.opacity);
+        return SUCCESS;
+    }
+
+    // Add an alpha channel if the image doesn't have one
+    if (!img_copy.has_alpha()) {
+        img_copy = img_copy.bandjoin(255); // Add an opaque alpha channel
+    }
+
+    // Extract and scale the alpha channel
+    VImage alpha_channel = img_copy.extract_band(img_copy.bands() - 1);
+    VImage scaled_alpha = alpha_channel * options.opacity;
+
+    // Recombine the color bands with the new alpha channel and overwrite the original
+    img = img_copy.extract_band(0, VImage::option()->set("n", img_copy.bands() - 1))
+              .bandjoin(scaled_alpha);
+    return SUCCESS;
+}
+
+/**
+ * @brief Maps an ImageIntent to the libvips rendering intent.
+ */
+static VipsIntent render_intent(ImageIntent intent) {
+    switch (intent) {
+        case IMAGE_INTENT_PERCEPTUAL: return VIPS_INTENT_PERCEPTUAL;
+        case IMAGE_INTENT_SATURATION: return VIPS_INTENT_SATURATION;
+        case IMAGE_INTENT_ABSOLUTE:   return VIPS_INTENT_ABSOLUTE;
+        default:                      return VIPS_INTENT_RELATIVE;
+    }
+}
+
+/**
+ * @brief Converts `img` to 8-bit sRGB, or 8-bit greyscale for greyscale input.
+ *
+ * Embedded profiles and CMYK go through lcms; everything else through the built-in
+ * colourspace conversions, which are also the fallback when libvips lacks lcms.
+ *
+ * @return SUCCESS on success.
+ */
+static ImageStatus apply_srgb8(VImage& img, const ImageSRGBOptions& options) {
+    VipsInterpretation interpretation = img.interpretation();
+    bool grey = interpretation == VIPS_INTERPRETATION_B_W || interpretation == VIPS_INTERPRETATION_GREY16;
+    bool has_profile = img.get_typeof(VIPS_META_ICC_NAME) != 0;
+
+    // Already 8-bit sRGB/greyscale with nothing to honour: the common case costs nothing
+    if (!has_profile && img.format() == VIPS_FORMAT_UCHAR &&
+        (interpretation == VIPS_INTERPRETATION_sRGB || interpretation == VIPS_INTERPRETATION_B_W)) {
+        return SUCCESS;
+    }
+
+    VImage converted = img;
+    bool icc_converted = false;
+    if (has_profile || interpretation == VIPS_INTERPRETATION_CMYK) {
+        try {
+            VOption* option = VImage::option()
+                ->set("intent", render_intent(options.intent))
+                ->set("depth", 8);
+            if (has_profile) {
+                option->set("embedded", true);
+            } else {
+                option->set("input_profile", "cmyk");
+            }
+            converted = img.icc_transform("srgb", option);
+            icc_converted = true;
+        } catch (const VError &e) {
+            log_message(IMAGE_LOG_WARNING, "ICC conversion to sRGB failed, using built-in conversion: ", e.what());
+            vips_error_clear();
+        }
+    }
+
+    if (!icc_converted) {
+        VipsInterpretation target = grey ? VIPS_INTERPRETATION_B_W : VIPS_INTERPRETATION_sRGB;
+        if (interpretation != target) {
+            converted = converted.colourspace(target);
+        }
+    }
+    if (converted.format() != VIPS_FORMAT_UCHAR) {
+        // 16-bit data mislabelled as 8-bit colourspaces still needs scaling down, not clipping
+        converted = converted.cast(VIPS_FORMAT_UCHAR,
+                                   VImage::option()->set("shift", converted.format() == VIPS_FORMAT_USHORT));
+    }
+
+    // The input profile no longer describes the pixels unless lcms produced the sRGB one
+    if ((!icc_converted || !options.keep_profile) && converted.get_typeof(VIPS_META_ICC_NAME)) {
+        converted = converted.copy();
+        converted.remove(VIPS_META_ICC_NAME);
+    }
+    img = converted;
+    return SUCCESS;
+}
+
+/**
+ * @brief Maps an ImageFormat to the suffix selecting its libvips saver.
+ * @return The suffix, or nullptr for formats that cannot be encoded.
+ */
+static const char* format_suffix(ImageFormat format) {
+    switch (format) {
+        case IMAGE_FORMAT_JPEG: return ".jpg";
+        case IMAGE_FORMAT_PNG: return ".png";
+        case IMAGE_FORMAT_WEBP: return ".webp";
+        case IMAGE_FORMAT_AVIF: return ".avif";
+        case IMAGE_FORMAT_JXL: return ".jxl";
+        case IMAGE_FORMAT_HEIF: return ".heic";
+        case IMAGE_FORMAT_GIF: return ".gif";
+        default: return nullptr;
+    }
+}
+
+/**
+ * @brief Builds the saver VOption set for an encode spec.
+ * @param spec The encode spec; its format must have a suffix.
+ * @return A VOption set to pass to write_to_buffer/write_to_target.
+ */
+static VOption* format_option(const ImageEncodeSpec& spec) {
+    switch (spec.format) {
+        case IMAGE_FORMAT_PNG: return png_option(spec.png);
+        case IMAGE_FORMAT_WEBP: return webp_option(spec.webp);
+        case IMAGE_FORMAT_AVIF: return heif_option(spec.avif, 50);
+        case IMAGE_FORMAT_JXL: return jxl_option(spec.jxl);
+        case IMAGE_FORMAT_HEIF: return heif_option(spec.heif, 50);
+        case IMAGE_FORMAT_GIF: return gif_option(spec.gif);
+        default: return jpeg_option(spec.jpeg);
+    }
+}
+
+/**
+ * @brief Checks that a crop rectangle is valid and lies inside a width x height image.
+ */
+static bool crop_fits(const ImageCropOptions& crop, int width, int height) {
+    return crop.width > 0 && crop.height > 0 && crop.x >= 0 && crop.y >= 0 &&
+           static_cast<long long>(crop.x) + crop.width <= width &&
+           static_cast<long long>(crop.y) + crop.height <= height;
+}
+
+/**
+ * @brief Runs a list of pipeline steps on `img`, fusing steps where the result is unchanged.
+ *
+ * Fusions: consecutive crops collapse into one crop of the outermost image, consecutive
+ * opacity changes multiply into one, and rotations by a multiple of 360 degrees are
+ * dropped. Crops are not moved ahead of resizes: libvips evaluates on demand, so a crop
+ * after a resize already computes only the cropped window, and moving it would change
+ * the edge pixels the resize kernel sees.
+ *
+ * @param img The image to transform; replaced only if every step succeeds.
+ * @param ops The steps to run.
+ * @param n Number of steps.
+ * @return SUCCESS on success, or the error code of the first failing step.
+ */
+static ImageStatus apply_pipeline(VImage& img, const ImagePipelineOp* ops, size_t n) {
+    VImage working = img;
+
+    for (size_t i = 0; i < n; ++i) {
+        const ImagePipelineOp& op = ops[i];
+        ImageStatus status = SUCCESS;
+
+        switch (op.type) {
+            case PIPELINE_OP_RESIZE:
+                status = apply_resize(working, op.resize);
+                break;
+            case PIPELINE_OP_CROP: {
+                ImageCropOptions crop = op.crop;
+                // A crop of a crop is a single crop, as long as the outer one is valid
+                while (i + 1 < n && ops[i + 1].type == PIPELINE_OP_CROP &&
+                       crop_fits(crop, working.width(), frame_height(working)) &&
+                       crop_fits(ops[i + 1].crop, crop.width, crop.height)) {
+                    const ImageCropOptions& inner = ops[++i].crop;
+                    crop = ImageCropOptions{crop.x + inner.x, crop.y + inner.y, inner.width, inner.height};
+                }
+                status = apply_crop(working, crop);
+                break;
+            }
+            case PIPELINE_OP_ROTATE:
+                if (std::fmod(op.rotate.angle, 360.0) != 0.0) {
+                    status = apply_rotate(working, op.rotate);
+                }
+                break;
+            case PIPELINE_OP_WATERMARK:
+                if (!op.watermark_image) {
+                    log_error("Error: Invalid watermark handle in pipeline step ", i, ".");
+                    return VIPS_INVALID_HANDLE;
+                }
+                status = apply_watermark(working, *static_cast<const VImage*>(op.watermark_image), op.watermark);
+                break;
+            case PIPELINE_OP_PREPARED_WATERMARK:
+                if (!op.prepared_watermark) {
+                    log_error("Error: Invalid prepared watermark handle in pipeline step ", i, ".");
+                    return VIPS_INVALID_HANDLE;
+                }
+                status = apply_prepared_watermark(working, **static_cast<WatermarkRef*>(op.prepared_watermark),
+                                                  op.placement);
+                break;
+            case PIPELINE_OP_ENSURE_SRGB8:
+                status = apply_srgb8(working, op.srgb);
+                break;
+            case PIPELINE_OP_FLIP:
+                status = apply_flip(working, op.flip);
+                break;
+            case PIPELINE_OP_COVER:
+                status = apply_cover(working, op.cover);
+                break;
+            case PIPELINE_OP_OPACITY: {
+                double opacity = std::max(0.0, std::min(1.0, op.opacity.opacity));
+                // Alpha scaling composes multiplicatively
+                while (i + 1 < n && ops[i + 1].type == PIPELINE_OP_OPACITY) {
+                    opacity *= std::max(0.0, std::min(1.0, ops[++i].opacity.opacity));
+                }
+                status = apply_opacity(working, ImageOpacityOptions{opacity});
+                break;
+            }
+            default:
+                log_error("Error: Unknown operation type ", op.type, " in pipeline step ", i, ".");
+                return UNKNOWN_ERROR;
+        }
+
+        if (status != SUCCESS) {
+            // Keep the step's own message as the cause
+            char cause[IMAGE_ERROR_MESSAGE_SIZE];
+            std::memcpy(cause, last_error.message, sizeof(cause));
+            log_error("Error: Pipeline step ", i, " failed: ", cause);
+            return status;
+        }
+    }
+
+    img = working;
+    return SUCCESS;
+}
+
+// State behind an ImageCancelHandle: the handle owns one reference and every
+// cancellable render takes its own, so a token can be freed while renders still check it
+struct CancelToken {
+    std::atomic<bool> cancelled{false};
+    std::chrono::steady_clock::rep deadline;    // steady_clock ticks of the deadline; 0 = none
+};
+using CancelRef = std::shared_ptr<CancelToken>;
+
+/**
+ * @brief True once `token` has been cancelled or its deadline has passed.
+ */
+static bool cancel_requested(CancelToken& token) {
+    if (token.cancelled.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    if (token.deadline != 0 && std::chrono::steady_clock::now().time_since_epoch().count() >= token.deadline) {
+        token.cancelled.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+// Process-wide state of the adaptive scheduler
+struct Scheduler {
+    std::mutex mutex;
+    ImageSchedulerOptions options{};    // pixels_per_thread <= 0 = off
+    int in_use = 0;                     // Threads held by running renders
+};
+static Scheduler scheduler;
+
+/**
+ * @brief Worker threads of one render, held from the scheduler's budget until it goes out of scope.
+ */
+class ThreadGrant {
+public:
+    /**
+     * @brief Sizes a render of `pixels` pixels, or takes `requested` threads outside the budget.
+     *
+     * threads() is 0 when neither applies, leaving the global concurrency in charge.
+     */
+    ThreadGrant(guint64 pixels, int requested) {
+        if (requested > 0) {
+            threads_ = requested;
+            return;
+        }
+        std::lock_guard<std::mutex> lock(scheduler.mutex);
+        const ImageSchedulerOptions& options = scheduler.options;
+        if (options.pixels_per_thread <= 0) {
+            return;
+        }
+        int max_threads = std::max(1, options.max_threads > 0 ? options.max_threads : vips_concurrency_get());
+        int budget = options.thread_budget > 0 ? options.thread_budget
+                                               : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        guint64 per_thread = static_cast<guint64>(options.pixels_per_thread);
+        guint64 wanted = std::min<guint64>((pixels + per_thread - 1) / per_thread, max_threads);
+        // Never wait for the budget: a render starting while it is used up runs on one thread
+        threads_ = std::clamp(static_cast<int>(wanted), 1, std::max(1, budget - scheduler.in_use));
+        scheduler.in_use += threads_;
+        held_ = true;
+    }
+
+    ~ThreadGrant() {
+        if (held_) {
+            std::lock_guard<std::mutex> lock(scheduler.mutex);
+            scheduler.in_use -= threads_;
+        }
+    }
+
+    ThreadGrant(const ThreadGrant&) = delete;
+    ThreadGrant& operator=(const ThreadGrant&) = delete;
+
+    int threads() const { return threads_; }
+
+private:
+    int threads_ = 0;
+    bool held_ = false;     // Counted against the scheduler's budget
+};
+
+// State of one render gate, shared by the libvips worker threads computing its strips
+struct RenderControl {
+    CancelRef cancel;                   // Null when not cancellable
+    ImageProgressFn progress = nullptr;
+    void* user_data = nullptr;
+    guint64 total = 0;                  // Pixels in the gated image
+    std::atomic<guint64> done{0};       // Pixels passed through so far
+    std::atomic<int> reported{-1};      // Last percentage given to `progress`
+    std::mutex report_mutex;            // Keeps progress calls ordered and non-overlapping
+};
+using RenderRef = std::shared_ptr<RenderControl>;
+
+/**
+ * @brief Calls the progress callback of `control` if `percent` has not been reported yet.
+ */
+static void report_progress(RenderControl& control, int percent) {
+    if (percent <= control.reported.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(control.report_mutex);
+    if (percent <= control.reported.load(std::memory_order_relaxed)) {
+        return;
+    }
+    control.reported.store(percent, std::memory_order_relaxed);
+    control.progress(percent, control.user_data);
+}
+
+/**
+ * @brief Generator passing pixels through unchanged, counting them for progress, until its token is cancelled.
+ *
+ * On cancellation it sets the kill flag of its image, so the threadpool stops
+ * handing out strips, and fails the strip with a libvips error.
+ */
+static int generate_render_gate(VipsRegion* out, void* sequence, void* a, void* b, gboolean* stop) {
+    VipsRegion* in = static_cast<VipsRegion*>(sequence);
+    RenderControl& control = **static_cast<RenderRef*>(b);
+    if (control.cancel && cancel_requested(*control.cancel)) {
+        vips_image_set_kill(out->im, TRUE);
+        vips_error("vips_wrapper", "%s", "render cancelled");
+        return -1;
+    }
+    if (vips_region_prepare(in, &out->valid) ||
+        vips_region_region(out, in, &out->valid, out->valid.left, out->valid.top)) {
+        return -1;
+    }
+    if (control.progress) {
+        guint64 area = static_cast<guint64>(out->valid.width) * out->valid.height;
+        guint64 done = control.done.fetch_add(area, std::memory_order_relaxed) + area;
+        // 100 is reported by run_pipeline once the encoder has finished
+        report_progress(control, static_cast<int>(std::min<guint64>(99, done * 100 / control.total)));
+    }
+    return 0;
+}
+
+/**
+ * @brief "postclose" handler dropping the control reference of a render gate.
+ */
+static void release_render_control(VipsImage* image, void* user_data) {
+    delete static_cast<RenderRef*>(user_data);
+}
+
+/**
+ * @brief Wraps `img` in a pass-through image carrying the per-render controls.
+ *
+ * The gate fails every strip computed after the token of `control` is
+ * cancelled, reports progress, and asks libvips for `threads` worker threads
+ * (0 = the global setting). It belongs to one render only: killing it or
+ * setting its concurrency never touches `img` or images shared with other calls.
+ *
+ * @throws VError if libvips cannot set up the image.
+ */
+static VImage render_gate(const VImage& img, const RenderRef& control, int threads) {
+    VipsImage* out = vips_image_new();
+    VipsImage** in = vips_allocate_input_array(out, img.get_image(), nullptr);
+    if (!in || vips_image_pipeline_array(out, VIPS_DEMAND_STYLE_THINSTRIP, in)) {
+        g_object_unref(out);
+        throw VError();
+    }
+    control->total = std::max<guint64>(1, static_cast<guint64>(out->Xsize) * out->Ysize);
+    RenderRef* held = new RenderRef(control);
+    g_signal_connect(out, "postclose", G_CALLBACK(release_render_control), held);
+    if (vips_image_generate(out, vips_start_one, generate_render_gate, vips_stop_one, in[0], held)) {
+        g_object_unref(out);
+        throw VError();
+    }
+// libvips 8.13 added per-image concurrency; the encoder's pipeline inherits it from the gate
+#if VIPS_MAJOR_VERSION > 8 || (VIPS_MAJOR_VERSION == 8 && VIPS_MINOR_VERSION >= 13)
+    if (threads > 0) {
+        vips_image_set_concurrency(out, threads);
+    }
+#endif
+    return VImage(out);
+}
+
+/**
+ * @brief Runs a validated pipeline on `img`, encoding to `result` or applying in place.
+ *
+ * With IMAGE_FORMAT_NONE `img` is replaced by the processed image on success;
+ * otherwise `img` is left untouched and the encoded output is stored in `result`.
+ * A cancel token in `run` is checked before the steps and, through a render gate,
+ * on every strip the encoder computes; the gate also carries the thread count and
+ * progress reporting of the render and is never left on `img`.
+ *
+ * @return SUCCESS, the failing step's status, IMAGE_CANCELLED, or VIPS_ERROR when encoding fails.
+ */
+static ImageStatus run_pipeline(VImage& img, const ImagePipelineOp* ops, size_t n, const ImageEncodeSpec& out,
+                                ImageBuffer* result, const ImageRunOptions* run = nullptr) {
+    OperationTimer timer(IMAGE_OP_PIPELINE);
+    const CancelRef* cancel = run && run->cancel ? static_cast<const CancelRef*>(run->cancel) : nullptr;
+    void* buf = nullptr;
+    size_t buf_size = 0;
+
+    try {
+        if (cancel && cancel_requested(**cancel)) {
+            set_error_message("Pipeline cancelled before it started.");
+            return timer.finish(IMAGE_CANCELLED);
+        }
+        VImage working = img;
+        ImageStatus status = apply_pipeline(working, ops, n);
+        if (status != SUCCESS) {
+            return timer.finish(status);
+        }
+
+        if (out.format == IMAGE_FORMAT_NONE) {
+            img = working;
+            return timer.finish(SUCCESS);
+        }
+
+        guint64 pixels = std::max(static_cast<guint64>(img.width()) * img.height(),
+                                  static_cast<guint64>(working.width()) * working.height());
+        ThreadGrant grant(pixels, run ? run->concurrency : 0);
+        RenderRef control;
+        if (cancel || (run && run->progress) || grant.threads() > 0) {
+            control = std::make_shared<RenderControl>();
+            if (cancel) control->cancel = *cancel;
+            if (run) {
+                control->progress = run->progress;
+                control->user_data = run->user_data;
+            }
+            working = render_gate(working, control, grant.threads());
+        }
+        working.write_to_buffer(format_suffix(out.format), &buf, &buf_size, format_option(out));
+        if (control && control->progress) {
+            report_progress(*control, 100);
+        }
+        *result = ImageBuffer{static_cast<unsigned char*>(buf), buf_size};
+        return timer.finish(SUCCESS, buf_size);
+    } catch (const VError &e) {
+        if (buf) g_free(buf);
+        if (cancel && cancel_requested(**cancel)) {
+            // Expected when the caller gives up; recorded for vips_wrapper_last_error() but not logged
+            vips_error_clear();
+            set_error_message("Pipeline cancelled: ", e.what());
+            return timer.finish(IMAGE_CANCELLED);
+        }
+        log_error("VIPS Error during process_pipeline: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during process_pipeline: ", e.what());
+        if (buf) g_free(buf);
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during process_pipeline: ", e.what());
+        if (buf) g_free(buf);
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during process_pipeline.");
+        if (buf) g_free(buf);
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Computes the size resize_image() gives a width x height image.
+ * @param options Resize options with at least one positive dimension.
+ * @param out_width Receives the target width.
+ * @param out_height Receives the target height.
+ */
+static void resize_target(int width, int height, const ImageResizeOptions& options, int* out_width,
+                          int* out_height) {
+    double scale_x = options.width > 0 ? static_cast<double>(options.width) / width : 0.0;
+    double scale_y = options.height > 0 ? static_cast<double>(options.height) / height : 0.0;
+    if (scale_x == 0.0) {
+        scale_x = scale_y;
+    } else if (scale_y == 0.0) {
+        scale_y = scale_x;
+    } else if (options.maintain_aspect) {
+        scale_x = scale_y = std::min(scale_x, scale_y);
+    }
+    // vips_resize rounds the scaled size to the nearest pixel
+    *out_width = std::max(1, static_cast<int>(std::lround(width * scale_x)));
+    *out_height = std::max(1, static_cast<int>(std::lround(height * scale_y)));
+}
+
+/**
+ * @brief Validates rendition specs and computes their target sizes for a source of the given size.
+ *
+ * @param order Receives the spec indices, largest target first.
+ * @param sizes Receives the target width and height of each spec.
+ * @return SUCCESS, IMAGE_INVALID_DIMENSIONS or IMAGE_INVALID_FORMAT.
+ */
+static ImageStatus plan_renditions(int width, int height, const ImageRenditionSpec* specs, size_t n,
+                                   std::vector<size_t>& order, std::vector<std::pair<int, int>>& sizes) {
+    sizes.resize(n);
+    order.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (specs[i].resize.width <= 0 && specs[i].resize.height <= 0) {
+            log_error("Error: Invalid dimensions for rendition ", i, " (width and/or height must be positive).");
+            return IMAGE_INVALID_DIMENSIONS;
+        }
+        if (!format_suffix(specs[i].output.format)) {
+            log_error("Error: Invalid output format for rendition ", i, ".");
+            return IMAGE_INVALID_FORMAT;
+        }
+        resize_target(width, height, specs[i].resize, &sizes[i].first, &sizes[i].second);
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) {
+        return static_cast<long long>(sizes[a].first) * sizes[a].second >
+               static_cast<long long>(sizes[b].first) * sizes[b].second;
+    });
+    return SUCCESS;
+}
+
+/**
+ * @brief Builds the rendition pyramid from `top` and encodes every level in parallel.
+ *
+ * Levels are built largest first and rendered into memory, so encoders never reach
+ * back to the decoder. Each is resized from the smallest level already built that is
+ * at least as large on both axes, or from `top` if there is none, so a level with a
+ * different aspect ratio is never stretched from a smaller one.
+ *
+ * @param top Image to derive the largest rendition from.
+ * @param specs The rendition specs.
+ * @param order Spec indices, largest target first.
+ * @param sizes Target sizes, indexed like specs.
+ * @param out Receives the encoded renditions, indexed like specs; reset to {nullptr, 0} on failure.
+ * @param bytes_out Receives the total encoded size.
+ * @return SUCCESS, or VIPS_ERROR/MEMORY_ALLOCATION_FAILURE for the first failed encode.
+ */
+static ImageStatus render_renditions(const VImage& top, const ImageRenditionSpec* specs,
+                                     const std::vector<size_t>& order,
+                                     const std::vector<std::pair<int, int>>& sizes, ImageBuffer* out,
+                                     uint64_t* bytes_out) {
+    size_t n = order.size();
+    std::vector<VImage> levels(n);
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = order[k];
+        // Earlier levels are larger by area, so the last one covering this level is the smallest
+        const VImage* parent = &top;
+        for (size_t j = 0; j < k; ++j) {
+            const auto& candidate = sizes[order[j]];
+            if (candidate.first >= sizes[i].first && candidate.second >= sizes[i].second) {
+                parent = &levels[order[j]];
+            }
+        }
+        levels[i] = resize_exact(*parent, sizes[i].first, sizes[i].second).copy_memory();
+    }
+
+    // Allocated up front: encoders record failures without allocating, even when out of memory
+    struct LevelResult {
+        ImageStatus status = SUCCESS;
+        char cause[IMAGE_ERROR_MESSAGE_SIZE] = {};
+    };
+    std::vector<LevelResult> results(n);
+    std::atomic<size_t> next{0};
+    // Runs on encoder threads, so nothing may escape it
+    auto encode_levels = [&]() noexcept {
+        for (size_t i = next++; i < n; i = next++) {
+            void* buf = nullptr;
+            size_t buf_size = 0;
+            LevelResult& result = results[i];
+            try {
+                levels[i].write_to_buffer(format_suffix(specs[i].output.format), &buf, &buf_size,
+                                          format_option(specs[i].output));
+                out[i] = ImageBuffer{static_cast<unsigned char*>(buf), buf_size};
+            } catch (const VError &e) {
+                result.status = VIPS_ERROR;
+                std::snprintf(result.cause, sizeof(result.cause), "%s", e.what());
+            } catch (const std::bad_alloc &e) {
+                result.status = MEMORY_ALLOCATION_FAILURE;
+                std::snprintf(result.cause, sizeof(result.cause), "%s", e.what());
+            } catch (const std::exception &e) {
+                result.status = UNKNOWN_ERROR;
+                std::snprintf(result.cause, sizeof(result.cause), "%s", e.what());
+            } catch (...) {
+                result.status = UNKNOWN_ERROR;
+                std::snprintf(result.cause, sizeof(result.cause), "%s", "unknown error");
+            }
+        }
+    };
+
+    // Encoders are largely single-threaded, so run one per core on top of libvips' own threads
+    size_t threads = std::min(n, static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency())));
+    std::vector<std::thread> encoders;
+    try {
+        encoders.reserve(threads - 1);
+        for (size_t t = 1; t < threads; ++t) {
+            encoders.emplace_back([&encode_levels] {
+                encode_levels();
+                // Release the per-thread buffers libvips keeps for this thread
+                vips_thread_shutdown();
+            });
+        }
+    } catch (const std::exception &e) {
+        // Carry on with the threads that did start; the calling thread always encodes
+        log_message(IMAGE_LOG_WARNING, "generate_renditions started ", encoders.size() + 1, " of ", threads,
+                    " encoder threads: ", e.what());
+    }
+    encode_levels();
+    for (auto& encoder : encoders) {
+        encoder.join();
+    }
+
+    *bytes_out = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (results[i].status != SUCCESS) {
+            // Errors are reported on the calling thread, where vips_wrapper_last_error() reads them
+            log_error("Error: Encoding rendition ", i, " failed: ", results[i].cause);
+            for (size_t j = 0; j < n; ++j) {
+                free_image_buffer(out[j]);
+                out[j] = ImageBuffer{nullptr, 0};
+            }
+            return results[i].status;
+        }
+        *bytes_out += out[i].size;
+    }
+    return SUCCESS;
+}
+
+// A queued submit_job request; holds its own references to every image it reads
+struct PoolJob {
+    VImage image;
+    std::vector<ImagePipelineOp> ops;
+    std::vector<VImage> overlays;   // Watermark images, pointed to by ops[i].watermark_image
+    std::vector<WatermarkRef> marks;    // Prepared watermarks, pointed to by ops[i].prepared_watermark
+    ImageEncodeSpec output;
+    ImageJobCompletionFn done;
+    void* user_data;
+};
+
+// State behind an ImageWorkerPoolHandle
+struct WorkerPool {
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<PoolJob> queue;
+    std::vector<std::thread> workers;
+    size_t queue_depth = 0;
+    bool stopping = false;
+};
+
+/**
+ * @brief Worker thread body: runs queued jobs until the pool stops and the queue is drained.
+ */
+static void worker_pool_run(WorkerPool* pool) {
+    for (;;) {
+        PoolJob job;
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->ready.wait(lock, [pool] { return pool->stopping || !pool->queue.empty(); });
+            if (pool->queue.empty()) {
+                break;
+            }
+            job = std::move(pool->queue.front());
+            pool->queue.pop_front();
+        }
+
+        ImageBuffer result{nullptr, 0};
+        ImageStatus status = run_pipeline(job.image, job.ops.data(), job.ops.size(), job.output, &result);
+        job.done(status, result, job.user_data);
+    }
+    // Release the per-thread buffers libvips keeps for this worker
+    vips_thread_shutdown();
+}
+
+/**
+ * @brief Stops a pool's workers after they drain the queue, and joins them.
+ */
+static void worker_pool_stop(WorkerPool* pool) {
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->stopping = true;
+    }
+    pool->ready.notify_all();
+    for (auto& worker : pool->workers) {
+        worker.join();
+    }
+    pool->workers.clear();
+}
+
+/**
+ * @brief g_free as an ImageBufferReleaseFn, for buffers the wrapper copied.
+ */
+static void release_copied_bytes(void* data, void* user_data) {
+    g_free(data);
+}
+
+/**
+ * @brief Loads a private copy of `data` that the loaded image owns.
+ *
+ * For callers whose buffer is only valid during the call: the libvips operation
+ * cache can keep a buffer load, and the pointer it was given, alive after the
+ * image is freed, and a later load of the same pointer and size would then read
+ * whatever the caller's memory holds by then.
+ */
+static VImageHandle load_copied_bytes(const unsigned char* data, size_t size, const ImageLoadOptions& options,
+                                      ImageStatus* status) {
+    if (!data || size == 0 || check_input_size(size, options) != SUCCESS) {
+        // Fails before anything is read, so there is nothing to copy
+        return load_image_from_bytes_with_options(data, size, options, status);
+    }
+    void* copy = g_try_malloc(size);
+    if (!copy) {
+        log_error("Memory allocation error: cannot copy ", size, " bytes of image data.");
+        ImageStatus failed = fail(IMAGE_OP_LOAD, MEMORY_ALLOCATION_FAILURE);
+        if (status) *status = failed;
+        return nullptr;
+    }
+    std::memcpy(copy, data, size);
+    return load_image_from_owned_bytes(static_cast<const unsigned char*>(copy), size, options,
+                                       release_copied_bytes, nullptr, status);
+}
+
+/**
+ * @brief Loads, processes and encodes one process_batch() item into `result`.
+ * Runs on a batch thread; the failure detail is copied out of that thread's ImageError.
+ */
+static void run_batch_item(const ImageBatchItem& item, const ImageBatchSpec& spec, ImageBatchResult* result) {
+    *result = ImageBatchResult{SUCCESS, {nullptr, 0}, {SUCCESS, IMAGE_OP_LOAD, {0}}};
+    ImageStatus status = SUCCESS;
+    VImageHandle handle = nullptr;
+    if (item.path) {
+        handle = load_image_with_options(item.path, spec.load, &status);
+    } else if (item.data && item.size > 0) {
+        handle = load_copied_bytes(item.data, item.size, spec.load, &status);
+    } else {
+        log_error("Error: Batch item has neither a path nor data.");
+        status = fail(IMAGE_OP_LOAD, IMAGE_INVALID_PATH);
+    }
+
+    if (handle) {
+        status = run_pipeline(*static_cast<VImage*>(handle), spec.ops, spec.op_count, spec.output, &result->output);
+        free_vimage_handle(handle);
+    }
+    result->status = status;
+    if (status != SUCCESS) {
+        result->error = last_error;
+        result->error.code = status;
+    }
+}
+
+// libvips 8.15 lets loaders bypass the operation cache entry of a file that was replaced
+#if VIPS_MAJOR_VERSION > 8 || (VIPS_MAJOR_VERSION == 8 && VIPS_MINOR_VERSION >= 15)
+#define VIPS_WRAPPER_HAVE_REVALIDATE 1
+#endif
+
+// Metadata field holding the key of a raw cache file, checked on load against hash collisions
+static const char* const RAW_CACHE_KEY_FIELD = "vipsgo-cache-key";
+
+// Suffix of raw cache entries; the saver is chosen from it, so temporary files end in it too
+static const char* const RAW_CACHE_SUFFIX = ".v";
+
+// Prefix of temporary files being written into a raw cache; they are never indexed
+static const char* const RAW_CACHE_TEMP_PREFIX = "tmp-";
+
+// Age after which a temporary file no writer is updating is left over from a crash
+static const std::chrono::minutes RAW_CACHE_STALE_TEMP_AGE{10};
+
+// File of a raw cache entry, with its position in the LRU list
+struct RawCacheEntry {
+    uint64_t bytes;
+    std::list<std::string>::iterator lru;
+};
+
+// State behind an ImageRawCacheHandle
+struct RawCache {
+    std::filesystem::path directory;
+    uint64_t max_bytes = 0;
+    std::mutex mutex;
+    std::list<std::string> lru;     // File names, most recently used first
+    std::unordered_map<std::string, RawCacheEntry> entries;    // By file name
+    uint64_t bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+/**
+ * @brief File name of the raw cache entry for `key`: the 64-bit FNV-1a hash of the key in hex.
+ * The hash is fixed so that every process sharing a directory agrees on it.
+ */
+static std::string raw_cache_file_name(const char* key) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char* c = key; *c; ++c) {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx%s", static_cast<unsigned long long>(hash), RAW_CACHE_SUFFIX);
+    return name;
+}
+
+/**
+ * @brief Indexes `name` as the most recently used entry, replacing an older entry of the same name.
+ * Caller holds cache->mutex.
+ */
+static void raw_cache_insert(RawCache* cache, const std::string& name, uint64_t bytes) {
+    auto it = cache->entries.find(name);
+    if (it != cache->entries.end()) {
+        cache->bytes -= it->second.bytes;
+        cache->lru.erase(it->second.lru);
+        cache->entries.erase(it);
+    }
+    cache->lru.push_front(name);
+    cache->entries.emplace(name, RawCacheEntry{bytes, cache->lru.begin()});
+    cache->bytes += bytes;
+}
+
+/**
+ * @brief Drops `name` from the index, optionally deleting its file. Caller holds cache->mutex.
+ */
+static void raw_cache_forget(RawCache* cache, const std::string& name, bool remove_file) {
+    auto it = cache->entries.find(name);
+    if (it == cache->entries.end()) {
+        return;
+    }
+    cache->bytes -= it->second.bytes;
+    cache->lru.erase(it->second.lru);
+    cache->entries.erase(it);
+    if (remove_file) {
+        std::error_code remove_error;
+        std::filesystem::remove(cache->directory / name, remove_error);
+    }
+}
+
+/**
+ * @brief Deletes least recently used entries until the cache fits max_bytes, keeping `keep`.
+ * Caller holds cache->mutex.
+ */
+static void raw_cache_evict(RawCache* cache, const std::string& keep) {
+    if (cache->max_bytes == 0) {
+        return;
+    }
+    while (cache->bytes > cache->max_bytes && !cache->lru.empty()) {
+        std::string victim = cache->lru.back();
+        if (victim == keep) {
+            break;
+        }
+        raw_cache_forget(cache, victim, true);
+        ++cache->evictions;
+    }
+}
+
+/**
+ * @brief Counts a raw cache miss and records it without logging; misses are routine.
+ */
+static ImageStatus raw_cache_miss(RawCache* cache, const char* key, ImageStatus* status) {
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        ++cache->misses;
+    }
+    set_error_message("No raw cache entry for key \"", key, "\".");
+    if (status) *status = IMAGE_CACHE_MISS;
+    return fail(IMAGE_OP_RAW_CACHE, IMAGE_CACHE_MISS);
+}
+
+// Process-wide result cache totals reported through ImageStats
+struct ResultCacheCounters {
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> coalesced;
+    std::atomic<uint64_t> evictions;
+    std::atomic<uint64_t> entries;
+    std::atomic<uint64_t> bytes;
+};
+
+static ResultCacheCounters result_cache_counters;
+
+// Byte budget and shard count of a result cache created with zeroed options
+static const uint64_t RESULT_CACHE_DEFAULT_BYTES = 64ull << 20;
+static const int RESULT_CACHE_DEFAULT_SHARDS = 16;
+
+// An encoded output shared by a result cache and the callers it was handed to
+struct CachedResult {
+    explicit CachedResult(const ImageBuffer& buffer) : data(buffer.data), size(buffer.size) {}
+    ~CachedResult() { g_free(data); }
+    CachedResult(const CachedResult&) = delete;
+    CachedResult& operator=(const CachedResult&) = delete;
+
+    unsigned char* data;
+    size_t size;
+};
+using CachedResultRef = std::shared_ptr<const CachedResult>;
+
+// A render in progress, awaited by the identical calls that arrive meanwhile
+struct ResultFlight {
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    bool done = false;
+    ImageStatus status = UNKNOWN_ERROR;
+    ImageError error{SUCCESS, IMAGE_OP_LOAD, {0}};  // Failure detail of the render
+    CachedResultRef result;
+};
+
+// Stored result of a result cache shard, with its position in the LRU list
+struct ResultCacheEntry {
+    CachedResultRef result;
+    std::list<std::string>::iterator lru;
+};
+
+// One independently locked partition of a result cache
+struct ResultCacheShard {
+    std::mutex mutex;
+    std::list<std::string> lru;     // Keys, most recently used first
+    std::unordered_map<std::string, ResultCacheEntry> entries;
+    std::unordered_map<std::string, std::shared_ptr<ResultFlight>> flights;    // Renders in progress, by key
+    uint64_t bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t coalesced = 0;
+    uint64_t evictions = 0;
+};
+
+// State behind an ImageResultCacheHandle
+struct ResultCache {
+    uint64_t shard_bytes = 0;       // Byte budget of each shard
+    std::vector<std::unique_ptr<ResultCacheShard>> shards;
+};
+
+/**
+ * @brief One lane step of the input digest (the XXH64 round).
+ */
+static uint64_t digest_round(uint64_t acc, uint64_t word) {
+    acc += word * 0xC2B2AE3D27D4EB4Full;
+    acc = (acc << 31) | (acc >> 33);
+    return acc * 0x9E3779B185EBCA87ull;
+}
+
+/**
+ * @brief Final avalanche of a digest half (the MurmurHash3 finaliser).
+ */
+static uint64_t digest_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief Rotates `x` left by `r` bits (0 < r < 64).
+ */
+static uint64_t rotate_left(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/**
+ * @brief Appends a 128-bit digest of `data` to `key`.
+ *
+ * Four independent lanes consume 32 bytes per step, so hashing a multi-megabyte
+ * input costs a fraction of decoding it. Not cryptographic.
+ */
+static void append_digest(std::string& key, const unsigned char* data, size_t size) {
+    uint64_t lanes[4] = {0x60EA27EEADC0B5D6ull, 0xC2B2AE3D27D4EB4Full, 0, 0x61C8864E7A143579ull};
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, data + offset + 8 * lane, sizeof(word));
+            lanes[lane] = digest_round(lanes[lane], word);
+        }
+    }
+    // The zero-padded tail is told apart from real zeros by the size, which the key also holds
+    uint64_t tail[4] = {0, 0, 0, 0};
+    std::memcpy(tail, data + offset, size - offset);
+    for (int lane = 0; lane < 4; ++lane) {
+        lanes[lane] = digest_round(lanes[lane], tail[lane]);
+    }
+
+    uint64_t halves[2] = {
+        digest_mix(lanes[0] ^ rotate_left(lanes[1], 7) ^ rotate_left(lanes[2], 12) ^ rotate_left(lanes[3], 18) ^ size),
+        digest_mix(lanes[3] ^ rotate_left(lanes[2], 23) ^ rotate_left(lanes[1], 29) ^ rotate_left(lanes[0], 37) ^
+                   (size * 0x9E3779B185EBCA87ull)),
+    };
+    key.append(reinterpret_cast<const char*>(halves), sizeof(halves));
+}
+
+/**
+ * @brief Appends the bytes of one option field to a result cache key.
+ */
+template <typename T>
+static void append_field(std::string& key, T value) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "key fields must be scalars");
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief Appends the HEIF/AVIF encoder options to a result cache key.
+ */
+static void append_heif_fields(std::string& key, const ImageEncodeHEIFOptions& options) {
+    append_field(key, options.quality);
+    append_field(key, options.lossless);
+    append_field(key, options.effort);
+    append_field(key, options.subsample);
+    append_field(key, options.strip);
+}
+
+/**
+ * @brief Builds the result cache key of a process_cached() call.
+ *
+ * Fields are appended one at a time, so struct padding and the options of other
+ * op types and formats never reach the key and cannot split identical requests.
+ *
+ * @return false if the result cannot be cached: the pipeline has a plain watermark
+ *         step, whose overlay pixels the key cannot capture, or a step that will fail.
+ */
+static bool result_cache_key(std::string& key, const unsigned char* data, size_t size, const ImageLoadOptions& load,
+                             const ImagePipelineOp* ops, size_t n, const ImageEncodeSpec& out) {
+    key.reserve(64 + n * 24);
+    append_digest(key, data, size);
+    append_field(key, static_cast<uint64_t>(size));
+
+    // `access` changes how the pixels are read, not which pixels come out
+    append_field(key, load.max_width);
+    append_field(key, load.max_height);
+    append_field(key, load.max_pixels);
+    append_field(key, load.max_bytes);
+    append_field(key, load.fail_on);
+    append_field(key, load.autorotate);
+    append_field(key, load.page);
+    append_field(key, load.n);
+
+    append_field(key, static_cast<uint64_t>(n));
+    for (size_t i = 0; i < n; ++i) {
+        const ImagePipelineOp& op = ops[i];
+        append_field(key, op.type);
+        switch (op.type) {
+            case PIPELINE_OP_RESIZE:
+                append_field(key, op.resize.maintain_aspect);
+                append_field(key, op.resize.width);
+                append_field(key, op.resize.height);
+                break;
+            case PIPELINE_OP_CROP:
+                append_field(key, op.crop.x);
+                append_field(key, op.crop.y);
+                append_field(key, op.crop.width);
+                append_field(key, op.crop.height);
+                break;
+            case PIPELINE_OP_ROTATE:
+                append_field(key, op.rotate.angle);
+                break;
+            case PIPELINE_OP_PREPARED_WATERMARK:
+                if (!op.prepared_watermark) {
+                    return false;
+                }
+                append_field(key, (*static_cast<const WatermarkRef*>(op.prepared_watermark))->serial);
+                append_field(key, op.placement.gravity);
+                append_field(key, op.placement.x);
+                append_field(key, op.placement.y);
+                append_field(key, op.placement.width_fraction);
+                break;
+            case PIPELINE_OP_OPACITY:
+                append_field(key, op.opacity.opacity);
+                break;
+            case PIPELINE_OP_ENSURE_SRGB8:
+                append_field(key, op.srgb.keep_profile);
+                append_field(key, op.srgb.intent);
+                break;
+            case PIPELINE_OP_FLIP:
+                append_field(key, op.flip.direction);
+                break;
+            case PIPELINE_OP_COVER:
+                append_field(key, op.cover.width);
+                append_field(key, op.cover.height);
+                append_field(key, op.cover.mode);
+                append_field(key, op.cover.gravity);
+                break;
+            default:
+                return false;
+        }
+    }
+
+    append_field(key, out.format);
+    switch (out.format) {
+        case IMAGE_FORMAT_PNG:
+            append_field(key, out.png.compression);
+            append_field(key, out.png.interlace);
+            break;
+        case IMAGE_FORMAT_WEBP:
+            append_field(key, out.webp.quality);
+            append_field(key, out.webp.lossless);
+            append_field(key, out.webp.effort);
+            append_field(key, out.webp.smart_subsample);
+            append_field(key, out.webp.strip);
+            break;
+        case IMAGE_FORMAT_AVIF:
+            append_heif_fields(key, out.avif);
+            break;
+        case IMAGE_FORMAT_HEIF:
+            append_heif_fields(key, out.heif);
+            break;
+        case IMAGE_FORMAT_JXL:
+            append_field(key, out.jxl.quality);
+            append_field(key, out.jxl.lossless);
+            append_field(key, out.jxl.effort);
+            append_field(key, out.jxl.strip);
+            break;
+        case IMAGE_FORMAT_GIF:
+            append_field(key, out.gif.effort);
+            append_field(key, out.gif.bitdepth);
+            break;
+        default: {
+            append_field(key, out.jpeg.quality);
+            append_field(key, out.jpeg.interlace);
+            // Legacy-layout options only set quality and interlace; the rest is ignored
+            bool extended = out.jpeg.version >= IMAGE_ENCODE_JPEG_OPTIONS_VERSION;
+            append_field(key, extended);
+            if (extended) {
+                append_field(key, out.jpeg.optimize_coding);
+                append_field(key, out.jpeg.trellis_quant);
+                append_field(key, out.jpeg.overshoot_deringing);
+                append_field(key, out.jpeg.optimize_scans);
+                append_field(key, out.jpeg.quant_table);
+                append_field(key, out.jpeg.subsample);
+                append_field(key, out.jpeg.strip);
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes, processes and encodes one process_cached() input into a shareable result.
+ * Never throws, so a render awaited by other calls always completes.
+ */
+static ImageStatus render_cached_result(const unsigned char* data, size_t size, const ImageLoadOptions& load,
+                                        const ImagePipelineOp* ops, size_t n, const ImageEncodeSpec& out,
+                                        CachedResultRef* result) {
+    ImageStatus status = SUCCESS;
+    // The caller's buffer is only valid during the call; misses are rare enough to afford the copy
+    VImageHandle handle = load_copied_bytes(data, size, load, &status);
+    if (!handle) {
+        return status;
+    }
+    ImageBuffer buffer{nullptr, 0};
+    status = run_pipeline(*static_cast<VImage*>(handle), ops, n, out, &buffer);
+    free_vimage_handle(handle);
+    if (status != SUCCESS) {
+        return status;
+    }
+
+    try {
+        *result = std::make_shared<const CachedResult>(buffer);
+        return SUCCESS;
+    } catch (const std::bad_alloc &e) {
+        free_image_buffer(buffer);
+        log_error("Memory allocation error during process_cached: ", e.what());
+        return fail(IMAGE_OP_RESULT_CACHE, MEMORY_ALLOCATION_FAILURE);
+    }
+}
+
+/**
+ * @brief Stores `result` as the most recently used entry of `shard`, then evicts down to `budget`.
+ * A result larger than the budget is not stored. Caller holds shard->mutex.
+ */
+static void result_cache_insert(ResultCacheShard* shard, const std::string& key, const CachedResultRef& result,
+                                uint64_t budget) {
+    if (result->size > budget) {
+        return;
+    }
+    shard->lru.push_front(key);
+    try {
+        shard->entries.emplace(key, ResultCacheEntry{result, shard->lru.begin()});
+    } catch (...) {
+        shard->lru.pop_front();
+        throw;
+    }
+    shard->bytes += result->size;
+    result_cache_counters.entries.fetch_add(1, std::memory_order_relaxed);
+    result_cache_counters.bytes.fetch_add(result->size, std::memory_order_relaxed);
+
+    // The new entry fits the budget on its own, so it is never its own victim
+    while (shard->bytes > budget) {
+        auto victim = shard->entries.find(shard->lru.back());
+        uint64_t bytes = victim->second.result->size;
+        shard->bytes -= bytes;
+        shard->entries.erase(victim);
+        shard->lru.pop_back();
+        ++shard->evictions;
+        result_cache_counters.entries.fetch_sub(1, std::memory_order_relaxed);
+        result_cache_counters.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        result_cache_counters.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Gives a process_cached() caller its own reference to `cached`.
+ */
+static void share_result(const CachedResultRef& cached, ImageCachedBuffer* result) {
+    result->ref = new CachedResultRef(cached);
+    result->data = cached->data;
+    result->size = cached->size;
+}
+
+// libvips 8.10 added the IIIF tile layout
+#if VIPS_MAJOR_VERSION > 8 || (VIPS_MAJOR_VERSION == 8 && VIPS_MINOR_VERSION >= 10)
+#define VIPS_WRAPPER_HAVE_IIIF 1
+#endif
+
+/**
+ * @brief Builds the dzsave "suffix" option: the tile saver's extension and its options.
+ * @return The suffix, or an empty string for formats tiles cannot be written in.
+ */
+static std::string tile_suffix(const ImageEncodeSpec& spec) {
+    char suffix[64];
+    switch (spec.format) {
+        case IMAGE_FORMAT_NONE:
+        case IMAGE_FORMAT_JPEG:
+            std::snprintf(suffix, sizeof(suffix), ".jpg[Q=%d]", option_in_range(spec.jpeg.quality, 1, 100, 75));
+            return suffix;
+        case IMAGE_FORMAT_PNG:
+            std::snprintf(suffix, sizeof(suffix), ".png[compression=%d]",
+                          option_in_range(spec.png.compression, 0, 9, 6));
+            return suffix;
+        case IMAGE_FORMAT_WEBP:
+            std::snprintf(suffix, sizeof(suffix), ".webp[Q=%d,lossless=%s,effort=%d]",
+                          option_in_range(spec.webp.quality, 1, 100, 75), spec.webp.lossless ? "true" : "false",
+                          option_in_range(spec.webp.effort, 0, 6, 4));
+            return suffix;
+        default:
+            return std::string();
+    }
+}
+
+/**
+ * @brief Maps an ImageTileLayout to the dzsave layout.
+ * @return false if the layout is unknown or not supported by this libvips.
+ */
+static bool tile_layout(ImageTileLayout layout, VipsForeignDzLayout* out) {
+    switch (layout) {
+        case IMAGE_TILE_LAYOUT_DZ: *out = VIPS_FOREIGN_DZ_LAYOUT_DZ; return true;
+        case IMAGE_TILE_LAYOUT_ZOOMIFY: *out = VIPS_FOREIGN_DZ_LAYOUT_ZOOMIFY; return true;
+        case IMAGE_TILE_LAYOUT_GOOGLE: *out = VIPS_FOREIGN_DZ_LAYOUT_GOOGLE; return true;
+#ifdef VIPS_WRAPPER_HAVE_IIIF
+        case IMAGE_TILE_LAYOUT_IIIF: *out = VIPS_FOREIGN_DZ_LAYOUT_IIIF; return true;
+#endif
+        default: return false;
+    }
+}
+
+/**
+ * @brief Interpretation for raw pixels of the given shape, so colour operations treat them as expected.
+ *
+ * @param bands Samples per pixel.
+ * @param format Sample type.
+ * @return Greyscale for 1-2 bands, sRGB for 3-4 (the 16-bit variants for ushort), multiband otherwise.
+ */
+static VipsInterpretation raw_interpretation(int bands, VipsBandFormat format) {
+    bool sixteen_bit = format == VIPS_FORMAT_USHORT;
+    if (bands <= 2) {
+        return sixteen_bit ? VIPS_INTERPRETATION_GREY16 : VIPS_INTERPRETATION_B_W;
+    }
+    if (bands <= 4) {
+        return sixteen_bit ? VIPS_INTERPRETATION_RGB16 : VIPS_INTERPRETATION_sRGB;
+    }
+    return VIPS_INTERPRETATION_MULTIBAND;
+}
+
+// Destination of write_to_memory(), shared with the sink callback
+struct TensorSink {
+    unsigned char* out;
+    size_t row_stride;
+    size_t plane_size;      // row_stride * height; 0 for interleaved output
+    size_t sample_size;
+    int bands;
+};
+
+/**
+ * @brief Scatters one row of interleaved samples into `bands` planes.
+ *
+ * @param in First sample of the row.
+ * @param width Pixels in the row.
+ * @param bands Samples per pixel.
+ * @param out Start of the row in the first plane.
+ * @param plane_size Bytes from one plane to the next.
+ */
+template <typename T>
+static void deinterleave_row(const T* in, int width, int bands, unsigned char* out, size_t plane_size) {
+    for (int b = 0; b < bands; ++b) {
+        T* plane = reinterpret_cast<T*>(out + b * plane_size);
+        const T* src = in + b;
+        for (int x = 0; x < width; ++x, src += bands) {
+            plane[x] = *src;
+        }
+    }
+}
+
+/**
+ * @brief vips_sink_disc() callback that copies a computed strip into the tensor.
+ *
+ * libvips calls it for each strip in top-to-bottom order, one at a time, while
+ * worker threads compute the following strips.
+ *
+ * @param region Computed pixels, already in the output sample type.
+ * @param area The strip within the image.
+ * @param a The TensorSink.
+ * @return 0; copying cannot fail.
+ */
+static int write_tensor_strip(VipsRegion* region, VipsRect* area, void* a) {
+    const TensorSink* sink = static_cast<const TensorSink*>(a);
+    size_t row_bytes = sink->sample_size * sink->bands * area->width;
+    for (int y = area->top; y < area->top + area->height; ++y) {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(VIPS_REGION_ADDR(region, area->left, y));
+        if (sink->plane_size == 0) {
+            std::memcpy(sink->out + y * sink->row_stride + area->left * sink->sample_size * sink->bands, in,
+                        row_bytes);
+            continue;
+        }
+        unsigned char* row = sink->out + y * sink->row_stride + area->left * sink->sample_size;
+        if (sink->sample_size == sizeof(float)) {
+            deinterleave_row(reinterpret_cast<const float*>(in), area->width, sink->bands, row, sink->plane_size);
+        } else {
+            deinterleave_row(in, area->width, sink->bands, row, sink->plane_size);
+        }
+    }
+    return 0;
+}
+
+// libvips has no getter for leak checking, so remember what was last requested
+static std::atomic<int> leak_check_state{RUNTIME_SWITCH_DEFAULT};
+
 extern "C" {
 
 /**
- * @brief Initializes the VIPS library. Must be called before any other VIPS operations.
- * @return SUCCESS on successful initialization, VIPS_INIT_FAILURE otherwise.
+ * @brief Initializes the VIPS library. Must be called before any other VIPS operations.
+ * @return SUCCESS on successful initialization, VIPS_INIT_FAILURE otherwise.
+ */
+int vips_wrapper_init() {
+    // Initialize VIPS with the program name
+    if (VIPS_INIT("vips_wrapper")) {
+        // Log VIPS error and exit if initialization fails
+        vips_error_exit(nullptr);
+        return VIPS_INIT_FAILURE;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Initializes the VIPS library and applies the given runtime settings.
+ * @param config Runtime settings; null or zero fields keep libvips defaults.
+ * @return SUCCESS on successful initialization, VIPS_INIT_FAILURE otherwise.
+ */
+int vips_wrapper_init_ex(const RuntimeConfig* config) {
+    int status = vips_wrapper_init();
+    if (status != SUCCESS || !config) {
+        return status;
+    }
+
+    if (config->concurrency > 0) {
+        vips_wrapper_set_concurrency(config->concurrency);
+    }
+    if (config->cache_disable) {
+        vips_wrapper_set_cache_max(0);
+        vips_wrapper_set_cache_max_mem(0);
+        vips_wrapper_set_cache_max_files(0);
+    } else {
+        if (config->cache_max > 0) vips_wrapper_set_cache_max(config->cache_max);
+        if (config->cache_max_mem > 0) vips_wrapper_set_cache_max_mem(config->cache_max_mem);
+        if (config->cache_max_files > 0) vips_wrapper_set_cache_max_files(config->cache_max_files);
+    }
+    if (config->vector != RUNTIME_SWITCH_DEFAULT) {
+        vips_wrapper_set_vector_enabled(config->vector == RUNTIME_SWITCH_ON);
+    }
+    if (config->leak_check != RUNTIME_SWITCH_DEFAULT) {
+        vips_wrapper_set_leak_check(config->leak_check == RUNTIME_SWITCH_ON);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Sets the number of worker threads used by each subsequently started pipeline.
+ * @param concurrency Threads per pipeline; 0 restores the libvips default.
+ */
+void vips_wrapper_set_concurrency(int concurrency) {
+    vips_concurrency_set(std::max(concurrency, 0));
+}
+
+/**
+ * @brief Sets the operation cache size limit, trimming the cache if needed.
+ * @param max Maximum number of cached operations.
+ */
+void vips_wrapper_set_cache_max(int max) {
+    vips_cache_set_max(std::max(max, 0));
+}
+
+/**
+ * @brief Sets the operation cache memory limit, trimming the cache if needed.
+ * @param max_mem Maximum cache memory in bytes.
+ */
+void vips_wrapper_set_cache_max_mem(size_t max_mem) {
+    vips_cache_set_max_mem(max_mem);
+}
+
+/**
+ * @brief Sets the operation cache open-file limit, trimming the cache if needed.
+ * @param max_files Maximum number of open files.
+ */
+void vips_wrapper_set_cache_max_files(int max_files) {
+    vips_cache_set_max_files(std::max(max_files, 0));
+}
+
+/**
+ * @brief Enables or disables libvips' vectorised code paths.
+ * @param enabled Non-zero to enable.
+ */
+void vips_wrapper_set_vector_enabled(int enabled) {
+    vips_vector_set_enabled(enabled ? TRUE : FALSE);
+}
+
+/**
+ * @brief Enables or disables libvips' reference leak reporting.
+ * @param enabled Non-zero to enable.
+ */
+void vips_wrapper_set_leak_check(int enabled) {
+    vips_leak_set(enabled ? TRUE : FALSE);
+    leak_check_state.store(enabled ? RUNTIME_SWITCH_ON : RUNTIME_SWITCH_OFF);
+}
+
+/**
+ * @brief Reports the runtime settings currently in effect.
+ * @param config Output settings.
+ */
+void vips_wrapper_get_runtime_config(RuntimeConfig* config) {
+    if (!config) {
+        return;
+    }
+    config->concurrency = vips_concurrency_get();
+    config->cache_max = vips_cache_get_max();
+    config->cache_max_mem = vips_cache_get_max_mem();
+    config->cache_max_files = vips_cache_get_max_files();
+    config->cache_disable = config->cache_max == 0 || config->cache_max_mem == 0;
+    config->vector = vips_vector_isenabled() ? RUNTIME_SWITCH_ON : RUNTIME_SWITCH_OFF;
+    config->leak_check = static_cast<RuntimeSwitch>(leak_check_state.load());
+}
+
+/**
+ * @brief Copies the operation counters and libvips' memory/cache state into `stats`.
+ * @param stats Output snapshot.
+ */
+void vips_wrapper_get_stats(ImageStats* stats) {
+    if (!stats) {
+        return;
+    }
+    for (int op = 0; op < IMAGE_OP_COUNT; ++op) {
+        const OperationCounters& counters = operation_counters[op];
+        ImageOperationStats& out = stats->ops[op];
+        out.calls = counters.calls.load(std::memory_order_relaxed);
+        out.errors = counters.errors.load(std::memory_order_relaxed);
+        out.bytes_in = counters.bytes_in.load(std::memory_order_relaxed);
+        out.bytes_out = counters.bytes_out.load(std::memory_order_relaxed);
+        out.latency_ns_sum = counters.latency_ns_sum.load(std::memory_order_relaxed);
+        for (int b = 0; b < IMAGE_LATENCY_BUCKETS; ++b) {
+            out.latency_buckets[b] = counters.latency_buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+    stats->vips_mem = vips_tracked_get_mem();
+    stats->vips_mem_highwater = vips_tracked_get_mem_highwater();
+    stats->vips_allocs = vips_tracked_get_allocs();
+    stats->vips_files = vips_tracked_get_files();
+    stats->cache_size = vips_cache_get_size();
+    stats->cache_max = vips_cache_get_max();
+    stats->result_cache_hits = result_cache_counters.hits.load(std::memory_order_relaxed);
+    stats->result_cache_misses = result_cache_counters.misses.load(std::memory_order_relaxed);
+    stats->result_cache_coalesced = result_cache_counters.coalesced.load(std::memory_order_relaxed);
+    stats->result_cache_evictions = result_cache_counters.evictions.load(std::memory_order_relaxed);
+    stats->result_cache_entries = result_cache_counters.entries.load(std::memory_order_relaxed);
+    stats->result_cache_bytes = result_cache_counters.bytes.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Resets every operation counter and the result cache totals to zero.
+ */
+void vips_wrapper_reset_stats() {
+    for (auto& counters : operation_counters) {
+        counters.calls = 0;
+        counters.errors = 0;
+        counters.bytes_in = 0;
+        counters.bytes_out = 0;
+        counters.latency_ns_sum = 0;
+        for (auto& bucket : counters.latency_buckets) {
+            bucket = 0;
+        }
+    }
+    // Occupancy is a gauge and survives the reset
+    result_cache_counters.hits = 0;
+    result_cache_counters.misses = 0;
+    result_cache_counters.coalesced = 0;
+    result_cache_counters.evictions = 0;
+}
+
+/**
+ * @brief Returns the upper bound of latency bucket `bucket` in nanoseconds.
+ */
+uint64_t vips_wrapper_latency_bucket_bound_ns(int bucket) {
+    if (bucket < 0) {
+        return 0;
+    }
+    if (bucket >= IMAGE_LATENCY_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+    return LATENCY_BUCKET_BASE_NS << bucket;
+}
+
+/**
+ * @brief Returns the metric name of an operation group.
+ */
+const char* vips_wrapper_operation_name(ImageOperation op) {
+    switch (op) {
+        case IMAGE_OP_LOAD: return "load";
+        case IMAGE_OP_THUMBNAIL: return "thumbnail";
+        case IMAGE_OP_RESIZE: return "resize";
+        case IMAGE_OP_CROP: return "crop";
+        case IMAGE_OP_ROTATE: return "rotate";
+        case IMAGE_OP_WATERMARK: return "watermark";
+        case IMAGE_OP_OPACITY: return "opacity";
+        case IMAGE_OP_ENCODE: return "encode";
+        case IMAGE_OP_PIPELINE: return "pipeline";
+        case IMAGE_OP_PROBE: return "probe";
+        case IMAGE_OP_RENDITIONS: return "renditions";
+        case IMAGE_OP_COLOUR: return "colour";
+        case IMAGE_OP_RAW_CACHE: return "raw_cache";
+        case IMAGE_OP_RESULT_CACHE: return "result_cache";
+        case IMAGE_OP_TILES: return "tiles";
+        case IMAGE_OP_TENSOR: return "tensor";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Installs the handler that receives diagnostic messages (null discards them).
+ * @param handler Message handler, or nullptr.
+ * @param user_data Passed through to the handler.
+ */
+void vips_wrapper_set_log_handler(ImageLogFn handler, void* user_data) {
+    log_sink.store(new LogSink{handler, user_data}, std::memory_order_release);
+}
+
+/**
+ * @brief Default log handler writing one line per message to stderr.
+ */
+void vips_wrapper_log_to_stderr(ImageLogLevel level, const char* message, void* user_data) {
+    std::fprintf(stderr, "%s%s\n", level == IMAGE_LOG_WARNING ? "Warning: " : "", message);
+}
+
+/**
+ * @brief Returns the calling thread's record of its most recent failure.
+ */
+const ImageError* vips_wrapper_last_error() {
+    return &last_error;
+}
+
+/**
+ * @brief Resets the calling thread's error record.
+ */
+void vips_wrapper_clear_error() {
+    last_error.code = SUCCESS;
+    last_error.operation = IMAGE_OP_LOAD;
+    last_error.message[0] = '\0';
+}
+
+/**
+ * @brief Cleans up VIPS resources. Should be called when image processing is complete.
+ */
+void vips_wrapper_cleanup() {
+    vips_shutdown();
+}
+
+/**
+ * @brief Loads an image from a file and returns a VImage handle.
+ *
+ * @param input_path The path to the image file to load.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle load_image(const char* input_path) {
+    return load_image_with_options(input_path, ImageLoadOptions{IMAGE_ACCESS_RANDOM}, nullptr);
+}
+
+/**
+ * @brief Loads an image from a file with explicit loader options and returns a VImage handle.
+ *
+ * @param input_path The path to the image file to load.
+ * @param options Loader options (access mode, limits, strictness).
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ * @throws std::runtime_error On failure to load the image or other unexpected errors.
+ */
+VImageHandle load_image_with_options(const char* input_path, ImageLoadOptions options, ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_LOAD, 0, status);
+    if (!input_path || std::strlen(input_path) == 0) {
+        log_error("Error: Input path for image loading is null or empty.");
+        return timer.fail(IMAGE_INVALID_PATH, nullptr);
+    }
+
+    if (options.max_bytes > 0) {
+        std::error_code size_error;
+        uintmax_t file_size = std::filesystem::file_size(input_path, size_error);
+        if (!size_error && check_input_size(file_size, options) != SUCCESS) {
+            return timer.fail(IMAGE_TOO_LARGE, nullptr);
+        }
+    }
+
+    // Sniffing the format costs an extra open, so it is only done when pages are requested
+    const char* loader = requests_pages(options) ? vips_foreign_find_load(input_path) : nullptr;
+    if (check_single_page(loader, options) != SUCCESS) {
+        return timer.fail(IMAGE_INVALID_BOUNDS, nullptr);
+    }
+
+    try {
+        // Create a new VImage instance from the file; only the header is read here
+        VImage loaded = VImage::new_from_file(input_path, load_option(options, loader));
+        if (check_load_limits(loaded, options) != SUCCESS) {
+            return timer.fail(IMAGE_TOO_LARGE, nullptr);
+        }
+        VImage upright = is_mapped_file(loaded) ? clear_access_tag(loaded) : tag_access(loaded, options.access);
+        if (options.autorotate) {
+            apply_autorotate(upright);
+        }
+        VImage* img = new VImage(upright);
+        return timer.succeed(static_cast<VImageHandle>(img));
+    } catch (const VError &e) {
+        log_error("VIPS Error during image loading: ", e.what());
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during image loading: ", e.what());
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, nullptr);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during image loading: ", e.what());
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    } catch (...) {
+        log_error("Unknown error occurred while loading image.");
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    }
+}
+
+/**
+ * @brief Loads an image from a byte buffer and returns a VImage handle.
+ *
+ * @param data Pointer to the image data bytes.
+ * @param size Size of the image data in bytes.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle load_image_from_bytes(const unsigned char* data, size_t size) {
+    return load_image_from_bytes_with_options(data, size, ImageLoadOptions{IMAGE_ACCESS_RANDOM}, nullptr);
+}
+
+/**
+ * @brief Loads an image from a byte buffer with explicit loader options and returns a VImage handle.
+ *
+ * @param data Pointer to the image data bytes.
+ * @param size Size of the image data in bytes.
+ * @param options Loader options (access mode, limits, strictness).
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle load_image_from_bytes_with_options(const unsigned char* data, size_t size, ImageLoadOptions options,
+                                                ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_LOAD, size, status);
+    if (!data || size == 0) {
+        log_error("Error: Image data is null or empty.");
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    }
+    if (check_input_size(size, options) != SUCCESS) {
+        return timer.fail(IMAGE_TOO_LARGE, nullptr);
+    }
+    const char* loader = requests_pages(options) ? vips_foreign_find_load_buffer(data, size) : nullptr;
+    if (check_single_page(loader, options) != SUCCESS) {
+        return timer.fail(IMAGE_INVALID_BOUNDS, nullptr);
+    }
+
+    try {
+        // Create a new VImage instance from the byte buffer; only the header is read here
+        VImage loaded = VImage::new_from_buffer(data, size, "", load_option(options, loader));
+        if (check_load_limits(loaded, options) != SUCCESS) {
+            return timer.fail(IMAGE_TOO_LARGE, nullptr);
+        }
+        VImage upright = tag_access(loaded, options.access);
+        if (options.autorotate) {
+            apply_autorotate(upright);
+        }
+        VImage* img = new VImage(upright);
+        return timer.succeed(static_cast<VImageHandle>(img));
+    } catch (const VError &e) {
+        log_error("VIPS Error during image loading from bytes: ", e.what());
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during image loading from bytes: ", e.what());
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, nullptr);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during image loading from bytes: ", e.what());
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    } catch (...) {
+        log_error("Unknown error occurred while loading image from bytes.");
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    }
+}
+
+/**
+ * @brief Loads an image from a byte buffer without copying it, taking ownership of the buffer.
+ *
+ * The release callback is invoked exactly once: when libvips closes the last image that
+ * reads from the buffer, or before returning if loading fails.
+ *
+ * @param data Pointer to the image data bytes.
+ * @param size Size of the image data in bytes.
+ * @param options Loader options (access mode, limits, strictness).
+ * @param release Callback that returns the buffer to its owner (must not be null).
+ * @param user_data Opaque pointer passed through to the release callback.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle load_image_from_owned_bytes(const unsigned char* data, size_t size, ImageLoadOptions options,
+                                         ImageBufferReleaseFn release, void* user_data, ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_LOAD, size, status);
+    if (!release) {
+        log_error("Error: Release callback for owned image data is null.");
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    }
+    if (!data || size == 0) {
+        log_error("Error: Image data is null or empty.");
+        release(const_cast<unsigned char*>(data), user_data);
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    }
+    if (check_input_size(size, options) != SUCCESS) {
+        release(const_cast<unsigned char*>(data), user_data);
+        return timer.fail(IMAGE_TOO_LARGE, nullptr);
+    }
+    const char* loader = requests_pages(options) ? vips_foreign_find_load_buffer(data, size) : nullptr;
+    if (check_single_page(loader, options) != SUCCESS) {
+        release(const_cast<unsigned char*>(data), user_data);
+        return timer.fail(IMAGE_INVALID_BOUNDS, nullptr);
+    }
+
+    OwnedBuffer* owned = nullptr;
+    try {
+        owned = new OwnedBuffer{data, release, user_data};
+        VImage loaded = VImage::new_from_buffer(data, size, "", load_option(options, loader));
+
+        // From here on libvips decides when the buffer is released
+        g_signal_connect(loaded.get_image(), "postclose", G_CALLBACK(release_owned_buffer), owned);
+        owned = nullptr;
+
+        // Checked after the hand-over: the operation cache may keep the header image alive
+        if (check_load_limits(loaded, options) != SUCCESS) {
+            return timer.fail(IMAGE_TOO_LARGE, nullptr);
+        }
+
+        VImage upright = tag_access(loaded, options.access);
+        if (options.autorotate) {
+            apply_autorotate(upright);
+        }
+        VImage* img = new VImage(upright);
+        return timer.succeed(static_cast<VImageHandle>(img));
+    } catch (const VError &e) {
+        log_error("VIPS Error during image loading from owned bytes: ", e.what());
+        timer.fail(IMAGE_LOAD_FAILURE);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during image loading from owned bytes: ", e.what());
+        timer.fail(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during image loading from owned bytes: ", e.what());
+        timer.fail(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred while loading image from owned bytes.");
+        timer.fail(UNKNOWN_ERROR);
+    }
+
+    // Ownership was transferred on entry; release now unless libvips already holds the buffer
+    if (owned) {
+        delete owned;
+        release(const_cast<unsigned char*>(data), user_data);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Loads and resizes an image from a file in a single shrink-on-load step.
+ *
+ * The target size is passed down to the loader (JPEG DCT shrink, WebP/HEIF scale-on-load,
+ * PDF/SVG render scale) so only the pixels needed for the output are ever decoded.
+ *
+ * @param input_path The path to the image file to load.
+ * @param options The resize options including dimensions and aspect ratio maintenance.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle thumbnail_from_path(const char* input_path, ImageResizeOptions options, ImageStatus* status) {
+    return thumbnail_from_path_with_options(input_path, options, ImageLoadOptions{}, status);
+}
+
+/**
+ * @brief Loads and resizes an image from a file in a single shrink-on-load step, honouring
+ *        the loader limits, strictness and autorotation.
+ *
+ * @param input_path The path to the image file to load.
+ * @param options The resize options including dimensions and aspect ratio maintenance.
+ * @param load Loader options; the access mode is ignored.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle thumbnail_from_path_with_options(const char* input_path, ImageResizeOptions options,
+                                              ImageLoadOptions load, ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_THUMBNAIL, 0, status);
+    if (!input_path || std::strlen(input_path) == 0) {
+        log_error("Error: Input path for thumbnail is null or empty.");
+        return timer.fail(IMAGE_INVALID_PATH, nullptr);
+    }
+    if (options.width <= 0 && options.height <= 0) {
+        log_error("Error: Invalid dimensions provided for thumbnail (width and/or height must be positive).");
+        return timer.fail(IMAGE_INVALID_DIMENSIONS, nullptr);
+    }
+
+    if (load.max_bytes > 0) {
+        std::error_code size_error;
+        uintmax_t file_size = std::filesystem::file_size(input_path, size_error);
+        if (!size_error && check_input_size(file_size, load) != SUCCESS) {
+            return timer.fail(IMAGE_TOO_LARGE, nullptr);
+        }
+    }
+
+    try {
+        if (has_dimension_limits(load)) {
+            // The limits refer to the source, which the thumbnail result no longer describes
+            VImage header = VImage::new_from_file(input_path, load_option(load));
+            if (check_load_limits(header, load) != SUCCESS) {
+                return timer.fail(IMAGE_TOO_LARGE, nullptr);
+            }
+        }
+
+        VOption* option = VImage::option();
+        int width = thumbnail_options(options, option, load.autorotate != 0);
+        set_thumbnail_fail_on(option, load.fail_on);
+
+        VImage* img = new VImage(VImage::thumbnail(input_path, width, option));
+        return timer.succeed(static_cast<VImageHandle>(img));
+    } catch (const VError &e) {
+        log_error("VIPS Error during thumbnail_from_path: ", e.what());
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during thumbnail_from_path: ", e.what());
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, nullptr);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during thumbnail_from_path: ", e.what());
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    } catch (...) {
+        log_error("Unknown error occurred during thumbnail_from_path.");
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    }
+}
+
+/**
+ * @brief Loads and resizes an image from a byte buffer in a single shrink-on-load step.
+ *
+ * The bytes are copied into a VipsBlob owned by the returned image, so the caller's buffer
+ * may be released as soon as this function returns.
+ *
+ * @param data Pointer to the image data bytes.
+ * @param size Size of the image data in bytes.
+ * @param options The resize options including dimensions and aspect ratio maintenance.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle thumbnail_from_buffer(const unsigned char* data, size_t size, ImageResizeOptions options,
+                                   ImageStatus* status) {
+    return thumbnail_from_buffer_with_options(data, size, options, ImageLoadOptions{}, status);
+}
+
+/**
+ * @brief Loads and resizes an image from a byte buffer in a single shrink-on-load step,
+ *        honouring the loader limits, strictness and autorotation.
+ *
+ * @param data Pointer to the image data bytes.
+ * @param size Size of the image data in bytes.
+ * @param options The resize options including dimensions and aspect ratio maintenance.
+ * @param load Loader options; the access mode is ignored.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle thumbnail_from_buffer_with_options(const unsigned char* data, size_t size, ImageResizeOptions options,
+                                                ImageLoadOptions load, ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_THUMBNAIL, size, status);
+    if (!data || size == 0) {
+        log_error("Error: Image data for thumbnail is null or empty.");
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    }
+    if (options.width <= 0 && options.height <= 0) {
+        log_error("Error: Invalid dimensions provided for thumbnail (width and/or height must be positive).");
+        return timer.fail(IMAGE_INVALID_DIMENSIONS, nullptr);
+    }
+    if (check_input_size(size, load) != SUCCESS) {
+        return timer.fail(IMAGE_TOO_LARGE, nullptr);
+    }
+
+    try {
+        if (has_dimension_limits(load)) {
+            // The limits refer to the source, which the thumbnail result no longer describes
+            VImage header = VImage::new_from_buffer(data, size, "", load_option(load));
+            if (check_load_limits(header, load) != SUCCESS) {
+                return timer.fail(IMAGE_TOO_LARGE, nullptr);
+            }
+        }
+
+        VipsBlobPtr blob(vips_blob_copy(data, size));
+        VOption* option = VImage::option();
+        int width = thumbnail_options(options, option, load.autorotate != 0);
+        set_thumbnail_fail_on(option, load.fail_on);
+
+        VImage* img = new VImage(VImage::thumbnail_buffer(blob.get(), width, option));
+        return timer.succeed(static_cast<VImageHandle>(img));
+    } catch (const VError &e) {
+        log_error("VIPS Error during thumbnail_from_buffer: ", e.what());
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during thumbnail_from_buffer: ", e.what());
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, nullptr);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during thumbnail_from_buffer: ", e.what());
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    } catch (...) {
+        log_error("Unknown error occurred during thumbnail_from_buffer.");
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    }
+}
+
+/**
+ * @brief Loads a cover-fit thumbnail from a file: shrink-on-load to the covering size,
+ *        then crop to exactly the requested box.
+ *
+ * @param input_path The path to the image file to load.
+ * @param options The output size and crop mode.
+ * @param load Loader options; the access mode is ignored.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle thumbnail_cover_from_path(const char* input_path, ImageCoverOptions options, ImageLoadOptions load,
+                                       ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_THUMBNAIL, 0, status);
+    if (!input_path || std::strlen(input_path) == 0) {
+        log_error("Error: Input path for cover thumbnail is null or empty.");
+        return timer.fail(IMAGE_INVALID_PATH, nullptr);
+    }
+    if (options.width <= 0 || options.height <= 0) {
+        log_error("Error: Invalid dimensions provided for cover thumbnail (width and height must be positive).");
+        return timer.fail(IMAGE_INVALID_DIMENSIONS, nullptr);
+    }
+
+    if (load.max_bytes > 0) {
+        std::error_code size_error;
+        uintmax_t file_size = std::filesystem::file_size(input_path, size_error);
+        if (!size_error && check_input_size(file_size, load) != SUCCESS) {
+            return timer.fail(IMAGE_TOO_LARGE, nullptr);
+        }
+    }
+
+    try {
+        int width = 0, height = 0;
+        if (options.mode == IMAGE_CROP_GRAVITY || has_dimension_limits(load)) {
+            VImage header = VImage::new_from_file(input_path, load_option(load));
+            if (check_load_limits(header, load) != SUCCESS) {
+                return timer.fail(IMAGE_TOO_LARGE, nullptr);
+            }
+            upright_size(header, load.autorotate != 0, &width, &height);
+        }
+
+        VOption* option = VImage::option();
+        int target = cover_thumbnail_options(options, width, height, load.autorotate != 0, option);
+        set_thumbnail_fail_on(option, load.fail_on);
+
+        VImage* img = new VImage(VImage::thumbnail(input_path, target, option));
+        return timer.succeed(static_cast<VImageHandle>(img));
+    } catch (const VError &e) {
+        log_error("VIPS Error during thumbnail_cover_from_path: ", e.what());
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during thumbnail_cover_from_path: ", e.what());
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, nullptr);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during thumbnail_cover_from_path: ", e.what());
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    } catch (...) {
+        log_error("Unknown error occurred during thumbnail_cover_from_path.");
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    }
+}
+
+/**
+ * @brief Loads a cover-fit thumbnail from a byte buffer.
+ *
+ * The bytes are copied into a VipsBlob owned by the returned image, so the caller's buffer
+ * may be released as soon as this function returns.
+ *
+ * @param data Pointer to the image data bytes.
+ * @param size Size of the image data in bytes.
+ * @param options The output size and crop mode.
+ * @param load Loader options; the access mode is ignored.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
+ */
+VImageHandle thumbnail_cover_from_buffer(const unsigned char* data, size_t size, ImageCoverOptions options,
+                                         ImageLoadOptions load, ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_THUMBNAIL, size, status);
+    if (!data || size == 0) {
+        log_error("Error: Image data for cover thumbnail is null or empty.");
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    }
+    if (options.width <= 0 || options.height <= 0) {
+        log_error("Error: Invalid dimensions provided for cover thumbnail (width and height must be positive).");
+        return timer.fail(IMAGE_INVALID_DIMENSIONS, nullptr);
+    }
+    if (check_input_size(size, load) != SUCCESS) {
+        return timer.fail(IMAGE_TOO_LARGE, nullptr);
+    }
+
+    try {
+        int width = 0, height = 0;
+        if (options.mode == IMAGE_CROP_GRAVITY || has_dimension_limits(load)) {
+            VImage header = VImage::new_from_buffer(data, size, "", load_option(load));
+            if (check_load_limits(header, load) != SUCCESS) {
+                return timer.fail(IMAGE_TOO_LARGE, nullptr);
+            }
+            upright_size(header, load.autorotate != 0, &width, &height);
+        }
+
+        VipsBlobPtr blob(vips_blob_copy(data, size));
+        VOption* option = VImage::option();
+        int target = cover_thumbnail_options(options, width, height, load.autorotate != 0, option);
+        set_thumbnail_fail_on(option, load.fail_on);
+
+        VImage* img = new VImage(VImage::thumbnail_buffer(blob.get(), target, option));
+        return timer.succeed(static_cast<VImageHandle>(img));
+    } catch (const VError &e) {
+        log_error("VIPS Error during thumbnail_cover_from_buffer: ", e.what());
+        return timer.fail(IMAGE_LOAD_FAILURE, nullptr);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during thumbnail_cover_from_buffer: ", e.what());
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, nullptr);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during thumbnail_cover_from_buffer: ", e.what());
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    } catch (...) {
+        log_error("Unknown error occurred during thumbnail_cover_from_buffer.");
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    }
+}
+
+/**
+ * @brief Frees the memory associated with a VImageHandle.
+ * @param handle The VImageHandle to free.
+ */
+void free_vimage_handle(VImageHandle handle) {
+    if (handle) {
+        VImagePtr img_ptr(static_cast<VImage*>(handle)); // Use smart pointer for deletion
+        // img_ptr will be deleted automatically when it goes out of scope
+    }
+}
+
+/**
+ * @brief Creates a second handle to the image of `handle`.
+ * The handles share the operation graph and decoded pixels but are otherwise independent.
+ *
+ * @param handle The VImageHandle to clone.
+ * @return A new VImageHandle, or NULL on failure.
+ */
+VImageHandle clone_vimage_handle(VImageHandle handle) {
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for clone_vimage_handle.");
+        fail(IMAGE_OP_LOAD, VIPS_INVALID_HANDLE);
+        return nullptr;
+    }
+    try {
+        return new VImage(*static_cast<const VImage*>(handle));
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during clone_vimage_handle: ", e.what());
+        fail(IMAGE_OP_LOAD, MEMORY_ALLOCATION_FAILURE);
+        return nullptr;
+    }
+}
+
+/**
+ * @brief Frees the data pointer within an ImageBuffer.
+ * This should be used to free buffers returned by encode_to_jpeg/png.
+ * @param buffer The ImageBuffer whose data pointer needs to be freed.
+ */
+void free_image_buffer(ImageBuffer buffer) {
+    if (buffer.data) {
+        g_free(buffer.data);
+        buffer.data = nullptr; // Clear pointer after freeing
+        buffer.size = 0;
+    }
+}
+
+/**
+ * @brief Resizes an image according to the specified options.
+ * This function modifies the VImage associated with the handle in-place.
+ *
+ * @param handle The VImageHandle to be resized.
+ * @param options The resize options including dimensions and aspect ratio maintenance.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus resize_image(VImageHandle handle, ImageResizeOptions options) {
+    OperationTimer timer(IMAGE_OP_RESIZE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for resize operation.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_resize(*static_cast<VImage*>(handle), options));
+    } catch (const VError &e) {
+        log_error("VIPS Error during resize_image: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during resize_image: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during resize_image: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during resize_image.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Crops an image to the specified rectangle.
+ * This function modifies the VImage associated with the handle in-place.
+ *
+ * @param handle The VImageHandle to be cropped.
+ * @param options The crop options including x and y coordinates, width and height.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus crop_image(VImageHandle handle, ImageCropOptions options) {
+    OperationTimer timer(IMAGE_OP_CROP);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for crop operation.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_crop(*static_cast<VImage*>(handle), options));
+    } catch (const VError &e) {
+        log_error("VIPS Error during crop_image: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during crop_image: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during crop_image: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during crop_image.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Resizes an image to cover a box and crops it to exactly that box.
+ * This function modifies the VImage associated with the handle in-place.
+ *
+ * @param handle The VImageHandle to be resized.
+ * @param options The output size and crop mode.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus cover_image(VImageHandle handle, ImageCoverOptions options) {
+    OperationTimer timer(IMAGE_OP_RESIZE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for cover operation.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_cover(*static_cast<VImage*>(handle), options));
+    } catch (const VError &e) {
+        log_error("VIPS Error during cover_image: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during cover_image: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during cover_image: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during cover_image.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Rotates an image by the specified angle in degrees.
+ * This function modifies the VImage associated with the handle in-place.
+ *
+ * @param handle The VImageHandle to be rotated.
+ * @param options The rotation options including the angle.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus rotate_image(VImageHandle handle, ImageRotateOptions options) {
+    OperationTimer timer(IMAGE_OP_ROTATE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for rotate operation.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_rotate(*static_cast<VImage*>(handle), options));
+    } catch (const VError &e) {
+        log_error("VIPS Error during rotate_image: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during rotate_image: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during rotate_image: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during rotate_image.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Resizes `src` into a new handle, leaving `src` unchanged.
+ *
+ * @param src The VImageHandle to read.
+ * @param dst Receives the new VImageHandle on success, NULL otherwise.
+ * @param options The resize options, as for resize_image().
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus resize_image_to(VImageHandle src, VImageHandle* dst, ImageResizeOptions options) {
+    OperationTimer timer(IMAGE_OP_RESIZE);
+    if (!dst) {
+        log_error("Error: Output handle pointer for resize_image_to is null.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+    *dst = nullptr;
+    if (!src) {
+        log_error("Error: Invalid VImage handle for resize_image_to.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(derive_image(src, dst, [&](VImage& img) { return apply_resize(img, options); }));
+    } catch (const VError &e) {
+        log_error("VIPS Error during resize_image_to: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during resize_image_to: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during resize_image_to: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during resize_image_to.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Crops `src` into a new handle, leaving `src` unchanged.
+ *
+ * @param src The VImageHandle to read.
+ * @param dst Receives the new VImageHandle on success, NULL otherwise.
+ * @param options The crop options, as for crop_image().
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus crop_image_to(VImageHandle src, VImageHandle* dst, ImageCropOptions options) {
+    OperationTimer timer(IMAGE_OP_CROP);
+    if (!dst) {
+        log_error("Error: Output handle pointer for crop_image_to is null.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+    *dst = nullptr;
+    if (!src) {
+        log_error("Error: Invalid VImage handle for crop_image_to.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(derive_image(src, dst, [&](VImage& img) { return apply_crop(img, options); }));
+    } catch (const VError &e) {
+        log_error("VIPS Error during crop_image_to: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during crop_image_to: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during crop_image_to: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during crop_image_to.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Rotates `src` into a new handle, leaving `src` unchanged.
+ *
+ * @param src The VImageHandle to read.
+ * @param dst Receives the new VImageHandle on success, NULL otherwise.
+ * @param options The rotation options, as for rotate_image().
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus rotate_image_to(VImageHandle src, VImageHandle* dst, ImageRotateOptions options) {
+    OperationTimer timer(IMAGE_OP_ROTATE);
+    if (!dst) {
+        log_error("Error: Output handle pointer for rotate_image_to is null.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+    *dst = nullptr;
+    if (!src) {
+        log_error("Error: Invalid VImage handle for rotate_image_to.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(derive_image(src, dst, [&](VImage& img) { return apply_rotate(img, options); }));
+    } catch (const VError &e) {
+        log_error("VIPS Error during rotate_image_to: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during rotate_image_to: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during rotate_image_to: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during rotate_image_to.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Mirrors an image horizontally or vertically.
+ * This function modifies the VImage associated with the handle in-place.
+ *
+ * @param handle The VImageHandle to be flipped.
+ * @param options The flip options including the mirror axis.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus flip_image(VImageHandle handle, ImageFlipOptions options) {
+    OperationTimer timer(IMAGE_OP_ROTATE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for flip operation.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_flip(*static_cast<VImage*>(handle), options));
+    } catch (const VError &e) {
+        log_error("VIPS Error during flip_image: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during flip_image: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during flip_image: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during flip_image.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Applies a watermark image to a base image.
+ * This function modifies the base VImage associated with the handle in-place.
+ *
+ * @param base_handle The VImageHandle of the base image.
+ * @param watermark_handle The VImageHandle of the watermark image.
+ * @param options Watermark options including position and opacity.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus watermark_image(VImageHandle base_handle, VImageHandle watermark_handle, ImageWatermarkOptions options) {
+    OperationTimer timer(IMAGE_OP_WATERMARK);
+    if (!base_handle || !watermark_handle) {
+        log_error("Error: Invalid VImage handle(s) for watermark operation.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_watermark(*static_cast<VImage*>(base_handle), *static_cast<VImage*>(watermark_handle), options));
+    } catch (const VError &e) {
+        log_error("VIPS Error during watermark_image: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during watermark_image: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during watermark_image: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during watermark_image.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Prepares a watermark for repeated, thread-safe application.
+ *
+ * @param watermark The overlay image; not referenced after the call.
+ * @param opacity Opacity baked into the overlay, clamped to [0.0, 1.0].
+ * @param blend_mode Blend mode used when the watermark is applied.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A watermark handle on success, nullptr on failure. The caller is responsible for
+ *         freeing the handle using `free_watermark`.
+ */
+ImageWatermarkHandle prepare_watermark(VImageHandle watermark, double opacity, ImageBlendMode blend_mode,
+                                       ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_WATERMARK, 0, status);
+    if (!watermark) {
+        log_error("Error: Invalid VImage handle for prepare_watermark.");
+        return timer.fail(VIPS_INVALID_HANDLE, nullptr);
+    }
+
+    try {
+        auto mark = std::make_shared<PreparedWatermark>();
+        mark->image = premultiplied_overlay(*static_cast<const VImage*>(watermark), opacity);
+        mark->blend = composite_mode(blend_mode);
+        static std::atomic<uint64_t> serials{0};
+        mark->serial = ++serials;
+        return timer.succeed(static_cast<ImageWatermarkHandle>(new WatermarkRef(std::move(mark))));
+    } catch (const VError &e) {
+        log_error("VIPS Error during prepare_watermark: ", e.what());
+        return timer.fail(VIPS_ERROR, nullptr);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during prepare_watermark: ", e.what());
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, nullptr);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during prepare_watermark: ", e.what());
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    } catch (...) {
+        log_error("Unknown error occurred during prepare_watermark.");
+        return timer.fail(UNKNOWN_ERROR, nullptr);
+    }
+}
+
+/**
+ * @brief Applies a prepared watermark to an image.
+ * This function modifies the VImage associated with `base_handle` in-place.
+ *
+ * @param base_handle The image to watermark.
+ * @param watermark The prepared watermark.
+ * @param placement Anchor, offsets and scale of the watermark.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus watermark_image_prepared(VImageHandle base_handle, ImageWatermarkHandle watermark,
+                                     ImageWatermarkPlacement placement) {
+    OperationTimer timer(IMAGE_OP_WATERMARK);
+    if (!base_handle || !watermark) {
+        log_error("Error: Invalid handle(s) for watermark_image_prepared.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_prepared_watermark(*static_cast<VImage*>(base_handle),
+                                                     **static_cast<WatermarkRef*>(watermark), placement));
+    } catch (const VError &e) {
+        log_error("VIPS Error during watermark_image_prepared: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during watermark_image_prepared: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during watermark_image_prepared: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during watermark_image_prepared.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Releases the caller's reference to a prepared watermark.
+ * @param watermark The handle to release; may be null.
+ */
+void free_watermark(ImageWatermarkHandle watermark) {
+    delete static_cast<WatermarkRef*>(watermark);
+}
+
+/**
+ * @brief Changes the overall opacity of an image.
+ * This function modifies the VImage associated with the handle in-place.
+ *
+ * @param handle The VImageHandle of the image to modify.
+ * @param options Opacity options including the desired opacity level.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus change_image_opacity(VImageHandle handle, ImageOpacityOptions options) {
+    OperationTimer timer(IMAGE_OP_OPACITY);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for opacity change operation.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_opacity(*static_cast<VImage*>(handle), options));
+    } catch (const VError &e) {
+        log_error("VIPS Error during change_image_opacity: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during change_image_opacity: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during change_image_opacity: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during change_image_opacity.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Converts an image to 8-bit sRGB (8-bit greyscale for greyscale input).
+ * This function modifies the VImage associated with the handle in-place.
+ *
+ * @param handle The VImageHandle of the image to convert.
+ * @param options Profile handling and rendering intent.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus ensure_srgb8(VImageHandle handle, ImageSRGBOptions options) {
+    OperationTimer timer(IMAGE_OP_COLOUR);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for ensure_srgb8.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+
+    try {
+        return timer.finish(apply_srgb8(*static_cast<VImage*>(handle), options));
+    } catch (const VError &e) {
+        log_error("VIPS Error during ensure_srgb8: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during ensure_srgb8: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during ensure_srgb8: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during ensure_srgb8.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Extracts metadata from a VImage handle.
+ * @param handle The VImageHandle from which to extract metadata.
+ * @return An ImageMeta struct containing the extracted metadata.
+ */
+ImageMeta extract_metadata(const VImageHandle handle) {
+    if (!handle) {
+        log_error("Warning: Invalid VImage handle provided for metadata extraction.");
+        return ImageMeta{};
+    }
+
+    return describe_image(*static_cast<const VImage*>(handle));
+}
+
+/**
+ * @brief Reads image metadata from a file header without decoding any pixels.
+ *
+ * @param input_path The path to the image file.
+ * @param options Pixel limit and error strictness.
+ * @param meta Receives the metadata, including the file size.
+ * @return SUCCESS, IMAGE_INVALID_PATH, IMAGE_INVALID_FORMAT, IMAGE_LOAD_FAILURE, or
+ *         IMAGE_TOO_LARGE if the pixel limit is exceeded.
+ */
+ImageStatus probe_image_from_path(const char* input_path, ImageProbeOptions options, ImageMeta* meta) {
+    OperationTimer timer(IMAGE_OP_PROBE);
+    if (!meta) {
+        log_error("Error: Metadata output for probe is null.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+    *meta = ImageMeta{};
+    if (!input_path || std::strlen(input_path) == 0) {
+        log_error("Error: Input path for probe is null or empty.");
+        return timer.finish(IMAGE_INVALID_PATH);
+    }
+
+    std::error_code size_error;
+    uintmax_t file_size = std::filesystem::file_size(input_path, size_error);
+    if (size_error) {
+        log_error("Error: Cannot probe ", input_path, ": not a readable regular file.");
+        return timer.finish(IMAGE_INVALID_PATH);
+    }
+    if (!vips_foreign_find_load(input_path)) {
+        log_error("Error: Unsupported image format for probe: ", vips_error_buffer());
+        vips_error_clear();
+        return timer.finish(IMAGE_INVALID_FORMAT);
+    }
+
+    try {
+        VImage img = VImage::new_from_file(input_path, probe_option(options));
+        return timer.finish(finish_probe(img, options, file_size, meta));
+    } catch (const VError &e) {
+        log_error("VIPS Error during probe_image_from_path: ", e.what());
+        return timer.finish(IMAGE_LOAD_FAILURE);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during probe_image_from_path: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during probe_image_from_path: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during probe_image_from_path.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Reads image metadata from an encoded buffer without decoding any pixels.
+ *
+ * @param data Pointer to the encoded image bytes; only read during the call.
+ * @param size Size of the data in bytes.
+ * @param options Pixel limit and error strictness.
+ * @param meta Receives the metadata, with file_size set to `size`.
+ * @return SUCCESS, IMAGE_INVALID_FORMAT, IMAGE_LOAD_FAILURE, or IMAGE_TOO_LARGE
+ *         if the pixel limit is exceeded.
+ */
+ImageStatus probe_image_from_bytes(const unsigned char* data, size_t size, ImageProbeOptions options,
+                                   ImageMeta* meta) {
+    OperationTimer timer(IMAGE_OP_PROBE, size);
+    if (!meta) {
+        log_error("Error: Metadata output for probe is null.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+    *meta = ImageMeta{};
+    if (!data || size == 0) {
+        log_error("Error: Image data for probe is null or empty.");
+        return timer.finish(IMAGE_LOAD_FAILURE);
+    }
+    if (!vips_foreign_find_load_buffer(data, size)) {
+        log_error("Error: Unsupported image format for probe: ", vips_error_buffer());
+        vips_error_clear();
+        return timer.finish(IMAGE_INVALID_FORMAT);
+    }
+
+    try {
+        VImage img = VImage::new_from_buffer(data, size, "", probe_option(options));
+        return timer.finish(finish_probe(img, options, size, meta));
+    } catch (const VError &e) {
+        log_error("VIPS Error during probe_image_from_bytes: ", e.what());
+        return timer.finish(IMAGE_LOAD_FAILURE);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during probe_image_from_bytes: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during probe_image_from_bytes: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during probe_image_from_bytes.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Returns JPEG encoding options for one of the ImageJPEGPreset trade-offs.
+ *
+ * @param preset The preset to fill in.
+ * @param quality JPEG quality (1-100), or 0 for the encoder default.
+ * @return Versioned options ready for encode_to_jpeg and friends.
+ */
+ImageEncodeJPEGOptions jpeg_options_preset(ImageJPEGPreset preset, int quality) {
+    ImageEncodeJPEGOptions options = {};
+    options.quality = quality;
+    options.version = IMAGE_ENCODE_JPEG_OPTIONS_VERSION;
+    options.subsample = IMAGE_SUBSAMPLE_AUTO;
+
+    switch (preset) {
+        case IMAGE_JPEG_PRESET_FAST:
+            options.strip = 1;
+            break;
+        case IMAGE_JPEG_PRESET_BALANCED:
+            options.optimize_coding = 1;
+            options.strip = 1;
+            break;
+        case IMAGE_JPEG_PRESET_SMALLEST:
+            options.interlace = 1;
+            options.optimize_coding = 1;
+            options.trellis_quant = 1;
+            options.overshoot_deringing = 1;
+            options.optimize_scans = 1;
+            options.quant_table = 3; // ImageMagick table, tuned for photographic content
+            options.subsample = IMAGE_SUBSAMPLE_ON;
+            options.strip = 1;
+            break;
+        default:
+            break;
+    }
+    return options;
+}
+
+/**
+ * @brief Encodes the image to JPEG format and returns the encoded data in a buffer.
+ * The caller is responsible for freeing the `data` pointer of the returned `EncodedImage`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options JPEG encoding options (quality, interlacing, coding and metadata controls).
+ * @return An EncodedImage struct containing the buffer and its size, or {nullptr, 0} on failure.
+ */
+ImageBuffer encode_to_jpeg(const VImageHandle handle, ImageEncodeJPEGOptions options) {
+    OperationTimer timer(IMAGE_OP_ENCODE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for JPEG encoding.");
+        return timer.fail(VIPS_INVALID_HANDLE, ImageBuffer{nullptr, 0});
+    }
+
+    void* buf = nullptr;
+    size_t buf_size = 0;
+    const VImage* img = static_cast<const VImage*>(handle);
+
+    try {
+        // Write the image to a buffer in JPEG format
+        img->write_to_buffer(".jpg", &buf, &buf_size, jpeg_option(options));
+
+        // The buffer returned by write_to_buffer is managed by GLib, so we transfer ownership
+        return timer.succeed(ImageBuffer{static_cast<unsigned char*>(buf), buf_size}, buf_size);
+    } catch (const VError &e) {
+        log_error("VIPS Error during JPEG encoding: ", e.what());
+        if (buf) g_free(buf); // Ensure buffer is freed on error
+        return timer.fail(IMAGE_SAVE_FAILURE, ImageBuffer{nullptr, 0});
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during JPEG encoding: ", e.what());
+        if (buf) g_free(buf);
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, ImageBuffer{nullptr, 0});
+    } catch (const std::exception &e) {
+        log_error("Standard exception during JPEG encoding: ", e.what());
+        if (buf) g_free(buf);
+        return timer.fail(UNKNOWN_ERROR, ImageBuffer{nullptr, 0});
+    } catch (...) {
+        log_error("Unknown error occurred during JPEG encoding.");
+        if (buf) g_free(buf);
+        return timer.fail(UNKNOWN_ERROR, ImageBuffer{nullptr, 0});
+    }
+}
+
+/**
+ * @brief Encodes the image to PNG format and returns the encoded data in a buffer.
+ * The caller is responsible for freeing the `data` pointer of the returned `EncodedImage`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options PNG encoding options (compression, interlacing).
+ * @return An EncodedImage struct containing the buffer and its size, or {nullptr, 0} on failure.
+ */
+ImageBuffer encode_to_png(const VImageHandle handle, ImageEncodePNGOptions options) {
+    OperationTimer timer(IMAGE_OP_ENCODE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for PNG encoding.");
+        return timer.fail(VIPS_INVALID_HANDLE, ImageBuffer{nullptr, 0});
+    }
+
+    void* buf = nullptr;
+    size_t buf_size = 0;
+    const VImage* img = static_cast<const VImage*>(handle);
+
+    try {
+        // Write the image to a buffer in PNG format
+        img->write_to_buffer(".png", &buf, &buf_size, png_option(options));
+
+        // The buffer returned by write_to_buffer is managed by GLib, so we transfer ownership
+        return timer.succeed(ImageBuffer{static_cast<unsigned char*>(buf), buf_size}, buf_size);
+    } catch (const VError &e) {
+        log_error("VIPS Error during PNG encoding: ", e.what());
+        if (buf) g_free(buf); // Ensure buffer is freed on error
+        return timer.fail(IMAGE_SAVE_FAILURE, ImageBuffer{nullptr, 0});
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during PNG encoding: ", e.what());
+        if (buf) g_free(buf);
+        return timer.fail(MEMORY_ALLOCATION_FAILURE, ImageBuffer{nullptr, 0});
+    } catch (const std::exception &e) {
+        log_error("Standard exception during PNG encoding: ", e.what());
+        if (buf) g_free(buf);
+        return timer.fail(UNKNOWN_ERROR, ImageBuffer{nullptr, 0});
+    } catch (...) {
+        log_error("Unknown error occurred during PNG encoding.");
+        if (buf) g_free(buf);
+        return timer.fail(UNKNOWN_ERROR, ImageBuffer{nullptr, 0});
+    }
+}
+
+/**
+ * @brief Encodes the image to WebP format and returns the encoded data in a buffer.
+ * The caller is responsible for freeing the buffer with `free_image_buffer`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options WebP encoding options (quality, lossless, effort, subsampling, strip).
+ * @return An ImageBuffer containing the encoded data, or {nullptr, 0} on failure.
+ */
+ImageBuffer encode_to_webp(const VImageHandle handle, ImageEncodeWebPOptions options) {
+    return encode_to_image_buffer(handle, ".webp", [&] { return webp_option(options); }, "WebP encoding");
+}
+
+/**
+ * @brief Encodes the image to AVIF format and returns the encoded data in a buffer.
+ * The caller is responsible for freeing the buffer with `free_image_buffer`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options AVIF encoding options (quality, lossless, effort, subsampling, strip).
+ * @return An ImageBuffer containing the encoded data, or {nullptr, 0} on failure.
+ */
+ImageBuffer encode_to_avif(const VImageHandle handle, ImageEncodeAVIFOptions options) {
+    return encode_to_image_buffer(handle, ".avif", [&] { return heif_option(options, 50); }, "AVIF encoding");
+}
+
+/**
+ * @brief Encodes the image to JPEG XL format and returns the encoded data in a buffer.
+ * The caller is responsible for freeing the buffer with `free_image_buffer`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options JPEG XL encoding options (quality, lossless, effort, strip).
+ * @return An ImageBuffer containing the encoded data, or {nullptr, 0} on failure.
+ */
+ImageBuffer encode_to_jxl(const VImageHandle handle, ImageEncodeJXLOptions options) {
+    return encode_to_image_buffer(handle, ".jxl", [&] { return jxl_option(options); }, "JPEG XL encoding");
+}
+
+/**
+ * @brief Encodes the image to HEIF (HEVC) format and returns the encoded data in a buffer.
+ * The caller is responsible for freeing the buffer with `free_image_buffer`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options HEIF encoding options (quality, lossless, effort, subsampling, strip).
+ * @return An ImageBuffer containing the encoded data, or {nullptr, 0} on failure.
+ */
+ImageBuffer encode_to_heif(const VImageHandle handle, ImageEncodeHEIFOptions options) {
+    return encode_to_image_buffer(handle, ".heic", [&] { return heif_option(options, 50); }, "HEIF encoding");
+}
+
+/**
+ * @brief Encodes the image to GIF format and returns the encoded data in a buffer.
+ * The caller is responsible for freeing the buffer with `free_image_buffer`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options GIF encoding options (effort, bitdepth).
+ * @return An ImageBuffer containing the encoded data, or {nullptr, 0} on failure.
+ */
+ImageBuffer encode_to_gif(const VImageHandle handle, ImageEncodeGIFOptions options) {
+    return encode_to_image_buffer(handle, ".gif", [&] { return gif_option(options); }, "GIF encoding");
+}
+
+/**
+ * @brief Encodes the image to any format libvips can save to a buffer.
+ * The caller is responsible for freeing the buffer with `free_image_buffer`.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param suffix Format suffix selecting the saver (e.g. ".webp", ".tif", ".gif").
+ * @param options libvips saver options as "name=value" pairs separated by commas
+ *        (e.g. "Q=80,effort=2"), or null/empty for saver defaults.
+ * @return An ImageBuffer containing the encoded data, or {nullptr, 0} on failure.
+ */
+ImageBuffer encode_to_format(const VImageHandle handle, const char* suffix, const char* options) {
+    if (!suffix || suffix[0] != '.' || std::strchr(suffix, '[')) {
+        log_error("Error: Invalid format suffix for encoding (expected e.g. \".webp\").");
+        fail(IMAGE_OP_ENCODE, IMAGE_INVALID_FORMAT);
+        return ImageBuffer{nullptr, 0};
+    }
+
+    // libvips parses saver options from a "[...]" block after the suffix
+    std::string format = suffix;
+    if (options && options[0] != '\0') {
+        format += "[";
+        format += options;
+        format += "]";
+    }
+    return encode_to_image_buffer(handle, format.c_str(), [] { return VImage::option(); }, "format encoding");
+}
+
+/**
+ * @brief Encodes the image to JPEG format, streaming the encoded bytes to a writer callback.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options JPEG encoding options (quality, interlacing).
+ * @param writer Callback receiving the encoded chunks in order.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus encode_to_jpeg_writer(const VImageHandle handle, ImageEncodeJPEGOptions options, ImageWriter writer) {
+    if (!writer.write) {
+        log_error("Error: Writer callback for JPEG encoding is null.");
+        return fail(IMAGE_OP_ENCODE, IMAGE_SAVE_FAILURE);
+    }
+    WriterSink sink{writer, 0};
+    return encode_to_custom_target(handle, ".jpg", [&] { return jpeg_option(options); },
+                                   write_to_image_writer, &sink, &sink.written, "JPEG encoding to writer");
+}
+
+/**
+ * @brief Encodes the image to PNG format, streaming the encoded bytes to a writer callback.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options PNG encoding options (compression, interlacing).
+ * @param writer Callback receiving the encoded chunks in order.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus encode_to_png_writer(const VImageHandle handle, ImageEncodePNGOptions options, ImageWriter writer) {
+    if (!writer.write) {
+        log_error("Error: Writer callback for PNG encoding is null.");
+        return fail(IMAGE_OP_ENCODE, IMAGE_SAVE_FAILURE);
+    }
+    WriterSink sink{writer, 0};
+    return encode_to_custom_target(handle, ".png", [&] { return png_option(options); },
+                                   write_to_image_writer, &sink, &sink.written, "PNG encoding to writer");
+}
+
+/**
+ * @brief Encodes the image to JPEG format into a caller-provided buffer.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options JPEG encoding options (quality, interlacing).
+ * @param out Destination buffer.
+ * @param capacity Size of the destination buffer in bytes.
+ * @param out_size Receives the encoded size (the required size if the buffer is too small).
+ * @return SUCCESS on success, IMAGE_BUFFER_TOO_SMALL if `capacity` was insufficient,
+ *         or an appropriate error code on failure.
+ */
+ImageStatus encode_to_jpeg_into(const VImageHandle handle, ImageEncodeJPEGOptions options,
+                                unsigned char* out, size_t capacity, size_t* out_size) {
+    return encode_to_fixed_buffer(handle, ".jpg", [&] { return jpeg_option(options); },
+                                  out, capacity, out_size, "JPEG encoding into buffer");
+}
+
+/**
+ * @brief Encodes the image to PNG format into a caller-provided buffer.
+ *
+ * @param handle The VImageHandle of the image to encode.
+ * @param options PNG encoding options (compression, interlacing).
+ * @param out Destination buffer.
+ * @param capacity Size of the destination buffer in bytes.
+ * @param out_size Receives the encoded size (the required size if the buffer is too small).
+ * @return SUCCESS on success, IMAGE_BUFFER_TOO_SMALL if `capacity` was insufficient,
+ *         or an appropriate error code on failure.
+ */
+ImageStatus encode_to_png_into(const VImageHandle handle, ImageEncodePNGOptions options,
+                               unsigned char* out, size_t capacity, size_t* out_size) {
+    return encode_to_fixed_buffer(handle, ".png", [&] { return png_option(options); },
+                                  out, capacity, out_size, "PNG encoding into buffer");
+}
+
+/**
+ * @brief Hidden sibling of `file` for writing it in full before it is renamed into place.
+ *
+ * Unique per process and thread, and keeps the extension of `file` last, since
+ * write_to_file picks the saver from it.
  */
-int vips_wrapper_init() {
-    // Initialize VIPS with the program name
-    if (VIPS_INIT("vips_wrapper")) {
-        // Log VIPS error and exit if initialization fails
-        vips_error_exit(nullptr);
-        return VIPS_INIT_FAILURE;
+static std::filesystem::path sibling_temporary(const std::filesystem::path& file) {
+    static std::atomic<uint64_t> sequence{0};
+    return file.parent_path() / ("." + file.stem().string() + ".tmp-" +
+        std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "-" +
+        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-" +
+        std::to_string(sequence++) + file.extension().string());
+}
+
+/**
+ * @brief Encodes the image straight to a file, choosing the saver from the extension
+ * for IMAGE_FORMAT_NONE.
+ *
+ * The encoder writes to a temporary file next to `path` that replaces it only once
+ * complete, so a failed save never touches an existing file at `path`.
+ *
+ * @param handle The VImageHandle of the image to save.
+ * @param path The destination file, optionally followed by libvips saver options
+ *        in brackets for IMAGE_FORMAT_NONE.
+ * @param spec Output format and encoder options.
+ * @return SUCCESS on success, or an appropriate error code on failure.
+ */
+ImageStatus save_image(const VImageHandle handle, const char* path, ImageEncodeSpec spec) {
+    OperationTimer timer(IMAGE_OP_ENCODE);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for save_image.");
+        return timer.finish(VIPS_INVALID_HANDLE);
     }
-    return SUCCESS;
+    if (!path || path[0] == '\0') {
+        log_error("Error: Output path for save_image is null or empty.");
+        return timer.finish(IMAGE_INVALID_PATH);
+    }
+    const char* suffix = format_suffix(spec.format);
+    if (spec.format != IMAGE_FORMAT_NONE && !suffix) {
+        log_error("Error: Invalid output format for save_image.");
+        return timer.finish(IMAGE_INVALID_FORMAT);
+    }
+
+    const VImage* img = static_cast<const VImage*>(handle);
+    ImageStatus status = SUCCESS;
+    std::filesystem::path temporary;
+    try {
+        // Saver options such as "out.tif[compression=lzw]" are not part of the file name
+        std::string file = path;
+        std::string options;
+        size_t bracket = file.rfind('[');
+        if (!suffix && bracket != std::string::npos && file.back() == ']') {
+            options = file.substr(bracket);
+            file.resize(bracket);
+        }
+        temporary = sibling_temporary(file);
+        if (suffix) {
+            // The file target is closed when it goes out of scope, before the file is renamed
+            VTarget target = VTarget::new_to_file(temporary.c_str());
+            img->write_to_target(suffix, target, format_option(spec));
+        } else {
+            img->write_to_file((temporary.string() + options).c_str());
+        }
+        std::error_code size_error;
+        uintmax_t written = std::filesystem::file_size(temporary, size_error);
+        std::filesystem::rename(temporary, file);
+        return timer.finish(SUCCESS, size_error ? 0 : static_cast<uint64_t>(written));
+    } catch (const VError &e) {
+        log_error("VIPS Error during save_image: ", e.what());
+        status = IMAGE_SAVE_FAILURE;
+    } catch (const std::filesystem::filesystem_error &e) {
+        log_error("Error: Cannot replace the output file of save_image: ", e.what());
+        status = IMAGE_SAVE_FAILURE;
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during save_image: ", e.what());
+        status = MEMORY_ALLOCATION_FAILURE;
+    } catch (const std::exception &e) {
+        log_error("Standard exception during save_image: ", e.what());
+        status = UNKNOWN_ERROR;
+    } catch (...) {
+        log_error("Unknown error occurred during save_image.");
+        status = UNKNOWN_ERROR;
+    }
+    if (!temporary.empty()) {
+        std::error_code remove_error;
+        std::filesystem::remove(temporary, remove_error);
+    }
+    return timer.finish(status);
 }
 
 /**
- * @brief Cleans up VIPS resources. Should be called when image processing is complete.
+ * @brief Runs a chain of operations and the final encode in a single call.
+ *
+ * The handle itself is left untouched unless `out.format` is IMAGE_FORMAT_NONE, in which
+ * case the transformed image replaces it and nothing is encoded.
+ *
+ * @param handle The VImageHandle of the source image.
+ * @param ops Array of operations to apply, in order.
+ * @param n Number of operations in `ops`.
+ * @param out Output format and encoder options.
+ * @param result Receives the encoded bytes; free with `free_image_buffer`.
+ * @return SUCCESS on success, or an appropriate error code on failure.
  */
-void vips_wrapper_cleanup() {
-    vips_shutdown();
+ImageStatus process_pipeline(VImageHandle handle, const ImagePipelineOp* ops, size_t n,
+                             ImageEncodeSpec out, ImageBuffer* result) {
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for pipeline.");
+        return fail(IMAGE_OP_PIPELINE, VIPS_INVALID_HANDLE);
+    }
+    if (!ops && n > 0) {
+        log_error("Error: Pipeline operations are null.");
+        return fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
+    }
+    const char* suffix = format_suffix(out.format);
+    if (out.format != IMAGE_FORMAT_NONE && (!suffix || !result)) {
+        log_error("Error: Invalid output format or result buffer for pipeline.");
+        return fail(IMAGE_OP_PIPELINE, IMAGE_INVALID_FORMAT);
+    }
+
+    return run_pipeline(*static_cast<VImage*>(handle), ops, n, out, result);
 }
 
 /**
- * @brief Loads an image from a file and returns a VImage handle.
+ * @brief Encodes several sizes of an image from a single decode.
  *
- * @param input_path The path to the image file to load.
- * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
- *         the handle using `free_vimage_handle`.
- * @throws std::runtime_error On failure to load the image or other unexpected errors.
+ * @param source The source image; not modified.
+ * @param specs Rendition sizes and encodings.
+ * @param n Number of renditions.
+ * @param out Receives the encoded renditions in spec order; all {nullptr, 0} on failure.
+ * @return SUCCESS, or the error code of the first failure.
  */
-VImageHandle load_image(const char* input_path) {
-    if (!input_path || std::strlen(input_path) == 0) {
-        std::cerr << "Error: Input path for image loading is null or empty." << std::endl;
-        return nullptr;
+ImageStatus generate_renditions(VImageHandle source, const ImageRenditionSpec* specs, size_t n, ImageBuffer* out) {
+    OperationTimer timer(IMAGE_OP_RENDITIONS);
+    if (!source) {
+        log_error("Error: Invalid VImage handle for generate_renditions.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+    if (n > 0 && (!specs || !out)) {
+        log_error("Error: Rendition specs or output array are null.");
+        return timer.finish(UNKNOWN_ERROR);
     }
+    std::fill(out, out + n, ImageBuffer{nullptr, 0});
 
     try {
-        // Create a new VImage instance from the file
-        VImage* img = new VImage(VImage::new_from_file(input_path));
-        return static_cast<VImageHandle>(img);
+        const VImage& img = *static_cast<const VImage*>(source);
+        std::vector<size_t> order;
+        std::vector<std::pair<int, int>> sizes;
+        ImageStatus status = plan_renditions(img.width(), img.height(), specs, n, order, sizes);
+        if (status != SUCCESS || n == 0) {
+            return timer.finish(status);
+        }
+
+        uint64_t bytes_out = 0;
+        status = render_renditions(img, specs, order, sizes, out, &bytes_out);
+        return timer.finish(status, bytes_out);
     } catch (const VError &e) {
-        std::cerr << "VIPS Error during image loading: " << e.what() << std::endl;
-        return nullptr;
+        log_error("VIPS Error during generate_renditions: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during generate_renditions: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during generate_renditions: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during generate_renditions.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Largest JPEG DCT shrink that keeps the decode at least `need_width` x `need_height`.
+ *
+ * libjpeg scales by 1/2, 1/4 or 1/8 while decoding, so the shrunk image is a
+ * decode rather than a resample and every level is still resized only once.
+ *
+ * @param width Full-resolution width of the stored (unrotated) image.
+ * @param height Full-resolution height of the stored (unrotated) image.
+ * @param need_width Smallest width the decode may have.
+ * @param need_height Smallest height the decode may have.
+ * @return 8, 4, 2 or 1.
+ */
+static int jpeg_load_shrink(int width, int height, int need_width, int need_height) {
+    for (int shrink : {8, 4, 2}) {
+        if (width / shrink >= need_width && height / shrink >= need_height) {
+            return shrink;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Encodes several sizes of an encoded image with the default load options.
+ *
+ * @param data Pointer to the encoded image bytes; only read during the call.
+ * @param size Size of the data in bytes.
+ * @param specs Rendition sizes and encodings.
+ * @param n Number of renditions.
+ * @param out Receives the encoded renditions in spec order; all {nullptr, 0} on failure.
+ * @return SUCCESS, or the error code of the first failure.
+ */
+ImageStatus generate_renditions_from_buffer(const unsigned char* data, size_t size,
+                                            const ImageRenditionSpec* specs, size_t n, ImageBuffer* out) {
+    return generate_renditions_from_buffer_with_options(data, size, ImageLoadOptions{}, specs, n, out);
+}
+
+/**
+ * @brief Encodes several sizes of an encoded image from a single decode.
+ *
+ * JPEG input is decoded with the largest DCT shrink that still covers every
+ * rendition; each level is then resized once, from the decode or from the
+ * smallest larger level.
+ *
+ * @param data Pointer to the encoded image bytes; only read during the call.
+ * @param size Size of the data in bytes.
+ * @param load Loader limits, strictness and autorotation; the access mode and pages are ignored.
+ * @param specs Rendition sizes and encodings.
+ * @param n Number of renditions.
+ * @param out Receives the encoded renditions in spec order; all {nullptr, 0} on failure.
+ * @return SUCCESS, or the error code of the first failure.
+ */
+ImageStatus generate_renditions_from_buffer_with_options(const unsigned char* data, size_t size,
+                                                         ImageLoadOptions load, const ImageRenditionSpec* specs,
+                                                         size_t n, ImageBuffer* out) {
+    OperationTimer timer(IMAGE_OP_RENDITIONS, size);
+    if (n > 0 && (!specs || !out)) {
+        log_error("Error: Rendition specs or output array are null.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+    std::fill(out, out + n, ImageBuffer{nullptr, 0});
+    if (!data || size == 0) {
+        log_error("Error: Image data for renditions is null or empty.");
+        return timer.finish(IMAGE_LOAD_FAILURE);
+    }
+    if (check_input_size(size, load) != SUCCESS) {
+        return timer.finish(IMAGE_TOO_LARGE);
+    }
+
+    // Levels are read repeatedly, and pages would stack into one tall image
+    load.access = IMAGE_ACCESS_RANDOM;
+    load.page = 0;
+    load.n = 1;
+
+    VImage top;
+    std::vector<size_t> order;
+    std::vector<std::pair<int, int>> sizes;
+    try {
+        // Loaded from a private copy: the operation cache may keep the loads, and the
+        // data they read, alive after this call
+        VipsBlobPtr blob(vips_blob_copy(data, size));
+        VSource source = VSource::new_from_blob(blob.get());
+
+        // Target sizes refer to the full-resolution upright image, so read its header first
+        VImage header = VImage::new_from_source(source, "", load_option(load));
+        if (check_load_limits(header, load) != SUCCESS) {
+            return timer.finish(IMAGE_TOO_LARGE);
+        }
+        int width = 0, height = 0;
+        upright_size(header, load.autorotate != 0, &width, &height);
+        ImageStatus status = plan_renditions(width, height, specs, n, order, sizes);
+        if (status != SUCCESS || n == 0) {
+            return timer.finish(status);
+        }
+
+        // The largest rendition by area may be small on one axis, so cover each axis separately
+        int need_width = 0, need_height = 0;
+        for (const auto& target : sizes) {
+            need_width = std::max(need_width, target.first);
+            need_height = std::max(need_height, target.second);
+        }
+        if (width != header.width()) {
+            std::swap(need_width, need_height);
+        }
+
+        // Only JPEG shrinks while decoding; the scale-on-load of other formats resamples
+        VOption* option = load_option(load);
+        const char* loader = vips_foreign_find_load_buffer(data, size);
+        if (loader && std::strcmp(loader, "VipsForeignLoadJpegBuffer") == 0) {
+            option->set("shrink", jpeg_load_shrink(header.width(), header.height(), need_width, need_height));
+        }
+        top = VImage::new_from_source(source, "", option);
+        if (load.autorotate) {
+            apply_autorotate(top);
+        }
+    } catch (const VError &e) {
+        log_error("VIPS Error while decoding for generate_renditions_from_buffer: ", e.what());
+        return timer.finish(IMAGE_LOAD_FAILURE);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during generate_renditions_from_buffer: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    }
+
+    try {
+        uint64_t bytes_out = 0;
+        ImageStatus status = render_renditions(top, specs, order, sizes, out, &bytes_out);
+        return timer.finish(status, bytes_out);
+    } catch (const VError &e) {
+        log_error("VIPS Error during generate_renditions_from_buffer: ", e.what());
+        return timer.finish(VIPS_ERROR);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during generate_renditions_from_buffer: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
+    } catch (const std::exception &e) {
+        log_error("Standard exception during generate_renditions_from_buffer: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred during generate_renditions_from_buffer.");
+        return timer.finish(UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Creates a worker pool with a fixed number of threads and a bounded job queue.
+ *
+ * @param options Pool sizing; zero fields select one worker per core and 2 x workers queued jobs.
+ * @return A pool handle to release with `destroy_worker_pool`, or nullptr on failure.
+ */
+ImageWorkerPoolHandle create_worker_pool(ImageWorkerPoolOptions options) {
+    int workers = options.workers > 0 ? options.workers
+                                      : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    WorkerPool* pool = nullptr;
+
+    try {
+        pool = new WorkerPool();
+        pool->queue_depth = options.queue_depth > 0 ? static_cast<size_t>(options.queue_depth)
+                                                    : static_cast<size_t>(workers) * 2;
+        pool->workers.reserve(workers);
+        for (int i = 0; i < workers; ++i) {
+            pool->workers.emplace_back(worker_pool_run, pool);
+        }
+        return static_cast<ImageWorkerPoolHandle>(pool);
+    } catch (const std::exception &e) {
+        log_error("Failed to start worker pool: ", e.what());
+        fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
+    } catch (...) {
+        log_error("Unknown error occurred while starting worker pool.");
+        fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
+    }
+    if (pool) {
+        worker_pool_stop(pool);
+        delete pool;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Queues a pipeline job on a worker pool.
+ *
+ * @param pool The pool handle.
+ * @param spec The job; ops and images are copied/referenced before returning.
+ * @param done Completion callback, invoked once on a worker thread for every accepted job.
+ * @param user_data Passed through to `done`.
+ * @return SUCCESS if queued, IMAGE_QUEUE_FULL if the queue is full, or a validation error.
+ */
+ImageStatus submit_job(ImageWorkerPoolHandle pool, ImagePipelineSpec spec, ImageJobCompletionFn done,
+                       void* user_data) {
+    if (!pool || !spec.image) {
+        log_error("Error: Invalid pool or image handle for submit_job.");
+        return fail(IMAGE_OP_PIPELINE, VIPS_INVALID_HANDLE);
+    }
+    if ((!spec.ops && spec.op_count > 0) || !done) {
+        log_error("Error: Job operations or completion callback are null.");
+        return fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
+    }
+    if (spec.output.format == IMAGE_FORMAT_NONE || !format_suffix(spec.output.format)) {
+        log_error("Error: Invalid output format for submit_job.");
+        return fail(IMAGE_OP_PIPELINE, IMAGE_INVALID_FORMAT);
+    }
+
+    WorkerPool* workers = static_cast<WorkerPool*>(pool);
+    try {
+        PoolJob job;
+        job.image = *static_cast<const VImage*>(spec.image);
+        job.ops.assign(spec.ops, spec.ops + spec.op_count);
+        job.overlays.reserve(spec.op_count);
+        job.marks.reserve(spec.op_count);
+        for (auto& op : job.ops) {
+            if (op.type == PIPELINE_OP_WATERMARK && op.watermark_image) {
+                job.overlays.push_back(*static_cast<const VImage*>(op.watermark_image));
+                op.watermark_image = &job.overlays.back();
+            } else if (op.type == PIPELINE_OP_PREPARED_WATERMARK && op.prepared_watermark) {
+                job.marks.push_back(*static_cast<const WatermarkRef*>(op.prepared_watermark));
+                op.prepared_watermark = &job.marks.back();
+            }
+        }
+        job.output = spec.output;
+        job.done = done;
+        job.user_data = user_data;
+
+        {
+            std::lock_guard<std::mutex> lock(workers->mutex);
+            if (workers->stopping) {
+                set_error_message("Error: Worker pool is shutting down.");
+                return fail(IMAGE_OP_PIPELINE, VIPS_INVALID_HANDLE);
+            }
+            if (workers->queue.size() >= workers->queue_depth) {
+                // Load shedding is routine under bursts, so it is recorded but not logged
+                set_error_message("Worker pool queue is full (", workers->queue_depth, " jobs).");
+                return fail(IMAGE_OP_PIPELINE, IMAGE_QUEUE_FULL);
+            }
+            workers->queue.push_back(std::move(job));
+        }
+        workers->ready.notify_one();
+        return SUCCESS;
     } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during image loading: " << e.what() << std::endl;
+        log_error("Memory allocation error during submit_job: ", e.what());
+        return fail(IMAGE_OP_PIPELINE, MEMORY_ALLOCATION_FAILURE);
+    } catch (...) {
+        log_error("Unknown error occurred during submit_job.");
+        return fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
+    }
+}
+
+/**
+ * @brief Returns the number of jobs waiting for a worker.
+ */
+size_t worker_pool_queued(ImageWorkerPoolHandle pool) {
+    if (!pool) {
+        return 0;
+    }
+    WorkerPool* workers = static_cast<WorkerPool*>(pool);
+    std::lock_guard<std::mutex> lock(workers->mutex);
+    return workers->queue.size();
+}
+
+/**
+ * @brief Stops accepting jobs, runs the queued ones, joins the workers and frees the pool.
+ */
+void destroy_worker_pool(ImageWorkerPoolHandle pool) {
+    if (!pool) {
+        return;
+    }
+    WorkerPool* workers = static_cast<WorkerPool*>(pool);
+    worker_pool_stop(workers);
+    delete workers;
+}
+
+/**
+ * @brief Loads, processes and encodes many images, spreading whole images over threads.
+ *
+ * @param items The inputs.
+ * @param n Number of items.
+ * @param spec Loader options, pipeline and output encoding shared by all items.
+ * @param results Receives one result per item.
+ * @param parallelism Images processed at once (0 = one per CPU core).
+ * @return SUCCESS once all items have run, or a validation error.
+ */
+ImageStatus process_batch(const ImageBatchItem* items, size_t n, ImageBatchSpec spec, ImageBatchResult* results,
+                          int parallelism) {
+    if (n > 0 && (!items || !results)) {
+        log_error("Error: Batch items or result array are null.");
+        return fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
+    }
+    if (!spec.ops && spec.op_count > 0) {
+        log_error("Error: Batch operations are null.");
+        return fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
+    }
+    if (spec.output.format == IMAGE_FORMAT_NONE || !format_suffix(spec.output.format)) {
+        log_error("Error: Invalid output format for process_batch.");
+        return fail(IMAGE_OP_PIPELINE, IMAGE_INVALID_FORMAT);
+    }
+
+    std::atomic<size_t> next{0};
+    auto run_items = [&]() {
+        for (size_t i = next++; i < n; i = next++) {
+            run_batch_item(items[i], spec, &results[i]);
+        }
+    };
+
+    size_t wanted = parallelism > 0 ? static_cast<size_t>(parallelism)
+                                    : static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency()));
+    size_t threads = std::max<size_t>(1, std::min(n, wanted));
+    std::vector<std::thread> runners;
+    try {
+        runners.reserve(threads - 1);
+        for (size_t t = 1; t < threads; ++t) {
+            runners.emplace_back([&]() {
+                run_items();
+                // Release the per-thread buffers libvips keeps for this thread
+                vips_thread_shutdown();
+            });
+        }
+    } catch (const std::exception &e) {
+        // Carry on with the threads that did start; the calling thread always runs items
+        log_message(IMAGE_LOG_WARNING, "process_batch started ", runners.size() + 1, " of ", threads,
+                    " threads: ", e.what());
+    }
+    run_items();
+    for (auto& runner : runners) {
+        runner.join();
+    }
+    return SUCCESS;
+}
+
+/**
+ * @brief Opens a raw pixel cache on a directory, indexing the entries already in it.
+ *
+ * @param options The directory and size bound.
+ * @param status Receives SUCCESS or the failure code (may be NULL).
+ * @return A cache handle, or nullptr on failure.
+ */
+ImageRawCacheHandle create_raw_cache(ImageRawCacheOptions options, ImageStatus* status) {
+    if (status) *status = SUCCESS;
+    if (!options.directory || options.directory[0] == '\0') {
+        log_error("Error: Raw cache directory is null or empty.");
+        if (status) *status = IMAGE_INVALID_PATH;
+        fail(IMAGE_OP_RAW_CACHE, IMAGE_INVALID_PATH);
         return nullptr;
+    }
+
+    try {
+        std::unique_ptr<RawCache> cache(new RawCache());
+        cache->directory = options.directory;
+        cache->max_bytes = options.max_bytes;
+        std::filesystem::create_directories(cache->directory);
+
+        // Index existing entries oldest first, so the newest end up most recently used.
+        // Temporaries of writers that crashed are deleted; recent ones may belong to another process.
+        auto now = std::filesystem::file_time_type::clock::now();
+        std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::directory_entry>> found;
+        for (const auto& file : std::filesystem::directory_iterator(cache->directory)) {
+            if (!file.is_regular_file() || file.path().extension() != RAW_CACHE_SUFFIX) {
+                continue;
+            }
+            if (file.path().filename().string().rfind(RAW_CACHE_TEMP_PREFIX, 0) == 0) {
+                if (now - file.last_write_time() > RAW_CACHE_STALE_TEMP_AGE) {
+                    std::error_code remove_error;
+                    std::filesystem::remove(file.path(), remove_error);
+                }
+                continue;
+            }
+            found.emplace_back(file.last_write_time(), file);
+        }
+        std::sort(found.begin(), found.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& file : found) {
+            raw_cache_insert(cache.get(), file.second.path().filename().string(), file.second.file_size());
+        }
+        raw_cache_evict(cache.get(), std::string());
+        return static_cast<ImageRawCacheHandle>(cache.release());
+    } catch (const std::filesystem::filesystem_error &e) {
+        log_error("Error: Cannot open raw cache directory: ", e.what());
+        if (status) *status = IMAGE_INVALID_PATH;
+        fail(IMAGE_OP_RAW_CACHE, IMAGE_INVALID_PATH);
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during create_raw_cache: ", e.what());
+        if (status) *status = MEMORY_ALLOCATION_FAILURE;
+        fail(IMAGE_OP_RAW_CACHE, MEMORY_ALLOCATION_FAILURE);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Renders an image into the raw cache under `key`, then evicts down to max_bytes.
+ *
+ * @param cache The cache handle.
+ * @param key The entry key.
+ * @param handle The image to store.
+ * @return SUCCESS, IMAGE_TOO_LARGE, IMAGE_SAVE_FAILURE, or a validation error.
+ */
+ImageStatus export_to_raw_cache(ImageRawCacheHandle cache, const char* key, VImageHandle handle) {
+    OperationTimer timer(IMAGE_OP_RAW_CACHE);
+    if (!cache || !handle) {
+        log_error("Error: Invalid cache or image handle for export_to_raw_cache.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+    if (!key || key[0] == '\0') {
+        log_error("Error: Raw cache key is null or empty.");
+        return timer.finish(IMAGE_INVALID_PATH);
+    }
+
+    RawCache* raw = static_cast<RawCache*>(cache);
+    std::string name = raw_cache_file_name(key);
+    // Unique per process and thread, so concurrent writers of one key never share a file.
+    // It keeps the entry suffix last, since write_to_file picks the saver from it.
+    static std::atomic<uint64_t> sequence{0};
+    std::filesystem::path temporary = raw->directory / (std::string(RAW_CACHE_TEMP_PREFIX) +
+        std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "-" +
+        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-" +
+        std::to_string(sequence++) + "-" + name);
+    ImageStatus status = IMAGE_SAVE_FAILURE;
+
+    try {
+        VImage img = clear_access_tag(*static_cast<const VImage*>(handle)).copy();
+        img.set(RAW_CACHE_KEY_FIELD, key);
+        img.write_to_file(temporary.c_str());
+
+        uint64_t bytes = std::filesystem::file_size(temporary);
+        if (raw->max_bytes > 0 && bytes > raw->max_bytes) {
+            log_error("Error: Raw cache entry of ", bytes, " bytes exceeds the cache size of ", raw->max_bytes,
+                      " bytes.");
+            status = IMAGE_TOO_LARGE;
+        } else {
+            std::filesystem::rename(temporary, raw->directory / name);
+            std::lock_guard<std::mutex> lock(raw->mutex);
+            raw_cache_insert(raw, name, bytes);
+            raw_cache_evict(raw, name);
+            return timer.finish(SUCCESS, bytes);
+        }
+    } catch (const VError &e) {
+        log_error("VIPS Error during export_to_raw_cache: ", e.what());
+    } catch (const std::filesystem::filesystem_error &e) {
+        log_error("Error: Cannot write raw cache entry: ", e.what());
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during export_to_raw_cache: ", e.what());
+        status = MEMORY_ALLOCATION_FAILURE;
     } catch (const std::exception &e) {
-        std::cerr << "Standard exception during image loading: " << e.what() << std::endl;
+        log_error("Standard exception during export_to_raw_cache: ", e.what());
+        status = UNKNOWN_ERROR;
+    }
+    std::error_code remove_error;
+    std::filesystem::remove(temporary, remove_error);
+    return timer.finish(status);
+}
+
+/**
+ * @brief Maps the raw cache entry of `key` as a new image.
+ *
+ * @param cache The cache handle.
+ * @param key The entry key.
+ * @param status Receives SUCCESS, IMAGE_CACHE_MISS or another failure code (may be NULL).
+ * @return A VImageHandle on a hit, nullptr otherwise.
+ */
+VImageHandle load_from_raw_cache(ImageRawCacheHandle cache, const char* key, ImageStatus* status) {
+    if (!cache || !key || key[0] == '\0') {
+        log_error("Error: Invalid cache handle or key for load_from_raw_cache.");
+        if (status) *status = VIPS_INVALID_HANDLE;
+        fail(IMAGE_OP_RAW_CACHE, VIPS_INVALID_HANDLE);
         return nullptr;
-    } catch (...) {
-        std::cerr << "Unknown error occurred while loading image." << std::endl;
+    }
+
+    RawCache* raw = static_cast<RawCache*>(cache);
+    std::string name = raw_cache_file_name(key);
+    std::filesystem::path path = raw->directory / name;
+    bool present = true;
+    {
+        std::lock_guard<std::mutex> lock(raw->mutex);
+        auto it = raw->entries.find(name);
+        if (it != raw->entries.end()) {
+            raw->lru.splice(raw->lru.begin(), raw->lru, it->second.lru);
+        } else {
+            // Another process sharing the directory may have stored it
+            std::error_code size_error;
+            uint64_t bytes = std::filesystem::file_size(path, size_error);
+            present = !size_error;
+            if (present) {
+                raw_cache_insert(raw, name, bytes);
+                raw_cache_evict(raw, name);
+            }
+        }
+    }
+    if (!present) {
+        raw_cache_miss(raw, key, status);
+        return nullptr;
+    }
+
+    try {
+        VOption* option = VImage::option();
+#ifdef VIPS_WRAPPER_HAVE_REVALIDATE
+        // The entry may have been replaced since libvips last opened this file name
+        option->set("revalidate", true);
+#endif
+        VImage loaded = VImage::new_from_file(path.c_str(), option);
+        if (!loaded.get_typeof(RAW_CACHE_KEY_FIELD) || std::strcmp(loaded.get_string(RAW_CACHE_KEY_FIELD), key) != 0) {
+            // A different key with the same hash; it keeps its entry
+            raw_cache_miss(raw, key, status);
+            return nullptr;
+        }
+
+        OperationTimer timer(IMAGE_OP_RAW_CACHE, 0, status);
+        std::error_code touch_error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), touch_error);
+        VImage* img = new VImage(clear_access_tag(loaded));
+        std::lock_guard<std::mutex> lock(raw->mutex);
+        ++raw->hits;
+        return timer.succeed(static_cast<VImageHandle>(img));
+    } catch (const VError &) {
+        // Evicted by another process since it was indexed, or unreadable: drop it
+        {
+            std::lock_guard<std::mutex> lock(raw->mutex);
+            raw_cache_forget(raw, name, false);
+        }
+        raw_cache_miss(raw, key, status);
+        return nullptr;
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during load_from_raw_cache: ", e.what());
+        if (status) *status = MEMORY_ALLOCATION_FAILURE;
+        fail(IMAGE_OP_RAW_CACHE, MEMORY_ALLOCATION_FAILURE);
         return nullptr;
     }
 }
 
 /**
- * @brief Loads an image from a byte buffer and returns a VImage handle.
+ * @brief Returns the counters of a raw pixel cache.
+ */
+ImageRawCacheStats raw_cache_stats(ImageRawCacheHandle cache) {
+    if (!cache) {
+        return ImageRawCacheStats{0, 0, 0, 0, 0};
+    }
+    RawCache* raw = static_cast<RawCache*>(cache);
+    std::lock_guard<std::mutex> lock(raw->mutex);
+    return ImageRawCacheStats{raw->entries.size(), raw->bytes, raw->hits, raw->misses, raw->evictions};
+}
+
+/**
+ * @brief Frees a raw pixel cache handle; the cache files stay on disk.
+ */
+void destroy_raw_cache(ImageRawCacheHandle cache) {
+    delete static_cast<RawCache*>(cache);
+}
+
+/**
+ * @brief Creates an in-memory cache of encoded pipeline outputs.
  *
- * @param data Pointer to the image data bytes.
- * @param size Size of the image data in bytes.
- * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
- *         the handle using `free_vimage_handle`.
+ * @param options The byte budget and shard count; zero fields select the defaults.
+ * @param status Receives SUCCESS or the failure code (may be NULL).
+ * @return A cache handle, or nullptr on allocation failure.
  */
-VImageHandle load_image_from_bytes(const unsigned char* data, size_t size) {
+ImageResultCacheHandle create_result_cache(ImageResultCacheOptions options, ImageStatus* status) {
+    if (status) *status = SUCCESS;
+    try {
+        std::unique_ptr<ResultCache> cache(new ResultCache());
+        uint64_t max_bytes = options.max_bytes > 0 ? options.max_bytes : RESULT_CACHE_DEFAULT_BYTES;
+        int shards = options.shards > 0 ? options.shards : RESULT_CACHE_DEFAULT_SHARDS;
+        cache->shard_bytes = max_bytes / static_cast<uint64_t>(shards);
+        cache->shards.reserve(shards);
+        for (int i = 0; i < shards; ++i) {
+            cache->shards.emplace_back(new ResultCacheShard());
+        }
+        return static_cast<ImageResultCacheHandle>(cache.release());
+    } catch (const std::bad_alloc &e) {
+        log_error("Memory allocation error during create_result_cache: ", e.what());
+        if (status) *status = MEMORY_ALLOCATION_FAILURE;
+        fail(IMAGE_OP_RESULT_CACHE, MEMORY_ALLOCATION_FAILURE);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns the cached output of an identical call, or renders, stores and returns it.
+ *
+ * Identical calls that miss at the same time share one render.
+ *
+ * @param cache The cache handle.
+ * @param data The encoded input.
+ * @param size Size of the input in bytes.
+ * @param load Loader options and limits.
+ * @param ops The pipeline steps.
+ * @param n Number of steps.
+ * @param out Output format and encoder options.
+ * @param result Receives a shared reference to the encoded output.
+ * @return SUCCESS, or the failure code of the validation, load, pipeline or encode.
+ */
+ImageStatus process_cached(ImageResultCacheHandle cache, const unsigned char* data, size_t size,
+                           ImageLoadOptions load, const ImagePipelineOp* ops, size_t n, ImageEncodeSpec out,
+                           ImageCachedBuffer* result) {
+    if (!cache || !result) {
+        log_error("Error: Invalid result cache handle or result pointer for process_cached.");
+        return fail(IMAGE_OP_RESULT_CACHE, VIPS_INVALID_HANDLE);
+    }
+    *result = ImageCachedBuffer{nullptr, 0, nullptr};
     if (!data || size == 0) {
-        std::cerr << "Error: Image data is null or empty." << std::endl;
-        return nullptr;
+        log_error("Error: Image data is null or empty.");
+        return fail(IMAGE_OP_LOAD, IMAGE_LOAD_FAILURE);
     }
+    if (!ops && n > 0) {
+        log_error("Error: Pipeline operations are null.");
+        return fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
+    }
+    if (out.format == IMAGE_FORMAT_NONE || !format_suffix(out.format)) {
+        log_error("Error: Invalid output format for process_cached.");
+        return fail(IMAGE_OP_PIPELINE, IMAGE_INVALID_FORMAT);
+    }
+
+    ResultCache* results = static_cast<ResultCache*>(cache);
+    try {
+        std::string key;
+        bool cacheable = result_cache_key(key, data, size, load, ops, n, out);
+        ResultCacheShard& shard = *results->shards[std::hash<std::string>()(key) % results->shards.size()];
+
+        CachedResultRef cached;
+        std::shared_ptr<ResultFlight> flight;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto entry = cacheable ? shard.entries.find(key) : shard.entries.end();
+            auto pending = cacheable ? shard.flights.find(key) : shard.flights.end();
+            if (entry != shard.entries.end()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, entry->second.lru);
+                cached = entry->second.result;
+                ++shard.hits;
+                result_cache_counters.hits.fetch_add(1, std::memory_order_relaxed);
+            } else if (pending != shard.flights.end()) {
+                flight = pending->second;
+                ++shard.coalesced;
+                result_cache_counters.coalesced.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                if (cacheable) {
+                    flight = std::make_shared<ResultFlight>();
+                    shard.flights.emplace(key, flight);
+                    leader = true;
+                }
+                ++shard.misses;
+                result_cache_counters.misses.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        if (cached) {
+            OperationTimer timer(IMAGE_OP_RESULT_CACHE);
+            share_result(cached, result);
+            return timer.finish(SUCCESS, cached->size);
+        }
 
-    try {
-        // Create a new VImage instance from the byte buffer
-        VImage* img = new VImage(VImage::new_from_buffer(data, size, ""));
-        return static_cast<VImageHandle>(img);
-    } catch (const VError &e) {
-        std::cerr << "VIPS Error during image loading from bytes: " << e.what() << std::endl;
-        return nullptr;
+        if (flight && !leader) {
+            ImageStatus status;
+            {
+                OperationTimer timer(IMAGE_OP_RESULT_CACHE);
+                std::unique_lock<std::mutex> lock(flight->mutex);
+                flight->done_cv.wait(lock, [&flight]() { return flight->done; });
+                status = flight->status;
+                if (status == SUCCESS) {
+                    share_result(flight->result, result);
+                    return timer.finish(SUCCESS, flight->result->size);
+                }
+                timer.finish(status);
+            }
+            // Report the render's own failure, not the wait
+            last_error = flight->error;
+            return status;
+        }
+
+        CachedResultRef rendered;
+        ImageStatus status = render_cached_result(data, size, load, ops, n, out, &rendered);
+        if (leader) {
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.flights.erase(key);
+                if (status == SUCCESS) {
+                    try {
+                        result_cache_insert(&shard, key, rendered, results->shard_bytes);
+                    } catch (const std::bad_alloc &) {
+                        // Served without being stored
+                    }
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(flight->mutex);
+                flight->status = status;
+                flight->error = last_error;
+                flight->error.code = status;
+                flight->result = rendered;
+                flight->done = true;
+            }
+            flight->done_cv.notify_all();
+        }
+        if (status == SUCCESS) {
+            share_result(rendered, result);
+        }
+        return status;
     } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during image loading from bytes: " << e.what() << std::endl;
-        return nullptr;
-    } catch (const std::exception &e) {
-        std::cerr << "Standard exception during image loading from bytes: " << e.what() << std::endl;
-        return nullptr;
-    } catch (...) {
-        std::cerr << "Unknown error occurred while loading image from bytes." << std::endl;
-        return nullptr;
+        log_error("Memory allocation error during process_cached: ", e.what());
+        return fail(IMAGE_OP_RESULT_CACHE, MEMORY_ALLOCATION_FAILURE);
     }
 }
 
 /**
- * @brief Frees the memory associated with a VImageHandle.
- * @param handle The VImageHandle to free.
+ * @brief Drops a caller's reference to a cached output.
  */
-void free_vimage_handle(VImageHandle handle) {
-    if (handle) {
-        VImagePtr img_ptr(static_cast<VImage*>(handle)); // Use smart pointer for deletion
-        // img_ptr will be deleted automatically when it goes out of scope
+void release_cached_buffer(ImageCachedBuffer buffer) {
+    delete static_cast<CachedResultRef*>(buffer.ref);
+}
+
+/**
+ * @brief Returns the counters of a result cache, summed over its shards.
+ */
+ImageResultCacheStats result_cache_stats(ImageResultCacheHandle cache) {
+    ImageResultCacheStats stats{0, 0, 0, 0, 0, 0};
+    if (!cache) {
+        return stats;
     }
+    for (const auto& shard : static_cast<ResultCache*>(cache)->shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.entries += shard->entries.size();
+        stats.bytes += shard->bytes;
+        stats.hits += shard->hits;
+        stats.misses += shard->misses;
+        stats.coalesced += shard->coalesced;
+        stats.evictions += shard->evictions;
+    }
+    return stats;
 }
 
 /**
- * @brief Frees the data pointer within an ImageBuffer.
- * This should be used to free buffers returned by encode_to_jpeg/png.
- * @param buffer The ImageBuffer whose data pointer needs to be freed.
+ * @brief Frees a result cache; outputs still referenced by callers stay valid.
  */
-void free_image_buffer(ImageBuffer buffer) {
-    if (buffer.data) {
-        g_free(buffer.data);
-        buffer.data = nullptr; // Clear pointer after freeing
-        buffer.size = 0;
+void destroy_result_cache(ImageResultCacheHandle cache) {
+    if (!cache) {
+        return;
+    }
+    ResultCache* results = static_cast<ResultCache*>(cache);
+    for (const auto& shard : results->shards) {
+        result_cache_counters.entries.fetch_sub(shard->entries.size(), std::memory_order_relaxed);
+        result_cache_counters.bytes.fetch_sub(shard->bytes, std::memory_order_relaxed);
     }
+    delete results;
 }
 
 /**
- * @brief Resizes an image according to the specified options.
- * This function modifies the VImage associated with the handle in-place.
+ * @brief Copies the raw pixels of a rectangle into a caller-provided buffer, computing only that rectangle.
  *
- * @param handle The VImageHandle to be resized.
- * @param options The resize options including dimensions and aspect ratio maintenance.
+ * @param handle The image to read.
+ * @param x Left edge of the region.
+ * @param y Top edge of the region.
+ * @param width Region width.
+ * @param height Region height.
+ * @param out Destination buffer.
+ * @param capacity Size of the destination buffer in bytes.
+ * @param layout Receives the pixel layout, also when the buffer is too small (may be NULL).
  * @return SUCCESS on success, or an appropriate error code on failure.
  */
-ImageStatus resize_image(VImageHandle handle, ImageResizeOptions options) {
+ImageStatus fetch_region(const VImageHandle handle, int x, int y, int width, int height,
+                         unsigned char* out, size_t capacity, ImagePixelLayout* layout) {
+    OperationTimer timer(IMAGE_OP_TILES);
     if (!handle) {
-        std::cerr << "Error: Invalid VImage handle for resize operation." << std::endl;
-        return VIPS_INVALID_HANDLE;
+        log_error("Error: Invalid VImage handle for fetch_region.");
+        return timer.finish(VIPS_INVALID_HANDLE);
     }
-    if (options.width <= 0 && options.height <= 0) {
-        std::cerr << "Error: Invalid dimensions provided for resize (width and/or height must be positive)." << std::endl;
-        return IMAGE_INVALID_DIMENSIONS;
+    if (width <= 0 || height <= 0) {
+        log_error("Error: Region size must be positive, got ", width, "x", height, ".");
+        return timer.finish(IMAGE_INVALID_DIMENSIONS);
     }
 
-    try {
-        VImage* img = static_cast<VImage*>(handle);
-        VImage resized_img;
+    const VImage& img = *static_cast<const VImage*>(handle);
+    if (x < 0 || y < 0 || static_cast<long long>(x) + width > img.width() ||
+        static_cast<long long>(y) + height > img.height()) {
+        log_error("Error: Region ", width, "x", height, "+", x, "+", y, " lies outside the ", img.width(), "x",
+                  img.height(), " image.");
+        return timer.finish(IMAGE_INVALID_BOUNDS);
+    }
 
-        if (options.maintain_aspect) {
-            double scale = 1.0;
-            // Calculate scale factor while maintaining aspect ratio
-            if (options.width > 0 && options.height > 0) {
-                scale = std::min(static_cast<double>(options.width) / img->width(),
-                                 static_cast<double>(options.height) / img->height());
-            } else if (options.width > 0) {
-                scale = static_cast<double>(options.width) / img->width();
-            } else { // options.height > 0
-                scale = static_cast<double>(options.height) / img->height();
-            }
-            resized_img = img->resize(scale, VImage::option()->set("kernel", VIPS_KERNEL_LANCZOS3));
-        } else {
-            // Calculate independent scales for width and height
-            double scale_x = (options.width > 0) ? static_cast<double>(options.width) / img->width() : 1.0;
-            double scale_y = (options.height > 0) ? static_cast<double>(options.height) / img->height() : 1.0;
-
-            // If one dimension is not specified, use the scale of the other to maintain proportion if no aspect constraint
-            if (options.width <= 0) {
-                scale_x = scale_y;
-            } else if (options.height <= 0) {
-                scale_y = scale_x;
-            }
+    size_t bytes_per_pixel = VIPS_IMAGE_SIZEOF_PEL(img.get_image());
+    size_t stride = bytes_per_pixel * static_cast<size_t>(width);
+    size_t needed = stride * static_cast<size_t>(height);
+    if (layout) {
+        *layout = ImagePixelLayout{width, height, img.bands(), static_cast<ImageSampleFormat>(img.format()),
+                                   bytes_per_pixel, stride};
+    }
+    if (!out || capacity < needed) {
+        set_error_message("Region needs ", needed, " bytes, buffer has ", capacity, ".");
+        return timer.finish(IMAGE_BUFFER_TOO_SMALL);
+    }
 
-            resized_img = img->resize(scale_x, VImage::option()
-                ->set("kernel", VIPS_KERNEL_LANCZOS3)
-                ->set("vscale", scale_y));
+    try {
+        // The region asks the pipeline for these pixels only; tiled sources read just the tiles under it
+        VRegion region = VRegion::new_from_image(ensure_random_access(img));
+        region.prepare(x, y, width, height);
+        for (int row = 0; row < height; ++row) {
+            std::memcpy(out + row * stride, region.addr(x, y + row), stride);
         }
-
-        // Overwrite the original VImage object with the resized one
-        *img = resized_img;
-        return SUCCESS;
+        return timer.finish(SUCCESS, needed);
     } catch (const VError &e) {
-        std::cerr << "VIPS Error during resize_image: " << e.what() << std::endl;
-        return VIPS_ERROR;
+        log_error("VIPS Error during fetch_region: ", e.what());
+        return timer.finish(VIPS_ERROR);
     } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during resize_image: " << e.what() << std::endl;
-        return MEMORY_ALLOCATION_FAILURE;
+        log_error("Memory allocation error during fetch_region: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
     } catch (const std::exception &e) {
-        std::cerr << "Standard exception during resize_image: " << e.what() << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Standard exception during fetch_region: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
     } catch (...) {
-        std::cerr << "Unknown error occurred during resize_image." << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Unknown error occurred during fetch_region.");
+        return timer.finish(UNKNOWN_ERROR);
     }
 }
 
 /**
- * @brief Crops an image to the specified rectangle.
- * This function modifies the VImage associated with the handle in-place.
+ * @brief Writes a tile pyramid of the image with dzsave, in a single top-to-bottom pass.
  *
- * @param handle The VImageHandle to be cropped.
- * @param options The crop options including x and y coordinates, width and height.
+ * @param handle The image to tile.
+ * @param path Output name without extension.
+ * @param options Layout, tile geometry and tile encoding.
  * @return SUCCESS on success, or an appropriate error code on failure.
  */
-ImageStatus crop_image(VImageHandle handle, ImageCropOptions options) {
+ImageStatus generate_tile_pyramid(const VImageHandle handle, const char* path, ImageTilePyramidOptions options) {
+    OperationTimer timer(IMAGE_OP_TILES);
     if (!handle) {
-        std::cerr << "Error: Invalid VImage handle for crop operation." << std::endl;
-        return VIPS_INVALID_HANDLE;
+        log_error("Error: Invalid VImage handle for generate_tile_pyramid.");
+        return timer.finish(VIPS_INVALID_HANDLE);
     }
-    if (options.width <= 0 || options.height <= 0) {
-        std::cerr << "Error: Invalid dimensions provided for crop (width and height must be positive)." << std::endl;
-        return IMAGE_INVALID_DIMENSIONS;
+    if (!path || path[0] == '\0') {
+        log_error("Error: Output path for generate_tile_pyramid is null or empty.");
+        return timer.finish(IMAGE_INVALID_PATH);
     }
-    if (options.x < 0 || options.y < 0) {
-        std::cerr << "Error: Invalid position provided for crop (x and y must be non-negative)." << std::endl;
-        return IMAGE_INVALID_POSITION;
+
+    VipsForeignDzLayout layout;
+    std::string suffix = tile_suffix(options.tiles);
+    if (!tile_layout(options.layout, &layout) || suffix.empty()) {
+        log_error("Error: Unsupported tile layout ", options.layout, " or tile format ", options.tiles.format, ".");
+        return timer.finish(IMAGE_INVALID_FORMAT);
+    }
+    int tile_size = options.tile_size > 0 ? options.tile_size : (layout == VIPS_FOREIGN_DZ_LAYOUT_DZ ? 254 : 256);
+    if (options.tile_size < 0 || options.overlap < 0 || options.overlap >= tile_size) {
+        log_error("Error: Invalid tile size ", options.tile_size, " or overlap ", options.overlap, ".");
+        return timer.finish(IMAGE_INVALID_DIMENSIONS);
+    }
+    VipsForeignDzDepth depth = VIPS_FOREIGN_DZ_DEPTH_ONEPIXEL;
+    if (options.depth == IMAGE_TILE_DEPTH_ONETILE) {
+        depth = VIPS_FOREIGN_DZ_DEPTH_ONETILE;
+    } else if (options.depth == IMAGE_TILE_DEPTH_ONE) {
+        depth = VIPS_FOREIGN_DZ_DEPTH_ONE;
     }
 
     try {
-        VImage* img = static_cast<VImage*>(handle);
-
-        // Validate crop bounds against image dimensions
-        if (static_cast<long long>(options.x) + options.width > img->width() ||
-            static_cast<long long>(options.y) + options.height > img->height()) {
-            std::cerr << "Error: Crop area extends beyond image boundaries." << std::endl;
-            return IMAGE_INVALID_BOUNDS;
-        }
-
-        VImage cropped_img = img->crop(options.x, options.y, options.width, options.height);
-
-        // Overwrite the original VImage object with the cropped one
-        *img = cropped_img;
-        return SUCCESS;
+        // dzsave reads strips top to bottom, so sequential images need no in-memory copy
+        static_cast<const VImage*>(handle)->dzsave(path, VImage::option()
+            ->set("layout", layout)
+            ->set("tile_size", tile_size)
+            ->set("overlap", options.overlap)
+            ->set("depth", depth)
+            ->set("suffix", suffix.c_str()));
+        return timer.finish(SUCCESS);
     } catch (const VError &e) {
-        std::cerr << "VIPS Error during crop_image: " << e.what() << std::endl;
-        return VIPS_ERROR;
+        log_error("VIPS Error during generate_tile_pyramid: ", e.what());
+        return timer.finish(IMAGE_SAVE_FAILURE);
     } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during crop_image: " << e.what() << std::endl;
-        return MEMORY_ALLOCATION_FAILURE;
+        log_error("Memory allocation error during generate_tile_pyramid: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
     } catch (const std::exception &e) {
-        std::cerr << "Standard exception during crop_image: " << e.what() << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Standard exception during generate_tile_pyramid: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
     } catch (...) {
-        std::cerr << "Unknown error occurred during crop_image." << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Unknown error occurred during generate_tile_pyramid.");
+        return timer.finish(UNKNOWN_ERROR);
     }
 }
 
 /**
- * @brief Rotates an image by the specified angle in degrees.
- * This function modifies the VImage associated with the handle in-place.
+ * @brief Wraps raw interleaved pixels as an image, copying them or taking ownership of them.
  *
- * @param handle The VImageHandle to be rotated.
- * @param options The rotation options including the angle.
- * @return SUCCESS on success, or an appropriate error code on failure.
+ * @param pixels Interleaved pixel data.
+ * @param size Size of the pixel data in bytes.
+ * @param width Image width.
+ * @param height Image height.
+ * @param bands Samples per pixel.
+ * @param format Sample type.
+ * @param release Callback that returns the pixels to their owner, or null to copy them.
+ * @param user_data Opaque pointer passed through to the release callback.
+ * @param status Receives SUCCESS or the failure code; may be null.
+ * @return A VImageHandle on success, nullptr on failure. The caller is responsible for freeing
+ *         the handle using `free_vimage_handle`.
  */
-ImageStatus rotate_image(VImageHandle handle, ImageRotateOptions options) {
-    if (!handle) {
-        std::cerr << "Error: Invalid VImage handle for rotate operation." << std::endl;
-        return VIPS_INVALID_HANDLE;
+VImageHandle load_image_from_memory(const void* pixels, size_t size, int width, int height, int bands,
+                                    ImageSampleFormat format, ImageBufferReleaseFn release, void* user_data,
+                                    ImageStatus* status) {
+    OperationTimer timer(IMAGE_OP_LOAD, size, status);
+    auto reject = [&](ImageStatus code) -> VImageHandle {
+        if (release) {
+            release(const_cast<void*>(pixels), user_data);
+        }
+        return timer.fail(code, nullptr);
+    };
+    if (!pixels) {
+        log_error("Error: Pixel data is null.");
+        return reject(IMAGE_LOAD_FAILURE);
+    }
+    if (width <= 0 || height <= 0 || bands <= 0) {
+        log_error("Error: Invalid raw image shape ", width, "x", height, "x", bands, ".");
+        return reject(IMAGE_INVALID_DIMENSIONS);
+    }
+    if (format < IMAGE_SAMPLE_UCHAR || format > IMAGE_SAMPLE_DPCOMPLEX) {
+        log_error("Error: Unknown sample format ", format, ".");
+        return reject(IMAGE_INVALID_FORMAT);
+    }
+
+    VipsBandFormat band_format = static_cast<VipsBandFormat>(format);
+    size_t needed = static_cast<size_t>(width) * height * bands * vips_format_sizeof(band_format);
+    if (size < needed) {
+        log_error("Error: ", width, "x", height, "x", bands, " pixels need ", needed, " bytes, got ", size, ".");
+        return reject(IMAGE_BUFFER_TOO_SMALL);
     }
 
+    OwnedBuffer* owned = nullptr;
     try {
-        VImage* img = static_cast<VImage*>(handle);
+        VImage raw;
+        if (release) {
+            owned = new OwnedBuffer{static_cast<const unsigned char*>(pixels), release, user_data};
+            raw = VImage::new_from_memory(pixels, size, width, height, bands, band_format);
 
-        std::vector<double> background_color;
-        // Determine background color based on image properties
-        if (img->has_alpha()) {
-            background_color = {0.0, 0.0, 0.0, 0.0}; // Transparent black
-        } else if (img->bands() >= 3) {
-            background_color = {255.0, 255.0, 255.0}; // White
+            // From here on libvips decides when the pixels are released
+            g_signal_connect(raw.get_image(), "postclose", G_CALLBACK(release_owned_buffer), owned);
+            owned = nullptr;
         } else {
-            background_color = {0.0}; // Black (grayscale)
+            raw = VImage::new_from_memory_copy(pixels, size, width, height, bands, band_format);
         }
 
-        VImage rotated_img = img->rotate(options.angle, VImage::option()
-            ->set("background", background_color));
-
-        // Overwrite the original VImage object with the rotated one
-        *img = rotated_img;
-        return SUCCESS;
+        VImage tagged = raw.copy(VImage::option()->set("interpretation", raw_interpretation(bands, band_format)));
+        VImage* img = new VImage(tagged);
+        return timer.succeed(static_cast<VImageHandle>(img));
     } catch (const VError &e) {
-        std::cerr << "VIPS Error during rotate_image: " << e.what() << std::endl;
-        return VIPS_ERROR;
+        log_error("VIPS Error during image loading from memory: ", e.what());
+        timer.fail(IMAGE_LOAD_FAILURE);
     } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during rotate_image: " << e.what() << std::endl;
-        return MEMORY_ALLOCATION_FAILURE;
+        log_error("Memory allocation error during image loading from memory: ", e.what());
+        timer.fail(MEMORY_ALLOCATION_FAILURE);
     } catch (const std::exception &e) {
-        std::cerr << "Standard exception during rotate_image: " << e.what() << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Standard exception during image loading from memory: ", e.what());
+        timer.fail(UNKNOWN_ERROR);
     } catch (...) {
-        std::cerr << "Unknown error occurred during rotate_image." << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Unknown error occurred while loading image from memory.");
+        timer.fail(UNKNOWN_ERROR);
+    }
+
+    // Ownership was transferred on entry; release now unless libvips already holds the pixels
+    if (owned) {
+        delete owned;
+        release(const_cast<void*>(pixels), user_data);
     }
+    return nullptr;
 }
 
 /**
- * @brief Applies a watermark image to a base image.
- * This function modifies the base VImage associated with the handle in-place.
+ * @brief Streams the image into a caller buffer as an interleaved or planar tensor.
  *
- * @param base_handle The VImageHandle of the base image.
- * @param watermark_handle The VImageHandle of the watermark image.
- * @param options Watermark options including position and opacity.
+ * The cast, normalisation and pending operations run as one libvips pipeline; vips_sink_disc()
+ * hands each computed strip to write_tensor_strip(), which copies or deinterleaves it into place.
+ *
+ * @param handle The image to write.
+ * @param spec Layout, sample type and normalisation.
+ * @param out Destination buffer.
+ * @param capacity Size of the destination buffer in bytes.
+ * @param out_size Receives the size the tensor needs, also when the buffer is too small (may be NULL).
  * @return SUCCESS on success, or an appropriate error code on failure.
  */
-ImageStatus watermark_image(VImageHandle base_handle, VImageHandle watermark_handle, ImageWatermarkOptions options) {
-    if (!base_handle || !watermark_handle) {
-        std::cerr << "Error: Invalid VImage handle(s) for watermark operation." << std::endl;
-        return VIPS_INVALID_HANDLE;
+ImageStatus write_to_memory(const VImageHandle handle, ImageTensorSpec spec, void* out, size_t capacity,
+                            size_t* out_size) {
+    OperationTimer timer(IMAGE_OP_TENSOR);
+    if (!handle) {
+        log_error("Error: Invalid VImage handle for write_to_memory.");
+        return timer.finish(VIPS_INVALID_HANDLE);
+    }
+    if ((spec.format != IMAGE_SAMPLE_UCHAR && spec.format != IMAGE_SAMPLE_FLOAT) ||
+        (spec.order != IMAGE_TENSOR_HWC && spec.order != IMAGE_TENSOR_CHW)) {
+        log_error("Error: Unsupported tensor sample format ", spec.format, " or order ", spec.order, ".");
+        return timer.finish(IMAGE_INVALID_FORMAT);
     }
 
-    // Ensure opacity is within valid range [0.0, 1.0]
-    options.opacity = std::max(0.0, std::min(1.0, options.opacity));
+    const VImage& img = *static_cast<const VImage*>(handle);
+    int bands = img.bands();
+    VipsBandFormat target = static_cast<VipsBandFormat>(spec.format);
+    size_t sample_size = vips_format_sizeof(target);
+    size_t packed_row = static_cast<size_t>(img.width()) * (spec.order == IMAGE_TENSOR_HWC ? bands : 1) * sample_size;
+    size_t row_stride = spec.row_stride ? spec.row_stride : packed_row;
+    if (row_stride < packed_row || row_stride % sample_size != 0 ||
+        reinterpret_cast<uintptr_t>(out) % sample_size != 0) {
+        log_error("Error: Tensor row stride ", row_stride, " is below ", packed_row,
+                  " bytes or the output is not aligned to ", sample_size, " bytes.");
+        return timer.finish(IMAGE_INVALID_DIMENSIONS);
+    }
 
-    try {
-        VImage* base_img = static_cast<VImage*>(base_handle);
-        VImage* watermark_img = static_cast<VImage*>(watermark_handle);
+    size_t plane_size = row_stride * img.height();
+    size_t needed = spec.order == IMAGE_TENSOR_CHW ? plane_size * bands : plane_size;
+    if (out_size) {
+        *out_size = needed;
+    }
+    if (!out || capacity < needed) {
+        set_error_message("Tensor needs ", needed, " bytes, buffer has ", capacity, ".");
+        return timer.finish(IMAGE_BUFFER_TOO_SMALL);
+    }
 
-        VImage watermark_copy = *watermark_img;
+    double scale = spec.scale != 0.0f ? spec.scale : 1.0;
+    bool per_band = false;
+    for (int b = 0; b < 4; ++b) {
+        per_band |= spec.mean[b] != 0.0f || (spec.std[b] != 0.0f && spec.std[b] != 1.0f);
+    }
+    if (per_band && bands > 4) {
+        log_error("Error: Mean and std cover 4 bands, the image has ", bands, ".");
+        return timer.finish(IMAGE_INVALID_DIMENSIONS);
+    }
 
-        // Ensure watermark has an alpha channel for blending, add one if missing
-        if (!watermark_copy.has_alpha()) {
-            watermark_copy = watermark_copy.bandjoin(255); // Add opaque alpha channel
+    try {
+        VImage tensor = img;
+        if (per_band) {
+            std::vector<double> a(bands), b(bands);
+            for (int i = 0; i < bands; ++i) {
+                double std_dev = spec.std[i] != 0.0f ? spec.std[i] : 1.0;
+                a[i] = scale / std_dev;
+                b[i] = -spec.mean[i] / std_dev;
+            }
+            tensor = tensor.linear(a, b, VImage::option()->set("uchar", target == VIPS_FORMAT_UCHAR));
+        } else if (scale != 1.0) {
+            tensor = tensor.linear(scale, 0.0, VImage::option()->set("uchar", target == VIPS_FORMAT_UCHAR));
         }
-
-        // Apply opacity to the watermark's alpha channel if less than 1.0
-        if (options.opacity < 1.0) {
-            VImage alpha_channel = watermark_copy.extract_band(watermark_copy.bands() - 1);
-            VImage scaled_alpha = alpha_channel * options.opacity;
-            watermark_copy = watermark_copy.extract_band(0, VImage::option()->set("n", watermark_copy.bands() - 1))
-                       .bandjoin(scaled_alpha);
+        if (tensor.format() != target) {
+            tensor = tensor.cast(target);
         }
 
-        // Composite the watermark onto the base image
-        VImage result_img = base_img->composite2(watermark_copy, VIPS_BLEND_MODE_OVER,
-            VImage::option()->set("x", options.x)->set("y", options.y));
-
-        // Overwrite the original base VImage object with the watermarked one
-        *base_img = result_img;
-        return SUCCESS;
+        TensorSink sink{static_cast<unsigned char*>(out), row_stride,
+                        spec.order == IMAGE_TENSOR_CHW ? plane_size : 0, sample_size, bands};
+        if (vips_sink_disc(tensor.get_image(), write_tensor_strip, &sink) != 0) {
+            log_error("VIPS Error during write_to_memory: ", vips_error_buffer());
+            vips_error_clear();
+            return timer.finish(VIPS_ERROR);
+        }
+        return timer.finish(SUCCESS, needed);
     } catch (const VError &e) {
-        std::cerr << "VIPS Error during watermark_image: " << e.what() << std::endl;
-        return VIPS_ERROR;
+        log_error("VIPS Error during write_to_memory: ", e.what());
+        return timer.finish(VIPS_ERROR);
     } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during watermark_image: " << e.what() << std::endl;
-        return MEMORY_ALLOCATION_FAILURE;
+        log_error("Memory allocation error during write_to_memory: ", e.what());
+        return timer.finish(MEMORY_ALLOCATION_FAILURE);
     } catch (const std::exception &e) {
-        std::cerr << "Standard exception during watermark_image: " << e.what() << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Standard exception during write_to_memory: ", e.what());
+        return timer.finish(UNKNOWN_ERROR);
     } catch (...) {
-        std::cerr << "Unknown error occurred during watermark_image." << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Unknown error occurred during write_to_memory.");
+        return timer.finish(UNKNOWN_ERROR);
     }
 }
 
 /**
- * @brief Changes the overall opacity of an image.
- * This function modifies the VImage associated with the handle in-place.
+ * @brief Creates a cancel token, optionally with a deadline.
  *
- * @param handle The VImageHandle of the image to modify.
- * @param options Opacity options including the desired opacity level.
- * @return SUCCESS on success, or an appropriate error code on failure.
+ * @param timeout_ms Milliseconds from now until the token cancels itself; 0 for none.
+ * @return The token handle, or nullptr if out of memory. Free it with `free_cancel_token`.
  */
-ImageStatus change_image_opacity(VImageHandle handle, ImageOpacityOptions options) {
-    if (!handle) {
-        std::cerr << "Error: Invalid VImage handle for opacity change operation." << std::endl;
-        return VIPS_INVALID_HANDLE;
-    }
-
-    // Ensure opacity is within valid range [0.0, 1.0]
-    options.opacity = std::max(0.0, std::min(1.0, options.opacity));
-
+ImageCancelHandle create_cancel_token(int64_t timeout_ms) {
     try {
-        VImage* img = static_cast<VImage*>(handle);
-        VImage img_copy = *img; // Work on a copy to avoid partial modifications on error
-
-        // Add an alpha channel if the image doesn't have one
-        if (!img_copy.has_alpha()) {
-            img_copy = img_copy.bandjoin(255); // Add an opaque alpha channel
+        CancelRef token = std::make_shared<CancelToken>();
+        token->deadline = 0;
+        if (timeout_ms > 0) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            token->deadline = deadline.time_since_epoch().count();
+        } else if (timeout_ms < 0) {
+            token->cancelled.store(true);
         }
-
-        // Extract and scale the alpha channel
-        VImage alpha_channel = img_copy.extract_band(img_copy.bands() - 1);
-        VImage scaled_alpha = alpha_channel * options.opacity;
-
-        // Recombine the color bands with the new alpha channel
-        VImage result_img = img_copy.extract_band(0, VImage::option()->set("n", img_copy.bands() - 1))
-                       .bandjoin(scaled_alpha);
-
-        // Overwrite the original VImage object with the modified one
-        *img = result_img;
-        return SUCCESS;
-    } catch (const VError &e) {
-        std::cerr << "VIPS Error during change_image_opacity: " << e.what() << std::endl;
-        return VIPS_ERROR;
+        return static_cast<ImageCancelHandle>(new CancelRef(std::move(token)));
     } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during change_image_opacity: " << e.what() << std::endl;
-        return MEMORY_ALLOCATION_FAILURE;
-    } catch (const std::exception &e) {
-        std::cerr << "Standard exception during change_image_opacity: " << e.what() << std::endl;
-        return UNKNOWN_ERROR;
-    } catch (...) {
-        std::cerr << "Unknown error occurred during change_image_opacity." << std::endl;
-        return UNKNOWN_ERROR;
+        log_error("Memory allocation error during create_cancel_token: ", e.what());
+        return nullptr;
     }
 }
 
 /**
- * @brief Extracts metadata from a VImage handle.
- * @param handle The VImageHandle from which to extract metadata.
- * @return An ImageMeta struct containing the extracted metadata.
+ * @brief Cancels a token; renders using it stop at their next strip.
+ *
+ * @param token The token to cancel.
  */
-ImageMeta extract_metadata(const VImageHandle handle) {
-    ImageMeta meta = {0}; // Initialize all members to zero/null
-    if (!handle) {
-        std::cerr << "Warning: Invalid VImage handle provided for metadata extraction." << std::endl;
-        return meta;
+void cancel_token_cancel(ImageCancelHandle token) {
+    if (token) {
+        (*static_cast<CancelRef*>(token))->cancelled.store(true, std::memory_order_relaxed);
     }
+}
 
-    const VImage* img = static_cast<const VImage*>(handle);
-
-    meta.width = img->width();
-    meta.height = img->height();
-    meta.channels = img->bands();
-
-    // Safely retrieve and copy format string
-    try {
-        std::string format_str = img->get_string("vips-loader");
-        std::strncpy(meta.format, format_str.c_str(), sizeof(meta.format) - 1);
-        meta.format[sizeof(meta.format) - 1] = '\0';
-    } catch (const VError &e) {
-        std::cerr << "VIPS Error getting image format: " << e.what() << std::endl;
-        std::strncpy(meta.format, "unknown", sizeof(meta.format) - 1);
-        meta.format[sizeof(meta.format) - 1] = '\0';
-    }
+/**
+ * @brief Reports whether a token has been cancelled or has passed its deadline.
+ *
+ * @param token The token to check.
+ * @return 1 if cancelled, 0 otherwise.
+ */
+int cancel_token_is_cancelled(ImageCancelHandle token) {
+    return token && cancel_requested(**static_cast<CancelRef*>(token)) ? 1 : 0;
+}
 
-    // Safely retrieve and copy colorspace string
-    try {
-        VipsInterpretation interp = img->interpretation();
-        const char* colorspace_name = vips_enum_nick(VIPS_TYPE_INTERPRETATION, interp);
-        if (colorspace_name) {
-            std::strncpy(meta.colorspace, colorspace_name, sizeof(meta.colorspace) - 1);
-            meta.colorspace[sizeof(meta.colorspace) - 1] = '\0';
-        } else {
-            std::strncpy(meta.colorspace, "unknown", sizeof(meta.colorspace) - 1);
-            meta.colorspace[sizeof(meta.colorspace) - 1] = '\0';
-        }
-    } catch (const VError &e) {
-        std::cerr << "VIPS Error getting image colorspace: " << e.what() << std::endl;
-        std::strncpy(meta.colorspace, "unknown", sizeof(meta.colorspace) - 1);
-        meta.colorspace[sizeof(meta.colorspace) - 1] = '\0';
-    }
+/**
+ * @brief Releases the handle's reference to a token; running renders keep theirs.
+ *
+ * @param token The token to release.
+ */
+void free_cancel_token(ImageCancelHandle token) {
+    delete static_cast<CancelRef*>(token);
+}
 
-    // Safely retrieve density (DPI)
-    try {
-        meta.density_x = img->xres();
-        meta.density_y = img->yres();
-    } catch (const VError &e) {
-        std::cerr << "VIPS Error getting image density: " << e.what() << std::endl;
-        meta.density_x = 72.0; // Default DPI
-        meta.density_y = 72.0;
+/**
+ * @brief Runs a pipeline and its encode, stopping early once `cancel` is cancelled.
+ *
+ * @param handle The VImageHandle of the source image.
+ * @param ops Array of operations to apply, in order.
+ * @param n Number of operations in `ops`.
+ * @param out Output format and encoder options.
+ * @param result Receives the encoded bytes; free with `free_image_buffer`.
+ * @param cancel The cancel token, or nullptr.
+ * @return SUCCESS on success, IMAGE_CANCELLED if cancelled, or an appropriate error code on failure.
+ */
+ImageStatus process_pipeline_cancellable(VImageHandle handle, const ImagePipelineOp* ops, size_t n,
+                                         ImageEncodeSpec out, ImageBuffer* result, ImageCancelHandle cancel) {
+    if (!cancel) {
+        return process_pipeline(handle, ops, n, out, result);
     }
-
-    meta.file_size = 0; // This field is typically populated after encoding to a file/buffer
-
-    return meta;
+    ImageRunOptions run = {};
+    run.cancel = cancel;
+    return process_pipeline_ex(handle, ops, n, out, result, &run);
 }
 
 /**
- * @brief Encodes the image to JPEG format and returns the encoded data in a buffer.
- * The caller is responsible for freeing the `data` pointer of the returned `EncodedImage`.
+ * @brief Enables, changes or disables (with nullptr) the adaptive thread scheduler.
  *
- * @param handle The VImageHandle of the image to encode.
- * @param options JPEG encoding options (quality, interlacing).
- * @return An EncodedImage struct containing the buffer and its size, or {nullptr, 0} on failure.
+ * @param options The scheduler settings, or nullptr to disable it.
  */
-ImageBuffer encode_to_jpeg(const VImageHandle handle, ImageEncodeJPEGOptions options) {
-    if (!handle) {
-        std::cerr << "Error: Invalid VImage handle for JPEG encoding." << std::endl;
-        return ImageBuffer{nullptr, 0};
+void vips_wrapper_set_scheduler(const ImageSchedulerOptions* options) {
+    std::lock_guard<std::mutex> lock(scheduler.mutex);
+    scheduler.options = options ? *options : ImageSchedulerOptions{};
+    if (scheduler.options.pixels_per_thread <= 0) {
+        scheduler.options = ImageSchedulerOptions{};
     }
+}
 
-    void* buf = nullptr;
-    size_t buf_size = 0;
-    const VImage* img = static_cast<const VImage*>(handle);
-
-    try {
-        VOption* option = VImage::option();
-        if (options.quality > 0 && options.quality <= 100) {
-            option->set("Q", options.quality);
-        } else {
-            option->set("Q", 75); // Default JPEG quality
-        }
-        option->set("interlace", options.interlace != 0);
-
-        // Write the image to a buffer in JPEG format
-        img->write_to_buffer(".jpg", &buf, &buf_size, option);
-
-        // The buffer returned by write_to_buffer is managed by GLib, so we transfer ownership
-        return ImageBuffer{static_cast<unsigned char*>(buf), buf_size};
-    } catch (const VError &e) {
-        std::cerr << "VIPS Error during JPEG encoding: " << e.what() << std::endl;
-        if (buf) g_free(buf); // Ensure buffer is freed on error
-        return ImageBuffer{nullptr, 0};
-    } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during JPEG encoding: " << e.what() << std::endl;
-        if (buf) g_free(buf);
-        return ImageBuffer{nullptr, 0};
-    } catch (const std::exception &e) {
-        std::cerr << "Standard exception during JPEG encoding: " << e.what() << std::endl;
-        if (buf) g_free(buf);
-        return ImageBuffer{nullptr, 0};
-    } catch (...) {
-        std::cerr << "Unknown error occurred during JPEG encoding." << std::endl;
-        if (buf) g_free(buf);
-        return ImageBuffer{nullptr, 0};
+/**
+ * @brief Reports the scheduler settings and the threads held by running renders.
+ *
+ * @param options Receives the settings, or nullptr.
+ * @return The number of threads currently handed out.
+ */
+int vips_wrapper_get_scheduler(ImageSchedulerOptions* options) {
+    std::lock_guard<std::mutex> lock(scheduler.mutex);
+    if (options) {
+        *options = scheduler.options;
     }
+    return scheduler.in_use;
 }
 
 /**
- * @brief Encodes the image to PNG format and returns the encoded data in a buffer.
- * The caller is responsible for freeing the `data` pointer of the returned `EncodedImage`.
+ * @brief Runs a pipeline and its encode with the per-call controls in `run`.
  *
- * @param handle The VImageHandle of the image to encode.
- * @param options PNG encoding options (compression, interlacing).
- * @return An EncodedImage struct containing the buffer and its size, or {nullptr, 0} on failure.
+ * @param handle The VImageHandle of the source image.
+ * @param ops Array of operations to apply, in order.
+ * @param n Number of operations in `ops`.
+ * @param out Output format and encoder options.
+ * @param result Receives the encoded bytes; free with `free_image_buffer`.
+ * @param run Cancel token, thread count and progress callback, or nullptr.
+ * @return SUCCESS on success, IMAGE_CANCELLED if cancelled, or an appropriate error code on failure.
  */
-ImageBuffer encode_to_png(const VImageHandle handle, ImageEncodePNGOptions options) {
+ImageStatus process_pipeline_ex(VImageHandle handle, const ImagePipelineOp* ops, size_t n, ImageEncodeSpec out,
+                                ImageBuffer* result, const ImageRunOptions* run) {
+    if (!run) {
+        return process_pipeline(handle, ops, n, out, result);
+    }
     if (!handle) {
-        std::cerr << "Error: Invalid VImage handle for PNG encoding." << std::endl;
-        return ImageBuffer{nullptr, 0};
+        log_error("Error: Invalid VImage handle for pipeline.");
+        return fail(IMAGE_OP_PIPELINE, VIPS_INVALID_HANDLE);
     }
-
-    void* buf = nullptr;
-    size_t buf_size = 0;
-    const VImage* img = static_cast<const VImage*>(handle);
-
-    try {
-        VOption* option = VImage::option();
-        // Validate compression level, default to 6 if invalid
-        if (options.compression < 0 || options.compression > 9) {
-            options.compression = 6;
-        }
-        option->set("compression", options.compression);
-        option->set("interlace", options.interlace != 0);
-
-        // Write the image to a buffer in PNG format
-        img->write_to_buffer(".png", &buf, &buf_size, option);
-
-        // The buffer returned by write_to_buffer is managed by GLib, so we transfer ownership
-        return ImageBuffer{static_cast<unsigned char*>(buf), buf_size};
-    } catch (const VError &e) {
-        std::cerr << "VIPS Error during PNG encoding: " << e.what() << std::endl;
-        if (buf) g_free(buf); // Ensure buffer is freed on error
-        return ImageBuffer{nullptr, 0};
-    } catch (const std::bad_alloc &e) {
-        std::cerr << "Memory allocation error during PNG encoding: " << e.what() << std::endl;
-        if (buf) g_free(buf);
-        return ImageBuffer{nullptr, 0};
-    } catch (const std::exception &e) {
-        std::cerr << "Standard exception during PNG encoding: " << e.what() << std::endl;
-        if (buf) g_free(buf);
-        return ImageBuffer{nullptr, 0};
-    } catch (...) {
-        std::cerr << "Unknown error occurred during PNG encoding." << std::endl;
-        if (buf) g_free(buf);
-        return ImageBuffer{nullptr, 0};
+    if (!ops && n > 0) {
+        log_error("Error: Pipeline operations are null.");
+        return fail(IMAGE_OP_PIPELINE, UNKNOWN_ERROR);
     }
+    const char* suffix = format_suffix(out.format);
+    if (out.format != IMAGE_FORMAT_NONE && (!suffix || !result)) {
+        log_error("Error: Invalid output format or result buffer for pipeline.");
+        return fail(IMAGE_OP_PIPELINE, IMAGE_INVALID_FORMAT);
+    }
+
+    return run_pipeline(*static_cast<VImage*>(handle), ops, n, out, result, run);
 }
 
 } // extern "C"
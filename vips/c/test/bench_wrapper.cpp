@@ -0,0 +1,798 @@
+/**
+ * @file bench_wrapper.cpp
+ * @brief Google Benchmark suite for the vips wrapper entry points
+ *
+ * Covers the loaders, every transform and both encoders across a matrix of
+ * synthetic source images (0.3MP-50MP, JPEG/PNG, 1/3/4 bands); benchmarks on
+ * decoded pixels use the PNG sources only. Each result reports throughput
+ * (MP/s) and the peak RSS of its own run; on glibc, allocations per
+ * iteration and peak heap use are recorded through a malloc-counting
+ * MemoryManager.
+ *
+ * Run with JSON output for regression tracking:
+ * @code
+ * ./bench_wrapper --benchmark_out=bench_wrapper.json --benchmark_out_format=json
+ * ./bench_wrapper --benchmark_filter=EncodeToJPEG --benchmark_repetitions=5
+ * @endcode
+ */
+#include "vips_wrapper.h"
+#include <benchmark/benchmark.h>
+#include <vips/vips8>
+#include <sys/resource.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace vips;
+
+namespace {
+
+//=============================================================================
+// ALLOCATION COUNTING
+//=============================================================================
+
+#if defined(__GLIBC__)
+// Counters updated by the malloc interposers below while a benchmark's memory run is active
+std::atomic<bool> g_recording{false};
+std::atomic<int64_t> g_allocs{0};
+std::atomic<int64_t> g_allocated_bytes{0};
+std::atomic<int64_t> g_live_bytes{0};
+std::atomic<int64_t> g_peak_bytes{0};
+
+void record_alloc(void* ptr) {
+    if (!ptr || !g_recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+    int64_t size = static_cast<int64_t>(malloc_usable_size(ptr));
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    int64_t live = g_live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    int64_t peak = g_peak_bytes.load(std::memory_order_relaxed);
+    while (live > peak && !g_peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void record_free(void* ptr) {
+    if (!ptr || !g_recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+    g_live_bytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+}
+
+// Feeds the interposer counters to Google Benchmark's allocs_per_iter / max_bytes_used
+class MallocCounter : public benchmark::MemoryManager {
+public:
+    void Start() override {
+        g_allocs = 0;
+        g_allocated_bytes = 0;
+        g_live_bytes = 0;
+        g_peak_bytes = 0;
+        g_recording = true;
+    }
+
+    void Stop(Result& result) override {
+        g_recording = false;
+        result.num_allocs = g_allocs.load();
+        result.max_bytes_used = g_peak_bytes.load();
+        result.total_allocated_bytes = g_allocated_bytes.load();
+        result.net_heap_growth = g_live_bytes.load();
+    }
+
+    // Pure virtual until Google Benchmark 1.8
+    void Stop(Result* result) { Stop(*result); }
+};
+#endif
+
+//=============================================================================
+// SOURCE IMAGES
+//=============================================================================
+
+enum SourceFormat { SOURCE_JPEG = 0, SOURCE_PNG = 1 };
+
+// A synthetic source image, encoded to a file and to memory
+struct Source {
+    std::string path;
+    std::vector<unsigned char> bytes;
+    VImage decoded;     // Pixels in memory, for transform and encoder benchmarks
+};
+
+/**
+ * @brief Builds a photo-like test image: a zone plate with per-band noise.
+ */
+VImage synthesize(int width, int height, int bands) {
+    VImage pattern = VImage::zone(width, height) * 80 + 128;
+    std::vector<VImage> planes;
+    for (int b = 0; b < bands; ++b) {
+        VImage noise = VImage::gaussnoise(width, height, VImage::option()->set("sigma", 12.0 + 4 * b));
+        planes.push_back(pattern + noise - 128);
+    }
+    VImage image = VImage::bandjoin(planes).cast(VIPS_FORMAT_UCHAR);
+    if (bands >= 3) {
+        image = image.copy(VImage::option()->set("interpretation", VIPS_INTERPRETATION_sRGB));
+    }
+    return image;
+}
+
+/**
+ * @brief Creates the source for one point of the benchmark matrix.
+ */
+Source make_source(int width, int height, int bands, SourceFormat format) {
+    const char* suffix = format == SOURCE_JPEG ? ".jpg" : ".png";
+    void* buf = nullptr;
+    size_t size = 0;
+    synthesize(width, height, bands)
+        .write_to_buffer(suffix, &buf, &size,
+                         format == SOURCE_JPEG ? VImage::option()->set("Q", 90) : VImage::option()->set("compression", 1));
+
+    Source src;
+    src.bytes.assign(static_cast<unsigned char*>(buf), static_cast<unsigned char*>(buf) + size);
+    g_free(buf);
+
+    src.path = "./test/bench_" + std::to_string(width) + "x" + std::to_string(height) + "_" +
+               std::to_string(bands) + suffix;
+    std::ofstream(src.path, std::ios::binary).write(reinterpret_cast<const char*>(src.bytes.data()),
+                                                    static_cast<std::streamsize>(src.bytes.size()));
+    src.decoded = VImage::new_from_buffer(src.bytes.data(), src.bytes.size(), "").copy_memory();
+    return src;
+}
+
+/**
+ * @brief Returns the source for one point of the benchmark matrix.
+ *
+ * Only the most recent source is kept: a 50MP matrix point holds hundreds of
+ * megabytes, and consecutive runs of a benchmark mostly reuse the same one.
+ */
+const Source& source(int width, int height, int bands, SourceFormat format) {
+    static std::tuple<int, int, int, int> cached_key{0, 0, 0, -1};
+    static Source cached;
+    auto key = std::make_tuple(width, height, bands, static_cast<int>(format));
+    if (key != cached_key) {
+        cached = Source();
+        cached = make_source(width, height, bands, format);
+        cached_key = key;
+    }
+    return cached;
+}
+
+/**
+ * @brief Returns the RGBA overlay used by the watermark benchmark.
+ */
+const Source& watermark_source() {
+    static Source mark = make_source(640, 480, 4, SOURCE_PNG);
+    return mark;
+}
+
+/**
+ * @brief Wraps a copy of `image` in a handle, as load_image would.
+ *
+ * Transforms work in place, so every iteration needs a fresh handle;
+ * sharing the decoded pixels keeps decode time out of the measurement.
+ */
+VImageHandle handle_of(const VImage& image) {
+    return static_cast<VImageHandle>(new VImage(image));
+}
+
+/**
+ * @brief Computes the pixels of a handle's image; wrapper operations are lazy until encoded.
+ */
+void materialise(VImageHandle handle) {
+    benchmark::DoNotOptimize(static_cast<VImage*>(handle)->avg());
+}
+
+//=============================================================================
+// REPORTING
+//=============================================================================
+
+/**
+ * @brief Reads the resident set high-water mark in MB since the last reset_peak_rss().
+ *
+ * Falls back to the process lifetime peak where /proc has no VmHWM.
+ */
+double peak_rss_mb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stod(line.substr(6)) / 1024.0; // in kB
+        }
+    }
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / 1024.0; // ru_maxrss is in KB
+}
+
+/**
+ * @brief Resets the resident set high-water mark to the current RSS (Linux 4.0+, else a no-op).
+ */
+void reset_peak_rss() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+/**
+ * @brief Adds the MP/s and peak RSS counters for a benchmark over a width x height image.
+ *
+ * The high-water mark is reset after it is read, so each run reports its own
+ * peak rather than the largest case run before it. Google Benchmark keeps the
+ * last run of a benchmark, which follows a run of the same benchmark.
+ */
+void report(benchmark::State& state, int width, int height) {
+    state.counters["MP/s"] = benchmark::Counter(width * static_cast<double>(height) / 1e6,
+                                                benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["peak_rss_MB"] = peak_rss_mb();
+    reset_peak_rss();
+}
+
+// Benchmark arguments: width, height, bands, source format
+int arg_width(const benchmark::State& state) { return static_cast<int>(state.range(0)); }
+int arg_height(const benchmark::State& state) { return static_cast<int>(state.range(1)); }
+int arg_bands(const benchmark::State& state) { return static_cast<int>(state.range(2)); }
+SourceFormat arg_format(const benchmark::State& state) { return static_cast<SourceFormat>(state.range(3)); }
+
+/**
+ * @brief Registers image sizes (0.3MP-50MP) x `band_counts` x `formats`.
+ *
+ * JPEG cannot hold 4 bands, so that combination is skipped.
+ */
+void register_matrix(benchmark::internal::Benchmark* b, std::initializer_list<int> band_counts,
+                     std::initializer_list<int> formats) {
+    const std::vector<std::pair<int, int>> sizes = {
+        {640, 480},     // 0.3 MP
+        {1920, 1080},   // 2 MP
+        {4000, 3000},   // 12 MP
+        {8660, 5774},   // 50 MP
+    };
+    b->ArgNames({"width", "height", "bands", "png"});
+    for (const auto& size : sizes) {
+        for (int bands : band_counts) {
+            for (int format : formats) {
+                if (format == SOURCE_JPEG && bands == 4) {
+                    continue;
+                }
+                b->Args({size.first, size.second, bands, format});
+            }
+        }
+    }
+    b->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+/**
+ * @brief Full matrix with both source formats, for the loaders.
+ */
+void image_matrix(benchmark::internal::Benchmark* b) {
+    register_matrix(b, {1, 3, 4}, {SOURCE_JPEG, SOURCE_PNG});
+}
+
+/**
+ * @brief Matrix for benchmarks on decoded pixels, where the source format makes no difference.
+ *
+ * PNG sources are used since they cover every band count.
+ */
+void pixel_matrix(benchmark::internal::Benchmark* b) {
+    register_matrix(b, {1, 3, 4}, {SOURCE_PNG});
+}
+
+/**
+ * @brief pixel_matrix() without 4-band images, for the JPEG encoder.
+ */
+void jpeg_pixel_matrix(benchmark::internal::Benchmark* b) {
+    register_matrix(b, {1, 3}, {SOURCE_PNG});
+}
+
+//=============================================================================
+// LOADERS
+//=============================================================================
+
+void BM_LoadImage(benchmark::State& state) {
+    const Source& src = source(arg_width(state), arg_height(state), arg_bands(state), arg_format(state));
+    for (auto _ : state) {
+        VImageHandle handle = load_image(src.path.c_str());
+        if (!handle) {
+            state.SkipWithError("load_image failed");
+            break;
+        }
+        materialise(handle);
+        free_vimage_handle(handle);
+    }
+    report(state, arg_width(state), arg_height(state));
+}
+BENCHMARK(BM_LoadImage)->Apply(image_matrix);
+
+void BM_LoadImageFromBytes(benchmark::State& state) {
+    const Source& src = source(arg_width(state), arg_height(state), arg_bands(state), arg_format(state));
+    for (auto _ : state) {
+        VImageHandle handle = load_image_from_bytes(src.bytes.data(), src.bytes.size());
+        if (!handle) {
+            state.SkipWithError("load_image_from_bytes failed");
+            break;
+        }
+        materialise(handle);
+        free_vimage_handle(handle);
+    }
+    report(state, arg_width(state), arg_height(state));
+}
+BENCHMARK(BM_LoadImageFromBytes)->Apply(image_matrix);
+
+//=============================================================================
+// TRANSFORMS
+//=============================================================================
+
+/**
+ * @brief Runs `op` on a fresh handle of the decoded source each iteration and computes the result.
+ */
+template <typename Op>
+void run_transform(benchmark::State& state, const char* name, Op op) {
+    const Source& src = source(arg_width(state), arg_height(state), arg_bands(state), arg_format(state));
+    for (auto _ : state) {
+        VImageHandle handle = handle_of(src.decoded);
+        if (op(handle) != SUCCESS) {
+            free_vimage_handle(handle);
+            state.SkipWithError(name);
+            break;
+        }
+        materialise(handle);
+        free_vimage_handle(handle);
+    }
+    report(state, arg_width(state), arg_height(state));
+}
+
+void BM_ResizeImage(benchmark::State& state) {
+    ImageResizeOptions options = {1, arg_width(state) / 4, arg_height(state) / 4};
+    run_transform(state, "resize_image failed", [&](VImageHandle h) { return resize_image(h, options); });
+}
+BENCHMARK(BM_ResizeImage)->Apply(pixel_matrix);
+
+// Same resize as BM_ResizeImage, derived from one shared handle instead of a fresh copy per iteration
+void BM_ResizeImageTo(benchmark::State& state) {
+    const Source& src = source(arg_width(state), arg_height(state), arg_bands(state), arg_format(state));
+    ImageResizeOptions options = {1, arg_width(state) / 4, arg_height(state) / 4};
+    VImageHandle shared = handle_of(src.decoded);
+    for (auto _ : state) {
+        VImageHandle resized = nullptr;
+        if (resize_image_to(shared, &resized, options) != SUCCESS) {
+            state.SkipWithError("resize_image_to failed");
+            break;
+        }
+        materialise(resized);
+        free_vimage_handle(resized);
+    }
+    free_vimage_handle(shared);
+    report(state, arg_width(state), arg_height(state));
+}
+BENCHMARK(BM_ResizeImageTo)->Apply(pixel_matrix);
+
+void BM_CropImage(benchmark::State& state) {
+    ImageCropOptions options = {arg_width(state) / 4, arg_height(state) / 4, arg_width(state) / 2, arg_height(state) / 2};
+    run_transform(state, "crop_image failed", [&](VImageHandle h) { return crop_image(h, options); });
+}
+BENCHMARK(BM_CropImage)->Apply(pixel_matrix);
+
+void BM_RotateImage90(benchmark::State& state) {
+    ImageRotateOptions options = {90.0};
+    run_transform(state, "rotate_image failed", [&](VImageHandle h) { return rotate_image(h, options); });
+}
+BENCHMARK(BM_RotateImage90)->Apply(pixel_matrix);
+
+void BM_RotateImage30(benchmark::State& state) {
+    ImageRotateOptions options = {30.0};
+    run_transform(state, "rotate_image failed", [&](VImageHandle h) { return rotate_image(h, options); });
+}
+BENCHMARK(BM_RotateImage30)->Apply(pixel_matrix);
+
+void BM_FlipImage(benchmark::State& state) {
+    ImageFlipOptions options = {IMAGE_FLIP_HORIZONTAL};
+    run_transform(state, "flip_image failed", [&](VImageHandle h) { return flip_image(h, options); });
+}
+BENCHMARK(BM_FlipImage)->Apply(pixel_matrix);
+
+void BM_WatermarkImage(benchmark::State& state) {
+    VImageHandle overlay = handle_of(watermark_source().decoded);
+    ImageWatermarkOptions options = {arg_width(state) / 8, arg_height(state) / 8, 0.5};
+    run_transform(state, "watermark_image failed", [&](VImageHandle h) { return watermark_image(h, overlay, options); });
+    free_vimage_handle(overlay);
+}
+BENCHMARK(BM_WatermarkImage)->Apply(pixel_matrix);
+
+// Same placement as BM_WatermarkImage, with the overlay prepared once outside the loop
+void BM_WatermarkImagePrepared(benchmark::State& state) {
+    VImageHandle overlay = handle_of(watermark_source().decoded);
+    ImageWatermarkHandle mark = prepare_watermark(overlay, 0.5, IMAGE_BLEND_OVER, nullptr);
+    free_vimage_handle(overlay);
+    ImageWatermarkPlacement placement = {IMAGE_GRAVITY_NONE, arg_width(state) / 8, arg_height(state) / 8, 0.0};
+    run_transform(state, "watermark_image_prepared failed",
+                  [&](VImageHandle h) { return watermark_image_prepared(h, mark, placement); });
+    free_watermark(mark);
+}
+BENCHMARK(BM_WatermarkImagePrepared)->Apply(pixel_matrix);
+
+void BM_ChangeImageOpacity(benchmark::State& state) {
+    ImageOpacityOptions options = {0.5};
+    run_transform(state, "change_image_opacity failed", [&](VImageHandle h) { return change_image_opacity(h, options); });
+}
+BENCHMARK(BM_ChangeImageOpacity)->Apply(pixel_matrix);
+
+//=============================================================================
+// ENCODERS
+//=============================================================================
+
+void BM_EncodeToJPEG(benchmark::State& state) {
+    const Source& src = source(arg_width(state), arg_height(state), arg_bands(state), arg_format(state));
+    VImageHandle handle = handle_of(src.decoded);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        ImageBuffer out = encode_to_jpeg(handle, ImageEncodeJPEGOptions{80, 0});
+        if (!out.data) {
+            state.SkipWithError("encode_to_jpeg failed");
+            break;
+        }
+        bytes = out.size;
+        free_image_buffer(out);
+    }
+    free_vimage_handle(handle);
+    report(state, arg_width(state), arg_height(state));
+    state.counters["output_bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK(BM_EncodeToJPEG)->Apply(jpeg_pixel_matrix);
+
+void BM_EncodeToPNG(benchmark::State& state) {
+    const Source& src = source(arg_width(state), arg_height(state), arg_bands(state), arg_format(state));
+    VImageHandle handle = handle_of(src.decoded);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        ImageBuffer out = encode_to_png(handle, ImageEncodePNGOptions{6, 0});
+        if (!out.data) {
+            state.SkipWithError("encode_to_png failed");
+            break;
+        }
+        bytes = out.size;
+        free_image_buffer(out);
+    }
+    free_vimage_handle(handle);
+    report(state, arg_width(state), arg_height(state));
+    state.counters["output_bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK(BM_EncodeToPNG)->Apply(pixel_matrix);
+
+//=============================================================================
+// BATCH
+//=============================================================================
+
+// Images per process_batch call
+const size_t BATCH_SIZE = 64;
+
+/**
+ * @brief Decodes, resizes to a quarter and re-encodes BATCH_SIZE copies of a small JPEG.
+ *
+ * Arguments: width, height, parallelism (0 = one per core). Compare parallelism
+ * 1 with 0 to see the gain from spreading whole images over the cores.
+ */
+void BM_ProcessBatch(benchmark::State& state) {
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    const Source& src = source(width, height, 3, SOURCE_JPEG);
+    std::vector<ImageBatchItem> items(BATCH_SIZE, ImageBatchItem{nullptr, src.bytes.data(), src.bytes.size()});
+    std::vector<ImageBatchResult> results(BATCH_SIZE);
+
+    ImagePipelineOp resize = {};
+    resize.type = PIPELINE_OP_RESIZE;
+    resize.resize = ImageResizeOptions{1, width / 4, height / 4};
+    ImageBatchSpec spec = {};
+    spec.load.access = IMAGE_ACCESS_SEQUENTIAL;
+    spec.ops = &resize;
+    spec.op_count = 1;
+    spec.output.format = IMAGE_FORMAT_JPEG;
+    spec.output.jpeg.quality = 80;
+
+    for (auto _ : state) {
+        ImageStatus status = process_batch(items.data(), items.size(), spec, results.data(),
+                                           static_cast<int>(state.range(2)));
+        for (auto& result : results) {
+            free_image_buffer(result.output);
+        }
+        if (status != SUCCESS) {
+            state.SkipWithError("process_batch failed");
+            break;
+        }
+    }
+    report(state, width, height * static_cast<int>(BATCH_SIZE));
+}
+BENCHMARK(BM_ProcessBatch)
+    ->ArgNames({"width", "height", "parallelism"})
+    ->Args({640, 480, 1})
+    ->Args({640, 480, 0})
+    ->Args({1920, 1080, 1})
+    ->Args({1920, 1080, 0})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+//=============================================================================
+// RESULT CACHE
+//=============================================================================
+
+/**
+ * @brief Thumbnails a JPEG through process_cached, against a warm or an empty cache.
+ *
+ * Arguments: width, height, warm (1 = every call hits, 0 = a fresh cache per call,
+ * which measures the render plus the key hash and bookkeeping).
+ */
+void BM_ProcessCached(benchmark::State& state) {
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    bool warm = state.range(2) != 0;
+    const Source& src = source(width, height, 3, SOURCE_JPEG);
+
+    ImagePipelineOp resize = {};
+    resize.type = PIPELINE_OP_RESIZE;
+    resize.resize = ImageResizeOptions{1, 320, 320};
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_JPEG;
+    out.jpeg.quality = 80;
+    ImageLoadOptions load = {};
+    load.access = IMAGE_ACCESS_SEQUENTIAL;
+
+    ImageResultCacheHandle cache = create_result_cache(ImageResultCacheOptions{0, 0}, nullptr);
+    for (auto _ : state) {
+        if (!warm) {
+            state.PauseTiming();
+            destroy_result_cache(cache);
+            cache = create_result_cache(ImageResultCacheOptions{0, 0}, nullptr);
+            state.ResumeTiming();
+        }
+        ImageCachedBuffer thumb = {};
+        ImageStatus status = process_cached(cache, src.bytes.data(), src.bytes.size(), load, &resize, 1, out, &thumb);
+        release_cached_buffer(thumb);
+        if (status != SUCCESS) {
+            state.SkipWithError("process_cached failed");
+            break;
+        }
+    }
+    destroy_result_cache(cache);
+    report(state, width, height);
+}
+BENCHMARK(BM_ProcessCached)
+    ->ArgNames({"width", "height", "warm"})
+    ->Args({1920, 1080, 0})
+    ->Args({1920, 1080, 1})
+    ->Args({4000, 3000, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+//=============================================================================
+// REGIONS AND TILES
+//=============================================================================
+
+/**
+ * @brief Reads 256x256 regions at scattered positions of a mapped `.v` master.
+ *
+ * Arguments: width, height. The time per region should not grow with the
+ * master size, since only the pixels under the region are paged in.
+ */
+void BM_FetchRegion(benchmark::State& state) {
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    const Source& src = source(width, height, 3, SOURCE_JPEG);
+    std::string master = src.path + ".v";
+    VImageHandle decoded = handle_of(src.decoded);
+    ImageStatus status = save_image(decoded, master.c_str(), ImageEncodeSpec{IMAGE_FORMAT_NONE});
+    free_vimage_handle(decoded);
+    VImageHandle handle = status == SUCCESS ? load_image(master.c_str()) : nullptr;
+    if (!handle) {
+        state.SkipWithError("could not write the .v master");
+        return;
+    }
+
+    const int size = 256;
+    std::vector<unsigned char> pixels(size * size * 3);
+    int64_t n = 0;
+    for (auto _ : state) {
+        // A fixed stride keeps positions scattered and deterministic
+        int x = static_cast<int>((n * 7919) % (width - size));
+        int y = static_cast<int>((n * 104729) % (height - size));
+        ++n;
+        if (fetch_region(handle, x, y, size, size, pixels.data(), pixels.size(), nullptr) != SUCCESS) {
+            state.SkipWithError("fetch_region failed");
+            break;
+        }
+        benchmark::DoNotOptimize(pixels.data());
+    }
+    free_vimage_handle(handle);
+    std::remove(master.c_str());
+    report(state, size, size);
+}
+BENCHMARK(BM_FetchRegion)
+    ->ArgNames({"width", "height"})
+    ->Args({1920, 1080})
+    ->Args({8000, 6000})
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Writes a Deep Zoom pyramid of 254px JPEG tiles from a decoded image.
+ *
+ * Arguments: width, height. Tiles are encoded on libvips' worker threads.
+ */
+void BM_GenerateTilePyramid(benchmark::State& state) {
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    VImageHandle handle = handle_of(source(width, height, 3, SOURCE_JPEG).decoded);
+    ImageTilePyramidOptions options = {};
+    options.tiles.format = IMAGE_FORMAT_JPEG;
+    options.tiles.jpeg.quality = 80;
+    std::string path = "./test/bench_pyramid_" + std::to_string(width) + "x" + std::to_string(height);
+
+    for (auto _ : state) {
+        if (generate_tile_pyramid(handle, path.c_str(), options) != SUCCESS) {
+            state.SkipWithError("generate_tile_pyramid failed");
+            break;
+        }
+        state.PauseTiming();
+        std::filesystem::remove_all(path + "_files");
+        std::filesystem::remove(path + ".dzi");
+        state.ResumeTiming();
+    }
+    free_vimage_handle(handle);
+    report(state, width, height);
+}
+BENCHMARK(BM_GenerateTilePyramid)
+    ->ArgNames({"width", "height"})
+    ->Args({1920, 1080})
+    ->Args({8000, 6000})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+//=============================================================================
+// RAW PIXEL INTERCHANGE
+//=============================================================================
+
+/**
+ * @brief Writes a decoded image as a normalised float tensor.
+ *
+ * Arguments: width, height, planar (0 = HWC, 1 = CHW). Compare with
+ * BM_EncodeToPNG, the encode-and-decode round trip this replaces.
+ */
+void BM_WriteToMemory(benchmark::State& state) {
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    VImageHandle handle = handle_of(source(width, height, 3, SOURCE_JPEG).decoded);
+    ImageTensorSpec spec = {state.range(2) ? IMAGE_TENSOR_CHW : IMAGE_TENSOR_HWC, IMAGE_SAMPLE_FLOAT, 0, 1.0f / 255,
+                            {0.485f, 0.456f, 0.406f}, {0.229f, 0.224f, 0.225f}};
+    std::vector<float> tensor(static_cast<size_t>(width) * height * 3);
+
+    for (auto _ : state) {
+        if (write_to_memory(handle, spec, tensor.data(), tensor.size() * sizeof(float), nullptr) != SUCCESS) {
+            state.SkipWithError("write_to_memory failed");
+            break;
+        }
+        benchmark::DoNotOptimize(tensor.data());
+    }
+    free_vimage_handle(handle);
+    report(state, width, height);
+}
+BENCHMARK(BM_WriteToMemory)
+    ->ArgNames({"width", "height", "planar"})
+    ->Args({640, 480, 0})
+    ->Args({640, 480, 1})
+    ->Args({1920, 1080, 0})
+    ->Args({1920, 1080, 1})
+    ->Args({4000, 3000, 1})
+    ->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Wraps interleaved uint8 pixels as an image and encodes it as JPEG.
+ *
+ * Arguments: width, height. The pixels are copied on import, so the time
+ * includes one memcpy of the frame.
+ */
+void BM_LoadImageFromMemory(benchmark::State& state) {
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = static_cast<unsigned char>(i * 31);
+    }
+
+    for (auto _ : state) {
+        VImageHandle handle = load_image_from_memory(pixels.data(), pixels.size(), width, height, 3,
+                                                     IMAGE_SAMPLE_UCHAR, nullptr, nullptr, nullptr);
+        ImageBuffer jpeg = handle ? encode_to_jpeg(handle, ImageEncodeJPEGOptions{85, 0}) : ImageBuffer{nullptr, 0};
+        free_vimage_handle(handle);
+        if (!jpeg.data) {
+            state.SkipWithError("load_image_from_memory failed");
+            break;
+        }
+        free_image_buffer(jpeg);
+    }
+    report(state, width, height);
+}
+BENCHMARK(BM_LoadImageFromMemory)
+    ->ArgNames({"width", "height"})
+    ->Args({640, 480})
+    ->Args({1920, 1080})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+//=============================================================================
+// ALLOCATOR INTERPOSERS
+//=============================================================================
+
+#if defined(__GLIBC__)
+// Defining these in the executable interposes them for libvips and GLib as well
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    void* ptr = __libc_malloc(size);
+    record_alloc(ptr);
+    return ptr;
+}
+
+void* calloc(size_t count, size_t size) {
+    void* ptr = __libc_calloc(count, size);
+    record_alloc(ptr);
+    return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+    record_free(ptr);
+    void* moved = __libc_realloc(ptr, size);
+    record_alloc(moved);
+    return moved;
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    record_alloc(ptr);
+    *out = ptr;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    void* ptr = __libc_memalign(alignment, size);
+    record_alloc(ptr);
+    return ptr;
+}
+
+void free(void* ptr) {
+    record_free(ptr);
+    __libc_free(ptr);
+}
+} // extern "C"
+#endif
+
+int main(int argc, char** argv) {
+    if (vips_wrapper_init() != SUCCESS) {
+        std::fprintf(stderr, "Failed to initialize Image SDK\n");
+        return 1;
+    }
+
+#if defined(__GLIBC__)
+    static MallocCounter malloc_counter;
+    benchmark::RegisterMemoryManager(&malloc_counter);
+#endif
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    vips_wrapper_cleanup();
+    return 0;
+}
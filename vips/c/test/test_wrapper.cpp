@@ -1,9 +1,17 @@
 #include "vips_wrapper.h"
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 #include <cstring>
+#include <cmath>
 #include <chrono>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
 
 using namespace std::chrono;
 
@@ -57,6 +65,11 @@ const char* status_to_string(ImageStatus code) {
         case IMAGE_INVALID_POSITION: return "IMAGE_INVALID_POSITION";
         case IMAGE_INVALID_BOUNDS: return "IMAGE_INVALID_BOUNDS";
         case IMAGE_SAVE_FAILURE: return "IMAGE_SAVE_FAILURE";
+        case IMAGE_BUFFER_TOO_SMALL: return "IMAGE_BUFFER_TOO_SMALL";
+        case IMAGE_QUEUE_FULL: return "IMAGE_QUEUE_FULL";
+        case IMAGE_TOO_LARGE: return "IMAGE_TOO_LARGE";
+        case IMAGE_CACHE_MISS: return "IMAGE_CACHE_MISS";
+        case IMAGE_CANCELLED: return "IMAGE_CANCELLED";
         case UNKNOWN_ERROR:
         default: return "UNKNOWN_ERROR";
     }
@@ -335,6 +348,1879 @@ bool test_png_encoding(const char* input_path) {
     return true;
 }
 
+/**
+ * @brief Tests shrink-on-load thumbnailing from path and from bytes
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_thumbnail(const char* input_path) {
+    std::cout << "\n=== Test 7: Shrink-on-load Thumbnail ===" << std::endl;
+    
+    ImageResizeOptions resize_opts = {1, 400, 300};
+    VImageHandle thumb = thumbnail_from_path(input_path, resize_opts, nullptr);
+    if (!thumb) {
+        std::cout << "   Thumbnail from path failed" << std::endl;
+        return false;
+    }
+    
+    // Result must match the dimensions of load_image + resize_image
+    VImageHandle reference = load_image(input_path);
+    if (!reference || resize_image(reference, resize_opts) != SUCCESS) {
+        std::cout << "   Reference resize failed" << std::endl;
+        free_vimage_handle(reference);
+        free_vimage_handle(thumb);
+        return false;
+    }
+    
+    ImageMeta thumb_meta = extract_metadata(thumb);
+    ImageMeta reference_meta = extract_metadata(reference);
+    free_vimage_handle(reference);
+    std::cout << "   Thumbnail size: " << thumb_meta.width << "x" << thumb_meta.height << std::endl;
+    if (thumb_meta.width != reference_meta.width || thumb_meta.height != reference_meta.height) {
+        std::cout << "   Thumbnail size differs from resize: " << reference_meta.width << "x"
+                  << reference_meta.height << std::endl;
+        free_vimage_handle(thumb);
+        return false;
+    }
+    
+    ImageBuffer jpeg = encode_to_jpeg(thumb, ImageEncodeJPEGOptions{85, 0});
+    free_vimage_handle(thumb);
+    if (!jpeg.data || jpeg.size == 0) {
+        std::cout << "   Thumbnail encoding failed" << std::endl;
+        return false;
+    }
+    save_encoded_image(jpeg.data, jpeg.size, "./test/test_thumbnail.jpg");
+    
+    // Thumbnail the encoded bytes again, constrained by height only
+    ImageResizeOptions height_opts = {1, 0, 100};
+    thumb = thumbnail_from_buffer(jpeg.data, jpeg.size, height_opts, nullptr);
+    free_image_buffer(jpeg);
+    if (!thumb) {
+        std::cout << "   Thumbnail from bytes failed" << std::endl;
+        return false;
+    }
+    
+    thumb_meta = extract_metadata(thumb);
+    free_vimage_handle(thumb);
+    std::cout << "   Thumbnail from bytes: " << thumb_meta.width << "x" << thumb_meta.height << std::endl;
+    return thumb_meta.height == 100;
+}
+
+/**
+ * @brief Tests sequential-access loading with streamable and non-streamable operations
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_sequential_load(const char* input_path) {
+    std::cout << "\n=== Test 8: Sequential Access Loading ===" << std::endl;
+    
+    ImageLoadOptions load_opts = {IMAGE_ACCESS_SEQUENTIAL};
+    VImageHandle vimg = load_image_with_options(input_path, load_opts, nullptr);
+    if (!vimg) {
+        std::cout << "   Failed to load image sequentially" << std::endl;
+        return false;
+    }
+    
+    // Resize -> Crop -> Encode streams top to bottom
+    ImageResizeOptions resize_opts = {1, 800, 600};
+    ImageCropOptions crop_opts = {10, 10, 400, 300};
+    if (resize_image(vimg, resize_opts) != SUCCESS || crop_image(vimg, crop_opts) != SUCCESS) {
+        std::cout << "   Sequential resize/crop failed" << std::endl;
+        free_vimage_handle(vimg);
+        return false;
+    }
+    
+    ImageBuffer jpeg = encode_to_jpeg(vimg, ImageEncodeJPEGOptions{85, 0});
+    free_vimage_handle(vimg);
+    if (!jpeg.data || jpeg.size == 0) {
+        std::cout << "   Sequential encoding failed" << std::endl;
+        return false;
+    }
+    std::cout << "   Streamed resize/crop: " << jpeg.size << " bytes" << std::endl;
+    free_image_buffer(jpeg);
+    
+    // Rotation must fall back to random access and still succeed
+    vimg = load_image_from_bytes_with_options(nullptr, 0, load_opts, nullptr);
+    if (vimg) {
+        std::cout << "   Loading empty bytes unexpectedly succeeded" << std::endl;
+        free_vimage_handle(vimg);
+        return false;
+    }
+    vimg = load_image_with_options(input_path, load_opts, nullptr);
+    if (!vimg) {
+        std::cout << "   Failed to reload image sequentially" << std::endl;
+        return false;
+    }
+    ImageRotateOptions rotate_opts = {15.0};
+    ImageStatus result = rotate_image(vimg, rotate_opts);
+    if (result != SUCCESS) {
+        std::cout << "   Sequential rotate failed: " << status_to_string(result) << std::endl;
+        free_vimage_handle(vimg);
+        return false;
+    }
+    
+    jpeg = encode_to_jpeg(vimg, ImageEncodeJPEGOptions{85, 0});
+    free_vimage_handle(vimg);
+    if (!jpeg.data || jpeg.size == 0) {
+        std::cout << "   Encoding rotated sequential image failed" << std::endl;
+        return false;
+    }
+    std::cout << "   Rotated with random-access fallback: " << jpeg.size << " bytes" << std::endl;
+    free_image_buffer(jpeg);
+    return true;
+}
+
+/**
+ * @brief Release callback used by the owned-bytes test; counts invocations and frees the data
+ * @param data The buffer handed back by the library
+ * @param user_data Pointer to the release counter
+ */
+void release_test_buffer(void* data, void* user_data) {
+    ++*static_cast<int*>(user_data);
+    free(data);
+}
+
+/**
+ * @brief Reads a whole file into a malloc'd buffer
+ * @param path File to read
+ * @param size Receives the size of the buffer
+ * @return The buffer, or nullptr on failure
+ */
+unsigned char* read_file_to_malloc(const char* path, size_t* size) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return nullptr;
+    }
+    *size = static_cast<size_t>(file.tellg());
+    unsigned char* data = static_cast<unsigned char*>(malloc(*size));
+    file.seekg(0);
+    if (!data || !file.read(reinterpret_cast<char*>(data), *size)) {
+        free(data);
+        return nullptr;
+    }
+    return data;
+}
+
+/**
+ * @brief Tests zero-copy loading with buffer ownership transfer
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_owned_bytes(const char* input_path) {
+    std::cout << "\n=== Test 9: Zero-copy Owned Bytes ===" << std::endl;
+    
+    size_t size = 0;
+    unsigned char* data = read_file_to_malloc(input_path, &size);
+    if (!data) {
+        std::cout << "   Failed to read " << input_path << std::endl;
+        return false;
+    }
+    
+    int releases = 0;
+    VImageHandle vimg = load_image_from_owned_bytes(data, size, ImageLoadOptions{IMAGE_ACCESS_SEQUENTIAL},
+                                                    release_test_buffer, &releases, nullptr);
+    if (!vimg) {
+        std::cout << "   Failed to load owned bytes" << std::endl;
+        return false;
+    }
+    if (releases != 0) {
+        std::cout << "   Buffer released while still in use" << std::endl;
+        free_vimage_handle(vimg);
+        return false;
+    }
+    
+    ImageResizeOptions resize_opts = {1, 400, 300};
+    ImageBuffer jpeg = {nullptr, 0};
+    if (resize_image(vimg, resize_opts) == SUCCESS) {
+        jpeg = encode_to_jpeg(vimg, ImageEncodeJPEGOptions{85, 0});
+    }
+    free_vimage_handle(vimg);
+    if (!jpeg.data || jpeg.size == 0) {
+        std::cout << "   Processing owned bytes failed" << std::endl;
+        return false;
+    }
+    std::cout << "   Decoded without copy: " << jpeg.size << " bytes" << std::endl;
+    free_image_buffer(jpeg);
+    
+    // A failed load must hand the buffer back before returning
+    int failed_releases = 0;
+    unsigned char* garbage = static_cast<unsigned char*>(malloc(16));
+    std::memset(garbage, 0x5a, 16);
+    vimg = load_image_from_owned_bytes(garbage, 16, ImageLoadOptions{IMAGE_ACCESS_RANDOM},
+                                       release_test_buffer, &failed_releases, nullptr);
+    if (vimg || failed_releases != 1) {
+        std::cout << "   Failed load did not release its buffer exactly once" << std::endl;
+        free_vimage_handle(vimg);
+        return false;
+    }
+    std::cout << "   Failed load released its buffer" << std::endl;
+    return true;
+}
+
+/**
+ * @brief Writer callback used by the streaming test; appends chunks to a std::vector
+ * @param data The encoded chunk
+ * @param size Size of the chunk in bytes
+ * @param user_data Pointer to the destination vector
+ * @return Number of bytes consumed
+ */
+long long append_to_vector(const void* data, size_t size, void* user_data) {
+    std::vector<unsigned char>* out = static_cast<std::vector<unsigned char>*>(user_data);
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    out->insert(out->end(), bytes, bytes + size);
+    return static_cast<long long>(size);
+}
+
+/**
+ * @brief Tests streaming encodes to a writer and into caller-provided buffers
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_streaming_encode(const char* input_path) {
+    std::cout << "\n=== Test 10: Streaming Encode ===" << std::endl;
+    
+    VImageHandle vimg = load_image(input_path);
+    if (!vimg) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImageResizeOptions resize_opts = {1, 400, 300};
+    resize_image(vimg, resize_opts);
+    
+    ImageEncodeJPEGOptions jpeg_opts = {85, 0};
+    ImageBuffer reference = encode_to_jpeg(vimg, jpeg_opts);
+    
+    // Writer output must match the buffered encoder byte for byte
+    std::vector<unsigned char> streamed;
+    ImageWriter writer = {append_to_vector, &streamed};
+    ImageStatus result = encode_to_jpeg_writer(vimg, jpeg_opts, writer);
+    bool ok = result == SUCCESS && reference.data && streamed.size() == reference.size &&
+              std::memcmp(streamed.data(), reference.data, reference.size) == 0;
+    std::cout << "   Writer JPEG: " << streamed.size() << " bytes (" << status_to_string(result) << ")" << std::endl;
+    
+    // A too small buffer reports the size it needs
+    unsigned char small[16];
+    size_t needed = 0;
+    result = encode_to_jpeg_into(vimg, jpeg_opts, small, sizeof(small), &needed);
+    ok = ok && result == IMAGE_BUFFER_TOO_SMALL && needed == reference.size;
+    std::cout << "   Small buffer: " << status_to_string(result) << ", needs " << needed << " bytes" << std::endl;
+    
+    std::vector<unsigned char> fixed(needed);
+    size_t written = 0;
+    result = encode_to_jpeg_into(vimg, jpeg_opts, fixed.data(), fixed.size(), &written);
+    ok = ok && result == SUCCESS && written == reference.size &&
+         std::memcmp(fixed.data(), reference.data, written) == 0;
+    std::cout << "   Fixed buffer: " << written << " bytes (" << status_to_string(result) << ")" << std::endl;
+    free_image_buffer(reference);
+    
+    std::vector<unsigned char> png;
+    ImageWriter png_writer = {append_to_vector, &png};
+    result = encode_to_png_writer(vimg, ImageEncodePNGOptions{6, 0}, png_writer);
+    ok = ok && result == SUCCESS && png.size() > 8;
+    std::cout << "   Writer PNG: " << png.size() << " bytes (" << status_to_string(result) << ")" << std::endl;
+    
+    free_vimage_handle(vimg);
+    return ok;
+}
+
+/**
+ * @brief Tests the fused single-call operation pipeline
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_pipeline(const char* input_path) {
+    std::cout << "\n=== Test 11: Fused Pipeline ===" << std::endl;
+    
+    VImageHandle vimg = load_image(input_path);
+    if (!vimg) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImageMeta original_meta = extract_metadata(vimg);
+    
+    // Resize -> Crop -> Crop (fused) -> Rotate 360 (skipped) -> Opacity
+    ImagePipelineOp ops[5] = {};
+    ops[0].type = PIPELINE_OP_RESIZE;
+    ops[0].resize = ImageResizeOptions{1, 800, 600};
+    ops[1].type = PIPELINE_OP_CROP;
+    ops[1].crop = ImageCropOptions{50, 50, 500, 400};
+    ops[2].type = PIPELINE_OP_CROP;
+    ops[2].crop = ImageCropOptions{10, 10, 300, 200};
+    ops[3].type = PIPELINE_OP_ROTATE;
+    ops[3].rotate = ImageRotateOptions{360.0};
+    ops[4].type = PIPELINE_OP_OPACITY;
+    ops[4].opacity = ImageOpacityOptions{0.5};
+    
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_PNG;
+    out.png = ImageEncodePNGOptions{6, 0};
+    
+    ImageBuffer png = {nullptr, 0};
+    ImageStatus result = process_pipeline(vimg, ops, 5, out, &png);
+    if (result != SUCCESS || !png.data) {
+        std::cout << "   Pipeline failed: " << status_to_string(result) << std::endl;
+        free_vimage_handle(vimg);
+        return false;
+    }
+    std::cout << "   Pipeline PNG: " << png.size << " bytes" << std::endl;
+    save_encoded_image(png.data, png.size, "./test/test_pipeline.png");
+    free_image_buffer(png);
+    
+    // The source handle is untouched by an encoding pipeline
+    ImageMeta after_meta = extract_metadata(vimg);
+    if (after_meta.width != original_meta.width || after_meta.height != original_meta.height) {
+        std::cout << "   Pipeline modified its source handle" << std::endl;
+        free_vimage_handle(vimg);
+        return false;
+    }
+    
+    // Without an output format the operations apply in place
+    out.format = IMAGE_FORMAT_NONE;
+    result = process_pipeline(vimg, ops, 5, out, nullptr);
+    ImageMeta in_place_meta = extract_metadata(vimg);
+    std::cout << "   In-place pipeline: " << in_place_meta.width << "x" << in_place_meta.height
+              << ", " << in_place_meta.channels << " channels" << std::endl;
+    bool ok = result == SUCCESS && in_place_meta.width == 300 && in_place_meta.height == 200;
+    
+    // An out-of-bounds step reports its error and leaves the handle alone
+    ops[1].crop = ImageCropOptions{0, 0, 100000, 10};
+    result = process_pipeline(vimg, ops + 1, 1, out, nullptr);
+    ok = ok && result == IMAGE_INVALID_BOUNDS && extract_metadata(vimg).width == 300;
+    
+    free_vimage_handle(vimg);
+    return ok;
+}
+
+/**
+ * @brief Tests the WebP/AVIF/JPEG XL/HEIF encoders and the generic format encoder
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_modern_encoders(const char* input_path) {
+    std::cout << "\n=== Test 12: Modern Encoders ===" << std::endl;
+    
+    VImageHandle vimg = thumbnail_from_path(input_path, ImageResizeOptions{1, 640, 480}, nullptr);
+    if (!vimg) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    
+    ImageBuffer webp = encode_to_webp(vimg, ImageEncodeWebPOptions{80, 0, 1, 0, 1});
+    bool ok = webp.data && webp.size > 12 && std::memcmp(webp.data + 8, "WEBP", 4) == 0;
+    std::cout << "   WebP: " << webp.size << " bytes" << std::endl;
+    save_encoded_image(webp.data, webp.size, "./test/test_encode.webp");
+    free_image_buffer(webp);
+    
+    ImageBuffer generic = encode_to_format(vimg, ".webp", "Q=60,effort=0");
+    ok = ok && generic.data && generic.size > 0;
+    std::cout << "   Generic .webp: " << generic.size << " bytes" << std::endl;
+    free_image_buffer(generic);
+    
+    // Malformed suffixes are rejected before reaching libvips
+    ImageBuffer rejected = encode_to_format(vimg, "webp[Q=60]", nullptr);
+    ok = ok && !rejected.data;
+    
+    // AVIF, JPEG XL and HEIF depend on optional libvips build dependencies
+    ImageBuffer avif = encode_to_avif(vimg, ImageEncodeAVIFOptions{50, 0, 0, IMAGE_SUBSAMPLE_AUTO, 1});
+    std::cout << "   AVIF: " << (avif.data ? std::to_string(avif.size) + " bytes" : "not available") << std::endl;
+    free_image_buffer(avif);
+    
+    ImageBuffer jxl = encode_to_jxl(vimg, ImageEncodeJXLOptions{75, 0, 3, 1});
+    std::cout << "   JPEG XL: " << (jxl.data ? std::to_string(jxl.size) + " bytes" : "not available") << std::endl;
+    free_image_buffer(jxl);
+    
+    ImageBuffer heif = encode_to_heif(vimg, ImageEncodeHEIFOptions{50, 0, 0, IMAGE_SUBSAMPLE_AUTO, 1});
+    std::cout << "   HEIF: " << (heif.data ? std::to_string(heif.size) + " bytes" : "not available") << std::endl;
+    free_image_buffer(heif);
+    
+    free_vimage_handle(vimg);
+    return ok;
+}
+
+/**
+ * @brief Tests the versioned JPEG tuning options and presets
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_jpeg_tuning(const char* input_path) {
+    std::cout << "\n=== Test 13: JPEG Tuning Presets ===" << std::endl;
+    
+    VImageHandle vimg = thumbnail_from_path(input_path, ImageResizeOptions{1, 1024, 768}, nullptr);
+    if (!vimg) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    
+    const struct {
+        ImageJPEGPreset preset;
+        const char* name;
+    } presets[] = {
+        {IMAGE_JPEG_PRESET_DEFAULT, "default"},
+        {IMAGE_JPEG_PRESET_FAST, "fast"},
+        {IMAGE_JPEG_PRESET_BALANCED, "balanced"},
+        {IMAGE_JPEG_PRESET_SMALLEST, "smallest"},
+    };
+    
+    bool ok = true;
+    size_t default_size = 0;
+    size_t smallest_size = 0;
+    for (const auto& p : presets) {
+        ImageEncodeJPEGOptions opts = jpeg_options_preset(p.preset, 80);
+        auto start = high_resolution_clock::now();
+        ImageBuffer jpeg = encode_to_jpeg(vimg, opts);
+        auto elapsed = duration_cast<microseconds>(high_resolution_clock::now() - start);
+        if (!jpeg.data) {
+            std::cout << "   Preset " << p.name << " failed" << std::endl;
+            ok = false;
+            continue;
+        }
+        std::cout << "   " << p.name << ": " << jpeg.size << " bytes in " << elapsed.count() << " us" << std::endl;
+        if (p.preset == IMAGE_JPEG_PRESET_DEFAULT) default_size = jpeg.size;
+        if (p.preset == IMAGE_JPEG_PRESET_SMALLEST) {
+            smallest_size = jpeg.size;
+            save_encoded_image(jpeg.data, jpeg.size, "./test/test_jpeg_smallest.jpg");
+        }
+        free_image_buffer(jpeg);
+    }
+    ok = ok && smallest_size > 0 && smallest_size <= default_size;
+    
+    // Legacy two-field initialisers still encode exactly as before
+    ImageBuffer legacy = encode_to_jpeg(vimg, ImageEncodeJPEGOptions{80, 0});
+    ok = ok && legacy.data && legacy.size == default_size;
+    free_image_buffer(legacy);
+    
+    free_vimage_handle(vimg);
+    return ok;
+}
+
+/**
+ * @brief Tests runtime concurrency and operation cache controls
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_runtime_config(const char* input_path) {
+    std::cout << "\n=== Test 14: Runtime Configuration ===" << std::endl;
+    
+    RuntimeConfig original = {};
+    vips_wrapper_get_runtime_config(&original);
+    std::cout << "   Defaults: concurrency " << original.concurrency << ", cache " << original.cache_max
+              << " ops / " << original.cache_max_mem << " bytes / " << original.cache_max_files << " files" << std::endl;
+    
+    // Re-initialising with a config applies it to the running library
+    RuntimeConfig config = {};
+    config.concurrency = 2;
+    config.cache_max = 50;
+    config.cache_max_mem = 32 << 20;
+    int init_result = vips_wrapper_init_ex(&config);
+    
+    RuntimeConfig applied = {};
+    vips_wrapper_get_runtime_config(&applied);
+    bool ok = init_result == SUCCESS && applied.concurrency == 2 && applied.cache_max == 50 &&
+              applied.cache_max_mem == config.cache_max_mem &&
+              applied.cache_max_files == original.cache_max_files; // zero field left untouched
+    
+    // Images still process with the cache disabled at runtime
+    vips_wrapper_set_cache_max(0);
+    VImageHandle vimg = load_image(input_path);
+    ok = ok && vimg && resize_image(vimg, ImageResizeOptions{1, 200, 150}) == SUCCESS;
+    free_vimage_handle(vimg);
+    
+    // Restore the defaults for the remaining tests
+    vips_wrapper_set_concurrency(original.concurrency);
+    vips_wrapper_set_cache_max(original.cache_max);
+    vips_wrapper_set_cache_max_mem(original.cache_max_mem);
+    vips_wrapper_get_runtime_config(&applied);
+    ok = ok && applied.cache_max == original.cache_max;
+    
+    std::cout << "   Runtime config " << (ok ? "applied" : "mismatch") << std::endl;
+    return ok;
+}
+
+// Completion tally shared by the worker pool test's jobs
+struct PoolTally {
+    std::mutex mutex;
+    std::condition_variable finished;
+    int completed = 0;
+    int succeeded = 0;
+    size_t bytes = 0;
+};
+
+static void count_pool_job(ImageStatus status, ImageBuffer result, void* user_data) {
+    PoolTally* tally = static_cast<PoolTally*>(user_data);
+    {
+        std::lock_guard<std::mutex> lock(tally->mutex);
+        tally->completed++;
+        if (status == SUCCESS && result.data) {
+            tally->succeeded++;
+            tally->bytes += result.size;
+        }
+    }
+    free_image_buffer(result);
+    tally->finished.notify_one();
+}
+
+/**
+ * @brief Tests the native worker pool, including queue-full rejection
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_worker_pool(const char* input_path) {
+    std::cout << "\n=== Test 15: Worker Pool ===" << std::endl;
+    
+    ImageWorkerPoolHandle pool = create_worker_pool(ImageWorkerPoolOptions{2, 4});
+    VImageHandle vimg = load_image(input_path);
+    if (!pool || !vimg) {
+        std::cout << "   Failed to create pool or load image" << std::endl;
+        destroy_worker_pool(pool);
+        free_vimage_handle(vimg);
+        return false;
+    }
+    
+    ImagePipelineOp ops[1] = {};
+    ops[0].type = PIPELINE_OP_RESIZE;
+    ops[0].resize = ImageResizeOptions{1, 320, 240};
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_JPEG;
+    out.jpeg = ImageEncodeJPEGOptions{80, 0};
+    ImagePipelineSpec spec = {vimg, ops, 1, out};
+    
+    // Submit a burst larger than workers + queue depth: the excess is rejected, not queued
+    PoolTally tally;
+    int accepted = 0;
+    int rejected = 0;
+    for (int i = 0; i < 20; ++i) {
+        ImageStatus status = submit_job(pool, spec, count_pool_job, &tally);
+        if (status == SUCCESS) {
+            accepted++;
+        } else if (status == IMAGE_QUEUE_FULL) {
+            rejected++;
+        }
+    }
+    
+    // Jobs hold their own reference to the source image
+    free_vimage_handle(vimg);
+    
+    {
+        std::unique_lock<std::mutex> lock(tally.mutex);
+        tally.finished.wait(lock, [&] { return tally.completed == accepted; });
+    }
+    
+    // An in-place pipeline has no result to deliver and is refused
+    spec.output.format = IMAGE_FORMAT_NONE;
+    bool ok = submit_job(pool, spec, count_pool_job, &tally) == IMAGE_INVALID_FORMAT;
+    destroy_worker_pool(pool);
+    
+    std::cout << "   Accepted " << accepted << ", rejected " << rejected << ", succeeded " << tally.succeeded
+              << " (" << tally.bytes << " bytes)" << std::endl;
+    return ok && accepted > 0 && accepted + rejected == 20 && tally.succeeded == accepted;
+}
+
+// Collects messages routed through vips_wrapper_set_log_handler
+static void capture_log(ImageLogLevel level, const char* message, void* user_data) {
+    static_cast<std::vector<std::string>*>(user_data)->push_back(message);
+}
+
+/**
+ * @brief Tests operation counters, latency histograms and the log handler
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_stats_and_logging(const char* input_path) {
+    std::cout << "\n=== Test 16: Stats and Logging ===" << std::endl;
+    
+    std::vector<std::string> messages;
+    vips_wrapper_set_log_handler(capture_log, &messages);
+    vips_wrapper_reset_stats();
+    
+    VImageHandle vimg = load_image(input_path);
+    bool ok = vimg && resize_image(vimg, ImageResizeOptions{1, 400, 300}) == SUCCESS;
+    ImageBuffer jpeg = encode_to_jpeg(vimg, ImageEncodeJPEGOptions{80, 0});
+    ok = ok && jpeg.data;
+    size_t encoded = jpeg.size;
+    free_image_buffer(jpeg);
+    
+    // A failing call is counted and logged through the handler, not stderr
+    ok = ok && crop_image(vimg, ImageCropOptions{0, 0, 100000, 10}) != SUCCESS;
+    free_vimage_handle(vimg);
+    vips_wrapper_set_log_handler(vips_wrapper_log_to_stderr, nullptr);
+    
+    ImageStats stats;
+    vips_wrapper_get_stats(&stats);
+    const ImageOperationStats& load = stats.ops[IMAGE_OP_LOAD];
+    const ImageOperationStats& encode = stats.ops[IMAGE_OP_ENCODE];
+    const ImageOperationStats& crop = stats.ops[IMAGE_OP_CROP];
+    
+    uint64_t bucketed = 0;
+    for (int b = 0; b < IMAGE_LATENCY_BUCKETS; ++b) {
+        bucketed += encode.latency_buckets[b];
+    }
+    ok = ok && load.calls == 1 && load.errors == 0 && stats.ops[IMAGE_OP_RESIZE].calls == 1 &&
+         encode.calls == 1 && encode.bytes_out == encoded && bucketed == 1 && encode.latency_ns_sum > 0 &&
+         crop.calls == 1 && crop.errors == 1 && !messages.empty();
+    ok = ok && vips_wrapper_latency_bucket_bound_ns(0) < vips_wrapper_latency_bucket_bound_ns(1) &&
+         vips_wrapper_latency_bucket_bound_ns(IMAGE_LATENCY_BUCKETS - 1) == UINT64_MAX;
+    
+    std::cout << "   " << vips_wrapper_operation_name(IMAGE_OP_ENCODE) << ": " << encode.calls << " calls, "
+              << encode.latency_ns_sum / 1000 << " us, " << encode.bytes_out << " bytes out" << std::endl;
+    std::cout << "   Captured " << messages.size() << " log message(s)" << std::endl;
+    std::cout << "   libvips memory: " << stats.vips_mem << " bytes (peak " << stats.vips_mem_highwater
+              << "), cache " << stats.cache_size << "/" << stats.cache_max << std::endl;
+    return ok;
+}
+
+/**
+ * @brief Tests thread-local error detail and loader status out-params
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_error_detail(const char* input_path) {
+    std::cout << "\n=== Test 17: Error Detail ===" << std::endl;
+    
+    // Detail is recorded even with logging disabled
+    vips_wrapper_set_log_handler(nullptr, nullptr);
+    vips_wrapper_clear_error();
+    bool ok = vips_wrapper_last_error()->code == SUCCESS;
+    
+    const unsigned char garbage[16] = {0};
+    ImageStatus status = SUCCESS;
+    VImageHandle vimg = load_image_from_bytes_with_options(garbage, sizeof(garbage),
+                                                           ImageLoadOptions{IMAGE_ACCESS_RANDOM}, &status);
+    const ImageError* err = vips_wrapper_last_error();
+    ok = ok && !vimg && status == IMAGE_LOAD_FAILURE && err->code == IMAGE_LOAD_FAILURE &&
+         err->operation == IMAGE_OP_LOAD && err->message[0] != '\0';
+    std::cout << "   Garbage load: " << err->message << std::endl;
+    
+    vimg = load_image_with_options("", ImageLoadOptions{IMAGE_ACCESS_RANDOM}, &status);
+    ok = ok && !vimg && status == IMAGE_INVALID_PATH;
+    
+    // Successful calls report SUCCESS through the out-param and leave the record alone
+    vimg = thumbnail_from_path(input_path, ImageResizeOptions{1, 200, 200}, &status);
+    ok = ok && vimg && status == SUCCESS && vips_wrapper_last_error()->code == IMAGE_INVALID_PATH;
+    
+    ok = ok && crop_image(vimg, ImageCropOptions{0, 0, 100000, 10}) == IMAGE_INVALID_BOUNDS &&
+         err->code == IMAGE_INVALID_BOUNDS && err->operation == IMAGE_OP_CROP;
+    
+    ImageBuffer buffer = encode_to_format(vimg, "jpg", nullptr);
+    ok = ok && !buffer.data && err->code == IMAGE_INVALID_FORMAT && err->operation == IMAGE_OP_ENCODE;
+    
+    // A too-small output buffer is reported with the size needed
+    unsigned char small[16];
+    size_t needed = 0;
+    ok = ok && encode_to_jpeg_into(vimg, ImageEncodeJPEGOptions{80, 0}, small, sizeof(small), &needed) ==
+                   IMAGE_BUFFER_TOO_SMALL && err->code == IMAGE_BUFFER_TOO_SMALL && needed > sizeof(small);
+    
+    // Records are per thread
+    ImageStatus other_thread_code = UNKNOWN_ERROR;
+    std::thread([&] { other_thread_code = vips_wrapper_last_error()->code; }).join();
+    ok = ok && other_thread_code == SUCCESS;
+    
+    free_vimage_handle(vimg);
+    vips_wrapper_set_log_handler(vips_wrapper_log_to_stderr, nullptr);
+    return ok;
+}
+
+/**
+ * @brief Tests header-only probing from path and bytes
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_probe(const char* input_path) {
+    std::cout << "\n=== Test 18: Header Probe ===" << std::endl;
+    
+    ImageMeta meta;
+    ImageProbeOptions probe = {0, 1};
+    bool ok = probe_image_from_path(input_path, probe, &meta) == SUCCESS;
+    
+    VImageHandle vimg = load_image(input_path);
+    ImageMeta loaded = extract_metadata(vimg);
+    ok = ok && vimg && meta.width == loaded.width && meta.height == loaded.height &&
+         meta.channels == loaded.channels && meta.file_size > 0 && meta.pages == 1 &&
+         meta.orientation >= 1 && meta.orientation <= 8 && std::strcmp(meta.format, loaded.format) == 0;
+    std::cout << "   " << meta.width << "x" << meta.height << " " << meta.format << ", " << meta.file_size
+              << " bytes, orientation " << meta.orientation << ", icc " << meta.has_icc << std::endl;
+    
+    // Over the pixel limit: rejected, but the dimensions are still reported
+    ImageMeta limited;
+    ok = ok && probe_image_from_path(input_path, ImageProbeOptions{1000, 1}, &limited) == IMAGE_TOO_LARGE &&
+         limited.width == meta.width && vips_wrapper_last_error()->code == IMAGE_TOO_LARGE;
+    
+    // Bytes: a PNG with alpha
+    change_image_opacity(vimg, ImageOpacityOptions{0.5});
+    ImageBuffer png = encode_to_png(vimg, ImageEncodePNGOptions{1, 0});
+    ok = ok && png.data && probe_image_from_bytes(png.data, png.size, probe, &meta) == SUCCESS &&
+         meta.has_alpha && meta.channels == 4 && meta.file_size == static_cast<long>(png.size);
+    free_image_buffer(png);
+    free_vimage_handle(vimg);
+    
+    const unsigned char garbage[64] = {0};
+    ok = ok && probe_image_from_bytes(garbage, sizeof(garbage), probe, &meta) == IMAGE_INVALID_FORMAT;
+    ok = ok && probe_image_from_path("./test/does-not-exist.jpg", probe, &meta) == IMAGE_INVALID_PATH;
+    return ok;
+}
+
+/**
+ * @brief Tests that loader size limits reject images before decoding
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_load_limits(const char* input_path) {
+    std::cout << "\n=== Test 19: Load Limits ===" << std::endl;
+    
+    ImageMeta meta;
+    if (probe_image_from_path(input_path, ImageProbeOptions{0, 0}, &meta) != SUCCESS) {
+        std::cout << "   Failed to probe test image" << std::endl;
+        return false;
+    }
+    uint64_t pixels = static_cast<uint64_t>(meta.width) * meta.height;
+    
+    // Exactly at every limit: accepted
+    ImageLoadOptions fits = {IMAGE_ACCESS_SEQUENTIAL, meta.width, meta.height, pixels,
+                             static_cast<uint64_t>(meta.file_size), IMAGE_FAIL_ON_ERROR};
+    ImageStatus status = UNKNOWN_ERROR;
+    VImageHandle vimg = load_image_with_options(input_path, fits, &status);
+    bool ok = vimg && status == SUCCESS;
+    free_vimage_handle(vimg);
+    
+    // One over each limit: rejected from the header alone
+    ImageLoadOptions over[] = {
+        {IMAGE_ACCESS_RANDOM, meta.width - 1, 0, 0, 0, IMAGE_FAIL_ON_NONE},
+        {IMAGE_ACCESS_RANDOM, 0, meta.height - 1, 0, 0, IMAGE_FAIL_ON_NONE},
+        {IMAGE_ACCESS_RANDOM, 0, 0, pixels - 1, 0, IMAGE_FAIL_ON_NONE},
+        {IMAGE_ACCESS_RANDOM, 0, 0, 0, static_cast<uint64_t>(meta.file_size) - 1, IMAGE_FAIL_ON_NONE},
+    };
+    for (const ImageLoadOptions& options : over) {
+        vimg = load_image_with_options(input_path, options, &status);
+        ok = ok && !vimg && status == IMAGE_TOO_LARGE && vips_wrapper_last_error()->code == IMAGE_TOO_LARGE;
+    }
+    std::cout << "   Rejected: " << vips_wrapper_last_error()->message << std::endl;
+    
+    // Buffer loaders apply the same limits
+    size_t size = 0;
+    unsigned char* data = read_file_to_malloc(input_path, &size);
+    if (!data) {
+        std::cout << "   Failed to read test image" << std::endl;
+        return false;
+    }
+    vimg = load_image_from_bytes_with_options(data, size, over[2], &status);
+    ok = ok && !vimg && status == IMAGE_TOO_LARGE;
+    vimg = load_image_from_bytes_with_options(data, size, over[3], &status);
+    ok = ok && !vimg && status == IMAGE_TOO_LARGE;
+    vimg = load_image_from_bytes_with_options(data, size, fits, &status);
+    ok = ok && vimg && status == SUCCESS;
+    free_vimage_handle(vimg);
+    free(data);
+    return ok;
+}
+
+/**
+ * @brief Tests prepared watermarks: placement, tiling, blend modes, threads and pipelines
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_prepared_watermark(const char* input_path) {
+    std::cout << "\n=== Test 20: Prepared Watermark ===" << std::endl;
+    
+    VImageHandle logo = thumbnail_from_path(input_path, ImageResizeOptions{1, 200, 0}, nullptr);
+    ImageStatus status = UNKNOWN_ERROR;
+    ImageWatermarkHandle mark = prepare_watermark(logo, 0.5, IMAGE_BLEND_OVER, &status);
+    ImageWatermarkHandle multiply = prepare_watermark(logo, 1.0, IMAGE_BLEND_MULTIPLY, nullptr);
+    free_vimage_handle(logo); // The prepared watermarks no longer need it
+    bool ok = mark && multiply && status == SUCCESS;
+    
+    VImageHandle base = load_image(input_path);
+    ImageMeta base_meta = extract_metadata(base);
+    ImageWatermarkPlacement placements[] = {
+        {IMAGE_GRAVITY_SOUTH_EAST, 16, 16, 0.25},
+        {IMAGE_GRAVITY_CENTRE, 0, 0, 0.0},
+        {IMAGE_GRAVITY_TILE, 7, 7, 0.1},
+        {IMAGE_GRAVITY_NONE, -50, -50, 0.0}, // Partly outside: clipped
+    };
+    for (const ImageWatermarkPlacement& placement : placements) {
+        ok = ok && watermark_image_prepared(base, mark, placement) == SUCCESS;
+    }
+    ok = ok && watermark_image_prepared(base, multiply, placements[0]) == SUCCESS;
+    ImageMeta stamped = extract_metadata(base);
+    ok = ok && stamped.width == base_meta.width && stamped.height == base_meta.height;
+    
+    ImageBuffer jpeg = encode_to_jpeg(base, ImageEncodeJPEGOptions{85, 0});
+    ok = ok && jpeg.data;
+    std::cout << "   Stamped " << stamped.width << "x" << stamped.height << ": " << jpeg.size << " bytes" << std::endl;
+    save_encoded_image(jpeg.data, jpeg.size, "./test/test_prepared_watermark.jpg");
+    free_image_buffer(jpeg);
+    free_vimage_handle(base);
+    
+    // One prepared watermark shared by several threads at once
+    std::vector<std::thread> threads;
+    std::atomic<int> failures{0};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            VImageHandle img = thumbnail_from_path(input_path, ImageResizeOptions{1, 400 + 100 * t, 0}, nullptr);
+            ImageBuffer out = {nullptr, 0};
+            if (watermark_image_prepared(img, mark, placements[0]) == SUCCESS) {
+                out = encode_to_jpeg(img, ImageEncodeJPEGOptions{80, 0});
+            }
+            if (!out.data) failures++;
+            free_image_buffer(out);
+            free_vimage_handle(img);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    ok = ok && failures == 0;
+    
+    // Pipeline step; the pipeline needs no reference beyond the call
+    VImageHandle img = load_image(input_path);
+    ImagePipelineOp ops[2] = {};
+    ops[0].type = PIPELINE_OP_RESIZE;
+    ops[0].resize = ImageResizeOptions{1, 800, 600};
+    ops[1].type = PIPELINE_OP_PREPARED_WATERMARK;
+    ops[1].prepared_watermark = mark;
+    ops[1].placement = ImageWatermarkPlacement{IMAGE_GRAVITY_NORTH_WEST, 10, 10, 0.2};
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_JPEG;
+    out.jpeg = ImageEncodeJPEGOptions{80, 0};
+    ImageBuffer piped = {nullptr, 0};
+    ok = ok && process_pipeline(img, ops, 2, out, &piped) == SUCCESS && piped.data;
+    free_image_buffer(piped);
+    
+    ops[1].prepared_watermark = nullptr;
+    ok = ok && process_pipeline(img, ops, 2, out, &piped) == VIPS_INVALID_HANDLE;
+    ok = ok && !prepare_watermark(nullptr, 0.5, IMAGE_BLEND_OVER, &status) && status == VIPS_INVALID_HANDLE;
+    
+    free_vimage_handle(img);
+    free_watermark(mark);
+    free_watermark(multiply);
+    free_watermark(nullptr);
+    return ok;
+}
+
+/**
+ * @brief Tests multi-size rendition generation from a handle and from encoded bytes
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_renditions(const char* input_path) {
+    std::cout << "\n=== Test 21: Renditions ===" << std::endl;
+    
+    // Deliberately unsorted, with an exact box and a height-only target
+    ImageRenditionSpec specs[4] = {};
+    specs[0].resize = ImageResizeOptions{1, 400, 0};
+    specs[1].resize = ImageResizeOptions{1, 1200, 0};
+    specs[2].resize = ImageResizeOptions{0, 300, 300};
+    specs[3].resize = ImageResizeOptions{1, 0, 100};
+    for (auto& spec : specs) {
+        spec.output.format = IMAGE_FORMAT_JPEG;
+        spec.output.jpeg = ImageEncodeJPEGOptions{80, 0};
+    }
+    specs[2].output.format = IMAGE_FORMAT_PNG;
+    specs[2].output.png = ImageEncodePNGOptions{6, 0};
+    
+    VImageHandle vimg = load_image(input_path);
+    size_t size = 0;
+    unsigned char* data = read_file_to_malloc(input_path, &size);
+    if (!vimg || !data) {
+        std::cout << "   Failed to load image" << std::endl;
+        free_vimage_handle(vimg);
+        free(data);
+        return false;
+    }
+    
+    ImageBuffer from_handle[4];
+    ImageBuffer from_bytes[4];
+    bool ok = generate_renditions(vimg, specs, 4, from_handle) == SUCCESS;
+    ok = ok && generate_renditions_from_buffer(data, size, specs, 4, from_bytes) == SUCCESS;
+    
+    // Every rendition has the size resize_image() gives it
+    for (int i = 0; ok && i < 4; ++i) {
+        VImageHandle expected = load_image(input_path);
+        resize_image(expected, specs[i].resize);
+        ImageMeta want = extract_metadata(expected);
+        free_vimage_handle(expected);
+        
+        ImageMeta got_handle, got_bytes;
+        ok = probe_image_from_bytes(from_handle[i].data, from_handle[i].size, ImageProbeOptions{0, 1}, &got_handle) == SUCCESS &&
+             probe_image_from_bytes(from_bytes[i].data, from_bytes[i].size, ImageProbeOptions{0, 1}, &got_bytes) == SUCCESS &&
+             got_handle.width == want.width && got_handle.height == want.height &&
+             got_bytes.width == want.width && got_bytes.height == want.height;
+        std::cout << "   Rendition " << i << ": " << got_handle.width << "x" << got_handle.height << " "
+                  << got_handle.format << ", " << from_handle[i].size << " / " << from_bytes[i].size << " bytes" << std::endl;
+    }
+    for (int i = 0; i < 4; ++i) {
+        free_image_buffer(from_handle[i]);
+        free_image_buffer(from_bytes[i]);
+    }
+    
+    // A level is never stretched from a smaller one: with a wide, flat spec sorted first,
+    // the 400x300 rendition matches the one made on its own
+    ImageRenditionSpec mixed[2] = {};
+    mixed[0].resize = ImageResizeOptions{0, 2000, 100};
+    mixed[1].resize = ImageResizeOptions{0, 400, 300};
+    for (auto& spec : mixed) {
+        spec.output.format = IMAGE_FORMAT_PNG;
+        spec.output.png = ImageEncodePNGOptions{6, 0};
+    }
+    ImageBuffer both[2] = {};
+    ImageBuffer alone[1] = {};
+    ImageBuffer shrunk[2] = {};
+    ok = ok && generate_renditions(vimg, mixed, 2, both) == SUCCESS;
+    ok = ok && generate_renditions(vimg, &mixed[1], 1, alone) == SUCCESS;
+    ok = ok && both[1].size == alone[0].size && std::memcmp(both[1].data, alone[0].data, alone[0].size) == 0;
+    ok = ok && generate_renditions_from_buffer(data, size, mixed, 2, shrunk) == SUCCESS;
+    ImageMeta flat = {};
+    ok = ok && probe_image_from_bytes(shrunk[1].data, shrunk[1].size, ImageProbeOptions{0, 1}, &flat) == SUCCESS &&
+         flat.width == 400 && flat.height == 300;
+    for (int i = 0; i < 2; ++i) {
+        free_image_buffer(both[i]);
+        free_image_buffer(shrunk[i]);
+    }
+    free_image_buffer(alone[0]);
+    
+    // An invalid spec fails the whole call and leaves no buffers behind
+    specs[3].output.format = IMAGE_FORMAT_NONE;
+    ok = ok && generate_renditions(vimg, specs, 4, from_handle) == IMAGE_INVALID_FORMAT;
+    ok = ok && generate_renditions_from_buffer(data, 16, specs, 3, from_bytes) == IMAGE_LOAD_FAILURE;
+    
+    // The load limits apply before anything is decoded
+    ImageLoadOptions limited = {};
+    limited.max_pixels = 1;
+    ok = ok && generate_renditions_from_buffer_with_options(data, size, limited, specs, 3, from_bytes) == IMAGE_TOO_LARGE;
+    
+    free_vimage_handle(vimg);
+    free(data);
+    return ok;
+}
+
+/**
+ * @brief Tests conversion to 8-bit sRGB, standalone and as a pipeline step
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_ensure_srgb8(const char* input_path) {
+    std::cout << "\n=== Test 22: 8-bit sRGB Conversion ===" << std::endl;
+    
+    VImageHandle vimg = load_image(input_path);
+    if (!vimg) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImageMeta before = extract_metadata(vimg);
+    bool ok = ensure_srgb8(vimg, ImageSRGBOptions{0, IMAGE_INTENT_RELATIVE}) == SUCCESS;
+    ImageMeta after = extract_metadata(vimg);
+    std::cout << "   " << before.colorspace << " (icc " << before.has_icc << ") -> " << after.colorspace
+              << " (icc " << after.has_icc << ")" << std::endl;
+    ok = ok && after.width == before.width && after.height == before.height && !after.has_icc &&
+         (std::strcmp(after.colorspace, "srgb") == 0 || std::strcmp(after.colorspace, "b-w") == 0);
+    
+    // Alpha survives the conversion
+    change_image_opacity(vimg, ImageOpacityOptions{0.5});
+    ok = ok && ensure_srgb8(vimg, ImageSRGBOptions{1, IMAGE_INTENT_PERCEPTUAL}) == SUCCESS &&
+         extract_metadata(vimg).has_alpha;
+    
+    // As the first pipeline step, ahead of the resize
+    ImagePipelineOp ops[2] = {};
+    ops[0].type = PIPELINE_OP_ENSURE_SRGB8;
+    ops[1].type = PIPELINE_OP_RESIZE;
+    ops[1].resize = ImageResizeOptions{1, 320, 0};
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_PNG;
+    out.png = ImageEncodePNGOptions{6, 0};
+    ImageBuffer png = {nullptr, 0};
+    ok = ok && process_pipeline(vimg, ops, 2, out, &png) == SUCCESS && png.data;
+    free_image_buffer(png);
+    
+    ok = ok && ensure_srgb8(nullptr, ImageSRGBOptions{}) == VIPS_INVALID_HANDLE;
+    free_vimage_handle(vimg);
+    return ok;
+}
+
+/**
+ * @brief Tests right-angle rotation, flips and EXIF autorotation on load and thumbnail
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_orientation(const char* input_path) {
+    std::cout << "\n=== Test 23: Orientation ===" << std::endl;
+    
+    VImageHandle vimg = load_image_with_options(input_path, ImageLoadOptions{IMAGE_ACCESS_SEQUENTIAL}, nullptr);
+    if (!vimg) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImageMeta original = extract_metadata(vimg);
+    
+    // Right angles are exact remaps: no canvas growth, even for a sequential source
+    bool ok = rotate_image(vimg, ImageRotateOptions{-270.0}) == SUCCESS;
+    ImageMeta turned = extract_metadata(vimg);
+    ok = ok && turned.width == original.height && turned.height == original.width;
+    ok = ok && rotate_image(vimg, ImageRotateOptions{450.0}) == SUCCESS;
+    ImageMeta upside_down = extract_metadata(vimg);
+    ok = ok && upside_down.width == original.width && upside_down.height == original.height;
+    std::cout << "   " << original.width << "x" << original.height << " -> " << turned.width << "x"
+              << turned.height << " -> " << upside_down.width << "x" << upside_down.height << std::endl;
+    
+    ok = ok && flip_image(vimg, ImageFlipOptions{IMAGE_FLIP_HORIZONTAL}) == SUCCESS &&
+         flip_image(vimg, ImageFlipOptions{IMAGE_FLIP_VERTICAL}) == SUCCESS;
+    ImageBuffer jpeg = encode_to_jpeg(vimg, ImageEncodeJPEGOptions{80, 0});
+    ok = ok && jpeg.data && extract_metadata(vimg).width == original.width;
+    free_image_buffer(jpeg);
+    free_vimage_handle(vimg);
+    
+    // Flip as a pipeline step
+    ImagePipelineOp ops[1] = {};
+    ops[0].type = PIPELINE_OP_FLIP;
+    ops[0].flip = ImageFlipOptions{IMAGE_FLIP_VERTICAL};
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_JPEG;
+    out.jpeg = ImageEncodeJPEGOptions{80, 0};
+    ImageBuffer flipped = {nullptr, 0};
+    vimg = load_image(input_path);
+    ok = ok && vimg && process_pipeline(vimg, ops, 1, out, &flipped) == SUCCESS && flipped.data;
+    free_image_buffer(flipped);
+    free_vimage_handle(vimg);
+    
+    // Autorotated loads come out upright, with the tag reset
+    ImageLoadOptions upright = {};
+    upright.access = IMAGE_ACCESS_SEQUENTIAL;
+    upright.autorotate = 1;
+    vimg = load_image_with_options(input_path, upright, nullptr);
+    ok = ok && vimg && extract_metadata(vimg).orientation == 1;
+    free_vimage_handle(vimg);
+    
+    VImageHandle thumb = thumbnail_from_path_with_options(input_path, ImageResizeOptions{1, 200, 200}, upright, nullptr);
+    ok = ok && thumb && extract_metadata(thumb).orientation == 1;
+    free_vimage_handle(thumb);
+    
+    // Thumbnails enforce the load limits against the source
+    ImageLoadOptions limited = {};
+    limited.max_pixels = 16;
+    ImageStatus status = SUCCESS;
+    thumb = thumbnail_from_path_with_options(input_path, ImageResizeOptions{1, 2, 2}, limited, &status);
+    ok = ok && !thumb && status == IMAGE_TOO_LARGE;
+    
+    ok = ok && flip_image(nullptr, ImageFlipOptions{}) == VIPS_INVALID_HANDLE;
+    return ok;
+}
+
+/**
+ * @brief Tests cover-fit resizing for every crop mode, on handles, thumbnails and pipelines
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_cover(const char* input_path) {
+    std::cout << "\n=== Test 24: Cover Fit ===" << std::endl;
+    
+    const ImageCropMode modes[] = {IMAGE_CROP_CENTRE, IMAGE_CROP_ATTENTION, IMAGE_CROP_ENTROPY, IMAGE_CROP_GRAVITY};
+    bool ok = true;
+    for (ImageCropMode mode : modes) {
+        ImageCoverOptions cover = {160, 90, mode, IMAGE_GRAVITY_SOUTH_EAST};
+        
+        VImageHandle vimg = load_image_with_options(input_path, ImageLoadOptions{IMAGE_ACCESS_SEQUENTIAL}, nullptr);
+        ok = ok && vimg && cover_image(vimg, cover) == SUCCESS;
+        ImageMeta resized = vimg ? extract_metadata(vimg) : ImageMeta{};
+        ImageBuffer jpeg = vimg ? encode_to_jpeg(vimg, ImageEncodeJPEGOptions{80, 0}) : ImageBuffer{nullptr, 0};
+        ok = ok && jpeg.data && resized.width == 160 && resized.height == 90;
+        free_image_buffer(jpeg);
+        free_vimage_handle(vimg);
+        
+        // The crop window is chosen after shrink-on-load
+        VImageHandle thumb = thumbnail_cover_from_path(input_path, cover, ImageLoadOptions{}, nullptr);
+        ImageMeta shrunk = thumb ? extract_metadata(thumb) : ImageMeta{};
+        ok = ok && thumb && shrunk.width == 160 && shrunk.height == 90;
+        std::cout << "   Mode " << mode << ": " << resized.width << "x" << resized.height << ", thumbnail "
+                  << shrunk.width << "x" << shrunk.height << std::endl;
+        free_vimage_handle(thumb);
+    }
+    
+    // Square from bytes, as a pipeline step and with invalid boxes
+    size_t size = 0;
+    unsigned char* data = read_file_to_malloc(input_path, &size);
+    VImageHandle square = data ? thumbnail_cover_from_buffer(data, size, ImageCoverOptions{128, 128}, ImageLoadOptions{},
+                                                             nullptr) : nullptr;
+    ok = ok && square && extract_metadata(square).width == 128 && extract_metadata(square).height == 128;
+    free_vimage_handle(square);
+    free(data);
+    
+    VImageHandle vimg = load_image(input_path);
+    ImagePipelineOp ops[1] = {};
+    ops[0].type = PIPELINE_OP_COVER;
+    ops[0].cover = ImageCoverOptions{64, 64, IMAGE_CROP_ATTENTION};
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_JPEG;
+    out.jpeg = ImageEncodeJPEGOptions{80, 0};
+    ImageBuffer result = {nullptr, 0};
+    ok = ok && vimg && process_pipeline(vimg, ops, 1, out, &result) == SUCCESS && result.data;
+    free_image_buffer(result);
+    
+    ImageStatus status = SUCCESS;
+    ok = ok && cover_image(vimg, ImageCoverOptions{100, 0}) == IMAGE_INVALID_DIMENSIONS &&
+         !thumbnail_cover_from_path(input_path, ImageCoverOptions{0, 100}, ImageLoadOptions{}, &status) &&
+         status == IMAGE_INVALID_DIMENSIONS;
+    free_vimage_handle(vimg);
+    
+    ok = ok && cover_image(nullptr, ImageCoverOptions{100, 100}) == VIPS_INVALID_HANDLE;
+    return ok;
+}
+
+/**
+ * @brief Tests page selection on the loaders and GIF output with frame-aware transforms
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_multi_page(const char* input_path) {
+    std::cout << "\n=== Test 25: Multi-page Images ===" << std::endl;
+    
+    // Single-page formats load one frame for any n, and have no second page
+    ImageLoadOptions all_pages = {IMAGE_ACCESS_SEQUENTIAL};
+    all_pages.n = -1;
+    VImageHandle vimg = load_image_with_options(input_path, all_pages, nullptr);
+    bool ok = vimg && extract_metadata(vimg).frames == 1;
+    
+    ImageLoadOptions second_page = {};
+    second_page.page = 1;
+    ImageStatus status = SUCCESS;
+    ok = ok && !load_image_with_options(input_path, second_page, &status) && status == IMAGE_INVALID_BOUNDS;
+    
+    // GIF output, then back through the multi-page loader
+    ok = ok && vimg && resize_image(vimg, ImageResizeOptions{1, 200, 0}) == SUCCESS;
+    ImageBuffer gif = vimg ? encode_to_gif(vimg, ImageEncodeGIFOptions{4, 6}) : ImageBuffer{nullptr, 0};
+    free_vimage_handle(vimg);
+    ok = ok && gif.data && gif.size > 6 && std::memcmp(gif.data, "GIF8", 4) == 0;
+    std::cout << "   GIF: " << gif.size << " bytes" << std::endl;
+    
+    VImageHandle frames = gif.data ? load_image_from_bytes_with_options(gif.data, gif.size, all_pages, nullptr) : nullptr;
+    ImageMeta meta = frames ? extract_metadata(frames) : ImageMeta{};
+    ok = ok && frames && meta.frames >= 1 && meta.height % meta.frames == 0;
+    
+    ImagePipelineOp ops[2] = {};
+    ops[0].type = PIPELINE_OP_CROP;
+    ops[0].crop = ImageCropOptions{10, 10, 100, 80};
+    ops[1].type = PIPELINE_OP_FLIP;
+    ops[1].flip = ImageFlipOptions{IMAGE_FLIP_VERTICAL};
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_GIF;
+    ImageBuffer result = {nullptr, 0};
+    ok = ok && frames && process_pipeline(frames, ops, 2, out, &result) == SUCCESS && result.data;
+    free_image_buffer(result);
+    free_vimage_handle(frames);
+    free_image_buffer(gif);
+    return ok;
+}
+
+/**
+ * @brief Tests cloned handles and the functional transforms on a handle shared between threads
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_shared_handles(const char* input_path) {
+    std::cout << "\n=== Test 26: Shared Handles ===" << std::endl;
+    
+    VImageHandle shared = load_image(input_path);
+    if (!shared) {
+        std::cerr << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImageMeta before = extract_metadata(shared);
+    
+    // One decode fanned out to several workers, each deriving its own size
+    const int widths[] = {80, 160, 240, 320};
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> workers;
+    for (int width : widths) {
+        workers.emplace_back([&, width] {
+            VImageHandle small = nullptr;
+            if (resize_image_to(shared, &small, ImageResizeOptions{1, width, 0}) != SUCCESS ||
+                extract_metadata(small).width != width) {
+                ok = false;
+            }
+            ImageBuffer jpeg = small ? encode_to_jpeg(small, ImageEncodeJPEGOptions{75, 0}) : ImageBuffer{nullptr, 0};
+            ok = ok && jpeg.data;
+            free_image_buffer(jpeg);
+            free_vimage_handle(small);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    ImageMeta after = extract_metadata(shared);
+    ok = ok && after.width == before.width && after.height == before.height;
+    std::cout << "   " << workers.size() << " renditions from one decode" << std::endl;
+    
+    // A clone is transformed in place without touching the original
+    VImageHandle clone = clone_vimage_handle(shared);
+    ok = ok && clone && crop_image(clone, ImageCropOptions{0, 0, 50, 40}) == SUCCESS;
+    ok = ok && extract_metadata(clone).width == 50 && extract_metadata(shared).width == before.width;
+    
+    VImageHandle turned = nullptr;
+    ok = ok && rotate_image_to(clone, &turned, ImageRotateOptions{90}) == SUCCESS &&
+         extract_metadata(turned).width == 40 && extract_metadata(clone).width == 50;
+    free_vimage_handle(turned);
+    free_vimage_handle(clone);
+    
+    // Failures leave the output handle NULL
+    VImageHandle cropped = shared;
+    ok = ok && crop_image_to(shared, &cropped, ImageCropOptions{0, 0, before.width + 1, 10}) != SUCCESS &&
+         cropped == nullptr;
+    ok = ok && resize_image_to(nullptr, &cropped, ImageResizeOptions{1, 10, 0}) == VIPS_INVALID_HANDLE;
+    ok = ok && !clone_vimage_handle(nullptr);
+    free_vimage_handle(shared);
+    return ok;
+}
+
+/**
+ * @brief Tests batch processing of paths and buffers with per-item status
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_batch(const char* input_path) {
+    std::cout << "\n=== Test 27: Batch Processing ===" << std::endl;
+    
+    size_t size = 0;
+    unsigned char* data = read_file_to_malloc(input_path, &size);
+    if (!data) {
+        std::cout << "   Failed to read test image" << std::endl;
+        return false;
+    }
+    
+    std::vector<ImageBatchItem> items;
+    for (int i = 0; i < 6; ++i) {
+        items.push_back(i % 2 ? ImageBatchItem{nullptr, data, size} : ImageBatchItem{input_path, nullptr, 0});
+    }
+    items.push_back(ImageBatchItem{"./test/missing.jpg", nullptr, 0});
+    items.push_back(ImageBatchItem{nullptr, nullptr, 0});
+    
+    ImagePipelineOp resize = {};
+    resize.type = PIPELINE_OP_RESIZE;
+    resize.resize = ImageResizeOptions{1, 160, 0};
+    ImageBatchSpec spec = {};
+    spec.load.access = IMAGE_ACCESS_SEQUENTIAL;
+    spec.ops = &resize;
+    spec.op_count = 1;
+    spec.output.format = IMAGE_FORMAT_JPEG;
+    spec.output.jpeg.quality = 80;
+    
+    std::vector<ImageBatchResult> results(items.size());
+    auto start = high_resolution_clock::now();
+    ImageStatus status = process_batch(items.data(), items.size(), spec, results.data(), 4);
+    auto ms = duration_cast<milliseconds>(high_resolution_clock::now() - start).count();
+    
+    // The bad items fail on their own without failing the batch
+    bool ok = status == SUCCESS && results[6].status != SUCCESS;
+    for (size_t i = 0; i < 6; ++i) {
+        ok = ok && results[i].status == SUCCESS && results[i].output.data && results[i].output.size > 0;
+    }
+    ok = ok && !results[6].output.data && results[6].error.code == results[6].status;
+    ok = ok && results[7].status == IMAGE_INVALID_PATH && results[7].error.message[0] != '\0';
+    std::cout << "   " << items.size() << " items in " << ms << "ms; failure: " << results[6].error.message << std::endl;
+    for (auto& result : results) {
+        free_image_buffer(result.output);
+    }
+    
+    // Encoding is required, and an empty batch succeeds
+    spec.output.format = IMAGE_FORMAT_NONE;
+    ok = ok && process_batch(items.data(), 1, spec, results.data(), 0) == IMAGE_INVALID_FORMAT;
+    spec.output.format = IMAGE_FORMAT_PNG;
+    ok = ok && process_batch(nullptr, 0, spec, nullptr, 0) == SUCCESS;
+    
+    free(data);
+    return ok;
+}
+
+/**
+ * @brief Tests saving straight to files and loading mapped .v intermediates
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_save_image(const char* input_path) {
+    std::cout << "\n=== Test 28: Save to File ===" << std::endl;
+    
+    VImageHandle vimg = load_image(input_path);
+    if (!vimg) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImageMeta meta = extract_metadata(vimg);
+    
+    ImageEncodeSpec jpeg = {};
+    jpeg.format = IMAGE_FORMAT_JPEG;
+    jpeg.jpeg.quality = 80;
+    bool ok = save_image(vimg, "./test/test_saved.jpg", jpeg) == SUCCESS;
+    ImageMeta probed = {};
+    ok = ok && probe_image_from_path("./test/test_saved.jpg", ImageProbeOptions{}, &probed) == SUCCESS &&
+         probed.width == meta.width && probed.file_size > 0;
+    std::cout << "   JPEG: " << probed.file_size << " bytes" << std::endl;
+    
+    // The extension picks the saver; a .v file loads mapped, also for sequential access
+    ImageEncodeSpec by_extension = {};
+    ok = ok && save_image(vimg, "./test/test_saved.v", by_extension) == SUCCESS;
+    free_vimage_handle(vimg);
+    
+    ImageLoadOptions sequential = {IMAGE_ACCESS_SEQUENTIAL};
+    VImageHandle mapped = load_image_with_options("./test/test_saved.v", sequential, nullptr);
+    ok = ok && mapped && extract_metadata(mapped).width == meta.width;
+    ok = ok && mapped && rotate_image(mapped, ImageRotateOptions{90}) == SUCCESS &&
+         extract_metadata(mapped).height == meta.width;
+    ImageBuffer png = mapped ? encode_to_png(mapped, ImageEncodePNGOptions{1, 0}) : ImageBuffer{nullptr, 0};
+    ok = ok && png.data;
+    free_image_buffer(png);
+    free_vimage_handle(mapped);
+    
+    // Failures leave no partial file behind and an existing file untouched
+    VImageHandle small = load_image(input_path);
+    ok = ok && small && save_image(small, "./test/no-such-dir/out.jpg", jpeg) == IMAGE_SAVE_FAILURE;
+    ok = ok && save_image(small, nullptr, jpeg) == IMAGE_INVALID_PATH;
+    std::ofstream("./test/test_saved.xyz") << "keep";
+    ok = ok && save_image(small, "./test/test_saved.xyz", by_extension) == IMAGE_SAVE_FAILURE;
+    std::string kept;
+    std::ifstream("./test/test_saved.xyz") >> kept;
+    ok = ok && kept == "keep";
+    std::filesystem::remove("./test/test_saved.xyz");
+    for (const auto& file : std::filesystem::directory_iterator("./test")) {
+        ok = ok && file.path().filename().string().rfind(".test_saved.tmp-", 0) != 0;
+    }
+    free_vimage_handle(small);
+    return ok;
+}
+
+/**
+ * @brief Tests the raw pixel cache: export, mapped reload, misses and LRU eviction
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_raw_cache(const char* input_path) {
+    std::cout << "\n=== Test 29: Raw Pixel Cache ===" << std::endl;
+    
+    const char* directory = "./test/raw_cache";
+    std::filesystem::remove_all(directory);
+    ImageStatus status = UNKNOWN_ERROR;
+    ImageRawCacheHandle cache = create_raw_cache(ImageRawCacheOptions{directory, 0}, &status);
+    if (!cache) {
+        std::cout << "   Failed to create raw cache" << std::endl;
+        return false;
+    }
+    
+    // A pre-shrunk master, decoded once
+    VImageHandle master = load_image(input_path);
+    bool ok = master && resize_image(master, ImageResizeOptions{1, 256, 0}) == SUCCESS;
+    ImageMeta meta = master ? extract_metadata(master) : ImageMeta{};
+    ok = ok && export_to_raw_cache(cache, "master-a", master) == SUCCESS;
+    uint64_t entry_bytes = raw_cache_stats(cache).bytes;
+    
+    VImageHandle hit = load_from_raw_cache(cache, "master-a", &status);
+    ok = ok && hit && status == SUCCESS && extract_metadata(hit).width == meta.width;
+    ok = ok && hit && rotate_image(hit, ImageRotateOptions{90}) == SUCCESS;
+    ImageBuffer jpeg = hit ? encode_to_jpeg(hit, ImageEncodeJPEGOptions{80, 0}) : ImageBuffer{nullptr, 0};
+    ok = ok && jpeg.data;
+    free_image_buffer(jpeg);
+    free_vimage_handle(hit);
+    
+    ok = ok && !load_from_raw_cache(cache, "master-b", &status) && status == IMAGE_CACHE_MISS;
+    ImageRawCacheStats stats = raw_cache_stats(cache);
+    ok = ok && stats.entries == 1 && stats.hits == 1 && stats.misses == 1 && entry_bytes > 0;
+    destroy_raw_cache(cache);
+    
+    // Temporaries left by a crashed writer are deleted on open; recent ones are kept
+    std::filesystem::path stale = std::filesystem::path(directory) / "tmp-1-2-3-0123456789abcdef.v";
+    std::filesystem::path fresh = std::filesystem::path(directory) / "tmp-4-5-6-0123456789abcdef.v";
+    std::ofstream(stale) << "partial";
+    std::ofstream(fresh) << "partial";
+    std::filesystem::last_write_time(stale, std::filesystem::file_time_type::clock::now() - std::chrono::hours(1));
+    
+    // Reopened with room for one entry: the existing file is indexed, and a new one evicts it
+    cache = create_raw_cache(ImageRawCacheOptions{directory, entry_bytes + entry_bytes / 2}, &status);
+    ok = ok && cache && raw_cache_stats(cache).entries == 1;
+    ok = ok && !std::filesystem::exists(stale) && std::filesystem::exists(fresh);
+    std::filesystem::remove(fresh);
+    ok = ok && cache && master && export_to_raw_cache(cache, "master-b", master) == SUCCESS;
+    stats = raw_cache_stats(cache);
+    ok = ok && stats.entries == 1 && stats.evictions == 1;
+    ok = ok && !load_from_raw_cache(cache, "master-a", &status) && status == IMAGE_CACHE_MISS;
+    hit = load_from_raw_cache(cache, "master-b", &status);
+    ok = ok && hit;
+    free_vimage_handle(hit);
+    std::cout << "   Entry: " << entry_bytes << " bytes, evictions: " << stats.evictions << std::endl;
+    
+    // An entry that can never fit is rejected
+    destroy_raw_cache(cache);
+    cache = create_raw_cache(ImageRawCacheOptions{directory, entry_bytes / 2}, &status);
+    ok = ok && cache && export_to_raw_cache(cache, "master-c", master) == IMAGE_TOO_LARGE;
+    ok = ok && export_to_raw_cache(cache, "", master) == IMAGE_INVALID_PATH;
+    destroy_raw_cache(cache);
+    free_vimage_handle(master);
+    std::filesystem::remove_all(directory);
+    return ok;
+}
+
+/**
+ * @brief Tests the result cache: hits, keying on options, coalesced renders and eviction
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_result_cache(const char* input_path) {
+    std::cout << "\n=== Test 30: Result Cache ===" << std::endl;
+    
+    size_t size = 0;
+    unsigned char* data = read_file_to_malloc(input_path, &size);
+    ImageStatus status = UNKNOWN_ERROR;
+    ImageResultCacheHandle cache = create_result_cache(ImageResultCacheOptions{0, 4}, &status);
+    if (!data || !cache) {
+        std::cout << "   Failed to create result cache" << std::endl;
+        free(data);
+        return false;
+    }
+    
+    ImagePipelineOp resize = {};
+    resize.type = PIPELINE_OP_RESIZE;
+    resize.resize = ImageResizeOptions{1, 160, 0};
+    ImageEncodeSpec out = {};
+    out.format = IMAGE_FORMAT_JPEG;
+    out.jpeg.quality = 80;
+    ImageLoadOptions load = {};
+    
+    // Eight identical calls at once render once; the rest wait for it or hit
+    std::vector<ImageCachedBuffer> buffers(8);
+    std::vector<ImageStatus> statuses(buffers.size(), UNKNOWN_ERROR);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            statuses[i] = process_cached(cache, data, size, load, &resize, 1, out, &buffers[i]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    bool ok = true;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        ok = ok && statuses[i] == SUCCESS && buffers[i].data == buffers[0].data && buffers[i].size > 0;
+    }
+    ImageResultCacheStats stats = result_cache_stats(cache);
+    ok = ok && stats.misses == 1 && stats.hits + stats.coalesced == buffers.size() - 1 && stats.entries == 1;
+    std::cout << "   " << buffers.size() << " calls: " << stats.misses << " render, " << stats.coalesced
+              << " coalesced, " << stats.hits << " hits" << std::endl;
+    
+    // References outlive eviction and the cache itself; other options are other entries
+    ImageCachedBuffer other = {};
+    out.jpeg.quality = 60;
+    ok = ok && process_cached(cache, data, size, load, &resize, 1, out, &other) == SUCCESS;
+    ok = ok && other.data != buffers[0].data && result_cache_stats(cache).entries == 2;
+    load.access = IMAGE_ACCESS_SEQUENTIAL;
+    ImageCachedBuffer same = {};
+    ok = ok && process_cached(cache, data, size, load, &resize, 1, out, &same) == SUCCESS && same.data == other.data;
+    
+    // Failures are reported to every caller and not stored
+    ImageCachedBuffer failed = {};
+    ok = ok && process_cached(cache, data + 1, size - 1, load, &resize, 1, out, &failed) != SUCCESS && !failed.ref;
+    out.format = IMAGE_FORMAT_NONE;
+    ok = ok && process_cached(cache, data, size, load, &resize, 1, out, &failed) == IMAGE_INVALID_FORMAT;
+    
+    ImageStats global;
+    vips_wrapper_get_stats(&global);
+    ok = ok && global.result_cache_entries >= 2 && global.result_cache_hits >= 1;
+    destroy_result_cache(cache);
+    ok = ok && buffers[0].data[0] == 0xFF && buffers[0].data[1] == 0xD8;
+    for (auto& buffer : buffers) {
+        release_cached_buffer(buffer);
+    }
+    release_cached_buffer(other);
+    release_cached_buffer(same);
+    
+    // A budget of one small result: the second evicts the first
+    cache = create_result_cache(ImageResultCacheOptions{static_cast<uint64_t>(same.size) * 3 / 2, 1}, &status);
+    out.format = IMAGE_FORMAT_JPEG;
+    ImageCachedBuffer first = {}, second = {};
+    ok = ok && process_cached(cache, data, size, load, &resize, 1, out, &first) == SUCCESS;
+    out.jpeg.quality = 50;
+    ok = ok && process_cached(cache, data, size, load, &resize, 1, out, &second) == SUCCESS;
+    stats = result_cache_stats(cache);
+    ok = ok && stats.entries == 1 && stats.evictions == 1 && stats.bytes == second.size;
+    release_cached_buffer(first);
+    release_cached_buffer(second);
+    destroy_result_cache(cache);
+    
+    free(data);
+    return ok;
+}
+
+/**
+ * @brief Tests raw region reads against crops, and Deep Zoom pyramid generation
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_regions_and_tiles(const char* input_path) {
+    std::cout << "\n=== Test 31: Regions and Tile Pyramids ===" << std::endl;
+    
+    VImageHandle img = load_image(input_path);
+    if (!img) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImageMeta meta = extract_metadata(img);
+    int x = meta.width / 3, y = meta.height / 3, width = 64, height = 48;
+    
+    // Ask for the size first, then read
+    ImagePixelLayout layout;
+    bool ok = fetch_region(img, x, y, width, height, nullptr, 0, &layout) == IMAGE_BUFFER_TOO_SMALL;
+    ok = ok && layout.width == width && layout.height == height && layout.bands == meta.channels;
+    ok = ok && layout.format == IMAGE_SAMPLE_UCHAR && layout.stride == layout.bytes_per_pixel * width;
+    std::vector<unsigned char> region(layout.stride * layout.height);
+    ok = ok && fetch_region(img, x, y, width, height, region.data(), region.size(), &layout) == SUCCESS;
+    
+    // The same pixels as the top-left corner of a crop at (x, y)
+    VImageHandle cropped = nullptr;
+    ok = ok && crop_image_to(img, &cropped, ImageCropOptions{x, y, width * 2, height * 2}) == SUCCESS;
+    std::vector<unsigned char> corner(region.size());
+    ok = ok && fetch_region(cropped, 0, 0, width, height, corner.data(), corner.size(), nullptr) == SUCCESS;
+    ok = ok && corner == region;
+    free_vimage_handle(cropped);
+    
+    ok = ok && fetch_region(img, meta.width - 10, 0, 20, 20, region.data(), region.size(), nullptr) == IMAGE_INVALID_BOUNDS;
+    ok = ok && fetch_region(img, 0, 0, 0, 20, region.data(), region.size(), nullptr) == IMAGE_INVALID_DIMENSIONS;
+    
+    // Deep Zoom pyramid: descriptor, one level per halving, single-tile top levels
+    const char* directory = "./test/pyramid";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    ImageTilePyramidOptions options = {};
+    options.tile_size = 128;
+    options.overlap = 1;
+    options.tiles.format = IMAGE_FORMAT_WEBP;
+    options.tiles.webp.quality = 70;
+    auto start = high_resolution_clock::now();
+    ok = ok && generate_tile_pyramid(img, "./test/pyramid/test", options) == SUCCESS;
+    auto ms = duration_cast<milliseconds>(high_resolution_clock::now() - start).count();
+    ok = ok && std::filesystem::exists("./test/pyramid/test.dzi");
+    ok = ok && std::filesystem::exists("./test/pyramid/test_files/0/0_0.webp");
+    size_t tiles = 0;
+    for (const auto& file : std::filesystem::recursive_directory_iterator("./test/pyramid/test_files")) {
+        tiles += file.is_regular_file();
+    }
+    ok = ok && tiles > 1;
+    std::cout << "   Region " << width << "x" << height << " matches crop; pyramid: " << tiles << " tiles in " << ms
+              << "ms" << std::endl;
+    
+    options.overlap = options.tile_size;
+    ok = ok && generate_tile_pyramid(img, "./test/pyramid/bad", options) == IMAGE_INVALID_DIMENSIONS;
+    options.overlap = 0;
+    options.tiles.format = IMAGE_FORMAT_GIF;
+    ok = ok && generate_tile_pyramid(img, "./test/pyramid/bad", options) == IMAGE_INVALID_FORMAT;
+    std::filesystem::remove_all(directory);
+    free_vimage_handle(img);
+    return ok;
+}
+
+/**
+ * @brief Tests raw pixel import with load_image_from_memory and tensor export with write_to_memory
+ * 
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_raw_pixel_interchange(const char* input_path) {
+    std::cout << "\n=== Test 32: Raw Pixel Interchange ===" << std::endl;
+    
+    VImageHandle img = load_image(input_path);
+    if (!img) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    VImageHandle small = nullptr;
+    bool ok = crop_image_to(img, &small, ImageCropOptions{0, 0, 64, 48}) == SUCCESS;
+    free_vimage_handle(img);
+    if (!ok) {
+        std::cout << "   Failed to crop image" << std::endl;
+        return false;
+    }
+    ImagePixelLayout layout;
+    fetch_region(small, 0, 0, 64, 48, nullptr, 0, &layout);
+    std::vector<unsigned char> pixels(layout.stride * layout.height);
+    ok = fetch_region(small, 0, 0, 64, 48, pixels.data(), pixels.size(), &layout) == SUCCESS;
+    int bands = layout.bands;
+    
+    // Interleaved uint8 is the raw pixels; ask for the size first
+    ImageTensorSpec spec = {};
+    size_t needed = 0;
+    ok = ok && write_to_memory(small, spec, nullptr, 0, &needed) == IMAGE_BUFFER_TOO_SMALL && needed == pixels.size();
+    std::vector<unsigned char> hwc(needed);
+    ok = ok && write_to_memory(small, spec, hwc.data(), hwc.size(), nullptr) == SUCCESS && hwc == pixels;
+    
+    // Planar float with ImageNet-style normalisation, rows padded to 64 bytes
+    spec = ImageTensorSpec{IMAGE_TENSOR_CHW, IMAGE_SAMPLE_FLOAT, 320, 1.0f / 255, {0.5f, 0.5f, 0.5f}, {0.25f, 0.25f, 0.25f}};
+    ok = ok && write_to_memory(small, spec, nullptr, 0, &needed) == IMAGE_BUFFER_TOO_SMALL;
+    ok = ok && needed == 320u * 48 * bands;
+    std::vector<float> chw(needed / sizeof(float));
+    ok = ok && write_to_memory(small, spec, chw.data(), needed, nullptr) == SUCCESS;
+    for (int b = 0; ok && b < bands && b < 3; ++b) {
+        int x = 17, y = 31;
+        float expected = (pixels[(y * 64 + x) * bands + b] / 255.0f - 0.5f) / 0.25f;
+        float actual = chw[(b * 48 + y) * 80 + x];
+        ok = std::abs(actual - expected) < 1e-3f;
+    }
+    
+    spec.row_stride = 100;
+    ok = ok && write_to_memory(small, spec, chw.data(), needed, nullptr) == IMAGE_INVALID_DIMENSIONS;
+    spec.format = IMAGE_SAMPLE_DOUBLE;
+    ok = ok && write_to_memory(small, spec, chw.data(), needed, nullptr) == IMAGE_INVALID_FORMAT;
+    
+    // Round trip through a copied and an owned raw image
+    ImageStatus status = UNKNOWN_ERROR;
+    VImageHandle copied = load_image_from_memory(pixels.data(), pixels.size(), 64, 48, bands, IMAGE_SAMPLE_UCHAR,
+                                                 nullptr, nullptr, &status);
+    ok = ok && copied && status == SUCCESS;
+    ok = ok && copied && write_to_memory(copied, ImageTensorSpec{}, hwc.data(), hwc.size(), nullptr) == SUCCESS;
+    ok = ok && hwc == pixels;
+    free_vimage_handle(copied);
+    
+    int released = 0;
+    void* owned = malloc(pixels.size());
+    std::memcpy(owned, pixels.data(), pixels.size());
+    VImageHandle wrapped = load_image_from_memory(owned, pixels.size(), 64, 48, bands, IMAGE_SAMPLE_UCHAR,
+                                                  release_test_buffer, &released, &status);
+    ok = ok && wrapped && released == 0;
+    ok = ok && wrapped && write_to_memory(wrapped, ImageTensorSpec{}, hwc.data(), hwc.size(), nullptr) == SUCCESS;
+    ok = ok && hwc == pixels;
+    free_vimage_handle(wrapped);
+    
+    // A short buffer is rejected and handed back before returning
+    int failed_releases = 0;
+    void* short_buffer = malloc(16);
+    ok = ok && !load_image_from_memory(short_buffer, 16, 64, 48, bands, IMAGE_SAMPLE_UCHAR, release_test_buffer,
+                                       &failed_releases, &status);
+    ok = ok && status == IMAGE_BUFFER_TOO_SMALL && failed_releases == 1;
+    std::cout << "   " << bands << "-band 64x48: HWC matches pixels, CHW float normalised, raw round trip intact"
+              << std::endl;
+    
+    free_vimage_handle(small);
+    return ok;
+}
+
+/**
+ * @brief Tests the 8-bit opacity and OVER compositing fast paths against the blend formulas
+ * 
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_uchar_alpha_fast_path(const char* input_path) {
+    std::cout << "\n=== Test 33: 8-bit Alpha Fast Path ===" << std::endl;
+    
+    // Flat images with known pixels: an orange RGB base and a half transparent blue mark
+    const unsigned char base_pixel[3] = {200, 100, 50};
+    const unsigned char mark_pixel[4] = {0, 0, 255, 128};
+    std::vector<unsigned char> base_pixels(64 * 48 * 3), mark_pixels(16 * 16 * 4);
+    for (size_t i = 0; i < base_pixels.size(); ++i) {
+        base_pixels[i] = base_pixel[i % 3];
+    }
+    for (size_t i = 0; i < mark_pixels.size(); ++i) {
+        mark_pixels[i] = mark_pixel[i % 4];
+    }
+    auto load_base = [&]() {
+        return load_image_from_memory(base_pixels.data(), base_pixels.size(), 64, 48, 3, IMAGE_SAMPLE_UCHAR,
+                                      nullptr, nullptr, nullptr);
+    };
+    VImageHandle mark = load_image_from_memory(mark_pixels.data(), mark_pixels.size(), 16, 16, 4,
+                                               IMAGE_SAMPLE_UCHAR, nullptr, nullptr, nullptr);
+    if (!mark) {
+        std::cout << "   Failed to wrap the watermark pixels" << std::endl;
+        return false;
+    }
+    
+    // Reads one pixel and checks it against the straight-alpha OVER formula, within one level
+    auto check_over = [&](VImageHandle img, int x, int y, double alpha) {
+        unsigned char pixel[4];
+        ImagePixelLayout layout;
+        if (fetch_region(img, x, y, 1, 1, pixel, sizeof(pixel), &layout) != SUCCESS) {
+            return false;
+        }
+        bool ok = layout.bands == 4 && layout.format == IMAGE_SAMPLE_UCHAR && pixel[3] == 255;
+        for (int c = 0; c < 3; ++c) {
+            double expected = mark_pixel[c] * alpha + base_pixel[c] * (1.0 - alpha);
+            ok = ok && std::abs(pixel[c] - expected) <= 1.0;
+        }
+        return ok;
+    };
+    
+    VImageHandle base = load_base();
+    bool ok = base && watermark_image(base, mark, ImageWatermarkOptions{10, 20, 0.5}) == SUCCESS;
+    ok = ok && check_over(base, 15, 25, 128 / 255.0 * 0.5) && check_over(base, 0, 0, 0.0);
+    ok = ok && check_over(base, 26, 36, 0.0); // Just past the bottom-right corner of the mark
+    free_vimage_handle(base);
+    
+    ImageWatermarkHandle prepared = prepare_watermark(mark, 1.0, IMAGE_BLEND_OVER, nullptr);
+    base = load_base();
+    ok = ok && prepared && base;
+    ok = ok && watermark_image_prepared(base, prepared, ImageWatermarkPlacement{IMAGE_GRAVITY_SOUTH_EAST, 0, 0, 0}) == SUCCESS;
+    ok = ok && check_over(base, 63, 47, 128 / 255.0) && check_over(base, 47, 31, 0.0);
+    free_vimage_handle(base);
+    free_watermark(prepared);
+    
+    // Opacity adds a uchar alpha to RGB and scales an existing one
+    unsigned char pixel[4];
+    ImagePixelLayout layout;
+    base = load_base();
+    ok = ok && base && change_image_opacity(base, ImageOpacityOptions{0.5}) == SUCCESS;
+    ok = ok && fetch_region(base, 5, 5, 1, 1, pixel, sizeof(pixel), &layout) == SUCCESS;
+    ok = ok && layout.bands == 4 && layout.format == IMAGE_SAMPLE_UCHAR && pixel[0] == 200 && pixel[3] == 128;
+    ok = ok && change_image_opacity(base, ImageOpacityOptions{0.5}) == SUCCESS;
+    ok = ok && fetch_region(base, 5, 5, 1, 1, pixel, sizeof(pixel), &layout) == SUCCESS;
+    ok = ok && layout.bands == 4 && pixel[2] == 50 && pixel[3] == 64;
+    free_vimage_handle(base);
+    
+    // 16-bit input keeps the generic path
+    std::vector<unsigned short> deep(8 * 8 * 3, 40000);
+    VImageHandle wide = load_image_from_memory(deep.data(), deep.size() * sizeof(unsigned short), 8, 8, 3,
+                                               IMAGE_SAMPLE_USHORT, nullptr, nullptr, nullptr);
+    ok = ok && wide && change_image_opacity(wide, ImageOpacityOptions{0.5}) == SUCCESS;
+    ok = ok && extract_metadata(wide).channels == 4;
+    free_vimage_handle(wide);
+    free_vimage_handle(mark);
+    
+    // Time the fast path on the real input
+    VImageHandle img = load_image(input_path);
+    ok = ok && img;
+    auto start = high_resolution_clock::now();
+    ok = ok && change_image_opacity(img, ImageOpacityOptions{0.7}) == SUCCESS;
+    ImageBuffer png = img ? encode_to_png(img, ImageEncodePNGOptions{1}) : ImageBuffer{nullptr, 0};
+    auto ms = duration_cast<milliseconds>(high_resolution_clock::now() - start).count();
+    ok = ok && png.data;
+    std::cout << "   OVER and opacity match the blend formulas; 70% opacity PNG in " << ms << "ms" << std::endl;
+    free_image_buffer(png);
+    free_vimage_handle(img);
+    return ok;
+}
+
+/**
+ * @brief Tests cancel tokens and deadlines on process_pipeline_cancellable
+ * 
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_cancellation(const char* input_path) {
+    std::cout << "\n=== Test 34: Cancellation and Deadlines ===" << std::endl;
+    
+    VImageHandle img = load_image(input_path);
+    if (!img) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImageEncodeSpec jpeg = {IMAGE_FORMAT_JPEG};
+    jpeg.jpeg.quality = 80;
+    
+    // A live token changes nothing
+    ImageCancelHandle token = create_cancel_token(0);
+    ImageBuffer out = {nullptr, 0};
+    bool ok = token && !cancel_token_is_cancelled(token);
+    ok = ok && process_pipeline_cancellable(img, nullptr, 0, jpeg, &out, token) == SUCCESS && out.data;
+    free_image_buffer(out);
+    
+    // Cancelled and expired tokens fail before any work
+    cancel_token_cancel(token);
+    out = ImageBuffer{nullptr, 0};
+    ok = ok && cancel_token_is_cancelled(token);
+    ok = ok && process_pipeline_cancellable(img, nullptr, 0, jpeg, &out, token) == IMAGE_CANCELLED && !out.data;
+    ok = ok && vips_wrapper_last_error()->code == IMAGE_CANCELLED;
+    free_cancel_token(token);
+    ImageCancelHandle expired = create_cancel_token(-1);
+    ok = ok && process_pipeline_cancellable(img, nullptr, 0, jpeg, &out, expired) == IMAGE_CANCELLED;
+    free_cancel_token(expired);
+    
+    // Cancel a slow upscale and PNG encode from another thread
+    ImagePipelineOp grow = {PIPELINE_OP_RESIZE};
+    grow.resize = ImageResizeOptions{1, 12000, 0};
+    ImageEncodeSpec png = {IMAGE_FORMAT_PNG};
+    png.png.compression = 9;
+    token = create_cancel_token(0);
+    std::thread canceller([token] {
+        std::this_thread::sleep_for(milliseconds(50));
+        cancel_token_cancel(token);
+    });
+    auto start = high_resolution_clock::now();
+    ImageStatus status = process_pipeline_cancellable(img, &grow, 1, png, &out, token);
+    auto ms = duration_cast<milliseconds>(high_resolution_clock::now() - start).count();
+    canceller.join();
+    free_cancel_token(token);
+    ok = ok && status == IMAGE_CANCELLED && !out.data;
+    
+    // A deadline stops the same render on its own
+    token = create_cancel_token(50);
+    ok = ok && process_pipeline_cancellable(img, &grow, 1, png, &out, token) == IMAGE_CANCELLED;
+    free_cancel_token(token);
+    std::cout << "   Upscale to 12000px cancelled after " << ms << "ms" << std::endl;
+    
+    // The source is unaffected
+    out = ImageBuffer{nullptr, 0};
+    ok = ok && process_pipeline(img, nullptr, 0, jpeg, &out) == SUCCESS && out.data;
+    free_image_buffer(out);
+    free_vimage_handle(img);
+    return ok;
+}
+
+/**
+ * @brief Tests the adaptive scheduler and progress reports of process_pipeline_ex
+ * 
+ * @param input_path Path to the input image
+ * @return true on success, false on failure
+ */
+bool test_scheduling_and_progress(const char* input_path) {
+    std::cout << "\n=== Test 35: Scheduling and Progress ===" << std::endl;
+    
+    VImageHandle img = load_image(input_path);
+    if (!img) {
+        std::cout << "   Failed to load image" << std::endl;
+        return false;
+    }
+    ImagePipelineOp grow = {PIPELINE_OP_RESIZE};
+    grow.resize = ImageResizeOptions{1, 2000, 0};
+    ImageEncodeSpec png = {IMAGE_FORMAT_PNG};
+    
+    ImageBuffer reference = {nullptr, 0};
+    bool ok = process_pipeline(img, &grow, 1, png, &reference) == SUCCESS && reference.data;
+    
+    // Progress only increases and ends at 100
+    std::vector<int> percents;
+    ImageRunOptions run = {};
+    run.progress = [](int percent, void* user_data) {
+        static_cast<std::vector<int>*>(user_data)->push_back(percent);
+    };
+    run.user_data = &percents;
+    ImageBuffer out = {nullptr, 0};
+    ok = ok && process_pipeline_ex(img, &grow, 1, png, &out, &run) == SUCCESS && out.data;
+    ok = ok && !percents.empty() && percents.back() == 100 && std::is_sorted(percents.begin(), percents.end()) &&
+         std::adjacent_find(percents.begin(), percents.end()) == percents.end();
+    ok = ok && out.size == reference.size && std::memcmp(out.data, reference.data, out.size) == 0;
+    std::cout << "   " << percents.size() << " progress reports" << std::endl;
+    free_image_buffer(out);
+    
+    // A fixed thread count gives the same output
+    percents.clear();
+    run.concurrency = 1;
+    out = ImageBuffer{nullptr, 0};
+    ok = ok && process_pipeline_ex(img, &grow, 1, png, &out, &run) == SUCCESS && out.data;
+    ok = ok && out.size == reference.size && std::memcmp(out.data, reference.data, out.size) == 0;
+    free_image_buffer(out);
+    
+    // The scheduler hands out threads and gets them all back
+    ImageSchedulerOptions sched = {1000000, 4, 2};
+    vips_wrapper_set_scheduler(&sched);
+    ImageSchedulerOptions current = {};
+    ok = ok && vips_wrapper_get_scheduler(&current) == 0 && current.pixels_per_thread == 1000000;
+    std::vector<std::thread> workers;
+    std::atomic<int> failures{0};
+    for (int i = 0; i < 4; ++i) {
+        workers.emplace_back([&] {
+            ImageBuffer result = {nullptr, 0};
+            if (process_pipeline(img, &grow, 1, png, &result) != SUCCESS || result.size != reference.size) {
+                failures++;
+            }
+            free_image_buffer(result);
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    ok = ok && failures == 0 && vips_wrapper_get_scheduler(nullptr) == 0;
+    vips_wrapper_set_scheduler(nullptr);
+    ok = ok && vips_wrapper_get_scheduler(&current) == 0 && current.pixels_per_thread == 0;
+    
+    free_image_buffer(reference);
+    free_vimage_handle(img);
+    return ok;
+}
+
 int main() {
     std::cout << "=== Image SDK Comprehensive Test Suite ===" << std::endl;
     
@@ -358,6 +2244,35 @@ int main() {
     all_tests_passed &= test_image_rotate(input_image);
     all_tests_passed &= test_chained_operations(input_image);
     all_tests_passed &= test_png_encoding(input_image);
+    all_tests_passed &= test_thumbnail(input_image);
+    all_tests_passed &= test_sequential_load(input_image);
+    all_tests_passed &= test_owned_bytes(input_image);
+    all_tests_passed &= test_streaming_encode(input_image);
+    all_tests_passed &= test_pipeline(input_image);
+    all_tests_passed &= test_modern_encoders(input_image);
+    all_tests_passed &= test_jpeg_tuning(input_image);
+    all_tests_passed &= test_runtime_config(input_image);
+    all_tests_passed &= test_worker_pool(input_image);
+    all_tests_passed &= test_stats_and_logging(input_image);
+    all_tests_passed &= test_error_detail(input_image);
+    all_tests_passed &= test_probe(input_image);
+    all_tests_passed &= test_load_limits(input_image);
+    all_tests_passed &= test_prepared_watermark(input_image);
+    all_tests_passed &= test_renditions(input_image);
+    all_tests_passed &= test_ensure_srgb8(input_image);
+    all_tests_passed &= test_orientation(input_image);
+    all_tests_passed &= test_cover(input_image);
+    all_tests_passed &= test_multi_page(input_image);
+    all_tests_passed &= test_shared_handles(input_image);
+    all_tests_passed &= test_batch(input_image);
+    all_tests_passed &= test_save_image(input_image);
+    all_tests_passed &= test_raw_cache(input_image);
+    all_tests_passed &= test_result_cache(input_image);
+    all_tests_passed &= test_regions_and_tiles(input_image);
+    all_tests_passed &= test_raw_pixel_interchange(input_image);
+    all_tests_passed &= test_uchar_alpha_fast_path(input_image);
+    all_tests_passed &= test_cancellation(input_image);
+    all_tests_passed &= test_scheduling_and_progress(input_image);
     
     auto total_time = high_resolution_clock::now() - start_time;
     auto duration_ms = duration_cast<milliseconds>(total_time).count();
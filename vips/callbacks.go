@@ -0,0 +1,89 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"errors"
+	"io"
+	"runtime"
+	"runtime/cgo"
+	"unsafe"
+)
+
+// This file holds the Go functions exported to the C library as callbacks.
+// It must keep its preamble free of C definitions (a cgo rule for //export).
+
+// vipsgoReleaseBuffer is the ImageBufferReleaseFn used by zero-copy loads.
+// userData carries a cgo.Handle to the runtime.Pinner keeping the Go slice in place;
+// libvips calls this once no image reads from the slice any more.
+//
+//export vipsgoReleaseBuffer
+func vipsgoReleaseBuffer(data unsafe.Pointer, userData unsafe.Pointer) {
+	handle := cgo.Handle(uintptr(userData))
+	handle.Value().(*runtime.Pinner).Unpin()
+	handle.Delete()
+}
+
+// writerState carries an io.Writer through the C library for streaming encodes.
+type writerState struct {
+	w   io.Writer
+	err error // first error returned by w, reported instead of the encoder status
+}
+
+// vipsgoWrite is the ImageWriteFn used by streaming encodes.
+// The chunk is handed to the io.Writer without copying; io.Writer implementations
+// must not retain it, so it is safe to expose C memory for the duration of the call.
+//
+//export vipsgoWrite
+func vipsgoWrite(data unsafe.Pointer, size C.size_t, userData unsafe.Pointer) C.longlong {
+	state := cgo.Handle(uintptr(userData)).Value().(*writerState)
+	if state.err != nil {
+		return -1
+	}
+	n, err := state.w.Write(unsafe.Slice((*byte)(data), int(size)))
+	if err != nil {
+		state.err = err
+		return -1
+	}
+	return C.longlong(n)
+}
+
+// vipsgoJobDone is the ImageJobCompletionFn of jobs submitted through Pool.
+// It runs on a native worker thread; userData carries a cgo.Handle to the *Job.
+//
+//export vipsgoJobDone
+func vipsgoJobDone(status C.ImageStatus, result C.ImageBuffer, userData unsafe.Pointer) {
+	handle := cgo.Handle(uintptr(userData))
+	job := handle.Value().(*Job)
+	handle.Delete()
+
+	if status != C.SUCCESS {
+		// Runs on the worker thread that failed, so its error record is current
+		job.err = lastError()
+	} else if result.data == nil {
+		job.err = errors.New("pipeline produced no output: check logs for VIPS errors")
+	} else {
+		job.data = C.GoBytes(unsafe.Pointer(result.data), C.int(result.size))
+	}
+	C.free_image_buffer(result)
+	close(job.done)
+}
+
+// vipsgoProgress is the ImageProgressFn of Image.RenderPipeline.
+// userData carries a cgo.Handle to the RenderOptions.Progress function.
+//
+//export vipsgoProgress
+func vipsgoProgress(percent C.int, userData unsafe.Pointer) {
+	cgo.Handle(uintptr(userData)).Value().(func(int))(int(percent))
+}
+
+// vipsgoLog is the ImageLogFn installed by SetLogHandler.
+//
+//export vipsgoLog
+func vipsgoLog(level C.ImageLogLevel, message *C.char, userData unsafe.Pointer) {
+	if handler := logHandler.Load(); handler != nil {
+		(*handler)(LogLevel(level), C.GoString(message))
+	}
+}
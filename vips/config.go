@@ -0,0 +1,138 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+
+// Switch is a three-state runtime feature setting.
+type Switch C.RuntimeSwitch
+
+const (
+	SwitchDefault Switch = C.RUNTIME_SWITCH_DEFAULT // Keep the libvips default
+	SwitchOn      Switch = C.RUNTIME_SWITCH_ON
+	SwitchOff     Switch = C.RUNTIME_SWITCH_OFF
+)
+
+// RuntimeConfig holds process-wide libvips settings. Zero fields keep the
+// libvips default, so only the settings of interest need to be set.
+type RuntimeConfig struct {
+	Concurrency   int    // Worker threads per pipeline
+	CacheMax      int    // Max cached operations
+	CacheMaxMem   uint64 // Max memory held by cached operations, in bytes
+	CacheMaxFiles int    // Max files held open by cached operations
+	CacheDisable  bool   // Disable the operation cache, overriding the limits above
+	Vector        Switch // SIMD (Highway/orc) code paths
+	LeakCheck     Switch // Reference leak reporting at shutdown
+}
+
+// InitWithConfig initializes the VIPS library like Init and applies config.
+//
+// When many goroutines process images concurrently, setting Concurrency to a
+// small value (often 1) keeps N goroutines x libvips threads from
+// oversubscribing the CPU.
+func InitWithConfig(config *RuntimeConfig) error {
+	if config == nil {
+		return Init()
+	}
+	cConfig := config.toC()
+	status := ImageStatus(C.vips_wrapper_init_ex(&cConfig))
+	return status.Error()
+}
+
+// SetConcurrency sets the worker threads used by pipelines started after the call.
+// 0 restores the libvips default.
+func SetConcurrency(concurrency int) {
+	C.vips_wrapper_set_concurrency(C.int(concurrency))
+}
+
+// SetCacheMax sets the maximum number of cached operations; 0 disables caching.
+func SetCacheMax(max int) {
+	C.vips_wrapper_set_cache_max(C.int(max))
+}
+
+// SetCacheMaxMem sets the maximum memory held by the operation cache, in bytes.
+func SetCacheMaxMem(maxMem uint64) {
+	C.vips_wrapper_set_cache_max_mem(C.size_t(maxMem))
+}
+
+// SetCacheMaxFiles sets the maximum number of files held open by the operation cache.
+func SetCacheMaxFiles(maxFiles int) {
+	C.vips_wrapper_set_cache_max_files(C.int(maxFiles))
+}
+
+// SetVectorEnabled enables or disables libvips' SIMD code paths.
+func SetVectorEnabled(enabled bool) {
+	C.vips_wrapper_set_vector_enabled(cBool(enabled))
+}
+
+// SetLeakCheck enables or disables libvips reference leak reporting.
+func SetLeakCheck(enabled bool) {
+	C.vips_wrapper_set_leak_check(cBool(enabled))
+}
+
+// SchedulerOptions configure adaptive thread allocation; see SetScheduler.
+type SchedulerOptions struct {
+	PixelsPerThread int64 // Pixels of work per libvips thread (0 = scheduler off)
+	MaxThreads      int   // Most threads one render may use (0 = the global concurrency)
+	ThreadBudget    int   // Threads shared by all running renders (0 = one per CPU core)
+}
+
+// SetScheduler sizes the libvips threads of every render from its pixel count instead
+// of giving each the global concurrency: small images run on one thread, large ones get
+// up to MaxThreads. Threads come from a shared budget, and a render never waits for it,
+// so a very large image cannot starve small ones. nil disables the scheduler.
+//
+// RenderOptions.Concurrency overrides the scheduler for a single call.
+func SetScheduler(options *SchedulerOptions) {
+	if options == nil {
+		C.vips_wrapper_set_scheduler(nil)
+		return
+	}
+	cOptions := C.ImageSchedulerOptions{
+		pixels_per_thread: C.int64_t(options.PixelsPerThread),
+		max_threads:       C.int(options.MaxThreads),
+		thread_budget:     C.int(options.ThreadBudget),
+	}
+	C.vips_wrapper_set_scheduler(&cOptions)
+}
+
+// CurrentScheduler returns the scheduler settings in effect (all zero when disabled)
+// and the number of threads currently held by running renders.
+func CurrentScheduler() (SchedulerOptions, int) {
+	var c C.ImageSchedulerOptions
+	inUse := int(C.vips_wrapper_get_scheduler(&c))
+	return SchedulerOptions{
+		PixelsPerThread: int64(c.pixels_per_thread),
+		MaxThreads:      int(c.max_threads),
+		ThreadBudget:    int(c.thread_budget),
+	}, inUse
+}
+
+// CurrentRuntimeConfig returns the runtime settings currently in effect.
+func CurrentRuntimeConfig() RuntimeConfig {
+	var c C.RuntimeConfig
+	C.vips_wrapper_get_runtime_config(&c)
+	return RuntimeConfig{
+		Concurrency:   int(c.concurrency),
+		CacheMax:      int(c.cache_max),
+		CacheMaxMem:   uint64(c.cache_max_mem),
+		CacheMaxFiles: int(c.cache_max_files),
+		CacheDisable:  c.cache_disable != 0,
+		Vector:        Switch(c.vector),
+		LeakCheck:     Switch(c.leak_check),
+	}
+}
+
+// toC converts the runtime config to its C representation.
+func (c *RuntimeConfig) toC() C.RuntimeConfig {
+	return C.RuntimeConfig{
+		concurrency:     C.int(c.Concurrency),
+		cache_max:       C.int(c.CacheMax),
+		cache_max_mem:   C.size_t(c.CacheMaxMem),
+		cache_max_files: C.int(c.CacheMaxFiles),
+		cache_disable:   cBool(c.CacheDisable),
+		vector:          C.RuntimeSwitch(c.Vector),
+		leak_check:      C.RuntimeSwitch(c.LeakCheck),
+	}
+}
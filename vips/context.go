@@ -0,0 +1,152 @@
+package vips
+
+/*
+#include <stdint.h>
+#include "c/include/vips_wrapper.h"
+
+// Exported from callbacks.go
+extern void vipsgoProgress(int percent, void* user_data);
+
+// Builds the run options on the C side so no Go pointer is stored in C memory.
+static inline ImageStatus vipsgo_process_pipeline_ex(VImageHandle handle, const ImagePipelineOp* ops, size_t n,
+                                                     ImageEncodeSpec out, ImageBuffer* result,
+                                                     ImageCancelHandle cancel, int concurrency, uintptr_t progress) {
+	ImageRunOptions run = {cancel, concurrency, progress ? vipsgoProgress : NULL, (void*)progress};
+	return process_pipeline_ex(handle, ops, n, out, result, &run);
+}
+*/
+import "C"
+import (
+	"context"
+	"errors"
+	"fmt"
+	"runtime"
+	"runtime/cgo"
+	"time"
+	"unsafe"
+)
+
+// ErrCancelled is returned, wrapped together with the context's error, when a call
+// taking a context.Context stops because the context was cancelled or its deadline passed.
+var ErrCancelled = errors.New("operation cancelled")
+
+// RenderOptions are per-call controls of Image.RenderPipeline.
+type RenderOptions struct {
+	// Concurrency is the number of libvips threads for this render; 0 leaves the
+	// choice to the scheduler (see SetScheduler) or the global concurrency.
+	Concurrency int
+	// Progress, if set, is called with the percentage of the output computed so far.
+	// Values only increase and end with 100 once the render has succeeded. It runs on
+	// libvips threads, one call at a time, and should return quickly.
+	Progress func(percent int)
+}
+
+// PipelineContext is Image.Pipeline bound to ctx: once ctx is done, the C library stops
+// computing pixels at the next strip, frees the partial output and the call returns an
+// error matching both ErrCancelled and ctx.Err(). The image itself is not affected.
+//
+// If out is nil or out.Format is FormatNone, ctx is only checked before the operations
+// are applied, since nothing is computed until the image is encoded.
+func (img *Image) PipelineContext(ctx context.Context, out *EncodeSpec, ops ...PipelineOp) ([]byte, error) {
+	return img.RenderPipeline(ctx, out, nil, ops...)
+}
+
+// RenderPipeline is PipelineContext with per-call controls: a thread count for this
+// render and a progress callback. options may be nil.
+func (img *Image) RenderPipeline(ctx context.Context, out *EncodeSpec, options *RenderOptions,
+	ops ...PipelineOp) ([]byte, error) {
+	if ctx.Done() == nil && options == nil {
+		return img.Pipeline(out, ops...)
+	}
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	if err := ctx.Err(); err != nil {
+		return nil, fmt.Errorf("%w: %w", err, ErrCancelled)
+	}
+
+	cOps, err := pipelineOps(ops)
+	if err != nil {
+		return nil, err
+	}
+	var cOut C.ImageEncodeSpec
+	if out != nil {
+		cOut = out.toC()
+	}
+
+	var token C.ImageCancelHandle
+	if ctx.Done() != nil {
+		var release func()
+		token, release = cancelToken(ctx)
+		defer release()
+	}
+	var concurrency C.int
+	var progress cgo.Handle
+	if options != nil {
+		concurrency = C.int(options.Concurrency)
+		if options.Progress != nil {
+			progress = cgo.NewHandle(options.Progress)
+			defer progress.Delete()
+		}
+	}
+
+	var cBuffer C.ImageBuffer
+	err = checkStatus(func() C.ImageStatus {
+		return C.vipsgo_process_pipeline_ex(img.handle, firstOp(cOps), C.size_t(len(cOps)), cOut, &cBuffer,
+			token, concurrency, C.uintptr_t(progress))
+	})
+	runtime.KeepAlive(img)
+	runtime.KeepAlive(ops)
+	if err != nil {
+		if ctxErr := ctx.Err(); ctxErr != nil && errors.Is(err, ErrCancelled) {
+			return nil, fmt.Errorf("%w: %w", ctxErr, err)
+		}
+		return nil, err
+	}
+	if cOut.format == C.IMAGE_FORMAT_NONE {
+		return nil, nil
+	}
+	if cBuffer.data == nil {
+		return nil, errors.New("pipeline produced no output: check logs for VIPS errors")
+	}
+	defer C.free_image_buffer(cBuffer)
+
+	return C.GoBytes(unsafe.Pointer(cBuffer.data), C.int(cBuffer.size)), nil
+}
+
+// EncodeContext encodes the image as described by out, stopping early once ctx is done;
+// see PipelineContext.
+func (img *Image) EncodeContext(ctx context.Context, out *EncodeSpec) ([]byte, error) {
+	if out == nil || out.Format == FormatNone {
+		return nil, errors.New("no output format given")
+	}
+	return img.PipelineContext(ctx, out)
+}
+
+// cancelToken creates a C cancel token that carries the deadline of ctx and is cancelled
+// when ctx is done. release stops watching ctx and frees the token; it waits for a
+// cancellation already in progress, so the token is never used after it is freed.
+func cancelToken(ctx context.Context) (C.ImageCancelHandle, func()) {
+	var timeoutMs int64
+	if deadline, ok := ctx.Deadline(); ok {
+		// Round up so a deadline less than a millisecond away still counts as one
+		remaining := time.Until(deadline)
+		timeoutMs = int64((remaining + time.Millisecond - 1) / time.Millisecond)
+		if timeoutMs <= 0 {
+			timeoutMs = -1
+		}
+	}
+	token := C.create_cancel_token(C.int64_t(timeoutMs))
+
+	cancelled := make(chan struct{})
+	stop := context.AfterFunc(ctx, func() {
+		C.cancel_token_cancel(token)
+		close(cancelled)
+	})
+	return token, func() {
+		if !stop() {
+			<-cancelled
+		}
+		C.free_cancel_token(token)
+	}
+}
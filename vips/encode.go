@@ -0,0 +1,244 @@
+package vips
+
+/*
+#include <stdlib.h>
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"runtime"
+	"unsafe"
+)
+
+// Subsample selects chroma subsampling for encoders that support it.
+type Subsample C.ImageSubsample
+
+const (
+	SubsampleAuto Subsample = C.IMAGE_SUBSAMPLE_AUTO // Encoder decides
+	SubsampleOn   Subsample = C.IMAGE_SUBSAMPLE_ON   // Always 4:2:0, smaller files
+	SubsampleOff  Subsample = C.IMAGE_SUBSAMPLE_OFF  // Always 4:4:4, sharper colour edges
+)
+
+// JPEGPreset names a ready-made JPEG encoder trade-off.
+type JPEGPreset C.ImageJPEGPreset
+
+const (
+	JPEGPresetDefault  JPEGPreset = C.IMAGE_JPEG_PRESET_DEFAULT  // libjpeg defaults, metadata kept
+	JPEGPresetFast     JPEGPreset = C.IMAGE_JPEG_PRESET_FAST     // Lowest encode CPU, metadata stripped
+	JPEGPresetBalanced JPEGPreset = C.IMAGE_JPEG_PRESET_BALANCED // Optimised Huffman tables, metadata stripped
+	JPEGPresetSmallest JPEGPreset = C.IMAGE_JPEG_PRESET_SMALLEST // All mozjpeg size tools, progressive, 4:2:0
+)
+
+// JPEGPresetOptions returns the JPEG options of preset at the given quality
+// (0 selects the encoder default). The result can be adjusted before use.
+func JPEGPresetOptions(preset JPEGPreset, quality int) ImageEncodeJPEGOptions {
+	c := C.jpeg_options_preset(C.ImageJPEGPreset(preset), C.int(quality))
+	return ImageEncodeJPEGOptions{
+		Quality:            int(c.quality),
+		Interlace:          c.interlace != 0,
+		OptimizeCoding:     c.optimize_coding != 0,
+		TrellisQuant:       c.trellis_quant != 0,
+		OvershootDeringing: c.overshoot_deringing != 0,
+		OptimizeScans:      c.optimize_scans != 0,
+		QuantTable:         int(c.quant_table),
+		Subsample:          Subsample(c.subsample),
+		Strip:              c.strip != 0,
+	}
+}
+
+// ImageEncodeWebPOptions defines options for WebP encoding.
+type ImageEncodeWebPOptions struct {
+	Quality        int  // 1-100 (out of range selects 75)
+	Lossless       bool // Lossless compression
+	Effort         int  // 0 (fastest) - 6 (smallest), out of range selects 4
+	SmartSubsample bool // Sharper chroma at some CPU cost
+	Strip          bool // Drop EXIF/XMP/ICC metadata
+}
+
+// ImageEncodeAVIFOptions defines options for AVIF encoding.
+type ImageEncodeAVIFOptions struct {
+	Quality   int       // 1-100 (out of range selects 50)
+	Lossless  bool      // Lossless compression
+	Effort    int       // 0 (fastest) - 9 (smallest), out of range selects 4
+	Subsample Subsample // Chroma subsampling
+	Strip     bool      // Drop EXIF/XMP/ICC metadata
+}
+
+// ImageEncodeHEIFOptions defines options for HEIF (HEVC) encoding.
+type ImageEncodeHEIFOptions struct {
+	Quality   int       // 1-100 (out of range selects 50)
+	Lossless  bool      // Lossless compression
+	Effort    int       // 0 (fastest) - 9 (smallest), out of range selects 4
+	Subsample Subsample // Chroma subsampling
+	Strip     bool      // Drop EXIF/XMP/ICC metadata
+}
+
+// ImageEncodeJXLOptions defines options for JPEG XL encoding.
+type ImageEncodeJXLOptions struct {
+	Quality  int  // 1-100 (out of range selects 75)
+	Lossless bool // Lossless compression
+	Effort   int  // 1 (fastest) - 9 (smallest), out of range selects 7
+	Strip    bool // Drop EXIF/XMP/ICC metadata
+}
+
+// ImageEncodeGIFOptions defines options for GIF encoding.
+type ImageEncodeGIFOptions struct {
+	Effort   int // 1 (fastest) - 10 (best palette), out of range selects 7
+	Bitdepth int // Bits per palette index 1-8, out of range selects 8 (256 colours)
+}
+
+// EncodeToWebP encodes the image to WebP format and returns the encoded data.
+// Multi-frame images are written as animations.
+func (img *Image) EncodeToWebP(options *ImageEncodeWebPOptions) ([]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	return takeImageBuffer(img, func() C.ImageBuffer { return C.encode_to_webp(img.handle, options.toC()) })
+}
+
+// EncodeToAVIF encodes the image to AVIF format and returns the encoded data.
+// Requires libvips built with libheif and an AV1 encoder.
+func (img *Image) EncodeToAVIF(options *ImageEncodeAVIFOptions) ([]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	return takeImageBuffer(img, func() C.ImageBuffer { return C.encode_to_avif(img.handle, options.toC()) })
+}
+
+// EncodeToJXL encodes the image to JPEG XL format and returns the encoded data.
+// Requires libvips built with libjxl.
+func (img *Image) EncodeToJXL(options *ImageEncodeJXLOptions) ([]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	return takeImageBuffer(img, func() C.ImageBuffer { return C.encode_to_jxl(img.handle, options.toC()) })
+}
+
+// EncodeToHEIF encodes the image to HEIF (HEVC) format and returns the encoded data.
+// Requires libvips built with libheif and an HEVC encoder.
+func (img *Image) EncodeToHEIF(options *ImageEncodeHEIFOptions) ([]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	return takeImageBuffer(img, func() C.ImageBuffer { return C.encode_to_heif(img.handle, options.toC()) })
+}
+
+// EncodeToGIF encodes the image to GIF format and returns the encoded data.
+// Multi-frame images are written as animations. Requires libvips 8.12 or newer.
+func (img *Image) EncodeToGIF(options *ImageEncodeGIFOptions) ([]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	return takeImageBuffer(img, func() C.ImageBuffer { return C.encode_to_gif(img.handle, options.toC()) })
+}
+
+// EncodeToFormat encodes the image with any libvips saver that can write to memory.
+// suffix selects the saver (".tif", ".gif", ...) and options holds libvips saver
+// options as comma-separated name=value pairs, e.g. "compression=deflate,tile=true".
+func (img *Image) EncodeToFormat(suffix, options string) ([]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	cSuffix := C.CString(suffix)
+	defer C.free(unsafe.Pointer(cSuffix))
+	cOptions := C.CString(options)
+	defer C.free(unsafe.Pointer(cOptions))
+
+	return takeImageBuffer(img, func() C.ImageBuffer { return C.encode_to_format(img.handle, cSuffix, cOptions) })
+}
+
+// Save encodes the image straight to a file, so the encoded bytes are never held in
+// memory. With a nil spec or FormatNone the saver is picked from the file extension,
+// which also allows ".tif" and ".v"; LoadImage maps ".v" files instead of decoding
+// them, which suits large intermediates. The file is written under a temporary name and
+// renamed over path once complete, so a failed save leaves an existing file untouched.
+// Do not save over the file the image was loaded from.
+func (img *Image) Save(path string, spec *EncodeSpec) error {
+	if img.handle == nil {
+		return VipsInvalidHandle.Error()
+	}
+	var cSpec C.ImageEncodeSpec
+	if spec != nil {
+		cSpec = spec.toC()
+	}
+	cPath := C.CString(path)
+	defer C.free(unsafe.Pointer(cPath))
+
+	err := checkStatus(func() C.ImageStatus { return C.save_image(img.handle, cPath, cSpec) })
+	runtime.KeepAlive(img)
+	return err
+}
+
+// takeImageBuffer runs an encoder of img, copies its result into Go memory and frees the C buffer.
+func takeImageBuffer(img *Image, encode func() C.ImageBuffer) ([]byte, error) {
+	var cBuffer C.ImageBuffer
+	err := detailed(func() bool {
+		cBuffer = encode()
+		return cBuffer.data != nil
+	})
+	runtime.KeepAlive(img)
+	if err != nil {
+		return nil, err
+	}
+	defer C.free_image_buffer(cBuffer)
+	return C.GoBytes(unsafe.Pointer(cBuffer.data), C.int(cBuffer.size)), nil
+}
+
+// cBool converts a Go bool to the int flags used by the C options structs.
+func cBool(b bool) C.int {
+	if b {
+		return 1
+	}
+	return 0
+}
+
+// toC converts the WebP options to their C representation.
+func (o *ImageEncodeWebPOptions) toC() C.ImageEncodeWebPOptions {
+	return C.ImageEncodeWebPOptions{
+		quality:         C.int(o.Quality),
+		lossless:        cBool(o.Lossless),
+		effort:          C.int(o.Effort),
+		smart_subsample: cBool(o.SmartSubsample),
+		strip:           cBool(o.Strip),
+	}
+}
+
+// toC converts the GIF options to their C representation.
+func (o *ImageEncodeGIFOptions) toC() C.ImageEncodeGIFOptions {
+	return C.ImageEncodeGIFOptions{
+		effort:   C.int(o.Effort),
+		bitdepth: C.int(o.Bitdepth),
+	}
+}
+
+// toC converts the AVIF options to their C representation.
+func (o *ImageEncodeAVIFOptions) toC() C.ImageEncodeAVIFOptions {
+	return C.ImageEncodeAVIFOptions{
+		quality:   C.int(o.Quality),
+		lossless:  cBool(o.Lossless),
+		effort:    C.int(o.Effort),
+		subsample: C.ImageSubsample(o.Subsample),
+		strip:     cBool(o.Strip),
+	}
+}
+
+// toC converts the HEIF options to their C representation.
+func (o *ImageEncodeHEIFOptions) toC() C.ImageEncodeHEIFOptions {
+	return C.ImageEncodeHEIFOptions{
+		quality:   C.int(o.Quality),
+		lossless:  cBool(o.Lossless),
+		effort:    C.int(o.Effort),
+		subsample: C.ImageSubsample(o.Subsample),
+		strip:     cBool(o.Strip),
+	}
+}
+
+// toC converts the JPEG XL options to their C representation.
+func (o *ImageEncodeJXLOptions) toC() C.ImageEncodeJXLOptions {
+	return C.ImageEncodeJXLOptions{
+		quality:  C.int(o.Quality),
+		lossless: cBool(o.Lossless),
+		effort:   C.int(o.Effort),
+		strip:    cBool(o.Strip),
+	}
+}
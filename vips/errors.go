@@ -0,0 +1,68 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import "runtime"
+
+// Error is a failed call into the C library, with the detail the library recorded for it.
+// Use errors.As to inspect it, e.g. to retry only on some statuses:
+//
+//	var vErr *vips.Error
+//	if errors.As(err, &vErr) && vErr.Status == vips.ImageLoadFailure { ... }
+type Error struct {
+	Status    ImageStatus // Status of the failed call
+	Operation string      // Operation group, e.g. "load", "crop" or "encode"
+	Message   string      // Wrapper message followed by the libvips error text
+}
+
+func (e *Error) Error() string {
+	if e.Message == "" {
+		return e.Operation + ": " + e.Status.Error().Error()
+	}
+	return e.Operation + ": " + e.Message
+}
+
+// Unwrap returns the generic error of Status, so errors.Is(err, ErrPoolFull) keeps working.
+func (e *Error) Unwrap() error {
+	return e.Status.Error()
+}
+
+// detailed runs call, a C library call reporting whether it succeeded, and returns the
+// library's error detail if it did not. The detail is thread-local in the C library,
+// so the goroutine stays on one OS thread until it has been read.
+func detailed(call func() bool) error {
+	runtime.LockOSThread()
+	if call() {
+		runtime.UnlockOSThread()
+		return nil
+	}
+	err := lastError()
+	runtime.UnlockOSThread()
+	return err
+}
+
+// checkStatus is detailed for C library calls returning an ImageStatus.
+func checkStatus(call func() C.ImageStatus) error {
+	return detailed(func() bool { return call() == C.SUCCESS })
+}
+
+// lastError converts the calling thread's C error record into an *Error.
+// It must run on the OS thread of the failed call.
+func lastError() error {
+	return errorFromC(C.vips_wrapper_last_error())
+}
+
+// errorFromC converts a C error record into an *Error.
+func errorFromC(record *C.ImageError) error {
+	status := ImageStatus(record.code)
+	if status == Success {
+		status = UnknownError
+	}
+	return &Error{
+		Status:    status,
+		Operation: C.GoString(C.vips_wrapper_operation_name(record.operation)),
+		Message:   C.GoString(&record.message[0]),
+	}
+}
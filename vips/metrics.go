@@ -0,0 +1,209 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+
+// Exported from callbacks.go
+extern void vipsgoLog(ImageLogLevel level, char* message, void* user_data);
+
+static inline void vipsgo_install_log_handler(void) {
+	vips_wrapper_set_log_handler((ImageLogFn)vipsgoLog, NULL);
+}
+
+static inline void vipsgo_restore_stderr_log(void) {
+	vips_wrapper_set_log_handler(vips_wrapper_log_to_stderr, NULL);
+}
+*/
+import "C"
+import (
+	"bufio"
+	"fmt"
+	"io"
+	"math"
+	"net/http"
+	"sync/atomic"
+	"time"
+)
+
+// LogLevel is the severity of a message from the C library.
+type LogLevel int
+
+const (
+	LogError   LogLevel = C.IMAGE_LOG_ERROR
+	LogWarning LogLevel = C.IMAGE_LOG_WARNING
+)
+
+// logHandler is the Go function receiving C library messages, if one is installed.
+var logHandler atomic.Pointer[func(level LogLevel, message string)]
+
+// SetLogHandler routes the C library's diagnostic messages to handler instead of stderr.
+// handler may be called concurrently from any thread. A nil handler discards messages;
+// failures are still counted in GetStats.
+func SetLogHandler(handler func(level LogLevel, message string)) {
+	if handler == nil {
+		logHandler.Store(nil)
+		C.vips_wrapper_set_log_handler(nil, nil)
+		return
+	}
+	logHandler.Store(&handler)
+	C.vipsgo_install_log_handler()
+}
+
+// ResetLogHandler restores the default of writing messages to stderr.
+func ResetLogHandler() {
+	logHandler.Store(nil)
+	C.vipsgo_restore_stderr_log()
+}
+
+// LatencyBucket is one cumulative histogram bucket, in Prometheus convention.
+type LatencyBucket struct {
+	UpperBound float64 // Seconds; +Inf for the last bucket
+	Count      uint64  // Calls that took at most UpperBound
+}
+
+// OperationStats holds the counters of one operation group (load, resize, encode, ...).
+type OperationStats struct {
+	Name       string
+	Calls      uint64
+	Errors     uint64
+	BytesIn    uint64 // Encoded bytes passed to loaders
+	BytesOut   uint64 // Encoded bytes produced by encoders
+	LatencySum time.Duration
+	Buckets    []LatencyBucket
+}
+
+// Stats is a snapshot of the wrapper's counters and libvips' memory and cache state.
+//
+// libvips evaluates lazily, so decode and pixel work are accounted to the encode or
+// pipeline call that first needs the pixels.
+type Stats struct {
+	Operations       []OperationStats
+	VipsMem          uint64 // Bytes allocated by libvips for pixel buffers
+	VipsMemHighwater uint64 // Peak of VipsMem
+	VipsAllocs       int    // Active libvips pixel buffer allocations
+	VipsFiles        int    // Files open in libvips
+	CacheSize        int    // Operations in the libvips operation cache
+	CacheMax         int    // Operation cache size limit
+
+	// Totals over all ResultCaches
+	ResultCacheHits      uint64 // Process calls answered from a cache
+	ResultCacheMisses    uint64 // Process calls that rendered their result
+	ResultCacheCoalesced uint64 // Process calls that waited for an identical call's render
+	ResultCacheEvictions uint64 // Results evicted to stay within the byte budgets
+	ResultCacheEntries   uint64 // Results currently held
+	ResultCacheBytes     uint64 // Encoded bytes currently held
+}
+
+// GetStats returns a snapshot of the counters. It takes no locks and is cheap to poll.
+func GetStats() Stats {
+	var c C.ImageStats
+	C.vips_wrapper_get_stats(&c)
+
+	stats := Stats{
+		Operations:       make([]OperationStats, C.IMAGE_OP_COUNT),
+		VipsMem:          uint64(c.vips_mem),
+		VipsMemHighwater: uint64(c.vips_mem_highwater),
+		VipsAllocs:       int(c.vips_allocs),
+		VipsFiles:        int(c.vips_files),
+		CacheSize:        int(c.cache_size),
+		CacheMax:         int(c.cache_max),
+
+		ResultCacheHits:      uint64(c.result_cache_hits),
+		ResultCacheMisses:    uint64(c.result_cache_misses),
+		ResultCacheCoalesced: uint64(c.result_cache_coalesced),
+		ResultCacheEvictions: uint64(c.result_cache_evictions),
+		ResultCacheEntries:   uint64(c.result_cache_entries),
+		ResultCacheBytes:     uint64(c.result_cache_bytes),
+	}
+	for i := range stats.Operations {
+		op := &c.ops[i]
+		out := &stats.Operations[i]
+		out.Name = C.GoString(C.vips_wrapper_operation_name(C.ImageOperation(i)))
+		out.Calls = uint64(op.calls)
+		out.Errors = uint64(op.errors)
+		out.BytesIn = uint64(op.bytes_in)
+		out.BytesOut = uint64(op.bytes_out)
+		out.LatencySum = time.Duration(op.latency_ns_sum)
+		out.Buckets = make([]LatencyBucket, C.IMAGE_LATENCY_BUCKETS)
+
+		var cumulative uint64
+		for b := range out.Buckets {
+			cumulative += uint64(op.latency_buckets[b])
+			bound := math.Inf(1)
+			if b < C.IMAGE_LATENCY_BUCKETS-1 {
+				bound = float64(C.vips_wrapper_latency_bucket_bound_ns(C.int(b))) / 1e9
+			}
+			out.Buckets[b] = LatencyBucket{UpperBound: bound, Count: cumulative}
+		}
+	}
+	return stats
+}
+
+// ResetStats zeroes the operation counters.
+func ResetStats() {
+	C.vips_wrapper_reset_stats()
+}
+
+// WritePrometheus writes the snapshot in the Prometheus text exposition format,
+// with metric names prefixed by "vipsgo_".
+func (s Stats) WritePrometheus(w io.Writer) error {
+	bw := bufio.NewWriter(w)
+
+	counter := func(name, help string, value func(op *OperationStats) uint64) {
+		fmt.Fprintf(bw, "# HELP vipsgo_%s %s\n# TYPE vipsgo_%s counter\n", name, help, name)
+		for i := range s.Operations {
+			fmt.Fprintf(bw, "vipsgo_%s{op=%q} %d\n", name, s.Operations[i].Name, value(&s.Operations[i]))
+		}
+	}
+	counter("operations_total", "Wrapper calls by operation.", func(op *OperationStats) uint64 { return op.Calls })
+	counter("operation_errors_total", "Failed wrapper calls by operation.", func(op *OperationStats) uint64 { return op.Errors })
+	counter("operation_bytes_in_total", "Encoded bytes passed to loaders.", func(op *OperationStats) uint64 { return op.BytesIn })
+	counter("operation_bytes_out_total", "Encoded bytes produced by encoders.", func(op *OperationStats) uint64 { return op.BytesOut })
+
+	fmt.Fprint(bw, "# HELP vipsgo_operation_duration_seconds Wall time of wrapper calls.\n")
+	fmt.Fprint(bw, "# TYPE vipsgo_operation_duration_seconds histogram\n")
+	for i := range s.Operations {
+		op := &s.Operations[i]
+		for _, b := range op.Buckets {
+			le := "+Inf"
+			if !math.IsInf(b.UpperBound, 1) {
+				le = fmt.Sprint(b.UpperBound)
+			}
+			fmt.Fprintf(bw, "vipsgo_operation_duration_seconds_bucket{op=%q,le=%q} %d\n", op.Name, le, b.Count)
+		}
+		fmt.Fprintf(bw, "vipsgo_operation_duration_seconds_sum{op=%q} %g\n", op.Name, op.LatencySum.Seconds())
+		fmt.Fprintf(bw, "vipsgo_operation_duration_seconds_count{op=%q} %d\n", op.Name, op.Calls)
+	}
+
+	gauge := func(name, help string, value uint64) {
+		fmt.Fprintf(bw, "# HELP vipsgo_%s %s\n# TYPE vipsgo_%s gauge\nvipsgo_%s %d\n", name, help, name, name, value)
+	}
+	gauge("vips_memory_bytes", "Bytes allocated by libvips for pixel buffers.", s.VipsMem)
+	gauge("vips_memory_highwater_bytes", "Peak bytes allocated by libvips for pixel buffers.", s.VipsMemHighwater)
+	gauge("vips_allocations", "Active libvips pixel buffer allocations.", uint64(s.VipsAllocs))
+	gauge("vips_open_files", "Files open in libvips.", uint64(s.VipsFiles))
+	gauge("vips_cache_operations", "Operations in the libvips operation cache.", uint64(s.CacheSize))
+	gauge("vips_cache_max_operations", "Operation cache size limit.", uint64(s.CacheMax))
+
+	total := func(name, help string, value uint64) {
+		fmt.Fprintf(bw, "# HELP vipsgo_%s %s\n# TYPE vipsgo_%s counter\nvipsgo_%s %d\n", name, help, name, name, value)
+	}
+	total("result_cache_hits_total", "Result cache lookups answered from a cache.", s.ResultCacheHits)
+	total("result_cache_misses_total", "Result cache lookups that rendered their result.", s.ResultCacheMisses)
+	total("result_cache_coalesced_total", "Result cache lookups that waited for an identical render.", s.ResultCacheCoalesced)
+	total("result_cache_evictions_total", "Results evicted from result caches.", s.ResultCacheEvictions)
+	gauge("result_cache_entries", "Results held by result caches.", s.ResultCacheEntries)
+	gauge("result_cache_bytes", "Encoded bytes held by result caches.", s.ResultCacheBytes)
+
+	return bw.Flush()
+}
+
+// MetricsHandler serves GetStats in the Prometheus text format, e.g.
+//
+//	http.Handle("/metrics/vips", vips.MetricsHandler())
+func MetricsHandler() http.Handler {
+	return http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		w.Header().Set("Content-Type", "text/plain; version=0.0.4")
+		_ = GetStats().WritePrometheus(w)
+	})
+}
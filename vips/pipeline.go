@@ -0,0 +1,207 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"errors"
+	"runtime"
+	"unsafe"
+)
+
+// ImageFormat selects the output format of EncodeSpec based APIs.
+type ImageFormat C.ImageFormat
+
+const (
+	FormatNone ImageFormat = C.IMAGE_FORMAT_NONE
+	FormatJPEG ImageFormat = C.IMAGE_FORMAT_JPEG
+	FormatPNG  ImageFormat = C.IMAGE_FORMAT_PNG
+	FormatWebP ImageFormat = C.IMAGE_FORMAT_WEBP
+	FormatAVIF ImageFormat = C.IMAGE_FORMAT_AVIF
+	FormatJXL  ImageFormat = C.IMAGE_FORMAT_JXL
+	FormatHEIF ImageFormat = C.IMAGE_FORMAT_HEIF
+	FormatGIF  ImageFormat = C.IMAGE_FORMAT_GIF
+)
+
+// EncodeSpec describes an output format and its encoder options.
+// Only the options matching Format are used.
+type EncodeSpec struct {
+	Format ImageFormat
+	JPEG   ImageEncodeJPEGOptions
+	PNG    ImageEncodePNGOptions
+	WebP   ImageEncodeWebPOptions
+	AVIF   ImageEncodeAVIFOptions
+	JXL    ImageEncodeJXLOptions
+	HEIF   ImageEncodeHEIFOptions
+	GIF    ImageEncodeGIFOptions
+}
+
+// PipelineOp is one step of an Image.Pipeline call.
+// Build it with ResizeOp, CoverOp, CropOp, RotateOp, FlipOp, WatermarkOp,
+// PreparedWatermarkOp, OpacityOp or EnsureSRGB8Op.
+type PipelineOp struct {
+	op        C.ImagePipelineOp
+	watermark *Image     // Overlay of a watermark step, kept alive for the call
+	prepared  *Watermark // Prepared overlay of a watermark step, kept alive for the call
+}
+
+// ResizeOp returns a pipeline step equivalent to Image.Resize.
+func ResizeOp(options *ImageResizeOptions) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_RESIZE
+	p.op.resize = options.toC()
+	return p
+}
+
+// CoverOp returns a pipeline step equivalent to Image.Cover.
+func CoverOp(options *ImageCoverOptions) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_COVER
+	p.op.cover = options.toC()
+	return p
+}
+
+// CropOp returns a pipeline step equivalent to Image.Crop.
+func CropOp(options *ImageCropOptions) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_CROP
+	p.op.crop = options.toC()
+	return p
+}
+
+// RotateOp returns a pipeline step equivalent to Image.Rotate.
+func RotateOp(options *ImageRotateOptions) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_ROTATE
+	p.op.rotate = options.toC()
+	return p
+}
+
+// FlipOp returns a pipeline step equivalent to Image.Flip.
+func FlipOp(options *ImageFlipOptions) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_FLIP
+	p.op.flip = options.toC()
+	return p
+}
+
+// WatermarkOp returns a pipeline step equivalent to Image.Watermark with the given overlay.
+func WatermarkOp(watermarkImg *Image, options *ImageWatermarkOptions) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_WATERMARK
+	p.op.watermark = options.toC()
+	p.watermark = watermarkImg
+	if watermarkImg != nil {
+		p.op.watermark_image = watermarkImg.handle
+	}
+	return p
+}
+
+// PreparedWatermarkOp returns a pipeline step equivalent to Image.ApplyWatermark.
+func PreparedWatermarkOp(mark *Watermark, placement *WatermarkPlacement) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_PREPARED_WATERMARK
+	p.op.placement = placement.toC()
+	p.prepared = mark
+	if mark != nil {
+		p.op.prepared_watermark = mark.handle
+	}
+	return p
+}
+
+// OpacityOp returns a pipeline step equivalent to Image.ChangeOpacity.
+func OpacityOp(options *ImageOpacityOptions) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_OPACITY
+	p.op.opacity = options.toC()
+	return p
+}
+
+// Pipeline applies ops and encodes the result in a single call into the C library,
+// so a whole request costs one cgo crossing. The image itself is left unchanged and
+// can be used for further pipelines.
+//
+// If out is nil or out.Format is FormatNone, the operations are applied to the image
+// in place (like calling the individual methods) and no bytes are returned.
+func (img *Image) Pipeline(out *EncodeSpec, ops ...PipelineOp) ([]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+
+	cOps, err := pipelineOps(ops)
+	if err != nil {
+		return nil, err
+	}
+	cOpsPtr := firstOp(cOps)
+
+	var cOut C.ImageEncodeSpec
+	if out != nil {
+		cOut = out.toC()
+	}
+
+	var cBuffer C.ImageBuffer
+	err = checkStatus(func() C.ImageStatus {
+		return C.process_pipeline(img.handle, cOpsPtr, C.size_t(len(cOps)), cOut, &cBuffer)
+	})
+	runtime.KeepAlive(img)
+	runtime.KeepAlive(ops)
+	if err != nil {
+		return nil, err
+	}
+	if cOut.format == C.IMAGE_FORMAT_NONE {
+		return nil, nil
+	}
+	if cBuffer.data == nil {
+		return nil, errors.New("pipeline produced no output: check logs for VIPS errors")
+	}
+	defer C.free_image_buffer(cBuffer)
+
+	return C.GoBytes(unsafe.Pointer(cBuffer.data), C.int(cBuffer.size)), nil
+}
+
+// pipelineOps converts ops to the array passed to the C library.
+func pipelineOps(ops []PipelineOp) ([]C.ImagePipelineOp, error) {
+	cOps := make([]C.ImagePipelineOp, len(ops))
+	for i := range ops {
+		if ops[i].op._type == C.PIPELINE_OP_WATERMARK && ops[i].op.watermark_image == nil {
+			return nil, VipsInvalidHandle.Error()
+		}
+		if ops[i].op._type == C.PIPELINE_OP_PREPARED_WATERMARK && ops[i].op.prepared_watermark == nil {
+			return nil, VipsInvalidHandle.Error()
+		}
+		cOps[i] = ops[i].op
+	}
+	return cOps, nil
+}
+
+// firstOp returns a pointer to the first op, or nil for an empty pipeline.
+func firstOp(cOps []C.ImagePipelineOp) *C.ImagePipelineOp {
+	if len(cOps) == 0 {
+		return nil
+	}
+	return &cOps[0]
+}
+
+// EnsureSRGB8Op returns a pipeline step equivalent to Image.EnsureSRGB8.
+// Put it first so the remaining steps run on 8-bit sRGB data.
+func EnsureSRGB8Op(options *ImageSRGBOptions) PipelineOp {
+	var p PipelineOp
+	p.op._type = C.PIPELINE_OP_ENSURE_SRGB8
+	p.op.srgb = options.toC()
+	return p
+}
+
+// toC converts the encode spec to its C representation.
+func (s *EncodeSpec) toC() C.ImageEncodeSpec {
+	return C.ImageEncodeSpec{
+		format: C.ImageFormat(s.Format),
+		jpeg:   s.JPEG.toC(),
+		png:    s.PNG.toC(),
+		webp:   s.WebP.toC(),
+		avif:   s.AVIF.toC(),
+		jxl:    s.JXL.toC(),
+		heif:   s.HEIF.toC(),
+		gif:    s.GIF.toC(),
+	}
+}
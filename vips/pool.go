@@ -0,0 +1,142 @@
+package vips
+
+/*
+#include <stdint.h>
+#include "c/include/vips_wrapper.h"
+
+// Exported from callbacks.go
+extern void vipsgoJobDone(ImageStatus status, ImageBuffer result, void* user_data);
+
+// Builds the job spec on the C side so no Go pointer is stored in C memory.
+static inline ImageStatus vipsgo_submit_job(ImageWorkerPoolHandle pool, VImageHandle image,
+                                            const ImagePipelineOp* ops, size_t op_count,
+                                            ImageEncodeSpec output, uintptr_t job) {
+	ImagePipelineSpec spec = {image, ops, op_count, output};
+	return submit_job(pool, spec, vipsgoJobDone, (void*)job);
+}
+*/
+import "C"
+import (
+	"errors"
+	"runtime"
+	"runtime/cgo"
+	"sync"
+)
+
+var (
+	// ErrPoolFull is returned by Pool.Submit when the job queue is full.
+	ErrPoolFull = errors.New("worker pool queue is full")
+	// ErrPoolClosed is returned by Pool.Submit after Close.
+	ErrPoolClosed = errors.New("worker pool is closed")
+)
+
+// PoolOptions sizes a Pool.
+type PoolOptions struct {
+	Workers    int // Native worker threads (0 = one per CPU core)
+	QueueDepth int // Jobs that may wait for a worker (0 = 2 x Workers)
+}
+
+// Pool runs pipelines on a fixed set of native worker threads.
+//
+// Submit only queues the job, so goroutines never hold an OS thread inside
+// libvips while an image is processed, and the number of threads doing image
+// work stays fixed however many goroutines submit. When the queue is full,
+// Submit fails fast with ErrPoolFull so callers can shed load.
+type Pool struct {
+	mu     sync.RWMutex
+	handle C.ImageWorkerPoolHandle
+}
+
+// Job is the pending result of Pool.Submit.
+type Job struct {
+	done chan struct{}
+	data []byte
+	err  error
+}
+
+// NewPool starts a worker pool. Call Close when done with it.
+func NewPool(options *PoolOptions) (*Pool, error) {
+	var cOptions C.ImageWorkerPoolOptions
+	if options != nil {
+		cOptions.workers = C.int(options.Workers)
+		cOptions.queue_depth = C.int(options.QueueDepth)
+	}
+	var handle C.ImageWorkerPoolHandle
+	if err := detailed(func() bool {
+		handle = C.create_worker_pool(cOptions)
+		return handle != nil
+	}); err != nil {
+		return nil, err
+	}
+	pool := &Pool{handle: handle}
+	runtime.SetFinalizer(pool, (*Pool).Close)
+	return pool, nil
+}
+
+// Submit queues ops on img followed by encoding to out, and returns immediately.
+// img may be freed or reused once Submit returns; the job keeps its own reference.
+// Returns ErrPoolFull if the queue is full.
+func (p *Pool) Submit(img *Image, out *EncodeSpec, ops ...PipelineOp) (*Job, error) {
+	if img == nil || img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	if out == nil || out.Format == FormatNone {
+		return nil, ImageInvalidFormat.Error()
+	}
+	cOps, err := pipelineOps(ops)
+	if err != nil {
+		return nil, err
+	}
+
+	job := &Job{done: make(chan struct{})}
+	handle := cgo.NewHandle(job)
+
+	p.mu.RLock()
+	if p.handle == nil {
+		p.mu.RUnlock()
+		handle.Delete()
+		return nil, ErrPoolClosed
+	}
+	status := ImageStatus(C.vipsgo_submit_job(p.handle, img.handle, firstOp(cOps), C.size_t(len(cOps)),
+		out.toC(), C.uintptr_t(handle)))
+	p.mu.RUnlock()
+	runtime.KeepAlive(img)
+	runtime.KeepAlive(ops)
+
+	if err := status.Error(); err != nil {
+		handle.Delete()
+		return nil, err
+	}
+	return job, nil
+}
+
+// Queued returns the number of jobs waiting for a worker.
+func (p *Pool) Queued() int {
+	p.mu.RLock()
+	defer p.mu.RUnlock()
+	return int(C.worker_pool_queued(p.handle))
+}
+
+// Close stops accepting jobs, waits for queued jobs to finish and stops the workers.
+func (p *Pool) Close() {
+	p.mu.Lock()
+	handle := p.handle
+	p.handle = nil
+	p.mu.Unlock()
+
+	if handle != nil {
+		C.destroy_worker_pool(handle)
+		runtime.SetFinalizer(p, nil)
+	}
+}
+
+// Done returns a channel that is closed when the job has finished.
+func (j *Job) Done() <-chan struct{} {
+	return j.done
+}
+
+// Wait blocks until the job has finished and returns its encoded output.
+func (j *Job) Wait() ([]byte, error) {
+	<-j.done
+	return j.data, j.err
+}
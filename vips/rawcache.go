@@ -0,0 +1,132 @@
+package vips
+
+/*
+#include <stdlib.h>
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"errors"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+var (
+	// ErrCacheMiss is returned by RawCache.Load when the key has no entry.
+	ErrCacheMiss = errors.New("raw cache miss")
+	// ErrCacheClosed is returned by RawCache methods after Close.
+	ErrCacheClosed = errors.New("raw cache is closed")
+)
+
+// RawCacheOptions locates and bounds a RawCache.
+type RawCacheOptions struct {
+	Directory string // Directory holding the cache files; created if missing
+	MaxBytes  uint64 // Total file size before least recently used entries are evicted (0 = unbounded)
+}
+
+// RawCacheStats holds the counters of a RawCache, as seen by this process.
+type RawCacheStats struct {
+	Entries   uint64 // Files currently indexed
+	Bytes     uint64 // Total size of the indexed files
+	Hits      uint64 // Load calls that returned an image
+	Misses    uint64 // Load calls that returned ErrCacheMiss
+	Evictions uint64 // Files removed to stay within MaxBytes
+}
+
+// RawCache keeps decoded images on disk in the uncompressed libvips ".v" format, so
+// that derivatives of hot masters can be re-rendered without decoding them again:
+// a loaded entry is mapped, not decoded. Entries are evicted least recently used
+// first once MaxBytes is exceeded. Several processes may share one directory.
+type RawCache struct {
+	mu     sync.RWMutex
+	handle C.ImageRawCacheHandle
+}
+
+// NewRawCache opens a raw cache on options.Directory, indexing the entries already
+// in it. Call Close when done with it; the files stay on disk.
+func NewRawCache(options *RawCacheOptions) (*RawCache, error) {
+	if options == nil {
+		return nil, errors.New("raw cache options are nil")
+	}
+	cDirectory := C.CString(options.Directory)
+	defer C.free(unsafe.Pointer(cDirectory))
+	cOptions := C.ImageRawCacheOptions{directory: cDirectory, max_bytes: C.uint64_t(options.MaxBytes)}
+
+	var handle C.ImageRawCacheHandle
+	if err := detailed(func() bool {
+		handle = C.create_raw_cache(cOptions, nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
+	}
+	cache := &RawCache{handle: handle}
+	runtime.SetFinalizer(cache, (*RawCache).Close)
+	return cache, nil
+}
+
+// Store renders img and stores its pixels under key, replacing an existing entry.
+// Resize img first to cache a pre-shrunk copy. img itself is left unchanged.
+func (c *RawCache) Store(key string, img *Image) error {
+	if img == nil || img.handle == nil {
+		return VipsInvalidHandle.Error()
+	}
+	cKey := C.CString(key)
+	defer C.free(unsafe.Pointer(cKey))
+
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	if c.handle == nil {
+		return ErrCacheClosed
+	}
+	err := checkStatus(func() C.ImageStatus { return C.export_to_raw_cache(c.handle, cKey, img.handle) })
+	runtime.KeepAlive(img)
+	return err
+}
+
+// Load returns the image stored under key, or an error matching ErrCacheMiss.
+func (c *RawCache) Load(key string) (*Image, error) {
+	cKey := C.CString(key)
+	defer C.free(unsafe.Pointer(cKey))
+
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	if c.handle == nil {
+		return nil, ErrCacheClosed
+	}
+	var handle C.VImageHandle
+	if err := detailed(func() bool {
+		handle = C.load_from_raw_cache(c.handle, cKey, nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
+	}
+	return newImage(handle), nil
+}
+
+// Stats returns the cache counters.
+func (c *RawCache) Stats() RawCacheStats {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	cStats := C.raw_cache_stats(c.handle)
+	return RawCacheStats{
+		Entries:   uint64(cStats.entries),
+		Bytes:     uint64(cStats.bytes),
+		Hits:      uint64(cStats.hits),
+		Misses:    uint64(cStats.misses),
+		Evictions: uint64(cStats.evictions),
+	}
+}
+
+// Close releases the cache handle. The files stay on disk for the next NewRawCache.
+func (c *RawCache) Close() {
+	c.mu.Lock()
+	handle := c.handle
+	c.handle = nil
+	c.mu.Unlock()
+
+	if handle != nil {
+		C.destroy_raw_cache(handle)
+		runtime.SetFinalizer(c, nil)
+	}
+}
@@ -0,0 +1,101 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"errors"
+	"runtime"
+	"unsafe"
+)
+
+// RenditionSpec is one output size of Image.Renditions.
+type RenditionSpec struct {
+	Resize ImageResizeOptions // Target size, as for Image.Resize
+	Output EncodeSpec         // Output format and encoder options
+}
+
+// Renditions encodes several sizes of the image from a single decode. The largest
+// rendition is resized from the image and kept in memory, each smaller one is resized
+// from the smallest larger one covering it on both axes, and all of them are encoded in
+// parallel in the C library.
+// The results are in the order of specs; the image itself is left unchanged.
+func (img *Image) Renditions(specs []RenditionSpec) ([][]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+
+	cSpecs, cOut := renditionArrays(specs)
+	err := checkStatus(func() C.ImageStatus {
+		return C.generate_renditions(img.handle, firstSpec(cSpecs), C.size_t(len(cSpecs)), firstBuffer(cOut))
+	})
+	runtime.KeepAlive(img)
+	if err != nil {
+		return nil, err
+	}
+	return takeRenditions(cOut), nil
+}
+
+// RenditionsFromBytes is Image.Renditions for an encoded image. JPEG input is decoded
+// with the largest DCT shrink that still covers every rendition, and each rendition is
+// resized once. The slice is only read during the call.
+func RenditionsFromBytes(data []byte, specs []RenditionSpec) ([][]byte, error) {
+	return RenditionsFromBytesWithOptions(data, &ImageLoadOptions{}, specs)
+}
+
+// RenditionsFromBytesWithOptions is RenditionsFromBytes with the load limits, strictness
+// and autorotation of load. The access mode and page selection are ignored.
+func RenditionsFromBytesWithOptions(data []byte, load *ImageLoadOptions, specs []RenditionSpec) ([][]byte, error) {
+	if len(data) == 0 {
+		return nil, errors.New("image data is empty")
+	}
+
+	cSpecs, cOut := renditionArrays(specs)
+	err := checkStatus(func() C.ImageStatus {
+		return C.generate_renditions_from_buffer_with_options((*C.uchar)(unsafe.Pointer(&data[0])),
+			C.size_t(len(data)), load.toC(), firstSpec(cSpecs), C.size_t(len(cSpecs)), firstBuffer(cOut))
+	})
+	if err != nil {
+		return nil, err
+	}
+	return takeRenditions(cOut), nil
+}
+
+// renditionArrays converts specs to the C array and allocates the matching output array.
+func renditionArrays(specs []RenditionSpec) ([]C.ImageRenditionSpec, []C.ImageBuffer) {
+	cSpecs := make([]C.ImageRenditionSpec, len(specs))
+	for i := range specs {
+		cSpecs[i] = C.ImageRenditionSpec{
+			resize: specs[i].Resize.toC(),
+			output: specs[i].Output.toC(),
+		}
+	}
+	return cSpecs, make([]C.ImageBuffer, len(specs))
+}
+
+// takeRenditions copies the encoded renditions into Go memory and frees the C buffers.
+func takeRenditions(cOut []C.ImageBuffer) [][]byte {
+	out := make([][]byte, len(cOut))
+	for i, buffer := range cOut {
+		out[i] = C.GoBytes(unsafe.Pointer(buffer.data), C.int(buffer.size))
+		C.free_image_buffer(buffer)
+	}
+	return out
+}
+
+// firstSpec returns a pointer to the first spec, or nil for no specs.
+func firstSpec(cSpecs []C.ImageRenditionSpec) *C.ImageRenditionSpec {
+	if len(cSpecs) == 0 {
+		return nil
+	}
+	return &cSpecs[0]
+}
+
+// firstBuffer returns a pointer to the first buffer, or nil for no buffers.
+func firstBuffer(cOut []C.ImageBuffer) *C.ImageBuffer {
+	if len(cOut) == 0 {
+		return nil
+	}
+	return &cOut[0]
+}
@@ -0,0 +1,126 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"errors"
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+// ErrResultCacheClosed is returned by ResultCache methods after Close.
+var ErrResultCacheClosed = errors.New("result cache is closed")
+
+// ResultCacheOptions sizes a ResultCache.
+type ResultCacheOptions struct {
+	MaxBytes uint64 // Encoded bytes kept before least recently used results are evicted (0 = 64 MiB)
+	Shards   int    // Independently locked partitions sharing MaxBytes evenly (0 = 16)
+}
+
+// ResultCacheStats holds the counters of a ResultCache.
+type ResultCacheStats struct {
+	Entries   uint64 // Results currently held
+	Bytes     uint64 // Encoded bytes currently held
+	Hits      uint64 // Process calls answered from the cache
+	Misses    uint64 // Process calls that rendered their result
+	Coalesced uint64 // Process calls that waited for an identical call's render
+	Evictions uint64 // Results evicted to stay within MaxBytes
+}
+
+// ResultCache keeps encoded outputs in memory, keyed on a hash of the input bytes and
+// every option that affects the output, so repeated identical requests skip the
+// decode, the pipeline and the encode. Identical requests that miss at the same time
+// share a single render. It is safe for concurrent use.
+type ResultCache struct {
+	mu     sync.RWMutex
+	handle C.ImageResultCacheHandle
+}
+
+// NewResultCache creates a result cache. Call Close when done with it.
+func NewResultCache(options *ResultCacheOptions) (*ResultCache, error) {
+	var cOptions C.ImageResultCacheOptions
+	if options != nil {
+		cOptions = C.ImageResultCacheOptions{max_bytes: C.uint64_t(options.MaxBytes), shards: C.int(options.Shards)}
+	}
+
+	var handle C.ImageResultCacheHandle
+	if err := detailed(func() bool {
+		handle = C.create_result_cache(cOptions, nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
+	}
+	cache := &ResultCache{handle: handle}
+	runtime.SetFinalizer(cache, (*ResultCache).Close)
+	return cache, nil
+}
+
+// Process decodes data with load (nil for the defaults), applies ops and encodes the
+// result as out, or returns a copy of the stored output of an identical earlier call.
+// out must not be nil or FormatNone. Pipelines with a WatermarkOp step are rendered
+// every time; use PreparedWatermarkOp for cacheable watermarks. Failures are not cached.
+// data is only read during the call; a miss decodes a copy of it.
+func (c *ResultCache) Process(data []byte, load *ImageLoadOptions, out *EncodeSpec, ops ...PipelineOp) ([]byte, error) {
+	if len(data) == 0 {
+		return nil, errors.New("image data is empty")
+	}
+	if out == nil {
+		return nil, errors.New("encode spec is nil")
+	}
+	cOps, err := pipelineOps(ops)
+	if err != nil {
+		return nil, err
+	}
+	var cLoad C.ImageLoadOptions
+	if load != nil {
+		cLoad = load.toC()
+	}
+
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	if c.handle == nil {
+		return nil, ErrResultCacheClosed
+	}
+	var cResult C.ImageCachedBuffer
+	err = checkStatus(func() C.ImageStatus {
+		return C.process_cached(c.handle, (*C.uchar)(unsafe.Pointer(&data[0])), C.size_t(len(data)), cLoad,
+			firstOp(cOps), C.size_t(len(cOps)), out.toC(), &cResult)
+	})
+	runtime.KeepAlive(ops)
+	if err != nil {
+		return nil, err
+	}
+	defer C.release_cached_buffer(cResult)
+	return C.GoBytes(unsafe.Pointer(cResult.data), C.int(cResult.size)), nil
+}
+
+// Stats returns the cache counters. The totals over all result caches are also in GetStats.
+func (c *ResultCache) Stats() ResultCacheStats {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	cStats := C.result_cache_stats(c.handle)
+	return ResultCacheStats{
+		Entries:   uint64(cStats.entries),
+		Bytes:     uint64(cStats.bytes),
+		Hits:      uint64(cStats.hits),
+		Misses:    uint64(cStats.misses),
+		Coalesced: uint64(cStats.coalesced),
+		Evictions: uint64(cStats.evictions),
+	}
+}
+
+// Close frees the cache and its results, waiting for running Process calls to finish.
+func (c *ResultCache) Close() {
+	c.mu.Lock()
+	handle := c.handle
+	c.handle = nil
+	c.mu.Unlock()
+
+	if handle != nil {
+		C.destroy_result_cache(handle)
+		runtime.SetFinalizer(c, nil)
+	}
+}
@@ -0,0 +1,105 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"runtime"
+	"unsafe"
+)
+
+// TensorOrder selects the axis order of Image.WriteToMemory.
+type TensorOrder C.ImageTensorOrder
+
+const (
+	TensorHWC TensorOrder = C.IMAGE_TENSOR_HWC // Interleaved: row, column, band
+	TensorCHW TensorOrder = C.IMAGE_TENSOR_CHW // Planar: one plane per band (PyTorch, ONNX)
+)
+
+// TensorSpec configures Image.WriteToMemory. Each sample is written as
+// (v*Scale - Mean[b]) / Std[b] for its band b; the zero value writes the pixels
+// unchanged as interleaved uint8.
+type TensorSpec struct {
+	Order     TensorOrder
+	Format    SampleFormat // SampleUChar (default) or SampleFloat
+	RowStride int          // Bytes from one row to the next, for aligned rows (0 = packed)
+	Scale     float32      // Applied before Mean and Std (0 = 1; 1.0/255 maps uint8 to [0, 1])
+	Mean      [4]float32   // Subtracted per band after scaling
+	Std       [4]float32   // Divisor per band after the mean (0 = 1)
+}
+
+// toC converts the spec to its C representation.
+func (s *TensorSpec) toC() C.ImageTensorSpec {
+	if s == nil {
+		return C.ImageTensorSpec{}
+	}
+	cSpec := C.ImageTensorSpec{
+		order:      C.ImageTensorOrder(s.Order),
+		format:     C.ImageSampleFormat(s.Format),
+		row_stride: C.size_t(s.RowStride),
+		scale:      C.float(s.Scale),
+	}
+	for i := range s.Mean {
+		cSpec.mean[i] = C.float(s.Mean[i])
+		cSpec.std[i] = C.float(s.Std[i])
+	}
+	return cSpec
+}
+
+// WriteToMemory writes the pixels of the image as a tensor laid out by spec. Pending
+// operations, the sample conversion, the normalisation and the reordering to planes run
+// in one streaming pass on libvips' worker threads, with no encode in between.
+//
+// The tensor is written into dst when it is large enough, so a buffer can be reused
+// across calls; otherwise a new slice is allocated. Float samples are in native byte
+// order; see WriteTensor for a []float32 result.
+func (img *Image) WriteToMemory(spec *TensorSpec, dst []byte) ([]byte, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+	cSpec := spec.toC()
+
+	var needed C.size_t
+	write := func(buf []byte) C.ImageStatus {
+		var out unsafe.Pointer
+		if len(buf) > 0 {
+			out = unsafe.Pointer(&buf[0])
+		}
+		return C.write_to_memory(img.handle, cSpec, out, C.size_t(len(buf)), &needed)
+	}
+	err := checkStatus(func() C.ImageStatus {
+		status := write(dst[:cap(dst)])
+		if status == C.IMAGE_BUFFER_TOO_SMALL {
+			// The size is known before any pixel is computed, so the first call was cheap
+			dst = make([]byte, int(needed))
+			status = write(dst)
+		}
+		return status
+	})
+	runtime.KeepAlive(img)
+	if err != nil {
+		return nil, err
+	}
+	return dst[:int(needed)], nil
+}
+
+// WriteTensor is WriteToMemory for float output: spec.Format is ignored and the
+// samples are returned as float32, reusing dst when it is large enough. spec may be nil.
+func (img *Image) WriteTensor(spec *TensorSpec, dst []float32) ([]float32, error) {
+	floatSpec := TensorSpec{}
+	if spec != nil {
+		floatSpec = *spec
+	}
+	floatSpec.Format = SampleFloat
+
+	var buf []byte
+	if cap(dst) > 0 {
+		buf = unsafe.Slice((*byte)(unsafe.Pointer(&dst[:cap(dst)][0])), cap(dst)*4)
+	}
+	out, err := img.WriteToMemory(&floatSpec, buf)
+	if err != nil {
+		return nil, err
+	}
+	return unsafe.Slice((*float32)(unsafe.Pointer(&out[0])), len(out)/4), nil
+}
@@ -0,0 +1,136 @@
+package vips
+
+/*
+#include <stdlib.h>
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import (
+	"runtime"
+	"unsafe"
+)
+
+// SampleFormat is the type of each sample of raw pixels.
+type SampleFormat C.ImageSampleFormat
+
+const (
+	SampleUChar     SampleFormat = C.IMAGE_SAMPLE_UCHAR
+	SampleChar      SampleFormat = C.IMAGE_SAMPLE_CHAR
+	SampleUShort    SampleFormat = C.IMAGE_SAMPLE_USHORT
+	SampleShort     SampleFormat = C.IMAGE_SAMPLE_SHORT
+	SampleUInt      SampleFormat = C.IMAGE_SAMPLE_UINT
+	SampleInt       SampleFormat = C.IMAGE_SAMPLE_INT
+	SampleFloat     SampleFormat = C.IMAGE_SAMPLE_FLOAT
+	SampleComplex   SampleFormat = C.IMAGE_SAMPLE_COMPLEX
+	SampleDouble    SampleFormat = C.IMAGE_SAMPLE_DOUBLE
+	SampleDPComplex SampleFormat = C.IMAGE_SAMPLE_DPCOMPLEX
+)
+
+// PixelLayout describes the pixels returned by Image.FetchRegion: rows packed top to
+// bottom, each pixel holding Bands interleaved samples in native byte order.
+type PixelLayout struct {
+	Width         int
+	Height        int
+	Bands         int
+	Format        SampleFormat
+	BytesPerPixel int
+	Stride        int // Bytes per row
+}
+
+// FetchRegion returns the raw pixels of the width x height rectangle at (x, y).
+// Only that rectangle is computed, so on tiled or mapped sources (tiled TIFF, ".v"
+// files, RawCache entries) the cost follows the region size, not the image size.
+//
+// The pixels are written into dst when it is large enough, so a buffer can be reused
+// across calls; otherwise a new slice is allocated. Load with AccessRandom: a
+// sequentially loaded image is decoded in full on every call.
+func (img *Image) FetchRegion(x, y, width, height int, dst []byte) ([]byte, PixelLayout, error) {
+	if img.handle == nil {
+		return nil, PixelLayout{}, VipsInvalidHandle.Error()
+	}
+
+	var cLayout C.ImagePixelLayout
+	fetch := func(buf []byte) C.ImageStatus {
+		var out *C.uchar
+		if len(buf) > 0 {
+			out = (*C.uchar)(unsafe.Pointer(&buf[0]))
+		}
+		return C.fetch_region(img.handle, C.int(x), C.int(y), C.int(width), C.int(height), out, C.size_t(len(buf)), &cLayout)
+	}
+	err := checkStatus(func() C.ImageStatus {
+		status := fetch(dst[:cap(dst)])
+		if status == C.IMAGE_BUFFER_TOO_SMALL {
+			// The layout is known before any pixel is computed, so the first call was cheap
+			dst = make([]byte, int(cLayout.stride)*int(cLayout.height))
+			status = fetch(dst)
+		}
+		return status
+	})
+	runtime.KeepAlive(img)
+	if err != nil {
+		return nil, PixelLayout{}, err
+	}
+
+	layout := PixelLayout{
+		Width:         int(cLayout.width),
+		Height:        int(cLayout.height),
+		Bands:         int(cLayout.bands),
+		Format:        SampleFormat(cLayout.format),
+		BytesPerPixel: int(cLayout.bytes_per_pixel),
+		Stride:        int(cLayout.stride),
+	}
+	return dst[:layout.Stride*layout.Height], layout, nil
+}
+
+// TileLayout selects the directory layout of Image.TilePyramid.
+type TileLayout C.ImageTileLayout
+
+const (
+	TileLayoutDeepZoom TileLayout = C.IMAGE_TILE_LAYOUT_DZ      // name.dzi plus name_files/<level>/<col>_<row>
+	TileLayoutZoomify  TileLayout = C.IMAGE_TILE_LAYOUT_ZOOMIFY // name/ImageProperties.xml plus TileGroup<n>/
+	TileLayoutGoogle   TileLayout = C.IMAGE_TILE_LAYOUT_GOOGLE  // name/<z>/<y>/<x>
+	TileLayoutIIIF     TileLayout = C.IMAGE_TILE_LAYOUT_IIIF    // name/info.json plus IIIF Image API 2 paths
+)
+
+// TileDepth selects how far Image.TilePyramid shrinks.
+type TileDepth C.ImageTileDepth
+
+const (
+	TileDepthOnePixel TileDepth = C.IMAGE_TILE_DEPTH_ONEPIXEL // Until the image is one pixel
+	TileDepthOneTile  TileDepth = C.IMAGE_TILE_DEPTH_ONETILE  // Until the image fits in one tile
+	TileDepthOne      TileDepth = C.IMAGE_TILE_DEPTH_ONE      // Full resolution only
+)
+
+// TilePyramidOptions configures Image.TilePyramid.
+type TilePyramidOptions struct {
+	Layout   TileLayout
+	TileSize int // Tile edge in pixels (0 = 254 for Deep Zoom, 256 otherwise)
+	Overlap  int // Pixels shared by neighbouring tiles (Deep Zoom only)
+	Depth    TileDepth
+	Tiles    EncodeSpec // JPEG (default), PNG or WebP; quality, lossless, compression and effort are used
+}
+
+// TilePyramid writes a zoomable tile pyramid of the image to path (without extension)
+// in one top-to-bottom pass, so sequentially loaded gigapixel images need memory for
+// a few rows of tiles only. Tiles are encoded in parallel on libvips' worker threads.
+func (img *Image) TilePyramid(path string, options *TilePyramidOptions) error {
+	if img.handle == nil {
+		return VipsInvalidHandle.Error()
+	}
+	var cOptions C.ImageTilePyramidOptions
+	if options != nil {
+		cOptions = C.ImageTilePyramidOptions{
+			layout:    C.ImageTileLayout(options.Layout),
+			tile_size: C.int(options.TileSize),
+			overlap:   C.int(options.Overlap),
+			depth:     C.ImageTileDepth(options.Depth),
+			tiles:     options.Tiles.toC(),
+		}
+	}
+	cPath := C.CString(path)
+	defer C.free(unsafe.Pointer(cPath))
+
+	err := checkStatus(func() C.ImageStatus { return C.generate_tile_pyramid(img.handle, cPath, cOptions) })
+	runtime.KeepAlive(img)
+	return err
+}
@@ -8,12 +8,24 @@ package vips
 #cgo pkg-config: vips-cpp
 #include "c/include/vips_wrapper.h"
 #include <stdlib.h> // For free
+#include <stdint.h> // For uintptr_t
+
+// cgo.Handle values travel through the C library as opaque user_data pointers.
+static inline void* vipsgo_handle_to_ptr(uintptr_t handle) { return (void*)handle; }
+
+// Exported from callbacks.go
+extern void vipsgoReleaseBuffer(void* data, void* user_data);
+extern long long vipsgoWrite(void* data, size_t size, void* user_data);
 
 // Forward declarations for functions that return pointers,
 // so Go can understand their signatures when called from C.
 // These are not strictly necessary for simple cases but good practice.
 extern VImageHandle load_image(const char* input_path);
 extern VImageHandle load_image_from_bytes(const unsigned char* data, size_t size);
+extern VImageHandle load_image_with_options(const char* input_path, ImageLoadOptions options, ImageStatus* status);
+extern VImageHandle load_image_from_owned_bytes(const unsigned char* data, size_t size, ImageLoadOptions options, ImageBufferReleaseFn release, void* user_data, ImageStatus* status);
+extern VImageHandle thumbnail_from_path(const char* input_path, ImageResizeOptions options, ImageStatus* status);
+extern VImageHandle thumbnail_from_buffer(const unsigned char* data, size_t size, ImageResizeOptions options, ImageStatus* status);
 extern void free_vimage_handle(VImageHandle handle);
 extern ImageBuffer encode_to_jpeg(VImageHandle handle, ImageEncodeJPEGOptions options);
 extern ImageBuffer encode_to_png(VImageHandle handle, ImageEncodePNGOptions options);
@@ -23,7 +35,9 @@ import "C"
 import (
 	"errors"
 	"fmt"
+	"io"
 	"runtime"
+	"runtime/cgo"
 	"unsafe"
 )
 
@@ -39,6 +53,15 @@ const (
 	ImageInvalidPosition    ImageStatus = C.IMAGE_INVALID_POSITION
 	ImageInvalidBounds      ImageStatus = C.IMAGE_INVALID_BOUNDS
 	MemoryAllocationFailure ImageStatus = C.MEMORY_ALLOCATION_FAILURE
+	ImageInvalidPath        ImageStatus = C.IMAGE_INVALID_PATH
+	ImageLoadFailure        ImageStatus = C.IMAGE_LOAD_FAILURE
+	ImageSaveFailure        ImageStatus = C.IMAGE_SAVE_FAILURE
+	ImageBufferTooSmall     ImageStatus = C.IMAGE_BUFFER_TOO_SMALL
+	ImageInvalidFormat      ImageStatus = C.IMAGE_INVALID_FORMAT
+	ImageQueueFull          ImageStatus = C.IMAGE_QUEUE_FULL
+	ImageTooLarge           ImageStatus = C.IMAGE_TOO_LARGE
+	ImageCacheMiss          ImageStatus = C.IMAGE_CACHE_MISS
+	ImageCancelled          ImageStatus = C.IMAGE_CANCELLED
 	UnknownError            ImageStatus = C.UNKNOWN_ERROR
 )
 
@@ -62,6 +85,24 @@ func (s ImageStatus) Error() error {
 		return errors.New("image operation out of bounds")
 	case MemoryAllocationFailure:
 		return errors.New("memory allocation failed")
+	case ImageInvalidPath:
+		return errors.New("invalid image path")
+	case ImageLoadFailure:
+		return errors.New("failed to load image")
+	case ImageSaveFailure:
+		return errors.New("failed to encode image")
+	case ImageBufferTooSmall:
+		return errors.New("output buffer too small")
+	case ImageInvalidFormat:
+		return errors.New("unsupported image format")
+	case ImageQueueFull:
+		return ErrPoolFull
+	case ImageTooLarge:
+		return errors.New("image exceeds the load limits")
+	case ImageCacheMiss:
+		return ErrCacheMiss
+	case ImageCancelled:
+		return ErrCancelled
 	case UnknownError:
 		return errors.New("an unknown error occurred")
 	default:
@@ -70,10 +111,62 @@ func (s ImageStatus) Error() error {
 }
 
 // Image represents a loaded image, managed by the C library.
+//
+// Methods that only read an image (ExtractMetadata, the encoders, Pipeline with an
+// output format, Renditions, Clone and the ...To transforms) may be called from many
+// goroutines at once on an image loaded with AccessRandom. The in-place transforms
+// (Resize, Crop, ...) and Free need exclusive use of the Image; derive per-goroutine
+// images with Clone or the ...To methods instead of sharing one that is modified.
 type Image struct {
 	handle C.VImageHandle
 }
 
+// ImageAccess selects the pixel access pattern requested from the loader.
+type ImageAccess C.ImageAccess
+
+const (
+	// AccessRandom allows pixels to be read in any order (default).
+	AccessRandom ImageAccess = C.IMAGE_ACCESS_RANDOM
+	// AccessSequential streams pixels once, top to bottom, keeping only a strip in memory.
+	// Use it for resize/crop/opacity/watermark chains followed by a single encode.
+	AccessSequential ImageAccess = C.IMAGE_ACCESS_SEQUENTIAL
+)
+
+// FailOn selects how strictly the loader treats damaged files.
+type FailOn C.ImageFailOn
+
+const (
+	FailOnNone      FailOn = C.IMAGE_FAIL_ON_NONE      // Decode whatever can be decoded (default)
+	FailOnTruncated FailOn = C.IMAGE_FAIL_ON_TRUNCATED // Reject truncated files
+	FailOnError     FailOn = C.IMAGE_FAIL_ON_ERROR     // Reject files with decode errors
+	FailOnWarning   FailOn = C.IMAGE_FAIL_ON_WARNING   // Reject files with anything unusual
+)
+
+// ImageLoadOptions defines options for loading an image.
+//
+// The limits protect against decompression bombs: they are checked against the
+// encoded size and the image header before any pixels are decoded, and a load
+// exceeding one fails with ImageTooLarge. Zero means no limit.
+type ImageLoadOptions struct {
+	Access    ImageAccess
+	MaxWidth  int    // Reject wider images
+	MaxHeight int    // Reject taller images
+	MaxPixels uint64 // Reject images with more pixels (width * height)
+	MaxBytes  uint64 // Reject larger encoded inputs
+	FailOn    FailOn // Strictness towards damaged files
+	// Autorotate turns and mirrors the pixels to the EXIF orientation. Mirror-only
+	// files stay sequential; other orientations of a sequential load are decoded
+	// into memory during the load.
+	Autorotate bool
+	// Page is the first page or frame to load, N the number of pages from there on
+	// (0 or 1 = one, -1 = all). The pages are stacked top to bottom in one tall image;
+	// Resize, Crop, Rotate, Flip, Cover and the watermarks work frame by frame, and
+	// EncodeToWebP and EncodeToGIF write the frames as an animation. Single-page
+	// formats ignore N and fail with ImageInvalidBounds for Page > 0.
+	Page int
+	N    int
+}
+
 // ImageResizeOptions defines options for resizing an image.
 type ImageResizeOptions struct {
 	Width          int
@@ -94,6 +187,38 @@ type ImageRotateOptions struct {
 	Angle float64 // Angle in degrees
 }
 
+// CropMode selects how Image.Cover and ThumbnailCover choose the crop window.
+type CropMode C.ImageCropMode
+
+const (
+	CropCentre    CropMode = C.IMAGE_CROP_CENTRE    // Keep the centre (default)
+	CropAttention CropMode = C.IMAGE_CROP_ATTENTION // Keep the region most likely to draw the eye
+	CropEntropy   CropMode = C.IMAGE_CROP_ENTROPY   // Keep the region with the most detail
+	CropGravity   CropMode = C.IMAGE_CROP_GRAVITY   // Keep the edge or corner named by Gravity
+)
+
+// ImageCoverOptions defines a cover-fit resize: the image is scaled to cover
+// Width x Height and the overflow is cropped, so the result is exactly that size.
+type ImageCoverOptions struct {
+	Width   int
+	Height  int
+	Mode    CropMode
+	Gravity Gravity // Kept edge or corner for CropGravity; GravityNone and GravityTile mean centre
+}
+
+// FlipDirection is the mirror axis of Image.Flip.
+type FlipDirection C.ImageFlipDirection
+
+const (
+	FlipHorizontal FlipDirection = C.IMAGE_FLIP_HORIZONTAL // Mirror left to right
+	FlipVertical   FlipDirection = C.IMAGE_FLIP_VERTICAL   // Mirror top to bottom
+)
+
+// ImageFlipOptions defines options for flipping an image.
+type ImageFlipOptions struct {
+	Direction FlipDirection
+}
+
 // ImageWatermarkOptions defines options for watermarking an image.
 type ImageWatermarkOptions struct {
 	X       int
@@ -106,22 +231,59 @@ type ImageOpacityOptions struct {
 	Opacity float64 // 0.0 to 1.0
 }
 
+// Intent is the rendering intent of ICC conversions.
+type Intent C.ImageIntent
+
+const (
+	IntentRelative   Intent = C.IMAGE_INTENT_RELATIVE   // Relative colorimetric (default)
+	IntentPerceptual Intent = C.IMAGE_INTENT_PERCEPTUAL // Compress out-of-gamut colours smoothly
+	IntentSaturation Intent = C.IMAGE_INTENT_SATURATION // Keep colours vivid
+	IntentAbsolute   Intent = C.IMAGE_INTENT_ABSOLUTE   // Keep the white point
+)
+
+// ImageSRGBOptions defines options for converting an image to 8-bit sRGB.
+type ImageSRGBOptions struct {
+	KeepProfile bool   // Keep the sRGB ICC profile after an ICC conversion (stripped otherwise)
+	Intent      Intent // Rendering intent for ICC conversions
+}
+
 // ImageMeta contains metadata extracted from an image.
 type ImageMeta struct {
-	Width      int
-	Height     int
-	Channels   int
-	Format     string
-	Colorspace string
-	DensityX   float64
-	DensityY   float64
-	FileSize   int // This will be 0 as per C implementation, usually after encoding
+	Width       int
+	Height      int
+	Channels    int
+	Format      string
+	Colorspace  string
+	DensityX    float64
+	DensityY    float64
+	FileSize    int  // Encoded size, set by ProbeImage/ProbeImageFromBytes (0 from ExtractMetadata)
+	Orientation int  // EXIF orientation 1-8 (1 if absent); 5-8 swap width and height when applied
+	HasAlpha    bool // The image has an alpha channel
+	Pages       int  // Number of pages or animation frames (1 for single images)
+	HasICC      bool // An ICC profile is embedded
+	Frames      int  // Frames stacked in this image (see ImageLoadOptions.N); each is Height/Frames tall
+}
+
+// ProbeOptions controls header-only probing.
+type ProbeOptions struct {
+	MaxPixels   uint64 // Reject images with more pixels (width * height * pages); 0 = no limit
+	FailOnError bool   // Reject files libvips can only read with errors (truncated, corrupt)
 }
 
 // ImageEncodeJPEGOptions defines options for JPEG encoding.
+// The trellis, deringing, scan and quant table controls need libvips built
+// against mozjpeg and are ignored otherwise. See JPEGPresetOptions for
+// ready-made combinations.
 type ImageEncodeJPEGOptions struct {
-	Quality   int  // 1-100
-	Interlace bool // Progressive JPEG
+	Quality            int       // 1-100
+	Interlace          bool      // Progressive JPEG
+	OptimizeCoding     bool      // Optimal Huffman tables
+	TrellisQuant       bool      // Trellis quantisation
+	OvershootDeringing bool      // Reduce ringing on hard edges
+	OptimizeScans      bool      // Size-optimised progressive scans (needs Interlace)
+	QuantTable         int       // Quantisation table 0-8; 3 suits photos
+	Subsample          Subsample // Chroma subsampling
+	Strip              bool      // Drop EXIF/XMP/ICC metadata
 }
 
 // ImageEncodePNGOptions defines options for PNG encoding.
@@ -144,44 +306,219 @@ func Cleanup() {
 // LoadImage loads an image from the given file path.
 // It returns an *Image and an error if the loading fails.
 func LoadImage(inputPath string) (*Image, error) {
+	return LoadImageWithOptions(inputPath, &ImageLoadOptions{})
+}
+
+// LoadImageWithOptions loads an image from the given file path using the given loader options.
+// It returns an *Image and an error if the loading fails.
+func LoadImageWithOptions(inputPath string, options *ImageLoadOptions) (*Image, error) {
 	cInputPath := C.CString(inputPath)
 	defer C.free(unsafe.Pointer(cInputPath))
 
-	handle := C.load_image(cInputPath)
-	if handle == nil {
-		return nil, errors.New("failed to load image: check logs for VIPS errors")
+	var handle C.VImageHandle
+	if err := detailed(func() bool {
+		handle = C.load_image_with_options(cInputPath, options.toC(), nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
 	}
-
-	img := &Image{handle: handle}
-	// Set a finalizer to ensure the C handle is freed when the Go Image object is garbage collected.
-	runtime.SetFinalizer(img, func(i *Image) {
-		C.free_vimage_handle(i.handle)
-	})
-	return img, nil
+	return newImage(handle), nil
 }
 
 // LoadImageFromBytes loads an image from a byte slice.
 // It returns an *Image and an error if the loading fails.
 func LoadImageFromBytes(data []byte) (*Image, error) {
+	return LoadImageFromBytesWithOptions(data, &ImageLoadOptions{})
+}
+
+// LoadImageFromBytesWithOptions loads an image from a byte slice using the given loader options.
+// It returns an *Image and an error if the loading fails.
+//
+// The slice is decoded in place, without a copy: it stays pinned until libvips no longer
+// reads from it, which may be after Free if other images (e.g. a watermarked base image)
+// still depend on this one. The caller must not modify data during that time.
+func LoadImageFromBytesWithOptions(data []byte, options *ImageLoadOptions) (*Image, error) {
 	if len(data) == 0 {
 		return nil, errors.New("image data is empty")
 	}
 
+	// Pin the backing array so libvips can keep reading it after this call returns;
+	// vipsgoReleaseBuffer unpins it once the C library hands it back.
+	pinner := &runtime.Pinner{}
+	pinner.Pin(&data[0])
+	release := cgo.NewHandle(pinner)
+
 	// Convert Go slice to C pointer and size
 	cData := (*C.uchar)(unsafe.Pointer(&data[0]))
 	cSize := C.size_t(len(data))
 
-	handle := C.load_image_from_bytes(cData, cSize)
-	if handle == nil {
-		return nil, errors.New("failed to load image from bytes: check logs for VIPS errors")
+	var handle C.VImageHandle
+	if err := detailed(func() bool {
+		handle = C.load_image_from_owned_bytes(cData, cSize, options.toC(),
+			C.ImageBufferReleaseFn(C.vipsgoReleaseBuffer), C.vipsgo_handle_to_ptr(C.uintptr_t(release)), nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
 	}
+	return newImage(handle), nil
+}
+
+// LoadImageFromMemory wraps raw interleaved pixels, such as a model output or a GPU
+// readback, as an image without encoding them: rows packed top to bottom, each pixel
+// holding bands samples of format in native byte order. Images with 1-2 bands are
+// treated as greyscale, 3-4 as sRGB, with the last band as alpha for 2 and 4.
+//
+// The slice is used in place, without a copy, under the same rules as
+// LoadImageFromBytesWithOptions: it stays pinned until libvips no longer reads from it,
+// and the caller must not modify pixels during that time.
+func LoadImageFromMemory(pixels []byte, width, height, bands int, format SampleFormat) (*Image, error) {
+	if len(pixels) == 0 {
+		return nil, errors.New("pixel data is empty")
+	}
+
+	pinner := &runtime.Pinner{}
+	pinner.Pin(&pixels[0])
+	release := cgo.NewHandle(pinner)
+
+	var handle C.VImageHandle
+	err := checkStatus(func() C.ImageStatus {
+		var status C.ImageStatus
+		handle = C.load_image_from_memory(unsafe.Pointer(&pixels[0]), C.size_t(len(pixels)), C.int(width),
+			C.int(height), C.int(bands), C.ImageSampleFormat(format),
+			C.ImageBufferReleaseFn(C.vipsgoReleaseBuffer), C.vipsgo_handle_to_ptr(C.uintptr_t(release)), &status)
+		return status
+	})
+	if err != nil {
+		return nil, err
+	}
+	return newImage(handle), nil
+}
+
+// Thumbnail loads an image from the given file path and resizes it in one step.
+// The target size is pushed down into the decoder (shrink-on-load), so this is
+// much cheaper than LoadImage followed by Resize for large sources.
+func Thumbnail(inputPath string, options *ImageResizeOptions) (*Image, error) {
+	return ThumbnailWithOptions(inputPath, options, &ImageLoadOptions{})
+}
+
+// ThumbnailWithOptions is Thumbnail with the limits, strictness and autorotation of
+// load. The limits apply to the source image; Access is ignored since thumbnails are
+// always decoded sequentially. With Autorotate the target box applies to the upright image.
+func ThumbnailWithOptions(inputPath string, options *ImageResizeOptions, load *ImageLoadOptions) (*Image, error) {
+	cInputPath := C.CString(inputPath)
+	defer C.free(unsafe.Pointer(cInputPath))
+
+	var handle C.VImageHandle
+	if err := detailed(func() bool {
+		handle = C.thumbnail_from_path_with_options(cInputPath, options.toC(), load.toC(), nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
+	}
+	return newImage(handle), nil
+}
 
+// ThumbnailCover loads a cover-fit thumbnail: the decode is shrunk to the covering size
+// and libvips chooses the crop window on the shrunk image, so no more pixels are decoded
+// than the output needs. load may be nil.
+func ThumbnailCover(inputPath string, options *ImageCoverOptions, load *ImageLoadOptions) (*Image, error) {
+	cInputPath := C.CString(inputPath)
+	defer C.free(unsafe.Pointer(cInputPath))
+
+	var handle C.VImageHandle
+	if err := detailed(func() bool {
+		handle = C.thumbnail_cover_from_path(cInputPath, options.toC(), load.toC(), nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
+	}
+	return newImage(handle), nil
+}
+
+// ThumbnailCoverFromBytes is ThumbnailCover for an image held in a byte slice.
+// The data is copied by the C library, so the slice may be reused after the call.
+func ThumbnailCoverFromBytes(data []byte, options *ImageCoverOptions, load *ImageLoadOptions) (*Image, error) {
+	if len(data) == 0 {
+		return nil, errors.New("image data is empty")
+	}
+
+	cData := (*C.uchar)(unsafe.Pointer(&data[0]))
+	cSize := C.size_t(len(data))
+
+	var handle C.VImageHandle
+	if err := detailed(func() bool {
+		handle = C.thumbnail_cover_from_buffer(cData, cSize, options.toC(), load.toC(), nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
+	}
+	return newImage(handle), nil
+}
+
+// ThumbnailFromBytes decodes and resizes an image held in a byte slice in one step.
+// The data is copied by the C library, so the slice may be reused after the call.
+func ThumbnailFromBytes(data []byte, options *ImageResizeOptions) (*Image, error) {
+	return ThumbnailFromBytesWithOptions(data, options, &ImageLoadOptions{})
+}
+
+// ThumbnailFromBytesWithOptions is ThumbnailFromBytes with the loader options of
+// ThumbnailWithOptions.
+func ThumbnailFromBytesWithOptions(data []byte, options *ImageResizeOptions, load *ImageLoadOptions) (*Image, error) {
+	if len(data) == 0 {
+		return nil, errors.New("image data is empty")
+	}
+
+	cData := (*C.uchar)(unsafe.Pointer(&data[0]))
+	cSize := C.size_t(len(data))
+
+	var handle C.VImageHandle
+	if err := detailed(func() bool {
+		handle = C.thumbnail_from_buffer_with_options(cData, cSize, options.toC(), load.toC(), nil)
+		return handle != nil
+	}); err != nil {
+		return nil, err
+	}
+	return newImage(handle), nil
+}
+
+// newImage wraps a C handle and sets a finalizer that frees it when the Go Image is garbage collected.
+func newImage(handle C.VImageHandle) *Image {
 	img := &Image{handle: handle}
-	// Set a finalizer to ensure the C handle is freed when the Go Image object is garbage collected.
 	runtime.SetFinalizer(img, func(i *Image) {
 		C.free_vimage_handle(i.handle)
 	})
-	return img, nil
+	return img
+}
+
+// toC converts the load options to their C representation; nil means the defaults.
+func (o *ImageLoadOptions) toC() C.ImageLoadOptions {
+	if o == nil {
+		return C.ImageLoadOptions{}
+	}
+	return C.ImageLoadOptions{
+		access:     C.ImageAccess(o.Access),
+		max_width:  C.int(o.MaxWidth),
+		max_height: C.int(o.MaxHeight),
+		max_pixels: C.uint64_t(o.MaxPixels),
+		max_bytes:  C.uint64_t(o.MaxBytes),
+		fail_on:    C.ImageFailOn(o.FailOn),
+		autorotate: cBool(o.Autorotate),
+		page:       C.int(o.Page),
+		n:          C.int(o.N),
+	}
+}
+
+// toC converts the resize options to their C representation.
+func (o *ImageResizeOptions) toC() C.ImageResizeOptions {
+	cOptions := C.ImageResizeOptions{
+		width:           C.int(o.Width),
+		height:          C.int(o.Height),
+		maintain_aspect: C.int(0), // C.int(bool) is 0 for false, 1 for true
+	}
+	if o.MaintainAspect {
+		cOptions.maintain_aspect = C.int(1)
+	}
+	return cOptions
 }
 
 // Free explicitly frees the resources associated with the image.
@@ -200,17 +537,7 @@ func (img *Image) Resize(options *ImageResizeOptions) error {
 		return VipsInvalidHandle.Error()
 	}
 
-	cOptions := C.ImageResizeOptions{
-		width:           C.int(options.Width),
-		height:          C.int(options.Height),
-		maintain_aspect: C.int(0), // C.int(bool) is 0 for false, 1 for true
-	}
-	if options.MaintainAspect {
-		cOptions.maintain_aspect = C.int(1)
-	}
-
-	status := ImageStatus(C.resize_image(img.handle, cOptions))
-	return status.Error()
+	return checkStatus(func() C.ImageStatus { return C.resize_image(img.handle, options.toC()) })
 }
 
 // Crop crops the image to the specified rectangle.
@@ -219,15 +546,7 @@ func (img *Image) Crop(options *ImageCropOptions) error {
 		return VipsInvalidHandle.Error()
 	}
 
-	cOptions := C.ImageCropOptions{
-		x:      C.int(options.X),
-		y:      C.int(options.Y),
-		width:  C.int(options.Width),
-		height: C.int(options.Height),
-	}
-
-	status := ImageStatus(C.crop_image(img.handle, cOptions))
-	return status.Error()
+	return checkStatus(func() C.ImageStatus { return C.crop_image(img.handle, options.toC()) })
 }
 
 // Rotate rotates the image by the specified angle in degrees.
@@ -236,12 +555,76 @@ func (img *Image) Rotate(options *ImageRotateOptions) error {
 		return VipsInvalidHandle.Error()
 	}
 
-	cOptions := C.ImageRotateOptions{
-		angle: C.double(options.Angle),
+	return checkStatus(func() C.ImageStatus { return C.rotate_image(img.handle, options.toC()) })
+}
+
+// Clone returns a second Image sharing the decoded pixels of img. Both images can be
+// transformed and freed independently.
+func (img *Image) Clone() (*Image, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+
+	var handle C.VImageHandle
+	err := detailed(func() bool {
+		handle = C.clone_vimage_handle(img.handle)
+		return handle != nil
+	})
+	runtime.KeepAlive(img)
+	if err != nil {
+		return nil, err
 	}
+	return newImage(handle), nil
+}
 
-	status := ImageStatus(C.rotate_image(img.handle, cOptions))
-	return status.Error()
+// ResizeTo returns a resized copy of the image, leaving img unchanged. The copy shares
+// the decode of img, so one image can feed parallel goroutines without reloading.
+func (img *Image) ResizeTo(options *ImageResizeOptions) (*Image, error) {
+	return img.derive(func(dst *C.VImageHandle) C.ImageStatus { return C.resize_image_to(img.handle, dst, options.toC()) })
+}
+
+// CropTo returns a cropped copy of the image, leaving img unchanged.
+func (img *Image) CropTo(options *ImageCropOptions) (*Image, error) {
+	return img.derive(func(dst *C.VImageHandle) C.ImageStatus { return C.crop_image_to(img.handle, dst, options.toC()) })
+}
+
+// RotateTo returns a rotated copy of the image, leaving img unchanged.
+func (img *Image) RotateTo(options *ImageRotateOptions) (*Image, error) {
+	return img.derive(func(dst *C.VImageHandle) C.ImageStatus { return C.rotate_image_to(img.handle, dst, options.toC()) })
+}
+
+// derive runs a functional transform of img and wraps the new handle it produces.
+func (img *Image) derive(transform func(dst *C.VImageHandle) C.ImageStatus) (*Image, error) {
+	if img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+
+	var handle C.VImageHandle
+	err := checkStatus(func() C.ImageStatus { return transform(&handle) })
+	runtime.KeepAlive(img)
+	if err != nil {
+		return nil, err
+	}
+	return newImage(handle), nil
+}
+
+// Cover resizes the image to cover the box of options and crops it to exactly that box.
+// For an encoded source prefer ThumbnailCover, which also shrinks on load.
+func (img *Image) Cover(options *ImageCoverOptions) error {
+	if img.handle == nil {
+		return VipsInvalidHandle.Error()
+	}
+
+	return checkStatus(func() C.ImageStatus { return C.cover_image(img.handle, options.toC()) })
+}
+
+// Flip mirrors the image horizontally or vertically.
+func (img *Image) Flip(options *ImageFlipOptions) error {
+	if img.handle == nil {
+		return VipsInvalidHandle.Error()
+	}
+
+	return checkStatus(func() C.ImageStatus { return C.flip_image(img.handle, options.toC()) })
 }
 
 // Watermark applies a watermark image to the base image.
@@ -250,14 +633,7 @@ func (baseImg *Image) Watermark(watermarkImg *Image, options *ImageWatermarkOpti
 		return VipsInvalidHandle.Error()
 	}
 
-	cOptions := C.ImageWatermarkOptions{
-		x:       C.int(options.X),
-		y:       C.int(options.Y),
-		opacity: C.double(options.Opacity),
-	}
-
-	status := ImageStatus(C.watermark_image(baseImg.handle, watermarkImg.handle, cOptions))
-	return status.Error()
+	return checkStatus(func() C.ImageStatus { return C.watermark_image(baseImg.handle, watermarkImg.handle, options.toC()) })
 }
 
 // ChangeOpacity changes the overall opacity of an image.
@@ -266,12 +642,18 @@ func (img *Image) ChangeOpacity(options *ImageOpacityOptions) error {
 		return VipsInvalidHandle.Error()
 	}
 
-	cOptions := C.ImageOpacityOptions{
-		opacity: C.double(options.Opacity),
+	return checkStatus(func() C.ImageStatus { return C.change_image_opacity(img.handle, options.toC()) })
+}
+
+// EnsureSRGB8 converts the image to 8 bits per channel sRGB (8-bit greyscale for
+// greyscale input), honouring an embedded ICC profile, so that later steps run on
+// 8-bit data. Images that are already 8-bit sRGB without a profile are left as is.
+func (img *Image) EnsureSRGB8(options *ImageSRGBOptions) error {
+	if img.handle == nil {
+		return VipsInvalidHandle.Error()
 	}
 
-	status := ImageStatus(C.change_image_opacity(img.handle, cOptions))
-	return status.Error()
+	return checkStatus(func() C.ImageStatus { return C.ensure_srgb8(img.handle, options.toC()) })
 }
 
 // ExtractMetadata extracts metadata from the image.
@@ -281,22 +663,66 @@ func (img *Image) ExtractMetadata() (ImageMeta, error) {
 	}
 
 	cMeta := C.extract_metadata(img.handle)
+	runtime.KeepAlive(img)
+	return metaFromC(&cMeta), nil
+}
+
+// ProbeImage reads the metadata of an image file from its header, without decoding pixels.
+// Use it to reject oversized or unsupported uploads before paying for a decode. If the
+// image exceeds options.MaxPixels, the metadata is returned along with an ImageTooLarge error.
+func ProbeImage(inputPath string, options *ProbeOptions) (ImageMeta, error) {
+	cInputPath := C.CString(inputPath)
+	defer C.free(unsafe.Pointer(cInputPath))
 
-	// Convert C strings to Go strings
-	format := C.GoString(&cMeta.format[0])
-	colorspace := C.GoString(&cMeta.colorspace[0])
+	var cMeta C.ImageMeta
+	err := checkStatus(func() C.ImageStatus {
+		return C.probe_image_from_path(cInputPath, options.toC(), &cMeta)
+	})
+	return metaFromC(&cMeta), err
+}
 
-	meta := ImageMeta{
-		Width:      int(cMeta.width),
-		Height:     int(cMeta.height),
-		Channels:   int(cMeta.channels),
-		Format:     format,
-		Colorspace: colorspace,
-		DensityX:   float64(cMeta.density_x),
-		DensityY:   float64(cMeta.density_y),
-		FileSize:   int(cMeta.file_size), // Will be 0
+// ProbeImageFromBytes is ProbeImage for an encoded image held in memory.
+// The slice is only read during the call.
+func ProbeImageFromBytes(data []byte, options *ProbeOptions) (ImageMeta, error) {
+	if len(data) == 0 {
+		return ImageMeta{}, errors.New("image data is empty")
+	}
+
+	var cMeta C.ImageMeta
+	err := checkStatus(func() C.ImageStatus {
+		return C.probe_image_from_bytes((*C.uchar)(unsafe.Pointer(&data[0])), C.size_t(len(data)), options.toC(), &cMeta)
+	})
+	return metaFromC(&cMeta), err
+}
+
+// metaFromC converts C image metadata to its Go representation.
+func metaFromC(cMeta *C.ImageMeta) ImageMeta {
+	return ImageMeta{
+		Width:       int(cMeta.width),
+		Height:      int(cMeta.height),
+		Channels:    int(cMeta.channels),
+		Format:      C.GoString(&cMeta.format[0]),
+		Colorspace:  C.GoString(&cMeta.colorspace[0]),
+		DensityX:    float64(cMeta.density_x),
+		DensityY:    float64(cMeta.density_y),
+		FileSize:    int(cMeta.file_size),
+		Orientation: int(cMeta.orientation),
+		HasAlpha:    cMeta.has_alpha != 0,
+		Pages:       int(cMeta.pages),
+		HasICC:      cMeta.has_icc != 0,
+		Frames:      int(cMeta.frames),
+	}
+}
+
+// toC converts the probe options to their C representation; nil selects no limits.
+func (o *ProbeOptions) toC() C.ImageProbeOptions {
+	if o == nil {
+		return C.ImageProbeOptions{}
+	}
+	return C.ImageProbeOptions{
+		max_pixels:    C.uint64_t(o.MaxPixels),
+		fail_on_error: cBool(o.FailOnError),
 	}
-	return meta, nil
 }
 
 // EncodeToJPEG encodes the image to JPEG format and returns the encoded data.
@@ -305,17 +731,12 @@ func (img *Image) EncodeToJPEG(options *ImageEncodeJPEGOptions) ([]byte, error)
 		return nil, VipsInvalidHandle.Error()
 	}
 
-	cOptions := C.ImageEncodeJPEGOptions{
-		quality:   C.int(options.Quality),
-		interlace: C.int(0),
-	}
-	if options.Interlace {
-		cOptions.interlace = C.int(1)
-	}
-
-	cBuffer := C.encode_to_jpeg(img.handle, cOptions)
-	if cBuffer.data == nil {
-		return nil, errors.New("failed to encode image to JPEG: check logs for VIPS errors")
+	var cBuffer C.ImageBuffer
+	if err := detailed(func() bool {
+		cBuffer = C.encode_to_jpeg(img.handle, options.toC())
+		return cBuffer.data != nil
+	}); err != nil {
+		return nil, err
 	}
 	defer C.free_image_buffer(cBuffer) // Ensure C-allocated buffer is freed
 
@@ -330,17 +751,12 @@ func (img *Image) EncodeToPNG(options *ImageEncodePNGOptions) ([]byte, error) {
 		return nil, VipsInvalidHandle.Error()
 	}
 
-	cOptions := C.ImageEncodePNGOptions{
-		compression: C.int(options.Compression),
-		interlace:   C.int(0),
-	}
-	if options.Interlace {
-		cOptions.interlace = C.int(1)
-	}
-
-	cBuffer := C.encode_to_png(img.handle, cOptions)
-	if cBuffer.data == nil {
-		return nil, errors.New("failed to encode image to PNG: check logs for VIPS errors")
+	var cBuffer C.ImageBuffer
+	if err := detailed(func() bool {
+		cBuffer = C.encode_to_png(img.handle, options.toC())
+		return cBuffer.data != nil
+	}); err != nil {
+		return nil, err
 	}
 	defer C.free_image_buffer(cBuffer) // Ensure C-allocated buffer is freed
 
@@ -348,3 +764,164 @@ func (img *Image) EncodeToPNG(options *ImageEncodePNGOptions) ([]byte, error) {
 	goBytes := C.GoBytes(unsafe.Pointer(cBuffer.data), C.int(cBuffer.size))
 	return goBytes, nil
 }
+
+// EncodeJPEGTo encodes the image to JPEG format and streams the encoded bytes to w
+// as they are produced, without buffering the whole encoded image.
+func (img *Image) EncodeJPEGTo(w io.Writer, options *ImageEncodeJPEGOptions) error {
+	if img.handle == nil {
+		return VipsInvalidHandle.Error()
+	}
+
+	cOptions := options.toC()
+	return img.encodeTo(w, func(writer C.ImageWriter) C.ImageStatus {
+		return C.encode_to_jpeg_writer(img.handle, cOptions, writer)
+	})
+}
+
+// EncodePNGTo encodes the image to PNG format and streams the encoded bytes to w
+// as they are produced, without buffering the whole encoded image.
+func (img *Image) EncodePNGTo(w io.Writer, options *ImageEncodePNGOptions) error {
+	if img.handle == nil {
+		return VipsInvalidHandle.Error()
+	}
+
+	cOptions := options.toC()
+	return img.encodeTo(w, func(writer C.ImageWriter) C.ImageStatus {
+		return C.encode_to_png_writer(img.handle, cOptions, writer)
+	})
+}
+
+// AppendJPEG encodes the image to JPEG format and appends the encoded bytes to dst,
+// returning the extended slice. Passing the previous result back as dst[:0] reuses its
+// memory, so steady-state encoding does not allocate.
+func (img *Image) AppendJPEG(dst []byte, options *ImageEncodeJPEGOptions) ([]byte, error) {
+	sink := &appendWriter{buf: dst}
+	err := img.EncodeJPEGTo(sink, options)
+	return sink.buf, err
+}
+
+// AppendPNG encodes the image to PNG format and appends the encoded bytes to dst,
+// returning the extended slice. See AppendJPEG for buffer reuse.
+func (img *Image) AppendPNG(dst []byte, options *ImageEncodePNGOptions) ([]byte, error) {
+	sink := &appendWriter{buf: dst}
+	err := img.EncodePNGTo(sink, options)
+	return sink.buf, err
+}
+
+// appendWriter is an io.Writer appending to a caller-owned slice.
+type appendWriter struct {
+	buf []byte
+}
+
+func (a *appendWriter) Write(p []byte) (int, error) {
+	a.buf = append(a.buf, p...)
+	return len(p), nil
+}
+
+// encodeTo runs a writer-based C encoder with w as its destination.
+func (img *Image) encodeTo(w io.Writer, encode func(C.ImageWriter) C.ImageStatus) error {
+	state := &writerState{w: w}
+	handle := cgo.NewHandle(state)
+	defer handle.Delete()
+
+	writer := C.ImageWriter{
+		write:     C.ImageWriteFn(C.vipsgoWrite),
+		user_data: C.vipsgo_handle_to_ptr(C.uintptr_t(handle)),
+	}
+	err := checkStatus(func() C.ImageStatus { return encode(writer) })
+	runtime.KeepAlive(img)
+
+	if state.err != nil {
+		return state.err
+	}
+	return err
+}
+
+// toC converts the crop options to their C representation.
+func (o *ImageCropOptions) toC() C.ImageCropOptions {
+	return C.ImageCropOptions{
+		x:      C.int(o.X),
+		y:      C.int(o.Y),
+		width:  C.int(o.Width),
+		height: C.int(o.Height),
+	}
+}
+
+// toC converts the rotate options to their C representation.
+func (o *ImageRotateOptions) toC() C.ImageRotateOptions {
+	return C.ImageRotateOptions{
+		angle: C.double(o.Angle),
+	}
+}
+
+// toC converts the cover options to their C representation.
+func (o *ImageCoverOptions) toC() C.ImageCoverOptions {
+	return C.ImageCoverOptions{
+		width:   C.int(o.Width),
+		height:  C.int(o.Height),
+		mode:    C.ImageCropMode(o.Mode),
+		gravity: C.ImageGravity(o.Gravity),
+	}
+}
+
+// toC converts the flip options to their C representation.
+func (o *ImageFlipOptions) toC() C.ImageFlipOptions {
+	return C.ImageFlipOptions{
+		direction: C.ImageFlipDirection(o.Direction),
+	}
+}
+
+// toC converts the watermark options to their C representation.
+func (o *ImageWatermarkOptions) toC() C.ImageWatermarkOptions {
+	return C.ImageWatermarkOptions{
+		x:       C.int(o.X),
+		y:       C.int(o.Y),
+		opacity: C.double(o.Opacity),
+	}
+}
+
+// toC converts the opacity options to their C representation.
+func (o *ImageOpacityOptions) toC() C.ImageOpacityOptions {
+	return C.ImageOpacityOptions{
+		opacity: C.double(o.Opacity),
+	}
+}
+
+// toC converts the sRGB options to their C representation; nil selects the defaults.
+func (o *ImageSRGBOptions) toC() C.ImageSRGBOptions {
+	if o == nil {
+		return C.ImageSRGBOptions{}
+	}
+	return C.ImageSRGBOptions{
+		keep_profile: cBool(o.KeepProfile),
+		intent:       C.ImageIntent(o.Intent),
+	}
+}
+
+// toC converts the JPEG options to their C representation.
+func (o *ImageEncodeJPEGOptions) toC() C.ImageEncodeJPEGOptions {
+	return C.ImageEncodeJPEGOptions{
+		quality:             C.int(o.Quality),
+		interlace:           cBool(o.Interlace),
+		version:             C.IMAGE_ENCODE_JPEG_OPTIONS_VERSION,
+		optimize_coding:     cBool(o.OptimizeCoding),
+		trellis_quant:       cBool(o.TrellisQuant),
+		overshoot_deringing: cBool(o.OvershootDeringing),
+		optimize_scans:      cBool(o.OptimizeScans),
+		quant_table:         C.int(o.QuantTable),
+		subsample:           C.ImageSubsample(o.Subsample),
+		strip:               cBool(o.Strip),
+	}
+}
+
+// toC converts the PNG options to their C representation.
+func (o *ImageEncodePNGOptions) toC() C.ImageEncodePNGOptions {
+	cOptions := C.ImageEncodePNGOptions{
+		compression: C.int(o.Compression),
+		interlace:   C.int(0),
+	}
+	if o.Interlace {
+		cOptions.interlace = C.int(1)
+	}
+	return cOptions
+}
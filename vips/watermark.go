@@ -0,0 +1,115 @@
+package vips
+
+/*
+#include "c/include/vips_wrapper.h"
+*/
+import "C"
+import "runtime"
+
+// BlendMode selects how a prepared watermark is blended onto the base image.
+type BlendMode C.ImageBlendMode
+
+const (
+	BlendOver       BlendMode = C.IMAGE_BLEND_OVER       // Plain alpha compositing (default)
+	BlendMultiply   BlendMode = C.IMAGE_BLEND_MULTIPLY   // Darkens: base * mark
+	BlendScreen     BlendMode = C.IMAGE_BLEND_SCREEN     // Lightens: inverse of multiply
+	BlendOverlay    BlendMode = C.IMAGE_BLEND_OVERLAY    // Multiply or screen depending on the base
+	BlendDarken     BlendMode = C.IMAGE_BLEND_DARKEN     // Darker of base and mark
+	BlendLighten    BlendMode = C.IMAGE_BLEND_LIGHTEN    // Lighter of base and mark
+	BlendHardLight  BlendMode = C.IMAGE_BLEND_HARD_LIGHT // Multiply or screen depending on the mark
+	BlendSoftLight  BlendMode = C.IMAGE_BLEND_SOFT_LIGHT // Gentle darken or lighten depending on the mark
+	BlendDifference BlendMode = C.IMAGE_BLEND_DIFFERENCE // Absolute difference
+	BlendExclusion  BlendMode = C.IMAGE_BLEND_EXCLUSION  // Lower-contrast difference
+)
+
+// Gravity anchors a prepared watermark on the base image.
+type Gravity C.ImageGravity
+
+const (
+	GravityNone      Gravity = C.IMAGE_GRAVITY_NONE // X/Y are absolute coordinates
+	GravityNorthWest Gravity = C.IMAGE_GRAVITY_NORTH_WEST
+	GravityNorth     Gravity = C.IMAGE_GRAVITY_NORTH
+	GravityNorthEast Gravity = C.IMAGE_GRAVITY_NORTH_EAST
+	GravityWest      Gravity = C.IMAGE_GRAVITY_WEST
+	GravityCentre    Gravity = C.IMAGE_GRAVITY_CENTRE
+	GravityEast      Gravity = C.IMAGE_GRAVITY_EAST
+	GravitySouthWest Gravity = C.IMAGE_GRAVITY_SOUTH_WEST
+	GravitySouth     Gravity = C.IMAGE_GRAVITY_SOUTH
+	GravitySouthEast Gravity = C.IMAGE_GRAVITY_SOUTH_EAST
+	GravityTile      Gravity = C.IMAGE_GRAVITY_TILE // Repeated across the whole image
+)
+
+// WatermarkPlacement positions a prepared watermark.
+type WatermarkPlacement struct {
+	Gravity Gravity
+	// X and Y are absolute coordinates for GravityNone, margins from the anchored
+	// edges (shifts on centred axes) for the other gravities, and the grid offset
+	// for GravityTile.
+	X, Y int
+	// WidthFraction scales the watermark relative to the base width, snapped to a
+	// size class (8 per octave) so similar images share one scaled copy; 0 = natural size.
+	WidthFraction float64
+}
+
+// Watermark is a prepared overlay: opacity, premultiplied alpha and colour
+// conversion are applied once, and the pixels are kept in memory. It is
+// immutable and safe to use from any number of goroutines at once.
+type Watermark struct {
+	handle C.ImageWatermarkHandle
+}
+
+// PrepareWatermark builds a Watermark from img for repeated use with
+// Image.ApplyWatermark or PreparedWatermarkOp. img may be freed afterwards.
+func PrepareWatermark(img *Image, opacity float64, mode BlendMode) (*Watermark, error) {
+	if img == nil || img.handle == nil {
+		return nil, VipsInvalidHandle.Error()
+	}
+
+	var handle C.ImageWatermarkHandle
+	err := detailed(func() bool {
+		handle = C.prepare_watermark(img.handle, C.double(opacity), C.ImageBlendMode(mode), nil)
+		return handle != nil
+	})
+	runtime.KeepAlive(img)
+	if err != nil {
+		return nil, err
+	}
+	mark := &Watermark{handle: handle}
+	runtime.SetFinalizer(mark, (*Watermark).Free)
+	return mark, nil
+}
+
+// Free releases the watermark. Queued pool jobs that use it keep their own reference.
+func (w *Watermark) Free() {
+	if w.handle != nil {
+		C.free_watermark(w.handle)
+		w.handle = nil
+		runtime.SetFinalizer(w, nil)
+	}
+}
+
+// ApplyWatermark composites a prepared watermark onto the image.
+func (img *Image) ApplyWatermark(mark *Watermark, placement *WatermarkPlacement) error {
+	if img.handle == nil || mark == nil || mark.handle == nil {
+		return VipsInvalidHandle.Error()
+	}
+
+	err := checkStatus(func() C.ImageStatus {
+		return C.watermark_image_prepared(img.handle, mark.handle, placement.toC())
+	})
+	runtime.KeepAlive(mark)
+	return err
+}
+
+// toC converts the placement to its C representation; nil places at the top-left corner.
+func (p *WatermarkPlacement) toC() C.ImageWatermarkPlacement {
+	if p == nil {
+		return C.ImageWatermarkPlacement{}
+	}
+	return C.ImageWatermarkPlacement{
+		gravity:        C.ImageGravity(p.Gravity),
+		x:              C.int(p.X),
+		y:              C.int(p.Y),
+		width_fraction: C.double(p.WidthFraction),
+	}
+}